@@ -0,0 +1,91 @@
+#begin VERTEX
+
+#version 430 core
+
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 uv;
+
+out VS_OUT {
+	vec2 uv;
+} vs_out;
+
+void main() {
+	vs_out.uv = uv;
+	gl_Position = vec4(position, 0.0, 1.0);
+}
+
+#end VERTEX
+
+#begin FRAGMENT
+
+#version 430 core
+
+in VS_OUT {
+	vec2 uv;
+} fs_in;
+
+out vec4 color;
+
+uniform sampler2D input_color;
+
+/* Set for the first downsample, straight from the bright pixels. */
+uniform bool first_mip;
+
+float karis_weight(vec3 c) {
+	return 1.0 / (1.0 + dot(c, vec3(0.2126, 0.7152, 0.0722)));
+}
+
+/* 13 bilinear taps arranged as five overlapping 2x2 boxes. */
+void main() {
+	vec2 texel = 1.0 / textureSize(input_color, 0);
+	vec2 uv = fs_in.uv;
+
+	vec3 a = texture(input_color, uv + texel * vec2(-2.0,  2.0)).rgb;
+	vec3 b = texture(input_color, uv + texel * vec2( 0.0,  2.0)).rgb;
+	vec3 c = texture(input_color, uv + texel * vec2( 2.0,  2.0)).rgb;
+
+	vec3 d = texture(input_color, uv + texel * vec2(-2.0,  0.0)).rgb;
+	vec3 e = texture(input_color, uv).rgb;
+	vec3 f = texture(input_color, uv + texel * vec2( 2.0,  0.0)).rgb;
+
+	vec3 g = texture(input_color, uv + texel * vec2(-2.0, -2.0)).rgb;
+	vec3 h = texture(input_color, uv + texel * vec2( 0.0, -2.0)).rgb;
+	vec3 i = texture(input_color, uv + texel * vec2( 2.0, -2.0)).rgb;
+
+	vec3 j = texture(input_color, uv + texel * vec2(-1.0,  1.0)).rgb;
+	vec3 k = texture(input_color, uv + texel * vec2( 1.0,  1.0)).rgb;
+	vec3 l = texture(input_color, uv + texel * vec2(-1.0, -1.0)).rgb;
+	vec3 m = texture(input_color, uv + texel * vec2( 1.0, -1.0)).rgb;
+
+	vec3 boxes[5] = vec3[] (
+		(j + k + l + m) * 0.25,
+		(a + b + d + e) * 0.25,
+		(b + c + e + f) * 0.25,
+		(d + e + g + h) * 0.25,
+		(e + f + h + i) * 0.25
+	);
+
+	vec3 result;
+	if (first_mip) {
+		/* Weighting each box by its brightness keeps single very bright
+		 * pixels from flickering as they move. */
+		float weights[5];
+		float total = 0.0;
+		for (int n = 0; n < 5; n++) {
+			weights[n] = karis_weight(boxes[n]) * (n == 0 ? 0.5 : 0.125);
+			total += weights[n];
+		}
+
+		result = vec3(0.0);
+		for (int n = 0; n < 5; n++) {
+			result += boxes[n] * weights[n];
+		}
+		result /= total;
+	} else {
+		result = boxes[0] * 0.5 + (boxes[1] + boxes[2] + boxes[3] + boxes[4]) * 0.125;
+	}
+
+	color = vec4(result, 1.0);
+}
+
+#end FRAGMENT
@@ -0,0 +1,52 @@
+#begin VERTEX
+
+#version 430 core
+
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 uv;
+
+out VS_OUT {
+	vec2 uv;
+} vs_out;
+
+void main() {
+	vs_out.uv = uv;
+	gl_Position = vec4(position, 0.0, 1.0);
+}
+
+#end VERTEX
+
+#begin FRAGMENT
+
+#version 430 core
+
+in VS_OUT {
+	vec2 uv;
+} fs_in;
+
+out vec4 color;
+
+uniform sampler2D input_color;
+
+/* Added on top of the next mip up, which is blended in additively. */
+void main() {
+	vec2 texel = 1.0 / textureSize(input_color, 0);
+	vec2 uv = fs_in.uv;
+
+	/* 3x3 tent filter. */
+	vec3 result = texture(input_color, uv).rgb * 4.0;
+
+	result += texture(input_color, uv + texel * vec2(-1.0,  0.0)).rgb * 2.0;
+	result += texture(input_color, uv + texel * vec2( 1.0,  0.0)).rgb * 2.0;
+	result += texture(input_color, uv + texel * vec2( 0.0, -1.0)).rgb * 2.0;
+	result += texture(input_color, uv + texel * vec2( 0.0,  1.0)).rgb * 2.0;
+
+	result += texture(input_color, uv + texel * vec2(-1.0, -1.0)).rgb;
+	result += texture(input_color, uv + texel * vec2( 1.0, -1.0)).rgb;
+	result += texture(input_color, uv + texel * vec2(-1.0,  1.0)).rgb;
+	result += texture(input_color, uv + texel * vec2( 1.0,  1.0)).rgb;
+
+	color = vec4(result / 16.0, 1.0);
+}
+
+#end FRAGMENT
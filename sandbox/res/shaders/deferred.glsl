@@ -0,0 +1,104 @@
+#begin VERTEX
+
+#version 430 core
+
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 uv;
+
+out VS_OUT {
+	vec2 uv;
+} vs_out;
+
+void main() {
+	vs_out.uv = uv;
+	gl_Position = vec4(position, 0.0, 1.0);
+}
+
+#end VERTEX
+
+#begin FRAGMENT
+
+#version 430 core
+
+in VS_OUT {
+	vec2 uv;
+} fs_in;
+
+#include "include/frame_data.glsl"
+
+#include "include/lights.glsl"
+
+layout (binding = 0) uniform sampler2D g_albedo;
+layout (binding = 1) uniform sampler2D g_normal;
+layout (binding = 2) uniform sampler2D g_material;
+layout (binding = 3) uniform sampler2D g_emissive;
+
+uniform mat4 inverse_view;
+
+/* The reciprocals of the projection's x and y scale, for taking points
+ * back out of clip space. */
+uniform vec2 projection_scale;
+
+layout (location = 0) out vec4 color;
+
+/* Whatever is brighter than the threshold, for bloom. */
+layout (location = 1) out vec4 bright_color;
+
+vec3 albedo = vec3(0.0);
+vec3 normal = vec3(0.0);
+float metallic = 0.0;
+float roughness = 0.0;
+vec3 world_pos = vec3(0.0);
+
+#include "include/pbr_lighting.glsl"
+
+void main() {
+	vec4 emissive_depth = texture(g_emissive, fs_in.uv);
+
+	/* Nothing was drawn here. */
+	float depth = emissive_depth.a;
+	if (depth <= 0.0) {
+		discard;
+	}
+
+	vec2 ndc = fs_in.uv * 2.0 - 1.0;
+	vec3 view_pos = vec3(ndc * projection_scale, -1.0) * depth;
+	world_pos = (inverse_view * vec4(view_pos, 1.0)).xyz;
+
+	vec4 albedo_ao = texture(g_albedo, fs_in.uv);
+	vec2 metallic_roughness = texture(g_material, fs_in.uv).rg;
+
+	albedo = albedo_ao.rgb;
+	normal = normalize(texture(g_normal, fs_in.uv).xyz);
+	metallic = metallic_roughness.r;
+	roughness = metallic_roughness.g;
+
+	vec3 view_dir = normalize(camera_position - world_pos);
+
+	vec3 F0 = vec3(0.04);
+	F0 = mix(F0, albedo, metallic);
+
+	vec3 lighting_result = vec3(0.0);
+
+	uvec2 cluster = get_light_cluster(depth);
+	for (uint i = 0; i < cluster.y; i++) {
+		lighting_result += calculate_point_light(point_lights[light_indices[cluster.x + i]],
+				normal, view_dir, F0);
+	}
+
+	for (uint i = 0; i < directional_light_count; i++) {
+		lighting_result += calculate_directional_light(directional_lights[i],
+				normal, view_dir, F0);
+	}
+
+	lighting_result += emissive_depth.rgb;
+
+	vec3 ambient = ambient_intensity * ambient_color * albedo * albedo_ao.a;
+
+	color = vec4(ambient + lighting_result, 1.0);
+
+	float brightness = dot(color.rgb, vec3(0.2126, 0.7152, 0.0722));
+	bright_color = brightness > bloom_threshold ? color : vec4(0.0, 0.0, 0.0, 1.0);
+}
+
+#end FRAGMENT
@@ -5,10 +5,11 @@
 layout (location = 0) in vec3 position;
 
 uniform mat4 light;
-uniform mat4 transform = mat4(1.0);
+
+#include "include/transform.glsl"
 
 void main() {
-	gl_Position = light * transform * vec4(position, 1.0);
+	gl_Position = light * get_transform() * vec4(position, 1.0);
 }
 
 #end VERTEX
@@ -0,0 +1,89 @@
+#begin VERTEX
+
+#version 430 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 uv;
+#include "include/frame_data.glsl"
+
+#include "include/transform.glsl"
+
+out VS_OUT {
+	vec3 normal;
+	vec2 uv;
+	vec3 world_pos;
+} vs_out;
+
+void main() {
+	mat4 transform = get_transform();
+
+	vs_out.uv = uv;
+	vs_out.normal = mat3(transform) * normal;
+	vs_out.world_pos = vec3(transform * vec4(position, 1.0));
+
+	gl_Position = camera * vec4(vs_out.world_pos, 1.0);
+}
+
+#end VERTEX
+
+#begin FRAGMENT
+
+#version 430 core
+
+in VS_OUT {
+	vec3 normal;
+	vec2 uv;
+	vec3 world_pos;
+} fs_in;
+
+#include "include/frame_data.glsl"
+
+#include "include/pbr_material.glsl"
+
+/* Albedo and ambient occlusion, world-space normal, metallic and
+ * roughness, and emission and view depth. */
+layout (location = 0) out vec4 g_albedo;
+layout (location = 1) out vec4 g_normal;
+layout (location = 2) out vec4 g_material;
+layout (location = 3) out vec4 g_emissive;
+
+void main() {
+	vec3 albedo = material.albedo;
+	vec3 normal = normalize(fs_in.normal);
+	float metallic = material.metallic;
+	float roughness = material.roughness;
+
+#ifdef ALICE_FEATURE_ALBEDO_MAP
+	albedo = material.albedo * pow(texture(albedo_map, fs_in.uv).rgb, vec3(gamma));
+#endif
+
+#ifdef ALICE_FEATURE_NORMAL_MAP
+	normal = get_normal_from_map();
+#endif
+
+#ifdef ALICE_FEATURE_ROUGHNESS_MAP
+	roughness = material.roughness * texture(roughness_map, fs_in.uv).r;
+#endif
+
+#ifdef ALICE_FEATURE_METALLIC_MAP
+	metallic = material.metallic * texture(metallic_map, fs_in.uv).r;
+#endif
+
+	float ao = 1.0;
+#ifdef ALICE_FEATURE_AMBIENT_OCCLUSION_MAP
+	ao = texture(ambient_occlusion_map, fs_in.uv).r;
+#endif
+
+	vec3 emissive = vec3(material.emissive);
+#ifdef ALICE_FEATURE_EMISSIVE_MAP
+	emissive *= texture(emissive_map, fs_in.uv).rgb;
+#endif
+
+	g_albedo = vec4(albedo, ao);
+	g_normal = vec4(normal, 0.0);
+	g_material = vec4(metallic, roughness, 0.0, 0.0);
+	g_emissive = vec4(albedo * emissive, -(view * vec4(fs_in.world_pos, 1.0)).z);
+}
+
+#end FRAGMENT
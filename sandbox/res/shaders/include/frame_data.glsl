@@ -0,0 +1,31 @@
+/* The per-frame uniform block, filled by alice_upload_frame_data. */
+
+struct DirectionalLight {
+	vec3 direction;
+	float intensity;
+	vec3 color;
+	bool cast_shadows;
+};
+
+layout (std140, binding = 0) uniform FrameData {
+	mat4 camera;
+	vec3 camera_position;
+	float gamma;
+	vec3 ambient_color;
+	float ambient_intensity;
+	uint directional_light_count;
+	uint point_light_count;
+	uint padding0;
+	float bloom_threshold;
+
+	mat4 view;
+	vec2 screen_size;
+	float cluster_near;
+	float cluster_far;
+
+	mat4 shadow_cascades[4];
+	vec4 shadow_splits;
+	uint shadow_cascade_count;
+
+	DirectionalLight directional_lights[100];
+};
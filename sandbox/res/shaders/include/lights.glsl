@@ -0,0 +1,36 @@
+/* Point lights, and the clusters that index them. */
+
+struct PointLight {
+	vec3 position;
+	float range;
+	vec3 color;
+	float intensity;
+
+	int shadow_index;
+};
+
+layout (std430, binding = 1) readonly buffer PointLights {
+	PointLight point_lights[];
+};
+
+/* Must match the grid in lightclusters.h. */
+const uvec3 cluster_grid = uvec3(16, 9, 24);
+
+layout (std430, binding = 4) readonly buffer LightClusters {
+	uvec2 light_clusters[];
+};
+
+layout (std430, binding = 5) readonly buffer LightIndices {
+	uint light_indices[];
+};
+
+/* The point lights that can reach the fragment, as an offset into
+ * light_indices and a count. */
+uvec2 get_light_cluster(float view_depth) {
+	uint slice = uint(max(log(view_depth / cluster_near) / log(cluster_far / cluster_near) * float(cluster_grid.z), 0.0));
+	uvec2 tile = uvec2(max(gl_FragCoord.xy / screen_size * vec2(cluster_grid.xy), vec2(0.0)));
+
+	uvec3 cluster = min(uvec3(tile, slice), cluster_grid - 1);
+
+	return light_clusters[(cluster.z * cluster_grid.y + cluster.y) * cluster_grid.x + cluster.x];
+}
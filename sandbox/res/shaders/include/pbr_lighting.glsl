@@ -0,0 +1,126 @@
+/* Cook-Torrance lighting from point and directional lights. Expects
+ * frame_data.glsl and lights.glsl, and the albedo, metallic, roughness and
+ * world_pos globals to be set before any of it is called. */
+
+#include "shadows.glsl"
+
+#ifdef ALICE_FEATURE_POINT_SHADOWS
+layout (binding = 9) uniform samplerCubeArray point_shadowmap;
+#endif
+
+const float PI = 3.14159265359;
+
+float calculate_directional_shadow(DirectionalLight light, vec3 normal, vec3 light_dir) {
+#ifdef ALICE_FEATURE_SHADOWS
+	if (!light.cast_shadows) { return 1.0; }
+
+	return sample_directional_shadow(world_pos, 8);
+#else
+	return 1.0;
+#endif
+}
+
+float distribution_ggx(vec3 N, vec3 H, float roughness) {
+	float a = roughness * roughness;
+	float a2 = a*a;
+	float NdotH = max(dot(N, H), 0.0);
+	float NdotH2 = NdotH*NdotH;
+
+	float nom   = a2;
+	float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+	denom = PI * denom * denom;
+
+	return nom / max(denom, 0.0000001);
+}
+
+float geometry_schlick_ggx(float NdotV, float roughness) {
+	float r = (roughness + 1.0);
+	float k = (r*r) / 8.0;
+
+	float nom   = NdotV;
+	float denom = NdotV * (1.0 - k) + k;
+
+	return nom / denom;
+}
+
+float geometry_smith(vec3 N, vec3 V, vec3 L, float roughness) {
+	float NdotV = max(dot(N, V), 0.0);
+	float NdotL = max(dot(N, L), 0.0);
+	float ggx2 = geometry_schlick_ggx(NdotV, roughness);
+	float ggx1 = geometry_schlick_ggx(NdotL, roughness);
+
+	return ggx1 * ggx2;
+}
+
+vec3 fresnel_schlick(float cosTheta, vec3 F0) {
+	return F0 + (1.0 - F0) * pow(max(1.0 - cosTheta, 0.0), 5.0);
+}
+
+float calculate_point_shadow(PointLight light) {
+#ifndef ALICE_FEATURE_POINT_SHADOWS
+	return 0.0;
+#else
+	if (light.shadow_index < 0) { return 0.0; }
+
+	vec3 frag_to_light = world_pos - light.position;
+
+	float closest_depth = texture(point_shadowmap, vec4(frag_to_light, float(light.shadow_index))).r;
+
+	closest_depth *= light.range;
+
+	float current_depth = length(frag_to_light);
+
+	float bias = 0.05;
+	float shadow = current_depth - bias > closest_depth ? 1.0 : 0.0;
+
+	return shadow;
+#endif
+}
+
+vec3 calculate_point_light(PointLight light, vec3 N, vec3 V, vec3 F0) {
+	vec3 L = normalize(light.position - world_pos);
+	vec3 H = normalize(V + L);
+	float dist = length(light.position - world_pos);
+	float attenuation = 1.0 / (pow((dist / light.range) * 5.0, 2.0) + 1.0);
+	vec3 radiance = light.color * light.intensity * attenuation * (1.0 - calculate_point_shadow(light));
+
+	float NDF = distribution_ggx(N, H, roughness);
+	float G = geometry_smith(N, V, L, roughness);
+	vec3 F = fresnel_schlick(clamp(dot(H, V), 1.0, 0.0), F0);
+
+	vec3 numerator	= NDF * G * F;
+	float denominator = 4 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0);
+	vec3 specular = numerator / max(denominator, 0.001);
+
+	vec3 kS = F;
+	vec3 kD = vec3(1.0) - kS;
+
+	kD *= 1.0 - metallic;
+
+	float NdotL = max(dot(N, L), 0.0);
+
+	return (kD * albedo / PI + specular) * radiance * NdotL;
+}
+
+vec3 calculate_directional_light(DirectionalLight light, vec3 N, vec3 V, vec3 F0) {
+	vec3 L = normalize(-light.direction);
+	vec3 H = normalize(V + L);
+	vec3 radiance = light.color * light.intensity;
+
+	float NDF = distribution_ggx(N, H, roughness);
+	float G = geometry_smith(N, V, L, roughness);
+	vec3 F = fresnel_schlick(clamp(dot(H, V), 0.0, 1.0), F0);
+
+	vec3 numerator	= NDF * G * F;
+	float denominator = 4 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0);
+	vec3 specular = numerator / max(denominator, 0.001);
+
+	vec3 kS = F;
+	vec3 kD = vec3(1.0) - kS;
+
+	kD *= 1.0 - metallic;
+
+	float NdotL = max(dot(N, L), 0.0);
+
+	return calculate_directional_shadow(light, N, V) * ((kD * albedo / PI + specular) * radiance * NdotL);
+}
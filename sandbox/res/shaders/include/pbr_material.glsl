@@ -0,0 +1,33 @@
+/* The PBR material block and its maps. Expects an fs_in block with the
+ * normal, UV and world position. Which maps the material has is given by
+ * the ALICE_FEATURE_*_MAP defines. */
+
+layout (std140, binding = 2) uniform MaterialData {
+	vec3 albedo;
+	float roughness;
+	float metallic;
+	float emissive;
+} material;
+
+layout (binding = 0) uniform sampler2D albedo_map;
+layout (binding = 1) uniform sampler2D normal_map;
+layout (binding = 2) uniform sampler2D metallic_map;
+layout (binding = 3) uniform sampler2D roughness_map;
+layout (binding = 4) uniform sampler2D ambient_occlusion_map;
+layout (binding = 5) uniform sampler2D emissive_map;
+
+vec3 get_normal_from_map() {
+	vec3 tangent_normal = texture(normal_map, fs_in.uv).xyz * 2.0 - 1.0;
+
+	vec3 Q1  = dFdx(fs_in.world_pos);
+	vec3 Q2  = dFdy(fs_in.world_pos);
+	vec2 st1 = dFdx(fs_in.uv);
+	vec2 st2 = dFdy(fs_in.uv);
+
+	vec3 N   = normalize(fs_in.normal);
+	vec3 T  = normalize(Q1 * st2.t - Q2 * st1.t);
+	vec3 B  = -normalize(cross(N, T));
+	mat3 TBN = mat3(T, B, N);
+
+	return normalize(TBN * tangent_normal);
+}
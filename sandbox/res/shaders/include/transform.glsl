@@ -0,0 +1,24 @@
+/* The model transform. Instanced draws index the instance buffer with the
+ * draw index attribute, anything else sets the transform uniform. */
+
+#ifdef ALICE_FEATURE_INSTANCING
+
+layout (location = 3) in uint draw_index;
+
+layout (std430, binding = 3) readonly buffer InstanceData {
+	mat4 instance_transforms[];
+};
+
+mat4 get_transform() {
+	return instance_transforms[draw_index];
+}
+
+#else
+
+uniform mat4 transform = mat4(1.0);
+
+mat4 get_transform() {
+	return transform;
+}
+
+#endif
@@ -4,11 +4,14 @@
 
 layout (location = 0) in vec3 position;
 
-uniform mat4 camera = mat4(1.0);
-uniform mat4 transform = mat4(1.0);
+layout (std140, binding = 0) uniform FrameData {
+	mat4 camera;
+};
+
+#include "include/transform.glsl"
 
 void main() {
-	gl_Position = camera * transform * vec4(position, 1.0);
+	gl_Position = camera * get_transform() * vec4(position, 1.0);
 }
 
 #end VERTEX
@@ -17,10 +20,12 @@ void main() {
 
 #version 430 core
 
-out vec4 color;
+layout (location = 0) out vec4 color;
+layout (location = 1) out vec4 bright_color;
 
 void main() {
 	color = vec4(1.0, 0.0, 1.0, 1.0);
+	bright_color = vec4(0.0, 0.0, 0.0, 1.0);
 }
 
 #end FRAGMENT
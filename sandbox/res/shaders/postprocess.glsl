@@ -31,11 +31,18 @@ uniform bool use_bloom;
 
 uniform sampler2D input_color;
 uniform sampler2D bloom_texture;
+
+/* The upsampled bloom chain is a sum of its mips. */
+uniform float bloom_scale = 1.0;
 uniform vec3 color_mod = vec3(1.0);
 
 uniform float input_width;
 uniform float input_height;
 
+/* The input size over the output size. Below one, the input is scaled up
+ * and sharpened to make up for the blur of the bilinear filter. */
+uniform float render_scale = 1.0;
+
 uniform float exposure = 1.0;
 uniform float gamma = 2.2;
 
@@ -83,18 +90,36 @@ vec4 get_antialiased_color() {
 	return vec4(result2, 1.0);
 }
 
+vec3 sharpen(vec3 center) {
+	vec3 neighbours =
+		texture(input_color, fs_in.uv + vec2( texel_size.x, 0.0)).rgb +
+		texture(input_color, fs_in.uv + vec2(-texel_size.x, 0.0)).rgb +
+		texture(input_color, fs_in.uv + vec2(0.0,  texel_size.y)).rgb +
+		texture(input_color, fs_in.uv + vec2(0.0, -texel_size.y)).rgb;
+
+	float amount = (1.0 - render_scale) * 0.5;
+
+	return max(center + amount * (center - neighbours * 0.25), vec3(0.0));
+}
+
 void main() {
 	vec3 hdr_color = vec3(0.0);
 	if (use_antialiasing) {
-		hdr_color = color_mod * get_antialiased_color().rgb;
+		hdr_color = get_antialiased_color().rgb;
 	} else {
-		hdr_color = color_mod * texture(input_color, fs_in.uv).rgb;
+		hdr_color = texture(input_color, fs_in.uv).rgb;
+	}
+
+	if (render_scale < 1.0) {
+		hdr_color = sharpen(hdr_color);
 	}
 
+	hdr_color *= color_mod;
+
 	vec3 bloom_color = vec3(0.0);
 
 	if (use_bloom) {
-		bloom_color = texture(bloom_texture, fs_in.uv).rgb;
+		bloom_color = texture(bloom_texture, fs_in.uv).rgb * bloom_scale;
 	}
 
 	hdr_color += bloom_color;
@@ -15,6 +15,15 @@
 #include <alice/scripting.h>
 #include <alice/physics.h>
 #include <alice/debugrenderer.h>
+#include <alice/staticbatch.h>
+#include <alice/renderqueue.h>
+#include <alice/glstate.h>
+#include <alice/occlusion.h>
+#include <alice/framegraph.h>
+#include <alice/nullgl.h>
+#include <alice/softrender.h>
+#include <alice/profiler.h>
+#include <alice/meshsimplify.h>
 
 typedef struct sandbox_t {
 	alice_entity_handle_t selected_entity;
@@ -56,6 +65,52 @@ static void draw_entity_hierarchy(mu_Context* ui, alice_scene_t* scene, alice_en
 	}
 }
 
+/* Draws the profile scopes under `parent', each followed by its children. */
+static void draw_profile_scopes(mu_Context* ui, u32 parent) {
+	alice_profiler_t* profiler = alice_get_profiler();
+
+	for (u32 i = 0; i < profiler->scope_count; i++) {
+		alice_profile_scope_t* scope = &profiler->scopes[i];
+		if (scope->parent != parent) { continue; }
+
+		char name_buf[128];
+		char cpu_buf[64];
+		char gpu_buf[64];
+		char calls_buf[32];
+
+		sprintf(name_buf, "%*s%s", scope->depth * 2, "", scope->name);
+		sprintf(cpu_buf, "%.3f / %.3f", scope->cpu_average, scope->cpu_max);
+		if (scope->gpu_timed) {
+			sprintf(gpu_buf, "%.3f / %.3f", scope->gpu_average, scope->gpu_max);
+		} else {
+			strcpy(gpu_buf, "-");
+		}
+		sprintf(calls_buf, "%g", scope->calls_per_frame);
+
+		mu_label(ui, name_buf);
+		mu_label(ui, cpu_buf);
+		mu_label(ui, gpu_buf);
+		mu_label(ui, calls_buf);
+
+		draw_profile_scopes(ui, i);
+	}
+}
+
+/* Prints the average time a frame spent in each scope under `parent'. */
+static void print_profile_scopes(u32 parent, double frame_count) {
+	alice_profiler_t* profiler = alice_get_profiler();
+
+	for (u32 i = 0; i < profiler->scope_count; i++) {
+		alice_profile_scope_t* scope = &profiler->scopes[i];
+		if (scope->parent != parent) { continue; }
+
+		printf("    %*s%-*s %.4f ms\n", scope->depth * 2, "", 24 - scope->depth * 2, scope->name,
+				scope->cpu_total / frame_count);
+
+		print_profile_scopes(i, frame_count);
+	}
+}
+
 static void draw_scene_hierarchy(mu_Context* ui, alice_scene_t* scene) {
 	assert(ui);
 	assert(scene);
@@ -73,6 +128,8 @@ static void draw_scene_hierarchy(mu_Context* ui, alice_scene_t* scene) {
 
 static void draw_renderable_properties(mu_Context* ui, alice_scene_t* scene, alice_renderable_3d_t* renderable) {
 	mu_checkbox(ui, "Cast shadows", (i32*)&renderable->cast_shadows);
+	mu_checkbox(ui, "Static", (i32*)&renderable->is_static);
+	mu_checkbox(ui, "Occluder", (i32*)&renderable->is_occluder);
 
 	if (renderable->model != alice_null) {
 		for (u32 i = 0; i < renderable->model->mesh_count; i++) {
@@ -118,7 +175,422 @@ static void draw_renderable_properties(mu_Context* ui, alice_scene_t* scene, ali
 	}
 }
 
-void main() {
+/* Writes the software renderer's image as a binary PPM. */
+static void write_software_image(alice_software_renderer_t* renderer, const char* filename) {
+	FILE* file = fopen(filename, "wb");
+	if (!file) {
+		alice_log_error("Failed to open `%s' for writing", filename);
+		return;
+	}
+
+	fprintf(file, "P6\n%u %u\n255\n", renderer->width, renderer->height);
+
+	for (u32 i = 0; i < renderer->width * renderer->height; i++) {
+		fwrite(renderer->pixels + i * 4, 1, 3, file);
+	}
+
+	fclose(file);
+}
+
+/* Runs a scene for a number of frames with no window or GPU, then prints
+ * what the renderer did per frame on average. Physics steps at a fixed
+ * rate, so that runs are comparable. With `software' set, the scene is
+ * drawn by the software renderer at 1080p instead, and the last frame is
+ * written to `output' if there is one. */
+static void run_headless(const char* scene_filename, u32 frame_count, const char* script_lib_name,
+		bool software, const char* output) {
+	alice_scene_t* scene = alice_new_scene(script_lib_name);
+	alice_deserialise_scene(scene, scene_filename);
+
+	alice_init_scripts(scene->script_context);
+
+	if (!scene->renderer) {
+		alice_log_warning("Scene `%s' has no 3D renderer; nothing will be drawn", scene_filename);
+	}
+
+	alice_application_t* app = alice_get_application();
+
+	alice_software_renderer_t* software_renderer = alice_null;
+	if (software) {
+		software_renderer = alice_new_software_renderer(1920, 1080);
+	}
+
+	double frame_time = 0.0;
+	u64 draw_calls = 0, drawn_objects = 0, culled_objects = 0;
+	u64 software_triangles = 0;
+	u64 gl_draw_calls = 0, gl_uniform_calls = 0, gl_buffer_calls = 0, gl_state_calls = 0;
+	u64 uploaded_bytes = 0;
+	u64 lod_objects[ALICE_MAX_MESH_LODS + 1] = { 0 };
+	u64 drawn_triangles = 0;
+
+	/* The first update measures loading, not a frame. */
+	alice_update_application();
+
+	for (u32 i = 0; i < frame_count; i++) {
+		alice_update_events();
+
+		alice_render_clear();
+
+		alice_update_scripts(scene->script_context, 1.0 / 60.0);
+
+		if (scene->physics_engine) {
+			alice_update_physics_engine(scene->physics_engine, 1.0 / 60.0);
+		}
+
+		alice_compute_scene_transforms(scene);
+
+		if (software_renderer) {
+			alice_software_render_scene(software_renderer, scene);
+
+			drawn_objects += software_renderer->drawn_mesh_count;
+			culled_objects += software_renderer->culled_mesh_count;
+			software_triangles += software_renderer->triangle_count;
+		} else if (scene->renderer) {
+			alice_render_scene_3d(scene->renderer, app->width, app->height, scene, alice_null);
+
+			draw_calls += scene->renderer->draw_call_count;
+			drawn_objects += scene->renderer->drawn_object_count;
+			culled_objects += scene->renderer->culled_object_count;
+
+			for (u32 j = 0; j <= ALICE_MAX_MESH_LODS; j++) {
+				lod_objects[j] += scene->renderer->lod_object_counts[j];
+			}
+
+			alice_render_queue_t* queue = scene->renderer->queue;
+			for (u32 j = 0; j < queue->packet_count; j++) {
+				alice_draw_packet_t* packet = &queue->packets[j];
+				drawn_triangles += alice_get_mesh_lod_geometry(packet->mesh, packet->lod)->index_count / 3;
+			}
+		}
+
+		const alice_null_gl_stats_t gl_stats = alice_get_null_gl_stats();
+		gl_draw_calls += gl_stats.draw_calls;
+		gl_uniform_calls += gl_stats.uniform_calls;
+		gl_buffer_calls += gl_stats.buffer_calls;
+		gl_state_calls += gl_stats.state_calls + gl_stats.texture_calls + gl_stats.framebuffer_calls;
+		uploaded_bytes += gl_stats.uploaded_bytes;
+
+		alice_update_application();
+
+		frame_time += app->timestep;
+	}
+
+	const double n = (double)alice_max(frame_count, 1);
+
+	const alice_shader_stats_t shader_stats = alice_get_shader_stats();
+
+	if (software_renderer) {
+		printf("%s: %u frames at %ux%u, software\n", scene_filename, frame_count,
+				software_renderer->width, software_renderer->height);
+		printf("  frame time:         %.4f ms\n", frame_time / n * 1000.0);
+		printf("  shader startup:     %.4f ms, %u shaders\n", shader_stats.time * 1000.0,
+				shader_stats.compiled_count + shader_stats.cached_count);
+		printf("  drawn meshes:       %.1f\n", (double)drawn_objects / n);
+		printf("  culled meshes:      %.1f\n", (double)culled_objects / n);
+		printf("  binned triangles:   %.1f\n", (double)software_triangles / n);
+		printf("  CPU time by scope:\n");
+		print_profile_scopes(ALICE_PROFILER_NO_PARENT, n);
+
+		if (output) {
+			write_software_image(software_renderer, output);
+		}
+
+		alice_free_software_renderer(software_renderer);
+		alice_free_scene(scene);
+		return;
+	}
+
+	printf("%s: %u frames at %ux%u\n", scene_filename, frame_count, app->width, app->height);
+	printf("  frame time:         %.4f ms\n", frame_time / n * 1000.0);
+	printf("  shader startup:     %.4f ms, %u shaders\n", shader_stats.time * 1000.0,
+			shader_stats.compiled_count + shader_stats.cached_count);
+	printf("  renderer draws:     %.1f\n", (double)draw_calls / n);
+	printf("  drawn objects:      %.1f\n", (double)drawn_objects / n);
+	printf("  culled objects:     %.1f\n", (double)culled_objects / n);
+	printf("  objects by LOD:    ");
+	for (u32 i = 0; i <= ALICE_MAX_MESH_LODS; i++) {
+		printf(" %.1f", (double)lod_objects[i] / n);
+	}
+	printf("\n");
+	printf("  drawn triangles:    %.1f\n", (double)drawn_triangles / n);
+	printf("  GL draw calls:      %.1f\n", (double)gl_draw_calls / n);
+	printf("  GL uniform calls:   %.1f\n", (double)gl_uniform_calls / n);
+	printf("  GL buffer calls:    %.1f\n", (double)gl_buffer_calls / n);
+	printf("  GL other calls:     %.1f\n", (double)gl_state_calls / n);
+	printf("  uploaded bytes:     %.0f\n", (double)uploaded_bytes / n);
+	printf("  CPU time by scope:\n");
+	print_profile_scopes(ALICE_PROFILER_NO_PARENT, n);
+
+	alice_free_scene(scene);
+}
+
+/* Bounds for --check-lods. A simplification aimed at a target may stop a
+ * few triangles either side of it, and the measured error of a level may
+ * be up to LOD_CHECK_MAX_PIXELS thresholds on screen at the distance it's
+ * first picked from. The timing is for simplifying the dense sphere by
+ * half, and is loose enough for debug builds. */
+#define LOD_CHECK_MIN_RATIO 0.9f
+#define LOD_CHECK_MAX_RATIO 1.05f
+#define LOD_CHECK_MAX_PIXELS 2.0f
+#define LOD_CHECK_MAX_MS 500.0
+#define LOD_CHECK_SUBDIVISIONS 3
+
+static alice_v3f_t v3f_sub(alice_v3f_t a, alice_v3f_t b) {
+	return (alice_v3f_t) { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+static alice_v3f_t v3f_mad(alice_v3f_t a, alice_v3f_t b, float s) {
+	return (alice_v3f_t) { a.x + b.x * s, a.y + b.y * s, a.z + b.z * s };
+}
+
+/* Real-Time Collision Detection, 5.1.5. */
+static alice_v3f_t closest_point_on_triangle(alice_v3f_t p, alice_v3f_t a, alice_v3f_t b, alice_v3f_t c) {
+	const alice_v3f_t ab = v3f_sub(b, a);
+	const alice_v3f_t ac = v3f_sub(c, a);
+
+	const alice_v3f_t ap = v3f_sub(p, a);
+	const float d1 = alice_v3f_dot(ab, ap);
+	const float d2 = alice_v3f_dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) { return a; }
+
+	const alice_v3f_t bp = v3f_sub(p, b);
+	const float d3 = alice_v3f_dot(ab, bp);
+	const float d4 = alice_v3f_dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3) { return b; }
+
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		return v3f_mad(a, ab, d1 / (d1 - d3));
+	}
+
+	const alice_v3f_t cp = v3f_sub(p, c);
+	const float d5 = alice_v3f_dot(ab, cp);
+	const float d6 = alice_v3f_dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6) { return c; }
+
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		return v3f_mad(a, ac, d2 / (d2 - d6));
+	}
+
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		return v3f_mad(b, v3f_sub(c, b), (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+
+	const float denominator = 1.0f / (va + vb + vc);
+	return v3f_mad(v3f_mad(a, ab, vb * denominator), ac, vc * denominator);
+}
+
+/* How far the simplified surface is from the mesh's own vertices, at the
+ * worst of them. */
+static float measure_lod_error(const alice_mesh_t* mesh, const u32* indices, u32 index_count) {
+	float worst = 0.0f;
+
+	for (u32 i = 0; i < mesh->position_count; i++) {
+		const alice_v3f_t p = mesh->positions[i];
+
+		float nearest = -1.0f;
+		for (u32 j = 0; j < index_count; j += 3) {
+			const alice_v3f_t closest = closest_point_on_triangle(p, mesh->positions[indices[j]],
+					mesh->positions[indices[j + 1]], mesh->positions[indices[j + 2]]);
+
+			const float distance = alice_v3f_dist(p, closest);
+			if (nearest < 0.0f || distance < nearest) {
+				nearest = distance;
+			}
+		}
+
+		worst = alice_max(worst, nearest);
+	}
+
+	return worst;
+}
+
+/* Splits every triangle into four, pushing the new corners out to the
+ * sphere the mesh was made from. */
+static void subdivide_sphere(alice_v3f_t** positions, u32* position_count, u32** indices, u32* index_count,
+		float radius) {
+	const u32 triangle_count = *index_count / 3;
+
+	alice_v3f_t* new_positions = malloc(triangle_count * 6 * sizeof(alice_v3f_t));
+	u32* new_indices = malloc(triangle_count * 12 * sizeof(u32));
+
+	u32 p = 0, n = 0;
+	for (u32 i = 0; i < triangle_count; i++) {
+		const alice_v3f_t a = (*positions)[(*indices)[i * 3 + 0]];
+		const alice_v3f_t b = (*positions)[(*indices)[i * 3 + 1]];
+		const alice_v3f_t c = (*positions)[(*indices)[i * 3 + 2]];
+
+		const alice_v3f_t corners[6] = {
+			a, b, c,
+			(alice_v3f_t) { (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f },
+			(alice_v3f_t) { (b.x + c.x) * 0.5f, (b.y + c.y) * 0.5f, (b.z + c.z) * 0.5f },
+			(alice_v3f_t) { (c.x + a.x) * 0.5f, (c.y + a.y) * 0.5f, (c.z + a.z) * 0.5f }
+		};
+
+		for (u32 j = 0; j < 6; j++) {
+			const alice_v3f_t d = alice_v3f_normalise(corners[j]);
+			new_positions[p + j] = (alice_v3f_t) { d.x * radius, d.y * radius, d.z * radius };
+		}
+
+		const u32 split[12] = { 0, 3, 5, 3, 1, 4, 5, 4, 2, 3, 4, 5 };
+		for (u32 j = 0; j < 12; j++) {
+			new_indices[n++] = p + split[j];
+		}
+
+		p += 6;
+	}
+
+	free(*positions);
+	free(*indices);
+
+	*positions = new_positions;
+	*position_count = p;
+	*indices = new_indices;
+	*index_count = n;
+}
+
+/* --check-lods [model] simplifies a model, the default sphere unless one is
+ * given, and a dense sphere, and fails if the triangle counts reached, the
+ * error on screen or the time taken are out of bounds. */
+static bool run_lod_check(const char* model_path) {
+	bool passed = true;
+
+	alice_model_t* model = alice_load_model(model_path);
+	if (!model || model->mesh_count == 0) {
+		printf("LOD check: failed to load `%s'\n", model_path);
+		return false;
+	}
+
+	/* Levels are picked once their reported error covers the threshold, so
+	 * the measured error there covers measured / reported thresholds. */
+	const float threshold = 1.0f;
+
+	for (u32 m = 0; m < model->mesh_count; m++) {
+		alice_mesh_t* mesh = &model->meshes[m];
+
+		const float budget = alice_v3f_dist(mesh->aabb.min, mesh->aabb.max) * ALICE_MESH_LOD_MAX_ERROR;
+
+		printf("%s, mesh %u: %u triangles, %u levels\n", model_path, m, mesh->index_count / 3, mesh->lod_count);
+
+		if (mesh->index_count / 2 >= ALICE_MESH_LOD_MIN_INDICES && mesh->lod_count == 0) {
+			printf("  FAIL: no levels were generated\n");
+			passed = false;
+		}
+
+		for (u32 l = 0; l < mesh->lod_count; l++) {
+			const alice_mesh_lod_t* lod = &mesh->lods[l];
+
+			const float measured = measure_lod_error(mesh, lod->indices, lod->index_count);
+			const float pixels = lod->error > 0.0f ? threshold * measured / lod->error : 0.0f;
+
+			printf("  level %u: %u triangles, reported error %g, measured %g, %g pixels when picked\n",
+					l + 1, lod->index_count / 3, lod->error, measured, pixels);
+
+			if (lod->error > budget) {
+				printf("  FAIL: reported error is over the budget of %g\n", budget);
+				passed = false;
+			}
+
+			if (lod->error > 0.0f ? pixels > LOD_CHECK_MAX_PIXELS * threshold : measured > 0.0f) {
+				printf("  FAIL: measured error is more than %g pixels when picked\n", LOD_CHECK_MAX_PIXELS);
+				passed = false;
+			}
+		}
+
+		/* Without an error limit, only the target should stop it. */
+		const u32 targets[] = { (mesh->index_count / 6) * 3, (mesh->index_count / 12) * 3 };
+		u32* out = malloc(mesh->index_count * sizeof(u32));
+
+		for (u32 t = 0; t < 2; t++) {
+			if (targets[t] < ALICE_MESH_LOD_MIN_INDICES) { continue; }
+
+			const u32 reached = alice_simplify_mesh(out, mesh->positions, mesh->normals,
+					mesh->position_count, mesh->indices, mesh->index_count, targets[t], 1e30f, alice_null);
+			const float ratio = (float)reached / (float)targets[t];
+
+			printf("  to %u triangles: reached %u, %g of the target\n", targets[t] / 3, reached / 3, ratio);
+
+			if (ratio < LOD_CHECK_MIN_RATIO || ratio > LOD_CHECK_MAX_RATIO) {
+				printf("  FAIL: reached ratio isn't within %g and %g\n", LOD_CHECK_MIN_RATIO, LOD_CHECK_MAX_RATIO);
+				passed = false;
+			}
+		}
+
+		free(out);
+	}
+
+	/* A denser sphere, for timing. */
+	alice_mesh_t* sphere = &alice_load_model("sphere")->meshes[0];
+
+	u32 position_count = sphere->index_count;
+	u32 index_count = sphere->index_count;
+	alice_v3f_t* positions = malloc(position_count * sizeof(alice_v3f_t));
+	u32* indices = malloc(index_count * sizeof(u32));
+	for (u32 i = 0; i < index_count; i++) {
+		positions[i] = sphere->positions[sphere->indices[i]];
+		indices[i] = i;
+	}
+
+	for (u32 i = 0; i < LOD_CHECK_SUBDIVISIONS; i++) {
+		subdivide_sphere(&positions, &position_count, &indices, &index_count, 0.5f);
+	}
+
+	u32* out = malloc(index_count * sizeof(u32));
+
+	const double start = alice_get_time();
+	const u32 reached = alice_simplify_mesh(out, positions, alice_null, position_count,
+			indices, index_count, (index_count / 6) * 3, 1e30f, alice_null);
+	const double ms = (alice_get_time() - start) * 1000.0;
+
+	printf("dense sphere: %u to %u triangles in %.2f ms\n", index_count / 3, reached / 3, ms);
+
+	if (ms > LOD_CHECK_MAX_MS) {
+		printf("  FAIL: took longer than %g ms\n", LOD_CHECK_MAX_MS);
+		passed = false;
+	}
+
+	free(out);
+	free(positions);
+	free(indices);
+
+	printf("LOD check %s\n", passed ? "passed" : "FAILED");
+
+	return passed;
+}
+
+int main(int argc, char** argv) {
+	/* --headless <scene> [frames] runs a scene without a window and
+	 * prints per-frame renderer statistics. Adding --software draws it
+	 * with the software renderer, and --output <file.ppm> saves the last
+	 * frame it drew. --check-lods [model] runs run_lod_check instead. */
+	const char* headless_scene = alice_null;
+	u32 headless_frame_count = 600;
+	bool software = false;
+	const char* software_output = alice_null;
+	const char* lod_check_model = alice_null;
+
+	for (i32 i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+			headless_scene = argv[++i];
+
+			if (i + 1 < argc && argv[i + 1][0] != '-') {
+				headless_frame_count = (u32)atoi(argv[++i]);
+			}
+		} else if (strcmp(argv[i], "--software") == 0) {
+			software = true;
+		} else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+			software_output = argv[++i];
+		} else if (strcmp(argv[i], "--check-lods") == 0) {
+			lod_check_model = "sphere";
+
+			if (i + 1 < argc && argv[i + 1][0] != '-') {
+				lod_check_model = argv[++i];
+			}
+		}
+	}
+
 	alice_init_resource_manager("res");
 	alice_init_application((alice_application_config_t){
 				.name = "sandbox",
@@ -127,6 +599,7 @@ void main() {
 				.width = 1024,
 				.height = 728,
 				.fullscreen = false,
+				.headless = headless_scene != alice_null || lod_check_model != alice_null
 			});
 
 	alice_init_default_resources();
@@ -137,6 +610,24 @@ void main() {
 	const char* script_lib_name = "./libscripts.so";
 #endif
 
+	if (lod_check_model) {
+		const bool passed = run_lod_check(lod_check_model);
+
+		alice_free_application();
+		alice_free_resource_manager();
+
+		return passed ? 0 : 1;
+	}
+
+	if (headless_scene) {
+		run_headless(headless_scene, headless_frame_count, script_lib_name, software, software_output);
+
+		alice_free_application();
+		alice_free_resource_manager();
+
+		return 0;
+	}
+
 	char scene_filename_buffer[256] = "scenes/physicstest.ascn";
 
 	alice_scene_t* scene = alice_new_scene(script_lib_name);
@@ -279,7 +770,6 @@ void main() {
 	alice_serialise_scene(scene, "scenes/physicstest.ascn");
 */
 
-	alice_3d_pick_context_t* pick_context = alice_new_3d_pick_context(alice_load_shader("shaders/pick.glsl"));
 	sandbox.selected_entity = alice_null_entity_handle;
 	sandbox.old_selected = alice_null_entity_handle;
 
@@ -293,6 +783,10 @@ void main() {
 	alice_init_microui_renderer(alice_load_shader("shaders/ui.glsl"),
 			alice_load_font("fonts/opensans.ttf", 14.0f));
 
+	const alice_shader_stats_t shader_stats = alice_get_shader_stats();
+	alice_log("Shaders took %g ms: %u compiled, %u from the cache, %u failed", shader_stats.time * 1000.0,
+			shader_stats.compiled_count, shader_stats.cached_count, shader_stats.failed_count);
+
 	bool fullscreen = false;
 
 	while (alice_is_application_running()) {
@@ -322,7 +816,12 @@ void main() {
 		}
 
 		if (alice_mouse_button_just_released(ALICE_MOUSE_BUTTON_RIGHT)) {
-			sandbox.selected_entity = alice_3d_pick(pick_context, scene);
+			const alice_v2i_t mouse_position = alice_get_mouse_position();
+
+			alice_3d_raycast_result_t pick;
+			alice_3d_pick(scene, (alice_v2f_t) { (float)mouse_position.x, (float)mouse_position.y }, &pick);
+
+			sandbox.selected_entity = pick.entity;
 		}
 
 		if (scene->renderer_2d) {
@@ -426,6 +925,13 @@ void main() {
 			static char ui_draw_call_buf[256] = "UI Draw Calls: 0";
 			static char renderer_3d_draw_call_buf[256] = "Renderer 3D Draw Calls: 0";
 			static char total_draw_call_buf[256] = "Total Draw Calls: 0";
+			static char culling_buf[256] = "Drawn Objects: 0, Culled Objects: 0";
+			static char gl_state_buf[256] = "GL State Calls: 0, Skipped: 0";
+			static char occlusion_buf[256] = "Occlusion Tested: 0, Occluded: 0";
+			static char point_shadow_buf[256] = "Point Shadow Faces Rendered: 0, Reused: 0";
+			static char frame_graph_buf[256] = "Frame Graph Passes: 0, Culled: 0, Targets: 0/0";
+			static char resolution_scale_buf[256] = "Resolution Scale: 1";
+			static char lod_buf[256] = "Objects by LOD: 0";
 			static double time_until_next_fps_print = 1.0;
 
 			time_until_next_fps_print -= app->timestep;
@@ -436,13 +942,43 @@ void main() {
 				sprintf(ui_draw_call_buf, "UI Draw Calls: %d", alice_get_microui_renderer()->draw_call_count);
 				if (scene->renderer) {
 					sprintf(renderer_3d_draw_call_buf, "Renderer 3D Draw Calls: %d", scene->renderer->draw_call_count);
+					sprintf(culling_buf, "Drawn Objects: %d, Culled Objects: %d",
+							scene->renderer->drawn_object_count, scene->renderer->culled_object_count);
+					sprintf(occlusion_buf, "Occlusion Tested: %d, Occluded: %d",
+							scene->renderer->use_occlusion_culling ? scene->renderer->occlusion->tested_count : 0,
+							scene->renderer->occluded_object_count);
+					sprintf(point_shadow_buf, "Point Shadow Faces Rendered: %d, Reused: %d",
+							scene->renderer->point_shadowmap->faces_rendered,
+							scene->renderer->point_shadowmap->faces_reused);
+
+					alice_frame_graph_t* graph = scene->renderer->frame_graph;
+					sprintf(frame_graph_buf, "Frame Graph Passes: %d, Culled: %d, Targets: %d/%d",
+							graph->order_count, graph->culled_pass_count,
+							graph->physical_count, graph->transient_count);
+
+					sprintf(resolution_scale_buf, "Resolution Scale: %g", scene->renderer->resolution_scale);
+
+					const u32* lod_counts = scene->renderer->lod_object_counts;
+					sprintf(lod_buf, "Objects by LOD: %d, %d, %d, %d",
+							lod_counts[0], lod_counts[1], lod_counts[2], lod_counts[3]);
 				}
 				sprintf(total_draw_call_buf, "Total Draw Calls: %d", alice_get_total_draw_calls());
+
+				alice_gl_state_stats_t gl_state_stats = alice_get_gl_state_stats();
+				sprintf(gl_state_buf, "GL State Calls: %d, Skipped: %d",
+						gl_state_stats.issued, gl_state_stats.skipped);
 			}
 
 			mu_label(ui, renderer_3d_draw_call_buf);
 			mu_label(ui, ui_draw_call_buf);
 			mu_label(ui, total_draw_call_buf);
+			mu_label(ui, culling_buf);
+			mu_label(ui, gl_state_buf);
+			mu_label(ui, occlusion_buf);
+			mu_label(ui, point_shadow_buf);
+			mu_label(ui, frame_graph_buf);
+			mu_label(ui, resolution_scale_buf);
+			mu_label(ui, lod_buf);
 
 			mu_label(ui, fps_buf);
 			mu_label(ui, frame_time_buf);
@@ -450,17 +986,34 @@ void main() {
 			if (scene->renderer) {
 				mu_checkbox(ui, "Anti-aliasing", (i32*)&scene->renderer->use_antialiasing);
 				mu_checkbox(ui, "Bloom", (i32*)&scene->renderer->use_bloom);
+				mu_checkbox(ui, "Occlusion culling", (i32*)&scene->renderer->use_occlusion_culling);
+				mu_checkbox(ui, "Deferred shading", (i32*)&scene->renderer->use_deferred);
+				mu_checkbox(ui, "Dynamic resolution", (i32*)&scene->renderer->use_dynamic_resolution);
+				mu_checkbox(ui, "LODs", (i32*)&scene->renderer->use_lods);
 
 				mu_layout_row(ui, 2, (int[]) { -200, -1 }, 0);
 				mu_label(ui, "Bloom threshold");
 				mu_slider_ex(ui, &scene->renderer->bloom_threshold, 0.0f, 16.0f, 0.01f, "%g", 0);
 
-				static float blur_iterations = 10.0f;
-				mu_label(ui, "Bloom blur iterations");
-				if (mu_slider_ex(ui, &blur_iterations,
-							2.0f, 100.0f, 2.0f, "%g", 0) == MU_RES_CHANGE) {
-					scene->renderer->bloom_blur_iterations = blur_iterations;
+				float bloom_mip_count = (float)scene->renderer->bloom_mip_count;
+				mu_label(ui, "Bloom mips");
+				if (mu_slider_ex(ui, &bloom_mip_count,
+							1.0f, (float)ALICE_MAX_BLOOM_MIPS, 1.0f, "%g", 0) == MU_RES_CHANGE) {
+					scene->renderer->bloom_mip_count = (u32)bloom_mip_count;
 				}
+
+				float cascade_count = (float)scene->renderer->shadowmap->cascade_count;
+				mu_label(ui, "Shadow cascades");
+				if (mu_slider_ex(ui, &cascade_count,
+							1.0f, (float)ALICE_MAX_SHADOW_CASCADES, 1.0f, "%g", 0) == MU_RES_CHANGE) {
+					scene->renderer->shadowmap->cascade_count = (u32)cascade_count;
+				}
+
+				mu_label(ui, "Shadow split lambda");
+				mu_slider_ex(ui, &scene->renderer->shadowmap->split_lambda, 0.0f, 1.0f, 0.01f, "%g", 0);
+
+				mu_label(ui, "LOD threshold (pixels)");
+				mu_slider_ex(ui, &scene->renderer->lod_threshold, 0.25f, 16.0f, 0.25f, "%g", 0);
 			}
 
 			mu_layout_row(ui, 2, (int[]) { -200, -1 }, 0);
@@ -482,10 +1035,27 @@ void main() {
 			}
 
 			mu_layout_row(ui, 1, (int[]) { -1 }, 0);
+			if (scene->renderer && mu_button(ui, "Rebuild Static Batches")) {
+				alice_build_static_batches(scene);
+			}
+
 			draw_scene_hierarchy(ui, scene);
 
 			mu_end_window(ui);
 		}
+
+		if (mu_begin_window(ui, "Profiler", mu_rect(420, 10, 460, 300))) {
+			/* Milliseconds a frame, averaged over the last window. */
+			mu_layout_row(ui, 4, (int[]) { 160, 110, 110, -1 }, 0);
+			mu_label(ui, "Scope");
+			mu_label(ui, "CPU avg / max");
+			mu_label(ui, "GPU avg / max");
+			mu_label(ui, "Calls");
+
+			draw_profile_scopes(ui, ALICE_PROFILER_NO_PARENT);
+
+			mu_end_window(ui);
+		}
 		mu_end(ui);
 
 		alice_render_microui(ui, app->width, app->height);
@@ -493,8 +1063,6 @@ void main() {
 		alice_update_application();
 	}
 
-	alice_free_3d_pick_context(pick_context);
-
 	free(ui);
 	alice_deinit_microui_renderer();
 
@@ -502,4 +1070,6 @@ void main() {
 
 	alice_free_application();
 	alice_free_resource_manager();
+
+	return 0;
 }
@@ -12,7 +12,11 @@ typedef struct alice_application_t {
 	double timestep;
 	double last, now;
 
+	/* Null when headless. */
 	GLFWwindow* window;
+
+	bool headless;
+	bool should_quit;
 } alice_application_t;
 
 typedef struct alice_application_config_t {
@@ -22,6 +26,11 @@ typedef struct alice_application_config_t {
 	u32 width;
 	u32 height;
 	bool fullscreen;
+
+	/* Runs without a window or a GL context. The null GL backend is
+	 * loaded in place of the real one, so everything still runs up to
+	 * the point of talking to the GPU. */
+	bool headless;
 } alice_application_config_t;
 
 ALICE_API void alice_init_application(alice_application_config_t cfg);
@@ -45,3 +54,6 @@ ALICE_API void alice_show_mouse();
 ALICE_API i32 alice_random_int(i32 min, i32 max);
 
 ALICE_API double alice_get_timestep();
+
+/* A monotonic clock, in seconds, that works with or without a window. */
+ALICE_API double alice_get_time();
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "alice/core.h"
+#include "alice/maths.h"
+#include "alice/physics.h"
+
+#define ALICE_BVH_NULL_NODE 0xffffffff
+
+/* Leaves store their bounds grown by this much on every side, so that
+ * objects can move a little without the tree changing. */
+#define ALICE_BVH_AABB_MARGIN 0.1f
+
+typedef struct alice_bvh_node_t {
+	alice_aabb_t aabb;
+
+	/* Doubles as the next free node for nodes on the free list. */
+	u32 parent;
+	u32 children[2];
+
+	/* Zero for leaves, -1 for free nodes. */
+	i32 height;
+
+	u32 user_data;
+
+	/* Leaves carry a caller-defined weight, and internal nodes the sum of
+	 * their children's, so that queries can report how much they
+	 * rejected without visiting it. */
+	u32 weight;
+} alice_bvh_node_t;
+
+/* A dynamic AABB tree, kept balanced with tree rotations as leaves are
+ * inserted and removed. Leaves are referred to by the node index returned
+ * from alice_bvh_insert, which stays valid until the leaf is removed. */
+typedef struct alice_bvh_t {
+	alice_bvh_node_t* nodes;
+	u32 node_count;
+	u32 node_capacity;
+
+	u32 root;
+	u32 free_list;
+
+	u32 leaf_count;
+} alice_bvh_t;
+
+/* Called for every leaf a query finds, with the leaf's user data. */
+typedef void (*alice_bvh_query_f)(void* data, u32 user_data);
+
+/* Called for every leaf whose bounds the ray enters before max_distance.
+ * Returns the distance the ray should be clipped to, or max_distance to
+ * carry on unchanged. */
+typedef float (*alice_bvh_ray_f)(void* data, u32 user_data, float max_distance);
+
+ALICE_API alice_bvh_t* alice_new_bvh();
+ALICE_API void alice_free_bvh(alice_bvh_t* bvh);
+
+ALICE_API u32 alice_bvh_insert(alice_bvh_t* bvh, alice_aabb_t aabb, u32 user_data, u32 weight);
+ALICE_API void alice_bvh_remove(alice_bvh_t* bvh, u32 leaf);
+
+/* Does nothing while `aabb' is inside the leaf's fattened bounds. Once it
+ * leaves them, the leaf is reinserted, or, with `defer_refit', its bounds
+ * are replaced in place and its ancestors are left for alice_bvh_refit.
+ * Returns true if the leaf's bounds changed. */
+ALICE_API bool alice_bvh_move(alice_bvh_t* bvh, u32 leaf, alice_aabb_t aabb, bool defer_refit);
+
+/* Recomputes the bounds of every internal node from its children. */
+ALICE_API void alice_bvh_refit(alice_bvh_t* bvh);
+
+ALICE_API void alice_bvh_set_weight(alice_bvh_t* bvh, u32 leaf, u32 weight);
+ALICE_API void alice_bvh_set_user_data(alice_bvh_t* bvh, u32 leaf, u32 user_data);
+
+/* Bounds of every leaf in the tree. Returns false if the tree is empty. */
+ALICE_API bool alice_bvh_get_bounds(const alice_bvh_t* bvh, alice_aabb_t* bounds);
+
+/* Each query returns the total weight of the leaves it rejected. */
+ALICE_API u32 alice_bvh_query_frustum(const alice_bvh_t* bvh, const alice_frustum_t* frustum,
+		alice_bvh_query_f callback, void* data);
+ALICE_API u32 alice_bvh_query_sphere(const alice_bvh_t* bvh, alice_v3f_t center, float radius,
+		alice_bvh_query_f callback, void* data);
+ALICE_API u32 alice_bvh_query_aabb(const alice_bvh_t* bvh, alice_aabb_t aabb,
+		alice_bvh_query_f callback, void* data);
+
+/* Visits the leaves along a ray, letting the callback shorten the ray as
+ * it finds hits so that nodes beyond the nearest hit are skipped. */
+ALICE_API void alice_bvh_query_ray(const alice_bvh_t* bvh, alice_v3f_t origin, alice_v3f_t direction,
+		float max_distance, alice_bvh_ray_f callback, void* data);
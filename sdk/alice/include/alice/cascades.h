@@ -0,0 +1,47 @@
+#pragma once
+
+#include "alice/core.h"
+#include "alice/maths.h"
+#include "alice/physics.h"
+
+/* Cascaded shadow maps for a directional light. The camera frustum is
+ * split in depth and each slice gets its own orthographic projection
+ * into one layer of the shadow map array. The shaders pick the cascade
+ * using the same split distances, so the maximum has to match theirs. */
+#define ALICE_MAX_SHADOW_CASCADES 4
+
+typedef struct alice_shadow_cascade_t {
+	/* Light projection multiplied by light view. */
+	alice_m4f_t matrix;
+
+	/* View-space distances bounding the slice of the camera frustum. */
+	float near;
+	float far;
+
+	/* The world-space sphere around the slice that the projection covers. */
+	alice_v3f_t center;
+	float radius;
+} alice_shadow_cascade_t;
+
+typedef struct alice_shadow_cascades_t {
+	alice_shadow_cascade_t cascades[ALICE_MAX_SHADOW_CASCADES];
+	u32 count;
+
+	alice_m4f_t light_view;
+} alice_shadow_cascades_t;
+
+/* Returns where the camera frustum is split for `index' of `count'
+ * cascades, blending logarithmic and uniform splits by `lambda' (the
+ * practical split scheme). Index 0 is `near' and `count' is `far'. */
+ALICE_API float alice_shadow_cascade_split(u32 index, u32 count, float lambda, float near, float far);
+
+/* Fits `count' cascades to a camera with the given view matrix, vertical
+ * field of view in degrees, aspect ratio and clip planes. Each cascade
+ * projects a sphere around its frustum slice, so its size doesn't change
+ * as the camera turns, and is snapped to whole texels of a `resolution'
+ * square map, so shadow edges don't crawl as the camera moves. The
+ * depth range is stretched to `casters' (in world space) so that casters
+ * between the light and the slice still land in the map. */
+ALICE_API void alice_fit_shadow_cascades(alice_shadow_cascades_t* cascades, u32 count, float lambda,
+		alice_m4f_t camera_view, float fov, float aspect, float near, float far,
+		alice_v3f_t light_direction, alice_aabb_t casters, u32 resolution);
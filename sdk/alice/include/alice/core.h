@@ -51,6 +51,10 @@
 	#endif
 #endif
 
+#if !defined(ALICE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+	#define ALICE_SIMD_SSE
+#endif
+
 #define alice_null 0x0
 
 #define alice_grow_capacity(c_) \
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "alice/core.h"
+
+/* Picks the scale the 3D scene is rendered at from measured frame times.
+ * Each update smooths the new frame time into a running average and
+ * compares it to the budget. Above `upper_threshold' of the budget the
+ * scale drops straight to where the average says it would fit; below
+ * `lower_threshold' it climbs back one step at a time. Between the two
+ * it holds, and after any change it waits `cooldown_frames' for the
+ * average to catch up, so it doesn't oscillate.
+ *
+ * Scales are kept to multiples of `step', so that only a handful of
+ * target sizes ever get allocated. The controller only ever looks at the
+ * frame times it is given, so a recorded trace always produces the same
+ * scales. */
+typedef struct alice_resolution_controller_t {
+	double target_frame_time;
+
+	float min_scale;
+	float max_scale;
+	float step;
+
+	/* How much of each new frame time goes into the average. */
+	float smoothing;
+
+	float lower_threshold;
+	float upper_threshold;
+	u32 cooldown_frames;
+
+	double average_frame_time;
+	float scale;
+	u32 frames_since_change;
+	bool has_average;
+} alice_resolution_controller_t;
+
+/* Sets up a controller for the given budget, in seconds, with defaults
+ * for everything else and a full scale. */
+ALICE_API void alice_init_resolution_controller(alice_resolution_controller_t* controller,
+		double target_frame_time);
+
+/* Forgets the average and goes back to full scale. */
+ALICE_API void alice_reset_resolution_controller(alice_resolution_controller_t* controller);
+
+/* Takes the time the last frame took and returns the scale to draw the
+ * next one at. */
+ALICE_API float alice_update_resolution_controller(alice_resolution_controller_t* controller,
+		double frame_time);
+
+/* Scales one side of the screen, never returning less than one pixel. */
+ALICE_API u32 alice_scale_resolution(u32 size, float scale);
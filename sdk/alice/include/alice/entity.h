@@ -10,6 +10,7 @@ typedef struct alice_script_context_t alice_script_context_t;
 typedef struct alice_scene_renderer_3d_t alice_scene_renderer_3d_t;
 typedef struct alice_scene_renderer_2d_t alice_scene_renderer_2d_t;
 typedef struct alice_physics_engine_t alice_physics_engine_t;
+typedef struct alice_bvh_t alice_bvh_t;
 
 typedef u64 alice_entity_handle_t;
 
@@ -82,6 +83,10 @@ struct alice_scene_t {
 	alice_scene_renderer_3d_t* renderer;
 	alice_scene_renderer_2d_t* renderer_2d;
 	alice_physics_engine_t* physics_engine;
+
+	/* World bounds of every renderable with a model, kept up to date by
+	 * alice_update_renderable_3d_bounds. */
+	alice_bvh_t* bvh;
 };
 
 #define alice_register_entity_type(s_, t_) \
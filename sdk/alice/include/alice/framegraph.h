@@ -0,0 +1,133 @@
+#pragma once
+
+#include "alice/core.h"
+#include "alice/graphics.h"
+
+/* A small frame graph. Each frame, passes are declared in the order they
+ * should run, along with the render targets they read and write. Compiling
+ * the graph culls the passes whose results nothing reads, works out how
+ * long each target lives, and lets transient targets with the same
+ * description share one pooled render target when their lifetimes don't
+ * overlap. Compilation doesn't touch GL; only execution does.
+ *
+ * Transient targets come from a pool kept across frames and keyed by
+ * their description, so changing size allocates new targets rather than
+ * resizing the old ones every frame. Targets left unused for a few frames
+ * are freed. */
+
+#define ALICE_FRAME_GRAPH_MAX_PASS_RESOURCES 8
+#define ALICE_FRAME_GRAPH_POOL_FRAMES 4
+
+typedef struct alice_frame_graph_t alice_frame_graph_t;
+
+typedef void (*alice_frame_graph_execute_f)(alice_frame_graph_t* graph, void* data);
+
+/* Every attachment is RGBA16F, so the attachment count stands in for the
+ * format. */
+typedef struct alice_frame_graph_target_desc_t {
+	u32 width;
+	u32 height;
+	u32 attachment_count;
+} alice_frame_graph_target_desc_t;
+
+typedef struct alice_frame_graph_resource_t {
+	const char* name;
+	alice_frame_graph_target_desc_t desc;
+
+	/* Imported targets belong to someone else and aren't pooled. A null
+	 * imported target is the default framebuffer. */
+	bool imported;
+	alice_render_target_t* target;
+
+	/* Keeps the passes that write this from being culled. */
+	bool is_output;
+
+	/* Set by compilation. Uses are indices into the compiled order. */
+	bool used;
+	u32 first_use;
+	u32 last_use;
+	u32 physical;
+} alice_frame_graph_resource_t;
+
+typedef struct alice_frame_graph_pass_t {
+	const char* name;
+
+	alice_frame_graph_execute_f execute;
+	void* data;
+
+	u32 reads[ALICE_FRAME_GRAPH_MAX_PASS_RESOURCES];
+	u32 read_count;
+
+	u32 writes[ALICE_FRAME_GRAPH_MAX_PASS_RESOURCES];
+	u32 write_count;
+
+	bool culled;
+} alice_frame_graph_pass_t;
+
+/* A render target that one or more transient resources are placed in. */
+typedef struct alice_frame_graph_physical_t {
+	alice_frame_graph_target_desc_t desc;
+	u32 last_use;
+
+	u32 pool_index;
+} alice_frame_graph_physical_t;
+
+typedef struct alice_frame_graph_pool_entry_t {
+	alice_frame_graph_target_desc_t desc;
+	alice_render_target_t* target;
+
+	bool taken;
+	u32 unused_frames;
+} alice_frame_graph_pool_entry_t;
+
+struct alice_frame_graph_t {
+	alice_frame_graph_pass_t* passes;
+	u32 pass_count;
+	u32 pass_capacity;
+
+	alice_frame_graph_resource_t* resources;
+	u32 resource_count;
+	u32 resource_capacity;
+
+	/* Indices of the passes left after culling, in execution order. */
+	u32* order;
+	u32 order_count;
+	u32 order_capacity;
+
+	alice_frame_graph_physical_t* physicals;
+	u32 physical_count;
+	u32 physical_capacity;
+
+	alice_frame_graph_pool_entry_t* pool;
+	u32 pool_count;
+	u32 pool_capacity;
+
+	u32 culled_pass_count;
+	u32 transient_count;
+};
+
+ALICE_API alice_frame_graph_t* alice_new_frame_graph();
+ALICE_API void alice_free_frame_graph(alice_frame_graph_t* graph);
+
+/* Forgets last frame's passes and resources. Pooled targets are kept. */
+ALICE_API void alice_begin_frame_graph(alice_frame_graph_t* graph);
+
+ALICE_API u32 alice_frame_graph_create_target(alice_frame_graph_t* graph, const char* name,
+		alice_frame_graph_target_desc_t desc);
+ALICE_API u32 alice_frame_graph_import_target(alice_frame_graph_t* graph, const char* name,
+		alice_render_target_t* target);
+ALICE_API void alice_frame_graph_mark_output(alice_frame_graph_t* graph, u32 resource);
+
+ALICE_API u32 alice_frame_graph_add_pass(alice_frame_graph_t* graph, const char* name,
+		alice_frame_graph_execute_f execute, void* data);
+ALICE_API void alice_frame_graph_read(alice_frame_graph_t* graph, u32 pass, u32 resource);
+ALICE_API void alice_frame_graph_write(alice_frame_graph_t* graph, u32 pass, u32 resource);
+
+ALICE_API void alice_compile_frame_graph(alice_frame_graph_t* graph);
+
+/* Takes render targets from the pool for the transient resources and runs
+ * the passes left after culling. */
+ALICE_API void alice_execute_frame_graph(alice_frame_graph_t* graph);
+
+/* For use by passes while the graph is executing. */
+ALICE_API alice_render_target_t* alice_frame_graph_get_target(alice_frame_graph_t* graph, u32 resource);
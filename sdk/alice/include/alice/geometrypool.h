@@ -0,0 +1,102 @@
+#pragma once
+
+#include "alice/core.h"
+
+/* Every pooled mesh shares one vertex layout:
+ * vec3 position, vec3 normal, vec2 uv. */
+#define ALICE_GEOMETRY_VERTEX_STRIDE 8
+
+/* Per-instance attribute holding the index of the instance's transform in
+ * the instance buffer. It's read from an identity buffer with a divisor of
+ * one, so it evaluates to baseInstance + gl_InstanceID. */
+#define ALICE_GEOMETRY_DRAW_INDEX_ATTRIBUTE 3
+
+typedef struct alice_range_t {
+	u32 offset;
+	u32 count;
+} alice_range_t;
+
+/* First-fit allocator over [0, capacity). Free ranges are kept sorted by
+ * offset and are coalesced when freed. It only does the book keeping, so
+ * it can be used to manage any linear resource. */
+typedef struct alice_range_allocator_t {
+	alice_range_t* free_ranges;
+	u32 free_count;
+	u32 free_capacity;
+
+	u32 capacity;
+	u32 used;
+} alice_range_allocator_t;
+
+ALICE_API void alice_init_range_allocator(alice_range_allocator_t* allocator, u32 capacity);
+ALICE_API void alice_deinit_range_allocator(alice_range_allocator_t* allocator);
+ALICE_API bool alice_range_allocate(alice_range_allocator_t* allocator, u32 count, u32* offset);
+ALICE_API void alice_range_free(alice_range_allocator_t* allocator, u32 offset, u32 count);
+ALICE_API void alice_range_allocator_grow(alice_range_allocator_t* allocator, u32 capacity);
+
+/* A mesh's slice of the geometry pool. Indices are relative to
+ * base_vertex. */
+typedef struct alice_geometry_t {
+	u32 base_vertex;
+	u32 vertex_count;
+
+	u32 first_index;
+	u32 index_count;
+} alice_geometry_t;
+
+/* Laid out to match GL's DrawElementsIndirectCommand. */
+typedef struct alice_draw_command_t {
+	u32 count;
+	u32 instance_count;
+	u32 first_index;
+	i32 base_vertex;
+	u32 base_instance;
+} alice_draw_command_t;
+
+/* Shared vertex, index and draw index buffers behind a single vertex
+ * array, so that any pooled mesh can be drawn without rebinding. */
+typedef struct alice_geometry_pool_t {
+	u32 va_id;
+	u32 vb_id;
+	u32 ib_id;
+	u32 draw_index_id;
+
+	alice_range_allocator_t vertices;
+	alice_range_allocator_t indices;
+
+	u32 draw_index_capacity;
+} alice_geometry_pool_t;
+
+/* The pool is created the first time it's requested, which has to be
+ * after the GL context is made. */
+ALICE_API alice_geometry_pool_t* alice_get_geometry_pool();
+ALICE_API void alice_free_geometry_pool();
+
+ALICE_API alice_geometry_t alice_geometry_pool_add(alice_geometry_pool_t* pool,
+		float* vertices, u32 vertex_count, u32* indices, u32 index_count);
+ALICE_API void alice_geometry_pool_remove(alice_geometry_pool_t* pool, alice_geometry_t* geometry);
+
+/* Adds another index list over an existing geometry's vertices, for
+ * example a simplified version of it. The result shares the vertices, so
+ * it must be removed with alice_geometry_pool_remove_indices before they
+ * are. */
+ALICE_API alice_geometry_t alice_geometry_pool_add_indices(alice_geometry_pool_t* pool,
+		const alice_geometry_t* geometry, u32* indices, u32 index_count);
+ALICE_API void alice_geometry_pool_remove_indices(alice_geometry_pool_t* pool, alice_geometry_t* geometry);
+
+/* Reads a mesh's vertices and indices back from the pool. `vertices' must
+ * hold vertex_count * ALICE_GEOMETRY_VERTEX_STRIDE floats and `indices'
+ * index_count indices. */
+ALICE_API void alice_geometry_pool_read(alice_geometry_pool_t* pool, alice_geometry_t* geometry,
+		float* vertices, u32* indices);
+
+ALICE_API void alice_bind_geometry_pool(alice_geometry_pool_t* pool);
+
+/* Makes sure draw indices [0, count) can be addressed by baseInstance. */
+ALICE_API void alice_geometry_pool_reserve_draw_indices(alice_geometry_pool_t* pool, u32 count);
+
+/* Both expect the pool to be bound. The indirect variant reads
+ * `command_count' alice_draw_command_t's, starting at `first_command', from
+ * the bound indirect buffer. */
+ALICE_API void alice_draw_geometry(alice_geometry_t* geometry);
+ALICE_API void alice_draw_geometry_indirect(u32 first_command, u32 command_count);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "alice/core.h"
+
+/* Texture bindings are cached for this many units; binds to higher units
+ * are passed straight through. */
+#define ALICE_GL_MAX_TEXTURE_UNITS 32
+
+/* The GL entry points that the state cache forwards to. The default table
+ * calls into GL; a different table can be installed with
+ * alice_set_gl_functions to check the cache's behaviour without a
+ * context. */
+typedef struct alice_gl_functions_t {
+	void (*use_program)(u32 program);
+	void (*bind_vertex_array)(u32 array);
+	void (*active_texture)(u32 unit);
+	void (*bind_texture)(u32 target, u32 texture);
+	void (*bind_framebuffer)(u32 target, u32 framebuffer);
+	void (*enable)(u32 capability);
+	void (*disable)(u32 capability);
+	bool (*is_enabled)(u32 capability);
+	void (*depth_mask)(bool write);
+	void (*blend_func)(u32 source, u32 destination);
+	void (*cull_face)(u32 mode);
+	void (*viewport)(i32 x, i32 y, i32 width, i32 height);
+} alice_gl_functions_t;
+
+typedef struct alice_gl_state_stats_t {
+	u32 issued;
+	u32 skipped;
+} alice_gl_state_stats_t;
+
+/* Passing null installs the default table, which alice_init_application
+ * does once the context exists. Either way the cached state is
+ * invalidated. */
+ALICE_API void alice_set_gl_functions(const alice_gl_functions_t* functions);
+
+/* Forgets everything the cache knows, so that the next call of each kind
+ * is issued. Needed after anything outside the engine changes GL state. */
+ALICE_API void alice_invalidate_gl_state();
+
+ALICE_API alice_gl_state_stats_t alice_get_gl_state_stats();
+ALICE_API void alice_reset_gl_state_stats();
+
+ALICE_API void alice_gl_use_program(u32 program);
+ALICE_API void alice_gl_bind_vertex_array(u32 array);
+ALICE_API void alice_gl_bind_texture(u32 unit, u32 target, u32 texture);
+/* Binds both the read and draw framebuffers. The other two bind one each,
+ * for blits. */
+ALICE_API void alice_gl_bind_framebuffer(u32 framebuffer);
+ALICE_API void alice_gl_bind_read_framebuffer(u32 framebuffer);
+ALICE_API void alice_gl_bind_draw_framebuffer(u32 framebuffer);
+ALICE_API void alice_gl_set_capability(u32 capability, bool enabled);
+ALICE_API bool alice_gl_is_enabled(u32 capability);
+ALICE_API void alice_gl_depth_mask(bool write);
+ALICE_API void alice_gl_blend_func(u32 source, u32 destination);
+ALICE_API void alice_gl_cull_face(u32 mode);
+ALICE_API void alice_gl_viewport(i32 x, i32 y, i32 width, i32 height);
+
+/* GL unbinds objects that are deleted while bound, and may hand their
+ * names out again. These keep the cache from treating a new object with
+ * a recycled name as already bound. */
+ALICE_API void alice_gl_forget_program(u32 program);
+ALICE_API void alice_gl_forget_vertex_array(u32 array);
+ALICE_API void alice_gl_forget_texture(u32 texture);
+ALICE_API void alice_gl_forget_framebuffer(u32 framebuffer);
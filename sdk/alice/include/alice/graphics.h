@@ -5,8 +5,18 @@
 #include "alice/resource.h"
 #include "alice/entity.h"
 #include "alice/physics.h"
+#include "alice/geometrypool.h"
+#include "alice/cascades.h"
+#include "alice/dynamicresolution.h"
+#include "alice/shaderpreprocessor.h"
 
 typedef struct alice_debug_renderer_t alice_debug_renderer_t;
+typedef struct alice_render_queue_t alice_render_queue_t;
+typedef struct alice_command_lists_t alice_command_lists_t;
+typedef struct alice_occlusion_buffer_t alice_occlusion_buffer_t;
+typedef struct alice_light_clusters_t alice_light_clusters_t;
+typedef struct alice_static_chunk_t alice_static_chunk_t;
+typedef struct alice_frame_graph_t alice_frame_graph_t;
 
 typedef struct alice_rgb_color_t {
 	float r, g, b;
@@ -25,15 +35,108 @@ typedef u32 alice_color_t;
 ALICE_API alice_color_t alice_color_from_rgb_color(alice_rgb_color_t rgb);
 ALICE_API alice_rgb_color_t alice_rgb_color_from_color(alice_color_t color);
 
+/* A uniform location, resolved once and reused for every draw. Invalid
+ * or inactive uniforms are -1, which GL silently ignores. */
+typedef i32 alice_uniform_t;
+
+/* The name is kept so that two uniforms whose names hash the same can
+ * still be told apart; both are marked `ambiguous'. */
+typedef struct alice_shader_uniform_t {
+	char* name;
+	u32 hash;
+	alice_uniform_t location;
+
+	bool occupied;
+	bool ambiguous;
+} alice_shader_uniform_t;
+
+/* Features a shader can be compiled with, each as a define named
+ * ALICE_FEATURE_ and the name below. Shaders test for them with #ifdef
+ * instead of branching on uniforms, so each combination of features is a
+ * separate program, or variant, of the shader. */
+typedef enum alice_shader_feature_t {
+	ALICE_SHADER_FEATURE_ALBEDO_MAP = 1 << 0,
+	ALICE_SHADER_FEATURE_NORMAL_MAP = 1 << 1,
+	ALICE_SHADER_FEATURE_METALLIC_MAP = 1 << 2,
+	ALICE_SHADER_FEATURE_ROUGHNESS_MAP = 1 << 3,
+	ALICE_SHADER_FEATURE_AMBIENT_OCCLUSION_MAP = 1 << 4,
+	ALICE_SHADER_FEATURE_EMISSIVE_MAP = 1 << 5,
+	ALICE_SHADER_FEATURE_DIFFUSE_MAP = 1 << 6,
+	ALICE_SHADER_FEATURE_SHADOWS = 1 << 7,
+	ALICE_SHADER_FEATURE_POINT_SHADOWS = 1 << 8,
+	ALICE_SHADER_FEATURE_INSTANCING = 1 << 9
+} alice_shader_feature_t;
+
+#define ALICE_SHADER_FEATURE_COUNT 10
+
+typedef struct alice_shader_variant_t {
+	u32 features;
+	struct alice_shader_t* shader;
+} alice_shader_variant_t;
+
 typedef struct alice_shader_t {
 	u32 id;
 
 	bool panic_mode;
+
+	/* Active uniforms, keyed by the hash of their name. Filled once
+	 * when the program is linked. */
+	alice_shader_uniform_t* uniforms;
+	u32 uniform_count;
+	u32 uniform_capacity;
+
+	/* The files the shader was made from, its own first, and when they
+	 * were last modified, so that changing an include reloads it. */
+	alice_shader_dependency_t* dependencies;
+	u32 dependency_count;
+
+	/* The source and path, kept for compiling variants. Both are null in
+	 * the variants themselves. */
+	char* source;
+	char* path;
+
+	/* The features whose defines the source mentions. Variants only
+	 * differ in these, so a shader that mentions none has no variants. */
+	u32 features;
+
+	/* Compiled when first asked for, by alice_get_shader_variant. The
+	 * shader itself is the variant without any features. */
+	alice_shader_variant_t* variants;
+	u32 variant_count;
+	u32 variant_capacity;
+
+	/* Unique to each initialisation, so that anything holding on to a
+	 * variant can tell when a reload has freed it. */
+	u32 generation;
 } alice_shader_t;
 
+/* Totals over every shader initialised so far, for reporting how long
+ * startup spent on them. */
+typedef struct alice_shader_stats_t {
+	u32 compiled_count;
+	u32 cached_count;
+	u32 failed_count;
+
+	/* In seconds, including preprocessing. */
+	double time;
+} alice_shader_stats_t;
+
 ALICE_API alice_shader_t* alice_init_shader(alice_shader_t* shader, char* source);
+
+/* Preprocesses the source, as alice_preprocess_shader does, with its
+ * includes relative to `path', which may be null, and compiles it, or
+ * loads it from the program binary cache. */
+ALICE_API alice_shader_t* alice_init_shader_ex(alice_shader_t* shader, const char* source, const char* path,
+		const alice_shader_define_t* defines, u32 define_count);
 ALICE_API void alice_deinit_shader(alice_shader_t* shader);
 
+/* Returns the variant of the shader with the given features, compiling it
+ * if it hasn't been yet. Features the shader doesn't mention are ignored.
+ * The variant belongs to the shader and is freed with it. */
+ALICE_API alice_shader_t* alice_get_shader_variant(alice_shader_t* shader, u32 features);
+
+ALICE_API alice_shader_stats_t alice_get_shader_stats();
+
 ALICE_API alice_shader_t* alice_new_shader(alice_resource_t* resource);
 ALICE_API void alice_free_shader(alice_shader_t* shader);
 
@@ -54,6 +157,21 @@ ALICE_API void alice_shader_set_v4u(alice_shader_t* shader, const char* name, al
 ALICE_API void alice_shader_set_v4f(alice_shader_t* shader, const char* name, alice_v4f_t v);
 ALICE_API void alice_shader_set_m4f(alice_shader_t* shader, const char* name, alice_m4f_t v);
 
+ALICE_API alice_uniform_t alice_shader_get_uniform(alice_shader_t* shader, const char* name);
+/* The hash alone can't tell uniforms whose names collide apart, so for
+ * those this returns -1 and logs a warning; look them up by name instead. */
+ALICE_API alice_uniform_t alice_shader_get_uniform_hashed(alice_shader_t* shader, u32 name_hash);
+
+/* Handle-based setters. These act on the currently bound shader. */
+ALICE_API void alice_uniform_set_int(alice_uniform_t uniform, i32 v);
+ALICE_API void alice_uniform_set_uint(alice_uniform_t uniform, u32 v);
+ALICE_API void alice_uniform_set_float(alice_uniform_t uniform, float v);
+ALICE_API void alice_uniform_set_color(alice_uniform_t uniform, alice_color_t color);
+ALICE_API void alice_uniform_set_v2f(alice_uniform_t uniform, alice_v2f_t v);
+ALICE_API void alice_uniform_set_v3f(alice_uniform_t uniform, alice_v3f_t v);
+ALICE_API void alice_uniform_set_v4f(alice_uniform_t uniform, alice_v4f_t v);
+ALICE_API void alice_uniform_set_m4f(alice_uniform_t uniform, alice_m4f_t v);
+
 typedef enum alice_vertex_buffer_flags_t {
 	ALICE_VERTEXBUFFER_STATIC_DRAW = 1 << 0,
 	ALICE_VERTEXBUFFER_DYNAMIC_DRAW = 1 << 1,
@@ -83,6 +201,29 @@ ALICE_API void alice_configure_vertex_buffer(alice_vertex_buffer_t* buffer, u32
 	u32 stride, u32 offset);
 ALICE_API void alice_draw_vertex_buffer(alice_vertex_buffer_t* buffer);
 ALICE_API void alice_draw_vertex_buffer_custom_count(alice_vertex_buffer_t* buffer, u32 count);
+ALICE_API void alice_draw_vertex_buffer_instanced(alice_vertex_buffer_t* buffer, u32 instance_count);
+
+typedef enum alice_gpu_buffer_type_t {
+	ALICE_GPU_BUFFER_UNIFORM,
+	ALICE_GPU_BUFFER_STORAGE,
+	ALICE_GPU_BUFFER_INDIRECT
+} alice_gpu_buffer_type_t;
+
+/* A uniform, shader storage or indirect command buffer. Indirect buffers
+ * have no indexed binding points, so binding one ignores `binding'. */
+typedef struct alice_gpu_buffer_t {
+	u32 id;
+
+	alice_gpu_buffer_type_t type;
+
+	u32 size;
+	u32 capacity;
+} alice_gpu_buffer_t;
+
+ALICE_API alice_gpu_buffer_t* alice_new_gpu_buffer(alice_gpu_buffer_type_t type, u32 capacity);
+ALICE_API void alice_free_gpu_buffer(alice_gpu_buffer_t* buffer);
+ALICE_API void alice_update_gpu_buffer(alice_gpu_buffer_t* buffer, const void* data, u32 size);
+ALICE_API void alice_bind_gpu_buffer(alice_gpu_buffer_t* buffer, u32 binding);
 
 ALICE_API u32 alice_get_total_draw_calls();
 
@@ -139,17 +280,66 @@ ALICE_API void alice_unbind_render_target(alice_render_target_t* target);
 ALICE_API void alice_resize_render_target(alice_render_target_t* target, u32 width, u32 height);
 ALICE_API void alice_render_target_bind_output(alice_render_target_t* rt, u32 attachment_index, u32 unit);
 
+/* The number of simplified levels a mesh can have, past the mesh itself.
+ * Each has about half the triangles of the one before it. */
+#define ALICE_MAX_MESH_LODS 3
+
+/* LOD chains stop once a level would keep more than ALICE_MESH_LOD_MAX_KEPT
+ * of the indices of the one before it, or would have fewer than
+ * ALICE_MESH_LOD_MIN_INDICES. */
+#define ALICE_MESH_LOD_MIN_INDICES (32 * 3)
+#define ALICE_MESH_LOD_MAX_KEPT 0.8f
+
+/* The furthest a mesh's last LOD may move from it, as a fraction of the
+ * diagonal of its bounds. */
+#define ALICE_MESH_LOD_MAX_ERROR 0.05f
+
+typedef struct alice_mesh_lod_t {
+	/* Shares the mesh's vertices, and only has indices of its own. */
+	alice_geometry_t geometry;
+
+	u32* indices;
+	u32 index_count;
+
+	/* How far, in model space, the surface may have moved from the full
+	 * mesh's. */
+	float error;
+} alice_mesh_lod_t;
+
 typedef struct alice_mesh_t {
 	alice_m4f_t transform;
 
-	alice_vertex_buffer_t* vb;
+	alice_geometry_t geometry;
 
 	alice_aabb_t aabb;
+
+	/* A copy of the positions, normals and indices kept on the CPU, for
+	 * occlusion culling, picking and the software renderer. There is one
+	 * normal for each position. */
+	alice_v3f_t* positions;
+	alice_v3f_t* normals;
+	u32 position_count;
+	u32* indices;
+	u32 index_count;
+
+	/* Level 0 is the mesh itself, and level l above that is lods[l - 1]. */
+	alice_mesh_lod_t lods[ALICE_MAX_MESH_LODS];
+	u32 lod_count;
 } alice_mesh_t;
 
-ALICE_API void alice_init_mesh(alice_mesh_t* mesh, alice_vertex_buffer_t* vb);
+/* `vertices' is in the geometry pool's layout, and `vertex_count' is the
+ * number of floats in it, as with alice_push_vertices. */
+ALICE_API void alice_init_mesh(alice_mesh_t* mesh, float* vertices, u32 vertex_count,
+		u32* indices, u32 index_count);
 ALICE_API void alice_deinit_mesh(alice_mesh_t* mesh);
 
+/* Simplifies the mesh into its LODs on the CPU. It doesn't touch GL, so
+ * it can be run from the job threads; alice_upload_mesh_lods must be
+ * called afterwards, on the main thread. */
+ALICE_API void alice_simplify_mesh_lods(alice_mesh_t* mesh);
+ALICE_API void alice_upload_mesh_lods(alice_mesh_t* mesh);
+ALICE_API alice_geometry_t* alice_get_mesh_lod_geometry(alice_mesh_t* mesh, u32 lod);
+
 ALICE_API alice_mesh_t alice_new_cube_mesh();
 ALICE_API alice_mesh_t alice_new_sphere_mesh();
 
@@ -166,6 +356,10 @@ ALICE_API alice_model_t* alice_new_model();
 ALICE_API void alice_free_model(alice_model_t* model);
 ALICE_API void alice_model_add_mesh(alice_model_t* model, alice_mesh_t mesh);
 
+/* Simplifies each of the model's meshes on the job threads, then uploads
+ * the LODs. */
+ALICE_API void alice_generate_model_lods(alice_model_t* model);
+
 ALICE_API void alice_calculate_aabb_from_mesh(alice_aabb_t* aabb,
 	float* vertices, u32 position_count, u32 position_stride);
 
@@ -220,8 +414,6 @@ typedef struct alice_directional_light_t {
 	float intensity;
 
 	bool cast_shadows;
-
-	alice_m4f_t transform;
 } alice_directional_light_t;
 
 typedef struct alice_pbr_material_t {
@@ -260,13 +452,52 @@ typedef struct alice_material_t {
 
 	alice_material_type_t type;
 
+	/* Transparent materials are drawn after opaque ones, back-to-front,
+	 * without writing depth. */
+	bool transparent;
+
 	union {
 		alice_pbr_material_t pbr;
 		alice_phong_material_t phong;
 	} as;
+
+	/* The material's parameters as last uploaded to its uniform block.
+	 * The block is only re-uploaded when they change. */
+	alice_gpu_buffer_t* uniform_buffer;
+	u8 uniform_data[64];
+
+	/* The variant of the shader last returned by alice_get_material_shader,
+	 * the features it was asked for with, and the shader's generation at
+	 * the time. */
+	alice_shader_t* variant;
+	u32 variant_features;
+	u32 variant_generation;
 } alice_material_t;
 
+/* Binding points of the blocks shared by the lit shaders. */
+#define ALICE_FRAME_BLOCK_BINDING 0
+#define ALICE_POINT_LIGHT_BLOCK_BINDING 1
+#define ALICE_MATERIAL_BLOCK_BINDING 2
+#define ALICE_INSTANCE_BLOCK_BINDING 3
+#define ALICE_LIGHT_CLUSTER_BLOCK_BINDING 4
+#define ALICE_LIGHT_INDEX_BLOCK_BINDING 5
+
+/* Must match the array sizes declared by the lit shaders. */
+#define ALICE_MAX_DIRECTIONAL_LIGHTS 100
+
+/* The shader features that come from the material itself, such as which
+ * maps it has. Safe to call from the job threads. */
+ALICE_API u32 alice_get_material_features(alice_material_t* material);
+
+/* Returns the variant of the material's shader with the material's own
+ * features and `frame_features', such as shadows, which are the same for
+ * everything drawn in a frame. The variant is cached on the material. */
+ALICE_API alice_shader_t* alice_get_material_shader(alice_material_t* material, u32 frame_features);
+
+/* Binds the material's shader without instancing, so the model transform
+ * is set with the `transform' uniform, and its uniform block and maps. */
 ALICE_API void alice_apply_material(alice_scene_t* scene, alice_material_t* material);
+ALICE_API void alice_deinit_material(alice_material_t* material);
 
 typedef struct alice_renderable_3d_t {
 	alice_entity_t base;
@@ -278,22 +509,100 @@ typedef struct alice_renderable_3d_t {
 	alice_model_t* model;
 
 	bool cast_shadows;
-} alice_renderable_3d_t;
 
-ALICE_API void alice_apply_point_lights(alice_scene_t* scene, alice_aabb_t mesh_aabb, alice_material_t* material);
+	/* Static renderables are merged into the renderer's static chunks by
+	 * alice_build_static_batches, which sets `batched' on the ones it
+	 * merged. */
+	bool is_static;
+	bool batched;
+
+	/* Occluders are rasterised into the renderer's occlusion buffer
+	 * before anything is tested against it. Large, simple meshes such as
+	 * walls and terrain make the best occluders. */
+	bool is_occluder;
+
+	/* Leaf in the scene's BVH, or ALICE_BVH_NULL_NODE while there is no
+	 * model to bound. */
+	u32 bvh_leaf;
+
+	/* World-space bounds of the whole model and of each of its meshes.
+	 * Refreshed once per frame by alice_update_renderable_3d_bounds, except
+	 * for batched renderables, whose bounds are fixed. */
+	alice_aabb_t aabb;
+	alice_aabb_t* mesh_aabbs;
+	u32 mesh_aabb_capacity;
+
+	/* The LOD each mesh is drawn at, picked for the camera once per frame
+	 * before any pass records, so the shadow passes draw the same levels.
+	 * Has as many entries as mesh_aabbs. */
+	u8* mesh_lods;
+} alice_renderable_3d_t;
 
 ALICE_API void alice_on_renderable_3d_create(alice_scene_t* scene, alice_entity_handle_t handle, void* ptr);
 ALICE_API void alice_on_renderable_3d_destroy(alice_scene_t* scene, alice_entity_handle_t handle, void* ptr);
 ALICE_API void alice_renderable_3d_add_material(alice_renderable_3d_t* renderable, const char* material_path);
-
+ALICE_API void alice_update_renderable_3d_bounds(alice_scene_t* scene);
+
+/* A mesh is drawn at its coarsest LOD whose error, projected to the
+ * screen at the mesh's nearest distance from the eye, covers no more than
+ * `threshold' pixels. A mesh only moves to a coarser level once its error
+ * is within ALICE_LOD_HYSTERESIS of the threshold, so that meshes near the
+ * boundary between two levels don't keep switching. */
+#define ALICE_LOD_HYSTERESIS 0.75f
+
+typedef struct alice_lod_selection_t {
+	/* The size in pixels of one unit at a distance of one unit, which is
+	 * the screen height over 2 tan(fov / 2). */
+	float pixels_per_unit;
+	float threshold;
+} alice_lod_selection_t;
+
+/* Picks the LOD of every renderable's meshes for a camera at `eye', on the
+ * job threads. Expects the bounds to be up to date. A null `lods' puts
+ * every mesh back to level 0. */
+ALICE_API void alice_select_renderable_3d_lods(alice_scene_t* scene, alice_v3f_t eye,
+		const alice_lod_selection_t* lods);
+
+/* Culls the scene's renderables against the frustum of `view_projection'
+ * and appends a packet for each visible mesh to `queue', recording in
+ * parallel on the job threads. Shadow recording skips renderables that
+ * don't cast shadows and leaves packets without a material. If
+ * `occlusion' isn't null, the occluders in the frustum are rasterised
+ * into it and everything else is tested against it as well. Nothing here
+ * touches GL, so recording can be run and timed without a context.
+ * Meshes are drawn at the LODs last picked by
+ * alice_select_renderable_3d_lods. Returns the number of meshes culled,
+ * including those occluded. */
+ALICE_API u32 alice_record_renderables_3d(alice_scene_t* scene, alice_command_lists_t* lists,
+		alice_render_queue_t* queue, alice_m4f_t view_projection, alice_v3f_t eye, bool shadow_pass,
+		alice_occlusion_buffer_t* occlusion);
+
+/* Cascaded shadow map for the first shadow casting directional light.
+ * Each cascade is a layer of `output' and records its own casters,
+ * culled against the cascade's light frustum. */
 typedef struct alice_shadowmap_t {
 	alice_shader_t* shader;
 
 	u32 res;
 
+	/* Between 1 and ALICE_MAX_SHADOW_CASCADES. */
+	u32 cascade_count;
+
+	/* Blend between uniform (0) and logarithmic (1) splits. */
+	float split_lambda;
+
 	bool in_use;
+	alice_directional_light_t* light;
+	alice_shadow_cascades_t cascades;
 
 	u32 draw_call_count;
+	u32 drawn_object_count;
+	u32 culled_object_count;
+
+	alice_command_lists_t* command_lists;
+	alice_render_queue_t* queues[ALICE_MAX_SHADOW_CASCADES];
+	alice_gpu_buffer_t* instance_storage[ALICE_MAX_SHADOW_CASCADES];
+	alice_gpu_buffer_t* draw_commands[ALICE_MAX_SHADOW_CASCADES];
 
 	u32 framebuffer;
 	u32 output;
@@ -302,8 +611,47 @@ typedef struct alice_shadowmap_t {
 ALICE_API alice_shadowmap_t* alice_new_shadowmap(u32 res, alice_shader_t* shader);
 ALICE_API void alice_free_shadowmap(alice_shadowmap_t* shadowmap);
 ALICE_API void alice_draw_shadowmap(alice_shadowmap_t* shadowmap, alice_scene_t* scene, alice_camera_3d_t* camera);
+
+/* The CPU half of alice_draw_shadowmap: picks the light and fits the
+ * cascades to `camera', then records the casters of one cascade into
+ * its queue. Neither touches GL. */
+ALICE_API void alice_fit_shadowmap(alice_shadowmap_t* shadowmap, alice_scene_t* scene, alice_camera_3d_t* camera);
+ALICE_API void alice_record_shadow_cascade(alice_shadowmap_t* shadowmap, alice_scene_t* scene, u32 index);
 ALICE_API void alice_bind_shadowmap_output(alice_shadowmap_t* shadowmap, u32 unit);
 
+/* Shadowed point lights each own six layers of a cube map array. */
+#define ALICE_MAX_POINT_SHADOWS 8
+
+typedef struct alice_point_shadow_caster_t {
+	/* Index into the renderable pool, or into the renderer's static
+	 * chunks if `is_static_chunk' is set. */
+	u32 index;
+	u32 mesh;
+	bool is_static_chunk;
+
+	/* Bit per cube face that the mesh's bounds fall into. */
+	u8 faces;
+} alice_point_shadow_caster_t;
+
+typedef struct alice_point_shadow_t {
+	alice_entity_handle_t light;
+
+	alice_v3f_t position;
+	float range;
+
+	alice_point_shadow_caster_t* casters;
+	u32 caster_count;
+	u32 caster_capacity;
+
+	/* A hash of the casters in each face and their transforms, as of the
+	 * last time it was rendered. A face is only rendered again when this
+	 * changes, so lights with nothing but static casters around them are
+	 * rendered once and then reused. */
+	u64 signatures[6];
+	u8 valid_faces;
+	u8 dirty_faces;
+} alice_point_shadow_t;
+
 typedef struct alice_point_shadowmap_t {
 	alice_shader_t* shader;
 
@@ -311,7 +659,14 @@ typedef struct alice_point_shadowmap_t {
 
 	bool in_use;
 
-	u32 cubemap;
+	alice_point_shadow_t shadows[ALICE_MAX_POINT_SHADOWS];
+	u32 shadow_count;
+
+	u32 faces_rendered;
+	u32 faces_reused;
+	u32 draw_call_count;
+
+	u32 cubemap_array;
 	u32 framebuffer;
 } alice_point_shadowmap_t;
 
@@ -319,16 +674,37 @@ ALICE_API alice_point_shadowmap_t* alice_new_point_shadowmap(u32 res, alice_shad
 ALICE_API void alice_free_point_shadowmap(alice_point_shadowmap_t* shadowmap);
 ALICE_API void alice_draw_point_shadowmap(alice_point_shadowmap_t* shadowmap,
 		alice_scene_t* scene);
+
+/* The CPU half of alice_draw_point_shadowmap: gives the first
+ * ALICE_MAX_POINT_SHADOWS shadow casting point lights a slot, keeping the
+ * slot of any light that had one last frame, gathers the casters in
+ * range of each and works out which faces need rendering. */
+ALICE_API void alice_update_point_shadows(alice_point_shadowmap_t* shadowmap, alice_scene_t* scene);
+
+/* Returns the slot of a light's shadow in the cube map array, or -1 if
+ * it doesn't have one. */
+ALICE_API i32 alice_get_point_shadow_index(alice_point_shadowmap_t* shadowmap, alice_entity_handle_t light);
+
 ALICE_API void alice_bind_point_shadowmap_output(alice_point_shadowmap_t* shadowmap, u32 unit);
 
+/* Albedo and ambient occlusion, world-space normal, metallic and
+ * roughness, and emission with view depth in the alpha. */
+#define ALICE_GBUFFER_ATTACHMENT_COUNT 4
+
+/* Bloom is downsampled from half resolution through a chain of targets,
+ * each half the size of the last, then upsampled back up the chain. */
+#define ALICE_MAX_BLOOM_MIPS 8
+
 typedef struct alice_scene_renderer_3d_t {
-	alice_render_target_t* bright_pixels;
-	alice_render_target_t* bloom_ping_pong[2];
-	alice_render_target_t* output;
+	/* Each frame is drawn through the frame graph, which owns the output,
+	 * G-buffer and bloom targets. The lit shaders write the scene to the
+	 * first attachment of the output and the pixels brighter than the
+	 * bloom threshold to the second. */
+	alice_frame_graph_t* frame_graph;
 	alice_vertex_buffer_t* quad;
 	alice_shader_t* postprocess;
-	alice_shader_t* extract;
-	alice_shader_t* blur;
+	alice_shader_t* bloom_downsample;
+	alice_shader_t* bloom_upsample;
 
 	bool debug;
 	alice_debug_renderer_t* debug_renderer;
@@ -336,23 +712,76 @@ typedef struct alice_scene_renderer_3d_t {
 	alice_shadowmap_t* shadowmap;
 	alice_point_shadowmap_t* point_shadowmap;
 
+	alice_render_queue_t* queue;
+	alice_command_lists_t* command_lists;
+
+	alice_static_chunk_t* static_chunks;
+	u32 static_chunk_count;
+	u32 static_chunk_capacity;
+
+	/* Per-frame camera, ambient and directional light block, and the
+	 * storage buffer holding every point light. */
+	alice_gpu_buffer_t* frame_uniforms;
+	alice_gpu_buffer_t* point_light_storage;
+
+	/* Model matrices of every queued packet, indexed by the shaders with
+	 * the per-instance draw index, and the indirect commands drawing them. */
+	alice_gpu_buffer_t* instance_storage;
+	alice_gpu_buffer_t* draw_commands;
+
+	void* point_light_data;
+	u32 point_light_capacity;
+
+	/* Point lights are assigned to clusters of the view frustum each
+	 * frame, and the lit shaders only loop over their cluster's lights. */
+	alice_light_clusters_t* light_clusters;
+	alice_gpu_buffer_t* light_cluster_storage;
+	alice_gpu_buffer_t* light_index_storage;
+
 	bool use_bloom;
 	float bloom_threshold;
-	u32 bloom_blur_iterations;
+	u32 bloom_mip_count;
+	u32 bloom_pass_count;
 
 	u32 draw_call_count;
+	u32 drawn_object_count;
+	u32 culled_object_count;
+
+	/* Deferred shading draws opaque PBR materials into the G-buffer and
+	 * lights them all in one full-screen pass. Anything else is still
+	 * drawn forward afterwards. */
+	bool use_deferred;
+	alice_shader_t* gbuffer_shader;
+	alice_shader_t* deferred_shader;
+
+	/* Draws the scene at a scale picked from the frame time and scales
+	 * it up to the full size in the postprocess pass. `resolution_scale'
+	 * is the scale the last frame was drawn at. */
+	bool use_dynamic_resolution;
+	alice_resolution_controller_t resolution;
+	float resolution_scale;
+
+	bool use_occlusion_culling;
+	alice_occlusion_buffer_t* occlusion;
+	u32 occluded_object_count;
 
 	bool use_antialiasing;
 
+	/* See alice_lod_selection_t. `lod_object_counts' is how many meshes
+	 * the camera drew at each LOD last frame. */
+	bool use_lods;
+	float lod_threshold;
+	u32 lod_object_counts[ALICE_MAX_MESH_LODS + 1];
+
 	alice_color_t color_mod;
 	alice_color_t ambient_color;
 	float ambient_intensity;
 } alice_scene_renderer_3d_t;
 
 ALICE_API alice_scene_renderer_3d_t* alice_new_scene_renderer_3d(alice_shader_t* postprocess_shader,
-	alice_shader_t* extract_shader, alice_shader_t* blur_shader, alice_shader_t* depth_shader,
+	alice_shader_t* bloom_downsample_shader, alice_shader_t* bloom_upsample_shader, alice_shader_t* depth_shader,
 	alice_shader_t* point_depth_shader, bool debug, alice_shader_t* debug_shader,
-	u32 shadowmap_resolution);
+	u32 shadowmap_resolution, u32 point_shadowmap_resolution);
 ALICE_API void alice_free_scene_renderer_3d(alice_scene_renderer_3d_t* renderer);
 ALICE_API void alice_render_scene_3d(alice_scene_renderer_3d_t* renderer, u32 width, u32 height,
 	alice_scene_t* scene, alice_render_target_t* render_target);
@@ -360,14 +789,26 @@ ALICE_API void alice_render_scene_3d(alice_scene_renderer_3d_t* renderer, u32 wi
 ALICE_API alice_aabb_t alice_transform_aabb(alice_aabb_t aabb, alice_m4f_t m);
 ALICE_API alice_aabb_t alice_compute_scene_aabb(alice_scene_t* scene);
 
-typedef struct alice_3d_pick_context_t {
-	alice_shader_t* shader;
-	alice_render_target_t* target;	
-} alice_3d_pick_context_t;
-
-ALICE_API alice_3d_pick_context_t* alice_new_3d_pick_context(alice_shader_t* shader);
-ALICE_API void alice_free_3d_pick_context(alice_3d_pick_context_t* context);
-ALICE_API alice_entity_handle_t alice_3d_pick(alice_3d_pick_context_t* context, alice_scene_t* scene);
+typedef struct alice_3d_raycast_result_t {
+	alice_entity_handle_t entity;
+	alice_v3f_t point;
+	float distance;
+
+	/* Which mesh of the renderable's model was hit, and which triangle of
+	 * that mesh. */
+	u32 mesh_index;
+	u32 triangle_index;
+} alice_3d_raycast_result_t;
+
+/* Finds the nearest renderable triangle along a ray, using the scene's
+ * BVH and the meshes' CPU-side copies. Doesn't touch GL. Returns false,
+ * with a null entity in `result', if nothing is hit. */
+ALICE_API bool alice_3d_raycast(alice_scene_t* scene, alice_v3f_t origin, alice_v3f_t direction,
+		float max_distance, alice_3d_raycast_result_t* result);
+
+/* Casts a ray from the active 3D camera through a point in window
+ * coordinates, as given by alice_get_mouse_position. */
+ALICE_API bool alice_3d_pick(alice_scene_t* scene, alice_v2f_t screen_position, alice_3d_raycast_result_t* result);
 
 typedef struct alice_sprite_2d_t {
 	alice_entity_t base;
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "alice/core.h"
+
+/* Called once for every index of a job batch. Calls for different indices
+ * may run at the same time on different threads. */
+typedef void (*alice_job_f)(void* data, u32 index);
+
+/* Starts the worker threads. A thread count of zero uses one worker per
+ * hardware thread, minus one for the thread that submits the jobs. Until
+ * this is called, or after alice_deinit_jobs, jobs run serially on the
+ * calling thread. */
+ALICE_API void alice_init_jobs(u32 thread_count);
+ALICE_API void alice_deinit_jobs();
+
+/* The number of threads that take part in a batch, including the caller. */
+ALICE_API u32 alice_get_job_thread_count();
+
+/* Runs function(data, i) for every i below count, spread across the
+ * workers and the calling thread, and returns once all of them have
+ * finished. Must only be called from one thread at a time. */
+ALICE_API void alice_run_jobs(alice_job_f function, void* data, u32 count);
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "alice/core.h"
+#include "alice/maths.h"
+
+/* The view frustum is split into a grid of clusters: evenly across the
+ * screen, and exponentially in depth so that clusters near the camera
+ * are as thin as those far away are wide. The shaders compute the same
+ * grid, so these have to match the ones in the lit shaders. */
+#define ALICE_LIGHT_CLUSTER_X 16
+#define ALICE_LIGHT_CLUSTER_Y 9
+#define ALICE_LIGHT_CLUSTER_Z 24
+#define ALICE_LIGHT_CLUSTER_COUNT (ALICE_LIGHT_CLUSTER_X * ALICE_LIGHT_CLUSTER_Y * ALICE_LIGHT_CLUSTER_Z)
+
+/* std430 layout of an entry in the cluster storage buffer: the range of
+ * the index list holding the lights that touch the cluster. */
+typedef struct alice_light_cluster_t {
+	u32 offset;
+	u32 count;
+} alice_light_cluster_t;
+
+/* Working storage for one depth slice, which is clustered by its own job. */
+typedef struct alice_light_cluster_slice_t {
+	/* View-space spheres of the lights overlapping the slice's depth range,
+	 * padded to a multiple of four. */
+	float* x;
+	float* y;
+	float* z;
+	float* radius;
+	u32* lights;
+	u32 candidate_count;
+	u32 candidate_capacity;
+
+	u32* indices;
+	u32 index_count;
+	u32 index_capacity;
+} alice_light_cluster_slice_t;
+
+typedef struct alice_light_clusters_t {
+	alice_m4f_t view;
+
+	float near;
+	float far;
+
+	/* View-space directions through the corners of the screen tiles,
+	 * scaled so that their z is -1. */
+	alice_v3f_t corners[(ALICE_LIGHT_CLUSTER_X + 1) * (ALICE_LIGHT_CLUSTER_Y + 1)];
+
+	/* View-space light spheres, in the order the lights were added. */
+	float* light_x;
+	float* light_y;
+	float* light_z;
+	float* light_radius;
+	u32 light_count;
+	u32 light_capacity;
+
+	alice_light_cluster_slice_t slices[ALICE_LIGHT_CLUSTER_Z];
+
+	/* The output, ready for upload. */
+	alice_light_cluster_t clusters[ALICE_LIGHT_CLUSTER_COUNT];
+	u32* indices;
+	u32 index_count;
+	u32 index_capacity;
+} alice_light_clusters_t;
+
+ALICE_API alice_light_clusters_t* alice_new_light_clusters();
+ALICE_API void alice_free_light_clusters(alice_light_clusters_t* clusters);
+
+/* Starts a new frame. `near' and `far' bound the clusters in depth and
+ * should be the camera's clip planes. */
+ALICE_API void alice_begin_light_clusters(alice_light_clusters_t* clusters, alice_m4f_t view,
+		alice_m4f_t projection, float near, float far);
+
+/* Lights are referred to in the index list by the order they are added. */
+ALICE_API void alice_add_cluster_light(alice_light_clusters_t* clusters, alice_v3f_t position, float range);
+
+/* Assigns the lights to clusters, one depth slice per job, and builds the
+ * index list. */
+ALICE_API void alice_end_light_clusters(alice_light_clusters_t* clusters);
+
+/* Returns the index of the cluster holding a point `view_depth' in front
+ * of the camera that lands on pixel (`x', `y') of a `width' by `height'
+ * target, measured from the bottom left as gl_FragCoord is. This is the
+ * lookup the shaders do. */
+ALICE_API u32 alice_get_light_cluster_index(const alice_light_clusters_t* clusters,
+		float x, float y, float width, float height, float view_depth);
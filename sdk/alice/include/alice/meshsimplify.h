@@ -0,0 +1,29 @@
+#pragma once
+
+#include "alice/core.h"
+#include "alice/maths.h"
+
+/* Edges whose collapse would turn a triangle further than this from its
+ * old facing, as the cosine of the angle, are left alone. */
+#define ALICE_SIMPLIFY_MIN_FACING 0.25f
+
+/* Simplifies an indexed triangle list by collapsing edges, cheapest first,
+ * where the cost of moving a vertex is its quadric error: the area
+ * weighted mean squared distance from the planes of the triangles around
+ * it. Each collapse moves one end of an edge onto the other, so the result
+ * only uses the vertices it was given and can share their buffer.
+ *
+ * Vertices at the same position are welded for the collapses, which keeps
+ * seams closed. A corner that moves onto a welded vertex picks whichever
+ * of its vertices has the closest normal. `normals' may be null, in which
+ * case the first is used. Vertices on open borders are never moved.
+ *
+ * Stops at `target_index_count' indices, or once the next collapse would
+ * cost more than `max_error', as a distance. Writes the indices to `out',
+ * which must have room for `index_count' of them, and returns how many
+ * there are. `result_error', if it isn't null, gets the largest error of
+ * the collapses made. Doesn't allocate anything that outlives the call,
+ * so it can be run from the job threads. */
+ALICE_API u32 alice_simplify_mesh(u32* out, const alice_v3f_t* positions, const alice_v3f_t* normals,
+		u32 position_count, const u32* indices, u32 index_count, u32 target_index_count,
+		float max_error, float* result_error);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "alice/core.h"
+
+/* A GL backend that draws nothing. Loading it points every GL entry
+ * point the engine uses at a stub that counts the call and returns, so
+ * the renderer can run without a context, a window or a GPU. Headless
+ * applications load it in place of the real one.
+ *
+ * Object names are handed out from a counter, shaders always compile and
+ * link (with no active uniforms), and buffer contents are kept, so that
+ * the static batcher can read its geometry back. Everything else is
+ * thrown away. */
+
+typedef struct alice_null_gl_stats_t {
+	u32 buffer_calls;
+	u32 texture_calls;
+	u32 framebuffer_calls;
+	u32 shader_calls;
+	u32 uniform_calls;
+	u32 state_calls;
+	u32 draw_calls;
+
+	/* Bytes passed to buffer and texture uploads. */
+	u64 uploaded_bytes;
+} alice_null_gl_stats_t;
+
+ALICE_API void alice_load_null_gl();
+
+/* Frees the buffer contents kept by the null backend. */
+ALICE_API void alice_unload_null_gl();
+
+ALICE_API alice_null_gl_stats_t alice_get_null_gl_stats();
+ALICE_API void alice_reset_null_gl_stats();
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "alice/core.h"
+#include "alice/maths.h"
+#include "alice/physics.h"
+
+#define ALICE_OCCLUSION_DEFAULT_WIDTH 256
+#define ALICE_OCCLUSION_DEFAULT_HEIGHT 128
+
+/* Occluders are binned into tiles of this size, and each tile is
+ * rasterised by its own job. The width must be a multiple of four. */
+#define ALICE_OCCLUSION_TILE_WIDTH 64
+#define ALICE_OCCLUSION_TILE_HEIGHT 32
+
+#define ALICE_OCCLUSION_MAX_LEVELS 16
+
+/* A triangle after projection, in pixels, with depth in [0, 1]. */
+typedef struct alice_occlusion_triangle_t {
+	float x[3];
+	float y[3];
+	float z[3];
+} alice_occlusion_triangle_t;
+
+typedef struct alice_occlusion_bin_t {
+	u32* triangles;
+	u32 count;
+	u32 capacity;
+} alice_occlusion_bin_t;
+
+/* A small CPU depth buffer that designated occluders are rasterised into,
+ * along with a hierarchy of the farthest depth in every 2x2 block, so that
+ * bounding boxes can be tested against it in a handful of reads. */
+typedef struct alice_occlusion_buffer_t {
+	u32 width;
+	u32 height;
+
+	alice_m4f_t view_projection;
+
+	/* Level 0 is the depth buffer itself. */
+	float* levels[ALICE_OCCLUSION_MAX_LEVELS];
+	u32 level_widths[ALICE_OCCLUSION_MAX_LEVELS];
+	u32 level_heights[ALICE_OCCLUSION_MAX_LEVELS];
+	u32 level_count;
+
+	alice_occlusion_triangle_t* triangles;
+	u32 triangle_count;
+	u32 triangle_capacity;
+
+	alice_occlusion_bin_t* bins;
+	u32 tile_count_x;
+	u32 tile_count_y;
+
+	/* Filled in by whoever runs the tests. */
+	u32 tested_count;
+	u32 rejected_count;
+} alice_occlusion_buffer_t;
+
+ALICE_API alice_occlusion_buffer_t* alice_new_occlusion_buffer(u32 width, u32 height);
+ALICE_API void alice_free_occlusion_buffer(alice_occlusion_buffer_t* buffer);
+
+/* Clears the buffer and the occluders from the last frame. */
+ALICE_API void alice_begin_occlusion_buffer(alice_occlusion_buffer_t* buffer, alice_m4f_t view_projection);
+
+/* Projects, clips and bins the triangles of one occluder. `positions' are
+ * in the space `transform' maps to world space. */
+ALICE_API void alice_occlusion_add_mesh(alice_occlusion_buffer_t* buffer, alice_m4f_t transform,
+		const alice_v3f_t* positions, const u32* indices, u32 index_count);
+
+/* Rasterises the binned occluders, one tile per job, and builds the
+ * depth hierarchy. */
+ALICE_API void alice_end_occlusion_buffer(alice_occlusion_buffer_t* buffer);
+
+/* Returns true if the box is certainly hidden behind the occluders. Boxes
+ * that cross the near plane are never reported as hidden. Safe to call
+ * from several threads at once. */
+ALICE_API bool alice_occlusion_test_aabb(const alice_occlusion_buffer_t* buffer, alice_aabb_t aabb);
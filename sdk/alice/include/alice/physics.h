@@ -18,6 +18,34 @@ ALICE_API bool alice_aabb_vs_aabb(alice_aabb_t a, alice_aabb_t b, alice_manifold
 ALICE_API bool alice_sphere_vs_aabb(alice_aabb_t a, alice_v3f_t sphere_position, float sphere_radius);
 ALICE_API bool alice_ray_vs_aabb(alice_aabb_t a, alice_v3f_t origin, alice_v3f_t direction, float* t);
 
+/* Hits triangles from either side. `t' is in units of `direction', which
+ * needn't be normalised. */
+ALICE_API bool alice_ray_vs_triangle(alice_v3f_t origin, alice_v3f_t direction,
+		alice_v3f_t a, alice_v3f_t b, alice_v3f_t c, float* t);
+
+/* Transforms a local-space AABB by an affine matrix, returning the
+ * world-space AABB that tightly encloses the result. */
+ALICE_API alice_aabb_t alice_aabb_to_world(alice_aabb_t aabb, alice_m4f_t transform);
+ALICE_API alice_aabb_t alice_aabb_union(alice_aabb_t a, alice_aabb_t b);
+
+/* Six planes stored as a structure of arrays so that they can be tested
+ * four at a time. The last two lanes repeat the first two planes. */
+typedef struct alice_frustum_t {
+	float nx[8];
+	float ny[8];
+	float nz[8];
+	float d[8];
+} alice_frustum_t;
+
+/* Extracts the planes from a view-projection matrix. */
+ALICE_API alice_frustum_t alice_frustum_from_m4f(alice_m4f_t matrix);
+ALICE_API bool alice_frustum_vs_aabb(const alice_frustum_t* frustum, alice_aabb_t aabb);
+
+/* Tests `count' AABBs, writing the result of each into `visible'.
+ * Returns the number of visible boxes. */
+ALICE_API u32 alice_frustum_cull_aabbs(const alice_frustum_t* frustum,
+		const alice_aabb_t* aabbs, u32 count, bool* visible);
+
 typedef struct alice_box_collider_t {
 	alice_v3f_t position;
 	alice_v3f_t dimentions;
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "alice/core.h"
+
+#define ALICE_PROFILER_MAX_SCOPES 128
+#define ALICE_PROFILER_MAX_DEPTH 32
+
+/* The averages and peaks are taken over this many frames. */
+#define ALICE_PROFILER_WINDOW 30
+
+#define ALICE_PROFILER_NO_PARENT ((u32)-1)
+
+/* A named region of a frame. Scopes are told apart by their name and their
+ * parent, so the same name opened under different parents gives different
+ * scopes, and opening one several times in a frame adds the times up. */
+typedef struct alice_profile_scope_t {
+	const char* name;
+	u32 parent;
+	u32 depth;
+
+	/* Whether the scope has ever been timed on the GPU. */
+	bool gpu_timed;
+
+	/* From the last complete window, in milliseconds a frame. */
+	double cpu_average;
+	double cpu_max;
+	double gpu_average;
+	double gpu_max;
+	double calls_per_frame;
+
+	/* Since alice_init_profiler, in milliseconds. */
+	double cpu_total;
+	double gpu_total;
+
+	/* The current frame and window. */
+	double frame_cpu;
+	double frame_gpu;
+	u32 frame_calls;
+
+	double window_cpu;
+	double window_cpu_max;
+	double window_gpu;
+	double window_gpu_max;
+	u32 window_calls;
+} alice_profile_scope_t;
+
+/* GL_TIME_ELAPSED queries issued in a frame, and the scopes they time. */
+typedef struct alice_profile_query_set_t {
+	u32* queries;
+	u32* scopes;
+	u32 count;
+	u32 capacity;
+} alice_profile_query_set_t;
+
+typedef struct alice_profile_marker_t {
+	u32 scope;
+	double start;
+	bool gpu;
+} alice_profile_marker_t;
+
+/* Times scopes of the frame on the CPU and, where asked, on the GPU. GPU
+ * queries are double buffered: those issued in one frame are read back at
+ * the end of the next, and results that aren't ready by then are dropped
+ * rather than waited for. GL_TIME_ELAPSED queries can't nest, so a GPU
+ * scope opened inside another is timed on the CPU only.
+ *
+ * Scopes must only be opened from the main thread. */
+typedef struct alice_profiler_t {
+	bool initialised;
+	bool gpu_timing;
+
+	alice_profile_scope_t scopes[ALICE_PROFILER_MAX_SCOPES];
+	u32 scope_count;
+
+	alice_profile_marker_t stack[ALICE_PROFILER_MAX_DEPTH];
+	u32 depth;
+
+	/* Scopes opened past the maximum depth, which aren't recorded. */
+	u32 overflow_depth;
+
+	alice_profile_query_set_t query_sets[2];
+	bool query_active;
+
+	u64 frame_index;
+	u32 window_frames;
+
+	/* Queries that weren't ready when they were read back. */
+	u32 dropped_query_count;
+} alice_profiler_t;
+
+/* With `gpu_timing' false, which headless applications want, no queries
+ * are issued and GPU scopes are timed on the CPU only. Called by
+ * alice_init_application. */
+ALICE_API void alice_init_profiler(bool gpu_timing);
+ALICE_API void alice_deinit_profiler();
+
+ALICE_API alice_profiler_t* alice_get_profiler();
+
+/* The name is kept, not copied, so it must outlive the profiler. */
+ALICE_API void alice_begin_profile_scope(const char* name);
+ALICE_API void alice_begin_gpu_profile_scope(const char* name);
+ALICE_API void alice_end_profile_scope();
+
+/* Reads back the previous frame's GPU queries and folds this frame into
+ * the statistics. Called by alice_update_application. */
+ALICE_API void alice_end_profiler_frame();
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "alice/core.h"
+#include "alice/maths.h"
+#include "alice/graphics.h"
+#include "alice/geometrypool.h"
+
+/* The pass occupies the top bits of every sort key, so packets are drawn
+ * pass by pass in the order listed here. */
+typedef enum alice_render_pass_t {
+	ALICE_RENDER_PASS_SHADOW = 0,
+	ALICE_RENDER_PASS_OPAQUE = 1,
+	ALICE_RENDER_PASS_TRANSPARENT = 2
+} alice_render_pass_t;
+
+/* Opaque and shadow keys:  | pass:2 | shader:14 | material:14 | mesh:14 | depth:20 |
+ * Transparent keys:        | pass:2 | ~depth:20 | shader:14 | material:14 | mesh:14 |
+ *
+ * The shader bits hash the shader together with the material's features,
+ * so that packets drawn with the same variant are next to each other, and
+ * likewise the mesh bits hash the mesh together with its LOD.
+ * Opaque packets are grouped by state and then drawn front-to-back,
+ * transparent packets are drawn back-to-front. */
+#define ALICE_SORT_KEY_PASS_BITS 2
+#define ALICE_SORT_KEY_ID_BITS 14
+#define ALICE_SORT_KEY_DEPTH_BITS 20
+
+typedef struct alice_draw_packet_t {
+	u64 key;
+
+	alice_render_pass_t pass;
+
+	alice_shader_t* shader;
+	alice_material_t* material;
+	alice_mesh_t* mesh;
+	u32 lod;
+
+	alice_m4f_t transform;
+	alice_aabb_t aabb;
+} alice_draw_packet_t;
+
+typedef struct alice_sort_item_t {
+	u64 key;
+	u32 index;
+} alice_sort_item_t;
+
+/* A run of indirect commands that share a pass, shader and material, drawn
+ * with a single multi-draw. */
+typedef struct alice_draw_bucket_t {
+	alice_render_pass_t pass;
+
+	alice_shader_t* shader;
+	alice_material_t* material;
+
+	u32 first_command;
+	u32 command_count;
+
+	u32 object_count;
+} alice_draw_bucket_t;
+
+typedef struct alice_render_queue_t {
+	alice_draw_packet_t* packets;
+	u32 packet_count;
+	u32 packet_capacity;
+
+	/* Keys and packet indices in submission order once sorted. */
+	alice_sort_item_t* items;
+	alice_sort_item_t* scratch;
+	u32 item_capacity;
+
+	/* Packet transforms in submission order, for the instance buffer. */
+	alice_m4f_t* transforms;
+	u32 transform_capacity;
+
+	alice_draw_command_t* commands;
+	u32 command_count;
+	u32 command_capacity;
+
+	alice_draw_bucket_t* buckets;
+	u32 bucket_count;
+	u32 bucket_capacity;
+} alice_render_queue_t;
+
+typedef struct alice_command_list_stats_t {
+	u32 culled;
+	u32 occlusion_tested;
+	u32 occluded;
+
+	/* Meshes skipped for having no material, or a material without a
+	 * shader. The jobs count these rather than logging from the workers. */
+	u32 missing_materials;
+	u32 missing_shaders;
+} alice_command_list_stats_t;
+
+/* One render queue per recording job. Each job pushes packets into its
+ * own list without locking, and the lists are appended to the target
+ * queue in job order, so the merged queue doesn't depend on how the jobs
+ * were scheduled. */
+typedef struct alice_command_lists_t {
+	alice_render_queue_t** lists;
+	alice_command_list_stats_t* stats;
+	u32 count;
+	u32 capacity;
+
+	/* Pool indices of the renderables the jobs record from. */
+	u32* candidates;
+	u32 candidate_count;
+	u32 candidate_capacity;
+
+	/* The totals of the missing counts last reported, so that the same
+	 * problem is only logged again when it changes. */
+	u32 reported_missing_materials;
+	u32 reported_missing_shaders;
+} alice_command_lists_t;
+
+ALICE_API alice_render_queue_t* alice_new_render_queue();
+ALICE_API void alice_free_render_queue(alice_render_queue_t* queue);
+ALICE_API void alice_clear_render_queue(alice_render_queue_t* queue);
+
+ALICE_API u64 alice_make_sort_key(alice_render_pass_t pass, const void* shader, u32 features,
+		const void* material, const void* mesh, u32 lod, float depth);
+
+ALICE_API alice_draw_packet_t* alice_render_queue_push(alice_render_queue_t* queue,
+		alice_render_pass_t pass, alice_material_t* material, alice_mesh_t* mesh,
+		u32 lod, alice_m4f_t transform, alice_aabb_t aabb, float depth);
+
+/* Radix sorts the queued packets by key. The sort is stable, so packets
+ * with equal keys are drawn in the order they were pushed. */
+ALICE_API void alice_sort_render_queue(alice_render_queue_t* queue);
+
+ALICE_API alice_draw_packet_t* alice_render_queue_get(alice_render_queue_t* queue, u32 index);
+
+/* Returns the number of consecutive sorted packets, starting at `start',
+ * that share a pass, mesh, LOD and material and can be drawn as one instanced
+ * draw. */
+ALICE_API u32 alice_render_queue_batch_size(alice_render_queue_t* queue, u32 start);
+
+/* Copies the transforms of the sorted packets into queue->transforms so
+ * that packet i's transform is at index i. */
+ALICE_API alice_m4f_t* alice_render_queue_gather_transforms(alice_render_queue_t* queue);
+
+/* Builds one indirect command per batch of the sorted queue, and groups
+ * consecutive commands into buckets. Command i's base instance is the
+ * index of its first packet, matching alice_render_queue_gather_transforms. */
+ALICE_API void alice_render_queue_build_commands(alice_render_queue_t* queue);
+
+ALICE_API alice_command_lists_t* alice_new_command_lists();
+ALICE_API void alice_free_command_lists(alice_command_lists_t* lists);
+
+/* Makes `count' empty lists available, reusing the storage of earlier
+ * frames. */
+ALICE_API void alice_reset_command_lists(alice_command_lists_t* lists, u32 count);
+
+/* Appends the packets of every list to `queue', in list order, and returns
+ * the total of the lists' culled counts. */
+ALICE_API u32 alice_merge_command_lists(alice_command_lists_t* lists, alice_render_queue_t* queue);
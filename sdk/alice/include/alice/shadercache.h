@@ -0,0 +1,28 @@
+#pragma once
+
+#include "alice/core.h"
+#include "alice/shaderpreprocessor.h"
+
+/* Linked programs, saved with glGetProgramBinary so that later runs can
+ * skip compiling them. Entries are keyed by a hash of the preprocessed
+ * stages and the driver's vendor, renderer and version strings, so a
+ * change to either misses the cache rather than loading a stale program.
+ *
+ * The cache lives in a directory under the PhysFS write directory. Until
+ * it is initialised, or if the driver has no binary formats, nothing is
+ * loaded or saved. Windowed applications initialise it in
+ * alice_init_application. */
+ALICE_API void alice_init_shader_cache(const char* directory);
+ALICE_API void alice_deinit_shader_cache();
+
+ALICE_API bool alice_is_shader_cache_enabled();
+
+ALICE_API u64 alice_get_shader_cache_key(const alice_preprocessed_shader_t* shader);
+
+/* Returns a linked program, or zero if there isn't one for the key or the
+ * driver refused the binary. */
+ALICE_API u32 alice_load_cached_program(u64 key);
+
+/* The program should have been linked with
+ * GL_PROGRAM_BINARY_RETRIEVABLE_HINT set. */
+ALICE_API void alice_save_cached_program(u64 key, u32 program);
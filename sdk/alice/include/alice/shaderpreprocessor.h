@@ -0,0 +1,58 @@
+#pragma once
+
+#include "alice/core.h"
+
+/* Deeper includes than this are taken to be a cycle. */
+#define ALICE_SHADER_MAX_INCLUDE_DEPTH 16
+
+typedef enum alice_shader_stage_t {
+	ALICE_SHADER_STAGE_VERTEX = 0,
+	ALICE_SHADER_STAGE_FRAGMENT,
+	ALICE_SHADER_STAGE_GEOMETRY,
+	ALICE_SHADER_STAGE_COUNT
+} alice_shader_stage_t;
+
+/* Injected as `#define name value' after each stage's #version. The value
+ * may be null. */
+typedef struct alice_shader_define_t {
+	const char* name;
+	const char* value;
+} alice_shader_define_t;
+
+typedef struct alice_shader_dependency_t {
+	char* path;
+	i64 modtime;
+} alice_shader_dependency_t;
+
+/* The stages of a shader source, split out of its #begin and #end
+ * sections, with every #include replaced by the file it names.
+ *
+ * Include paths are relative to the including file, or to the resource
+ * root if they start with a slash, and are read through PhysFS. A file is
+ * included at most once in each stage. #line directives are written
+ * around every include, with the index of the file in `files' as the
+ * source string number, so compile errors can be traced back to the file
+ * they are in. */
+typedef struct alice_preprocessed_shader_t {
+	/* Null for stages the source doesn't have. */
+	char* stages[ALICE_SHADER_STAGE_COUNT];
+	u32 stage_lengths[ALICE_SHADER_STAGE_COUNT];
+
+	/* Every file the source was made from. The first is the shader's own,
+	 * which has a null path if it wasn't loaded from a file. */
+	alice_shader_dependency_t* files;
+	u32 file_count;
+	u32 file_capacity;
+} alice_preprocessed_shader_t;
+
+/* Returns false, having logged why, if an include couldn't be read. The
+ * result must be deinitialised either way. */
+ALICE_API bool alice_preprocess_shader(alice_preprocessed_shader_t* shader, const char* source,
+		const char* path, const alice_shader_define_t* defines, u32 define_count);
+ALICE_API void alice_deinit_preprocessed_shader(alice_preprocessed_shader_t* shader);
+
+/* Writes a line for each source string number and the file it stands
+ * for, to go with a compile error. */
+ALICE_API void alice_log_shader_sources(const alice_preprocessed_shader_t* shader);
+
+ALICE_API const char* alice_shader_stage_name(alice_shader_stage_t stage);
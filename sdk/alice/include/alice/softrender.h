@@ -0,0 +1,148 @@
+#pragma once
+
+#include "alice/core.h"
+#include "alice/maths.h"
+#include "alice/graphics.h"
+
+/* Triangles are binned into tiles of this size, and each tile is
+ * rasterised and shaded by its own job. The width must be a multiple of
+ * four. */
+#define ALICE_SOFTWARE_TILE_WIDTH 64
+#define ALICE_SOFTWARE_TILE_HEIGHT 32
+
+/* Entries in the tone mapping table, which spans exposed colours from zero
+ * to ALICE_SOFTWARE_TONE_MAP_RANGE. */
+#define ALICE_SOFTWARE_TONE_MAP_SIZE 4096
+#define ALICE_SOFTWARE_TONE_MAP_RANGE 16.0f
+
+typedef enum alice_software_shading_t {
+	/* Every surface is drawn in its material's base colour. */
+	ALICE_SOFTWARE_SHADING_UNLIT,
+
+	/* Blinn-Phong lighting from the scene's ambient, directional and point
+	 * lights, as phong.glsl does it. PBR materials are approximated. */
+	ALICE_SOFTWARE_SHADING_PHONG
+} alice_software_shading_t;
+
+/* A material reduced to what the software renderer shades with. */
+typedef struct alice_software_material_t {
+	alice_v3f_t diffuse;
+	alice_v3f_t specular;
+	alice_v3f_t ambient;
+	float shininess;
+	float emissive;
+} alice_software_material_t;
+
+/* A triangle after projection, in pixels. The edge functions and the depth
+ * plane are divided by the area, so at a pixel they give the barycentric
+ * weights and the depth directly. They take coordinates relative to
+ * (min_x, min_y). The attributes are interpolated with those weights
+ * corrected by `inv_w', when the pixel is shaded. */
+typedef struct alice_software_triangle_t {
+	float ea[3], eb[3], ec[3];
+	float za, zb, zc;
+	float inv_w[3];
+
+	i32 min_x, min_y, max_x, max_y;
+
+	alice_v3f_t world_positions[3];
+	alice_v3f_t normals[3];
+
+	u32 material;
+} alice_software_triangle_t;
+
+/* A vertex after transformation, in clip space and in world space. */
+typedef struct alice_software_vertex_t {
+	float x, y, z, w;
+
+	alice_v3f_t world_position;
+	alice_v3f_t normal;
+} alice_software_vertex_t;
+
+typedef struct alice_software_bin_t {
+	u32* triangles;
+	u32 count;
+	u32 capacity;
+} alice_software_bin_t;
+
+/* Lights as the shading wants them, with the intensity folded into the
+ * colour. */
+typedef struct alice_software_directional_light_t {
+	alice_v3f_t to_light;
+	alice_v3f_t color;
+} alice_software_directional_light_t;
+
+typedef struct alice_software_point_light_t {
+	alice_v3f_t position;
+	float range;
+	alice_v3f_t color;
+} alice_software_point_light_t;
+
+/* Draws a 3D scene on the CPU into an in-memory image, for thumbnails,
+ * image comparisons and machines without a GPU. It reads the same
+ * entities, materials and renderer settings as alice_render_scene_3d, but
+ * not textures, shadows or post processing other than tone mapping. */
+typedef struct alice_software_renderer_t {
+	u32 width;
+	u32 height;
+
+	alice_software_shading_t shading;
+	alice_color_t clear_color;
+
+	/* RGBA, eight bits a channel, top row first. Alpha is zero where
+	 * nothing was drawn. */
+	u8* pixels;
+
+	/* Depth in [0, 1], and one plus the index of the triangle covering
+	 * each pixel, or zero where nothing was drawn. */
+	float* depth;
+	u32* visibility;
+
+	alice_software_triangle_t* triangles;
+	u32 triangle_count;
+	u32 triangle_capacity;
+
+	alice_software_material_t* materials;
+	u32 material_count;
+	u32 material_capacity;
+
+	alice_software_directional_light_t* directional_lights;
+	u32 directional_light_count;
+	u32 directional_light_capacity;
+
+	alice_software_point_light_t* point_lights;
+	u32 point_light_count;
+	u32 point_light_capacity;
+
+	alice_software_bin_t* bins;
+	u32 tile_count_x;
+	u32 tile_count_y;
+
+	/* Per-frame state read by the tile jobs. */
+	alice_m4f_t view_projection;
+	alice_v3f_t camera_position;
+	alice_v3f_t ambient;
+
+	/* Exposure and gamma applied to colours from zero to the range, with
+	 * the entries spaced by the square root so that the darks, where the
+	 * gamma curve is steepest, get most of them. Rebuilt when the
+	 * camera's exposure or gamma change. */
+	u8 tone_map[ALICE_SOFTWARE_TONE_MAP_SIZE];
+	float tone_map_exposure;
+	float tone_map_gamma;
+
+	/* Scratch space for a mesh's transformed vertices. */
+	alice_software_vertex_t* vertices;
+	u32 vertex_capacity;
+
+	/* Statistics from the last frame. */
+	u32 drawn_mesh_count;
+	u32 culled_mesh_count;
+} alice_software_renderer_t;
+
+ALICE_API alice_software_renderer_t* alice_new_software_renderer(u32 width, u32 height);
+ALICE_API void alice_free_software_renderer(alice_software_renderer_t* renderer);
+
+/* Draws the scene from its active 3D camera. Expects the transforms to
+ * be up to date, as alice_render_scene_3d does. */
+ALICE_API void alice_software_render_scene(alice_software_renderer_t* renderer, alice_scene_t* scene);
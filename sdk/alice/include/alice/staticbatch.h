@@ -0,0 +1,25 @@
+#pragma once
+
+#include "alice/core.h"
+#include "alice/graphics.h"
+
+/* Upper bound on the vertices merged into a single chunk. Smaller chunks
+ * cull better, larger ones mean fewer draws. */
+#define ALICE_STATIC_CHUNK_MAX_VERTICES (1 << 16)
+
+/* Static meshes sharing a material, pre-transformed into world space and
+ * merged into one pooled mesh. The mesh's transform is the identity, and
+ * its AABB is the world-space bounds of the chunk. */
+typedef struct alice_static_chunk_t {
+	alice_material_t* material;
+	bool cast_shadows;
+
+	alice_mesh_t mesh;
+} alice_static_chunk_t;
+
+/* Merges every renderable marked is_static into chunks owned by the scene's
+ * renderer, replacing any chunks from an earlier build. Merged renderables
+ * are flagged as batched and skipped by the scene and shadow passes, so
+ * moving one has no visible effect until the batches are rebuilt. */
+ALICE_API void alice_build_static_batches(alice_scene_t* scene);
+ALICE_API void alice_free_static_batches(alice_scene_renderer_3d_t* renderer);
@@ -1,3 +1,12 @@
+#ifndef _WIN32
+	/* For clock_gettime. */
+	#define _POSIX_C_SOURCE 199309L
+#endif
+
+#ifdef _WIN32
+	#include <windows.h>
+#endif
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -10,6 +19,11 @@
 #include "alice/input.h"
 #include "alice/maths.h"
 #include "alice/graphics.h"
+#include "alice/glstate.h"
+#include "alice/jobs.h"
+#include "alice/nullgl.h"
+#include "alice/profiler.h"
+#include "alice/shadercache.h"
 
 extern u32 total_draw_calls;
 
@@ -64,7 +78,7 @@ static void framebuffer_size_callback(GLFWwindow* window, i32 width, i32 height)
 	app->width = width;
 	app->height = height;
 
-	glViewport(0, 0, width, height);
+	alice_gl_viewport(0, 0, width, height);
 }
 
 static void key_callback(GLFWwindow* window, i32 key, i32 scancode, i32 action, i32 mods) {
@@ -91,21 +105,24 @@ static void character_callback(GLFWwindow* window, u32 codepoint) {
 
 alice_application_t app;
 
-alice_application_t* alice_get_application() {
-	return &app;
+/* GLFW's timer needs GLFW initialised, which needs a display, so headless
+ * applications, and the profiler, read the clock themselves. */
+double alice_get_time() {
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (double)time.tv_sec + (double)time.tv_nsec / 1000000000.0;
+#endif
 }
 
-void alice_init_application(alice_application_config_t cfg) {
-	srand((u32)time(alice_null));
-
-	app.name = cfg.name;
-	app.width = cfg.width;
-	app.height = cfg.height;
-
-	app.timestep = 0.0;
-	app.now = 0.0;
-	app.last = 0.0;
-
+static void alice_init_window(alice_application_config_t cfg) {
 	glfwInit();
 
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -136,21 +153,58 @@ void alice_init_application(alice_application_config_t cfg) {
 	glfwSwapInterval(0);
 
 	gladLoadGL();
+}
+
+alice_application_t* alice_get_application() {
+	return &app;
+}
+
+void alice_init_application(alice_application_config_t cfg) {
+	srand((u32)time(alice_null));
+
+	app.name = cfg.name;
+	app.width = cfg.width;
+	app.height = cfg.height;
+
+	app.timestep = 0.0;
+	app.now = 0.0;
+	app.last = 0.0;
 
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	app.window = alice_null;
+	app.headless = cfg.headless;
+	app.should_quit = false;
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	if (app.headless) {
+		alice_load_null_gl();
+		app.last = alice_get_time();
+	} else {
+		alice_init_window(cfg);
+	}
+
+	alice_set_gl_functions(alice_null);
+
+	alice_gl_set_capability(GL_CULL_FACE, true);
+	alice_gl_cull_face(GL_BACK);
 
-	glEnable(GL_DEBUG_OUTPUT);
-	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-	glDebugMessageCallback(gl_debug_callback, NULL);
-	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+	alice_gl_set_capability(GL_BLEND, true);
+	alice_gl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	if (!app.headless) {
+		glEnable(GL_DEBUG_OUTPUT);
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		glDebugMessageCallback(gl_debug_callback, NULL);
+		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+
+		alice_init_shader_cache("shadercache");
+	}
 
 	alice_init_input();
 
-	if (cfg.splash_image && cfg.splash_shader) {
+	alice_init_jobs(0);
+
+	alice_init_profiler(!app.headless);
+
+	if (!app.headless && cfg.splash_image && cfg.splash_shader) {
 		alice_texture_t* splash_texture = alice_load_texture(cfg.splash_image, ALICE_TEXTURE_ANTIALIASED);
 
 		alice_shader_t* shader = alice_load_shader(cfg.splash_shader);
@@ -207,32 +261,66 @@ void alice_init_application(alice_application_config_t cfg) {
 
 void alice_update_events() {
 	alice_reset_input();
-	glfwPollEvents();
+
+	if (app.window) {
+		glfwPollEvents();
+	}
 }
 
 void alice_update_application() {
-	glfwSwapBuffers(app.window);
+	alice_end_profiler_frame();
 
 	total_draw_calls = 0;
+	alice_reset_gl_state_stats();
+
+	if (app.headless) {
+		alice_reset_null_gl_stats();
+
+		app.now = alice_get_time();
+	} else {
+		glfwSwapBuffers(app.window);
+
+		app.now = glfwGetTime();
+	}
 
-	app.now = glfwGetTime();
 	app.timestep = app.now - app.last;
 	app.last = app.now;
 }
 
 bool alice_is_application_running() {
+	if (app.headless) {
+		return !app.should_quit;
+	}
+
 	return !glfwWindowShouldClose(app.window);
 }
 
 void alice_quit_application() {
-	glfwSetWindowShouldClose(app.window, true);
+	app.should_quit = true;
+
+	if (app.window) {
+		glfwSetWindowShouldClose(app.window, true);
+	}
 }
 
 void alice_cancel_application_quit() {
-	glfwSetWindowShouldClose(app.window, false);
+	app.should_quit = false;
+
+	if (app.window) {
+		glfwSetWindowShouldClose(app.window, false);
+	}
 }
 
 void alice_free_application() {
+	alice_deinit_profiler();
+	alice_deinit_jobs();
+	alice_deinit_shader_cache();
+
+	if (app.headless) {
+		alice_unload_null_gl();
+		return;
+	}
+
 	glfwDestroyWindow(app.window);
 	glfwTerminate();
 }
@@ -241,16 +329,22 @@ void alice_resize_application(u32 new_width, u32 new_height) {
 	app.width = new_width;
 	app.height = new_height;
 
-	glfwSetWindowSize(app.window, new_width, new_height);
+	if (app.window) {
+		glfwSetWindowSize(app.window, new_width, new_height);
+	}
 }
 
 void alice_rename_application(const char* new_name) {
 	app.name = new_name;
 
-	glfwSetWindowTitle(app.window, new_name);
+	if (app.window) {
+		glfwSetWindowTitle(app.window, new_name);
+	}
 }
 
 void alice_set_application_fullscreen(u32 monitor_index, bool fullscreen) {
+	if (!app.window) { return; }
+
 	if (fullscreen) {
 		i32 monitor_count;
 		GLFWmonitor** monitors = glfwGetMonitors(&monitor_count);
@@ -272,11 +366,15 @@ void alice_set_application_fullscreen(u32 monitor_index, bool fullscreen) {
 }
 
 void alice_hide_mouse() {
-	glfwSetInputMode(app.window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	if (app.window) {
+		glfwSetInputMode(app.window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	}
 }
 
 void alice_show_mouse() {
-	glfwSetInputMode(app.window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+	if (app.window) {
+		glfwSetInputMode(app.window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+	}
 }
 
 i32 alice_random_int(i32 min, i32 max) {
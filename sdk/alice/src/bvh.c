@@ -0,0 +1,530 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "alice/bvh.h"
+
+/* Queries walk the tree with a fixed stack. The tree is kept balanced, so
+ * its height stays far below this. */
+#define ALICE_BVH_STACK_SIZE 256
+
+static alice_aabb_t alice_bvh_fatten(alice_aabb_t aabb) {
+	const float m = ALICE_BVH_AABB_MARGIN;
+
+	return (alice_aabb_t) {
+		.min = { aabb.min.x - m, aabb.min.y - m, aabb.min.z - m },
+		.max = { aabb.max.x + m, aabb.max.y + m, aabb.max.z + m }
+	};
+}
+
+static bool alice_bvh_aabb_contains(alice_aabb_t outer, alice_aabb_t inner) {
+	return
+		outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+		outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+static bool alice_bvh_aabb_overlaps(alice_aabb_t a, alice_aabb_t b) {
+	return
+		a.min.x <= b.max.x && a.max.x >= b.min.x &&
+		a.min.y <= b.max.y && a.max.y >= b.min.y &&
+		a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+/* Half the surface area, which is all the insertion cost needs. */
+static float alice_bvh_aabb_area(alice_aabb_t aabb) {
+	const float x = aabb.max.x - aabb.min.x;
+	const float y = aabb.max.y - aabb.min.y;
+	const float z = aabb.max.z - aabb.min.z;
+
+	return x * y + y * z + z * x;
+}
+
+static u32 alice_bvh_allocate_node(alice_bvh_t* bvh) {
+	if (bvh->free_list == ALICE_BVH_NULL_NODE) {
+		const u32 old_capacity = bvh->node_capacity;
+
+		bvh->node_capacity = alice_grow_capacity(bvh->node_capacity);
+		bvh->nodes = realloc(bvh->nodes, bvh->node_capacity * sizeof(alice_bvh_node_t));
+
+		for (u32 i = old_capacity; i < bvh->node_capacity; i++) {
+			bvh->nodes[i].parent = i + 1 < bvh->node_capacity ? i + 1 : ALICE_BVH_NULL_NODE;
+			bvh->nodes[i].height = -1;
+		}
+
+		bvh->free_list = old_capacity;
+	}
+
+	const u32 index = bvh->free_list;
+	alice_bvh_node_t* node = &bvh->nodes[index];
+
+	bvh->free_list = node->parent;
+
+	node->parent = ALICE_BVH_NULL_NODE;
+	node->children[0] = ALICE_BVH_NULL_NODE;
+	node->children[1] = ALICE_BVH_NULL_NODE;
+	node->height = 0;
+	node->user_data = 0;
+	node->weight = 0;
+
+	bvh->node_count++;
+
+	return index;
+}
+
+static void alice_bvh_free_node(alice_bvh_t* bvh, u32 index) {
+	assert(index < bvh->node_capacity);
+
+	bvh->nodes[index].parent = bvh->free_list;
+	bvh->nodes[index].height = -1;
+
+	bvh->free_list = index;
+	bvh->node_count--;
+}
+
+static void alice_bvh_fit_node(alice_bvh_t* bvh, u32 index) {
+	alice_bvh_node_t* node = &bvh->nodes[index];
+	alice_bvh_node_t* a = &bvh->nodes[node->children[0]];
+	alice_bvh_node_t* b = &bvh->nodes[node->children[1]];
+
+	node->aabb = alice_aabb_union(a->aabb, b->aabb);
+	node->height = 1 + alice_max(a->height, b->height);
+	node->weight = a->weight + b->weight;
+}
+
+/* Rotates the subtree at `a' if one side is more than one level taller
+ * than the other, returning the index of the subtree's new root. */
+static u32 alice_bvh_balance(alice_bvh_t* bvh, u32 ia) {
+	alice_bvh_node_t* a = &bvh->nodes[ia];
+
+	if (a->height < 2) {
+		return ia;
+	}
+
+	const u32 ib = a->children[0];
+	const u32 ic = a->children[1];
+
+	alice_bvh_node_t* b = &bvh->nodes[ib];
+	alice_bvh_node_t* c = &bvh->nodes[ic];
+
+	const i32 balance = c->height - b->height;
+
+	/* Promotes whichever child is taller. The rotation is the same either
+	 * way, apart from which side of `a' it replaces. */
+	if (balance > 1 || balance < -1) {
+		const bool promote_c = balance > 1;
+
+		const u32 iup = promote_c ? ic : ib;
+		alice_bvh_node_t* up = &bvh->nodes[iup];
+
+		const u32 ifirst = up->children[0];
+		const u32 isecond = up->children[1];
+
+		/* Swap `a' and `up'. */
+		up->children[0] = ia;
+		up->parent = a->parent;
+		a->parent = iup;
+
+		if (up->parent != ALICE_BVH_NULL_NODE) {
+			alice_bvh_node_t* parent = &bvh->nodes[up->parent];
+
+			if (parent->children[0] == ia) {
+				parent->children[0] = iup;
+			} else {
+				parent->children[1] = iup;
+			}
+		} else {
+			bvh->root = iup;
+		}
+
+		/* The taller grandchild stays under `up', the other takes the
+		 * place `up' had under `a'. */
+		const bool keep_first = bvh->nodes[ifirst].height > bvh->nodes[isecond].height;
+		const u32 ikeep = keep_first ? ifirst : isecond;
+		const u32 imove = keep_first ? isecond : ifirst;
+
+		up->children[1] = ikeep;
+
+		if (promote_c) {
+			a->children[1] = imove;
+		} else {
+			a->children[0] = imove;
+		}
+
+		bvh->nodes[imove].parent = ia;
+
+		alice_bvh_fit_node(bvh, ia);
+		alice_bvh_fit_node(bvh, iup);
+
+		return iup;
+	}
+
+	return ia;
+}
+
+static void alice_bvh_fit_ancestors(alice_bvh_t* bvh, u32 index) {
+	while (index != ALICE_BVH_NULL_NODE) {
+		index = alice_bvh_balance(bvh, index);
+
+		alice_bvh_fit_node(bvh, index);
+
+		index = bvh->nodes[index].parent;
+	}
+}
+
+static void alice_bvh_insert_leaf(alice_bvh_t* bvh, u32 leaf) {
+	if (bvh->root == ALICE_BVH_NULL_NODE) {
+		bvh->root = leaf;
+		bvh->nodes[leaf].parent = ALICE_BVH_NULL_NODE;
+		return;
+	}
+
+	/* Walk down to the sibling that grows the tree's surface area the
+	 * least. */
+	const alice_aabb_t leaf_aabb = bvh->nodes[leaf].aabb;
+
+	u32 index = bvh->root;
+	while (bvh->nodes[index].height > 0) {
+		alice_bvh_node_t* node = &bvh->nodes[index];
+
+		const float area = alice_bvh_aabb_area(node->aabb);
+		const float combined_area = alice_bvh_aabb_area(alice_aabb_union(node->aabb, leaf_aabb));
+
+		/* Cost of pairing the leaf with this node, and the cost every
+		 * level below inherits from this node growing. */
+		const float cost = 2.0f * combined_area;
+		const float inherited_cost = 2.0f * (combined_area - area);
+
+		float child_costs[2];
+		for (u32 i = 0; i < 2; i++) {
+			alice_bvh_node_t* child = &bvh->nodes[node->children[i]];
+
+			const alice_aabb_t aabb = alice_aabb_union(leaf_aabb, child->aabb);
+
+			if (child->height == 0) {
+				child_costs[i] = alice_bvh_aabb_area(aabb) + inherited_cost;
+			} else {
+				child_costs[i] = alice_bvh_aabb_area(aabb) - alice_bvh_aabb_area(child->aabb) +
+					inherited_cost;
+			}
+		}
+
+		if (cost < child_costs[0] && cost < child_costs[1]) {
+			break;
+		}
+
+		index = child_costs[0] < child_costs[1] ? node->children[0] : node->children[1];
+	}
+
+	const u32 sibling = index;
+	const u32 old_parent = bvh->nodes[sibling].parent;
+	const u32 new_parent = alice_bvh_allocate_node(bvh);
+
+	alice_bvh_node_t* parent = &bvh->nodes[new_parent];
+	parent->parent = old_parent;
+	parent->children[0] = sibling;
+	parent->children[1] = leaf;
+
+	if (old_parent != ALICE_BVH_NULL_NODE) {
+		alice_bvh_node_t* grandparent = &bvh->nodes[old_parent];
+
+		if (grandparent->children[0] == sibling) {
+			grandparent->children[0] = new_parent;
+		} else {
+			grandparent->children[1] = new_parent;
+		}
+	} else {
+		bvh->root = new_parent;
+	}
+
+	bvh->nodes[sibling].parent = new_parent;
+	bvh->nodes[leaf].parent = new_parent;
+
+	alice_bvh_fit_ancestors(bvh, new_parent);
+}
+
+static void alice_bvh_remove_leaf(alice_bvh_t* bvh, u32 leaf) {
+	if (leaf == bvh->root) {
+		bvh->root = ALICE_BVH_NULL_NODE;
+		return;
+	}
+
+	const u32 parent = bvh->nodes[leaf].parent;
+	const u32 grandparent = bvh->nodes[parent].parent;
+	const u32 sibling = bvh->nodes[parent].children[0] == leaf ?
+		bvh->nodes[parent].children[1] : bvh->nodes[parent].children[0];
+
+	if (grandparent != ALICE_BVH_NULL_NODE) {
+		alice_bvh_node_t* node = &bvh->nodes[grandparent];
+
+		if (node->children[0] == parent) {
+			node->children[0] = sibling;
+		} else {
+			node->children[1] = sibling;
+		}
+
+		bvh->nodes[sibling].parent = grandparent;
+		alice_bvh_free_node(bvh, parent);
+
+		alice_bvh_fit_ancestors(bvh, grandparent);
+	} else {
+		bvh->root = sibling;
+		bvh->nodes[sibling].parent = ALICE_BVH_NULL_NODE;
+		alice_bvh_free_node(bvh, parent);
+	}
+}
+
+alice_bvh_t* alice_new_bvh() {
+	alice_bvh_t* new = malloc(sizeof(alice_bvh_t));
+
+	new->nodes = alice_null;
+	new->node_count = 0;
+	new->node_capacity = 0;
+
+	new->root = ALICE_BVH_NULL_NODE;
+	new->free_list = ALICE_BVH_NULL_NODE;
+
+	new->leaf_count = 0;
+
+	return new;
+}
+
+void alice_free_bvh(alice_bvh_t* bvh) {
+	assert(bvh);
+
+	if (bvh->node_capacity > 0) {
+		free(bvh->nodes);
+	}
+
+	free(bvh);
+}
+
+u32 alice_bvh_insert(alice_bvh_t* bvh, alice_aabb_t aabb, u32 user_data, u32 weight) {
+	assert(bvh);
+
+	const u32 leaf = alice_bvh_allocate_node(bvh);
+
+	alice_bvh_node_t* node = &bvh->nodes[leaf];
+	node->aabb = alice_bvh_fatten(aabb);
+	node->user_data = user_data;
+	node->weight = weight;
+
+	alice_bvh_insert_leaf(bvh, leaf);
+
+	bvh->leaf_count++;
+
+	return leaf;
+}
+
+void alice_bvh_remove(alice_bvh_t* bvh, u32 leaf) {
+	assert(bvh);
+	assert(leaf < bvh->node_capacity && bvh->nodes[leaf].height == 0);
+
+	alice_bvh_remove_leaf(bvh, leaf);
+	alice_bvh_free_node(bvh, leaf);
+
+	bvh->leaf_count--;
+}
+
+bool alice_bvh_move(alice_bvh_t* bvh, u32 leaf, alice_aabb_t aabb, bool defer_refit) {
+	assert(bvh);
+	assert(leaf < bvh->node_capacity && bvh->nodes[leaf].height == 0);
+
+	if (alice_bvh_aabb_contains(bvh->nodes[leaf].aabb, aabb)) {
+		return false;
+	}
+
+	bvh->nodes[leaf].aabb = alice_bvh_fatten(aabb);
+
+	if (!defer_refit) {
+		alice_bvh_remove_leaf(bvh, leaf);
+		alice_bvh_insert_leaf(bvh, leaf);
+	}
+
+	return true;
+}
+
+static void alice_bvh_refit_node(alice_bvh_t* bvh, u32 index) {
+	if (bvh->nodes[index].height == 0) {
+		return;
+	}
+
+	alice_bvh_refit_node(bvh, bvh->nodes[index].children[0]);
+	alice_bvh_refit_node(bvh, bvh->nodes[index].children[1]);
+
+	alice_bvh_fit_node(bvh, index);
+}
+
+void alice_bvh_refit(alice_bvh_t* bvh) {
+	assert(bvh);
+
+	if (bvh->root != ALICE_BVH_NULL_NODE) {
+		alice_bvh_refit_node(bvh, bvh->root);
+	}
+}
+
+void alice_bvh_set_weight(alice_bvh_t* bvh, u32 leaf, u32 weight) {
+	assert(bvh);
+	assert(leaf < bvh->node_capacity && bvh->nodes[leaf].height == 0);
+
+	const u32 old_weight = bvh->nodes[leaf].weight;
+	if (old_weight == weight) {
+		return;
+	}
+
+	for (u32 index = leaf; index != ALICE_BVH_NULL_NODE; index = bvh->nodes[index].parent) {
+		bvh->nodes[index].weight = bvh->nodes[index].weight - old_weight + weight;
+	}
+}
+
+void alice_bvh_set_user_data(alice_bvh_t* bvh, u32 leaf, u32 user_data) {
+	assert(bvh);
+	assert(leaf < bvh->node_capacity && bvh->nodes[leaf].height == 0);
+
+	bvh->nodes[leaf].user_data = user_data;
+}
+
+bool alice_bvh_get_bounds(const alice_bvh_t* bvh, alice_aabb_t* bounds) {
+	assert(bvh);
+	assert(bounds);
+
+	if (bvh->root == ALICE_BVH_NULL_NODE) {
+		return false;
+	}
+
+	*bounds = bvh->nodes[bvh->root].aabb;
+	return true;
+}
+
+typedef enum alice_bvh_shape_t {
+	ALICE_BVH_SHAPE_FRUSTUM,
+	ALICE_BVH_SHAPE_SPHERE,
+	ALICE_BVH_SHAPE_AABB
+} alice_bvh_shape_t;
+
+typedef struct alice_bvh_query_t {
+	alice_bvh_shape_t shape;
+
+	const alice_frustum_t* frustum;
+
+	alice_v3f_t center;
+	float radius;
+
+	alice_aabb_t aabb;
+} alice_bvh_query_t;
+
+static bool alice_bvh_query_hits(const alice_bvh_query_t* query, alice_aabb_t aabb) {
+	switch (query->shape) {
+		case ALICE_BVH_SHAPE_FRUSTUM:
+			return alice_frustum_vs_aabb(query->frustum, aabb);
+		case ALICE_BVH_SHAPE_SPHERE:
+			return alice_sphere_vs_aabb(aabb, query->center, query->radius);
+		case ALICE_BVH_SHAPE_AABB:
+			return alice_bvh_aabb_overlaps(query->aabb, aabb);
+		default:
+			return false;
+	}
+}
+
+static u32 alice_bvh_query(const alice_bvh_t* bvh, const alice_bvh_query_t* query,
+		alice_bvh_query_f callback, void* data) {
+	assert(bvh);
+	assert(callback);
+
+	if (bvh->root == ALICE_BVH_NULL_NODE) {
+		return 0;
+	}
+
+	u32 rejected_weight = 0;
+
+	u32 stack[ALICE_BVH_STACK_SIZE];
+	u32 stack_count = 0;
+
+	stack[stack_count++] = bvh->root;
+
+	while (stack_count > 0) {
+		const alice_bvh_node_t* node = &bvh->nodes[stack[--stack_count]];
+
+		if (!alice_bvh_query_hits(query, node->aabb)) {
+			rejected_weight += node->weight;
+			continue;
+		}
+
+		if (node->height == 0) {
+			callback(data, node->user_data);
+			continue;
+		}
+
+		assert(stack_count + 2 <= ALICE_BVH_STACK_SIZE);
+
+		stack[stack_count++] = node->children[1];
+		stack[stack_count++] = node->children[0];
+	}
+
+	return rejected_weight;
+}
+
+u32 alice_bvh_query_frustum(const alice_bvh_t* bvh, const alice_frustum_t* frustum,
+		alice_bvh_query_f callback, void* data) {
+	assert(frustum);
+
+	const alice_bvh_query_t query = {
+		.shape = ALICE_BVH_SHAPE_FRUSTUM,
+		.frustum = frustum
+	};
+
+	return alice_bvh_query(bvh, &query, callback, data);
+}
+
+u32 alice_bvh_query_sphere(const alice_bvh_t* bvh, alice_v3f_t center, float radius,
+		alice_bvh_query_f callback, void* data) {
+	const alice_bvh_query_t query = {
+		.shape = ALICE_BVH_SHAPE_SPHERE,
+		.center = center,
+		.radius = radius
+	};
+
+	return alice_bvh_query(bvh, &query, callback, data);
+}
+
+u32 alice_bvh_query_aabb(const alice_bvh_t* bvh, alice_aabb_t aabb,
+		alice_bvh_query_f callback, void* data) {
+	const alice_bvh_query_t query = {
+		.shape = ALICE_BVH_SHAPE_AABB,
+		.aabb = aabb
+	};
+
+	return alice_bvh_query(bvh, &query, callback, data);
+}
+
+void alice_bvh_query_ray(const alice_bvh_t* bvh, alice_v3f_t origin, alice_v3f_t direction,
+		float max_distance, alice_bvh_ray_f callback, void* data) {
+	assert(bvh);
+	assert(callback);
+
+	if (bvh->root == ALICE_BVH_NULL_NODE) {
+		return;
+	}
+
+	u32 stack[ALICE_BVH_STACK_SIZE];
+	u32 stack_count = 0;
+
+	stack[stack_count++] = bvh->root;
+
+	while (stack_count > 0) {
+		const alice_bvh_node_t* node = &bvh->nodes[stack[--stack_count]];
+
+		float t;
+		if (!alice_ray_vs_aabb(node->aabb, origin, direction, &t) || t > max_distance) {
+			continue;
+		}
+
+		if (node->height == 0) {
+			max_distance = callback(data, node->user_data, max_distance);
+			continue;
+		}
+
+		assert(stack_count + 2 <= ALICE_BVH_STACK_SIZE);
+
+		stack[stack_count++] = node->children[1];
+		stack[stack_count++] = node->children[0];
+	}
+}
@@ -0,0 +1,117 @@
+#include <assert.h>
+#include <math.h>
+
+#include "alice/cascades.h"
+
+static alice_v3f_t alice_cascade_transform_point(alice_m4f_t m, alice_v3f_t p) {
+	return (alice_v3f_t) {
+		m.elements[0][0] * p.x + m.elements[1][0] * p.y + m.elements[2][0] * p.z + m.elements[3][0],
+		m.elements[0][1] * p.x + m.elements[1][1] * p.y + m.elements[2][1] * p.z + m.elements[3][1],
+		m.elements[0][2] * p.x + m.elements[1][2] * p.y + m.elements[2][2] * p.z + m.elements[3][2]
+	};
+}
+
+float alice_shadow_cascade_split(u32 index, u32 count, float lambda, float near, float far) {
+	assert(count > 0);
+	assert(index <= count);
+
+	const float t = (float)index / (float)count;
+
+	const float logarithmic = near * powf(far / near, t);
+	const float uniform = near + (far - near) * t;
+
+	return lambda * logarithmic + (1.0f - lambda) * uniform;
+}
+
+void alice_fit_shadow_cascades(alice_shadow_cascades_t* cascades, u32 count, float lambda,
+		alice_m4f_t camera_view, float fov, float aspect, float near, float far,
+		alice_v3f_t light_direction, alice_aabb_t casters, u32 resolution) {
+	assert(cascades);
+	assert(count > 0 && count <= ALICE_MAX_SHADOW_CASCADES);
+	assert(near > 0.0f && far > near);
+	assert(resolution > 0);
+
+	cascades->count = count;
+
+	const alice_v3f_t forward = alice_v3f_normalise(light_direction);
+	const alice_v3f_t up = fabsf(forward.y) > 0.99f ?
+		(alice_v3f_t) { 0.0f, 0.0f, 1.0f } :
+		(alice_v3f_t) { 0.0f, 1.0f, 0.0f };
+
+	/* Only rotates, so the snapping below is the same whichever cascade
+	 * or frame it's done in. */
+	const alice_m4f_t light_view = alice_m4f_lookat((alice_v3f_t) { 0.0f, 0.0f, 0.0f }, forward, up);
+	cascades->light_view = light_view;
+
+	/* The nearest the casters get to the light, as a light-view z. */
+	float caster_max_z = light_view.elements[3][2];
+	{
+		const float mins[3] = { casters.min.x, casters.min.y, casters.min.z };
+		const float maxs[3] = { casters.max.x, casters.max.y, casters.max.z };
+
+		for (u32 i = 0; i < 3; i++) {
+			const float a = light_view.elements[i][2] * mins[i];
+			const float b = light_view.elements[i][2] * maxs[i];
+			caster_max_z += a > b ? a : b;
+		}
+	}
+
+	const alice_m4f_t inverse_view = alice_m4f_inverse(camera_view);
+
+	/* Squared ratio of a corner's distance from the view axis to its depth. */
+	const float tan_half_fov = tanf(alice_torad(0.5f * fov));
+	const float k2 = tan_half_fov * tan_half_fov * (1.0f + aspect * aspect);
+
+	for (u32 i = 0; i < count; i++) {
+		alice_shadow_cascade_t* cascade = &cascades->cascades[i];
+
+		const float n = alice_shadow_cascade_split(i, count, lambda, near, far);
+		const float f = alice_shadow_cascade_split(i + 1, count, lambda, near, far);
+
+		cascade->near = n;
+		cascade->far = f;
+
+		/* The smallest sphere holding the slice is centred on the view axis
+		 * where the near and far corners are equally far away, unless that
+		 * is past the far plane, in which case it's the far plane's circle. */
+		float center_depth = 0.5f * (n + f) * (1.0f + k2);
+		float radius;
+		if (center_depth >= f) {
+			center_depth = f;
+			radius = f * sqrtf(k2);
+		} else {
+			radius = sqrtf((center_depth - n) * (center_depth - n) + k2 * n * n);
+		}
+
+		/* Rounded so that float error doesn't change the texel size. */
+		radius = ceilf(radius * 16.0f) / 16.0f;
+
+		const alice_v3f_t center = alice_cascade_transform_point(inverse_view,
+				(alice_v3f_t) { 0.0f, 0.0f, -center_depth });
+
+		cascade->center = center;
+		cascade->radius = radius;
+
+		const alice_v3f_t light_center = alice_cascade_transform_point(light_view, center);
+
+		/* One texel to spare so the sphere still fits once snapped. */
+		const float texel_size = (2.0f * radius) / (float)(resolution > 1 ? resolution - 1 : 1);
+		const float extent = texel_size * (float)resolution;
+
+		const float left = floorf((light_center.x - radius) / texel_size) * texel_size;
+		const float bottom = floorf((light_center.y - radius) / texel_size) * texel_size;
+
+		const float min_z = light_center.z - radius;
+		float max_z = light_center.z + radius;
+		if (caster_max_z > max_z) {
+			max_z = caster_max_z;
+		}
+
+		const alice_m4f_t projection = alice_m4f_ortho(
+				left, left + extent,
+				bottom, bottom + extent,
+				min_z, max_z);
+
+		cascade->matrix = alice_m4f_multiply(projection, light_view);
+	}
+}
@@ -0,0 +1,89 @@
+#include <assert.h>
+#include <math.h>
+
+#include "alice/dynamicresolution.h"
+
+void alice_init_resolution_controller(alice_resolution_controller_t* controller,
+		double target_frame_time) {
+	assert(controller);
+	assert(target_frame_time > 0.0);
+
+	controller->target_frame_time = target_frame_time;
+
+	controller->min_scale = 0.5f;
+	controller->max_scale = 1.0f;
+	controller->step = 0.05f;
+
+	controller->smoothing = 0.1f;
+
+	controller->lower_threshold = 0.8f;
+	controller->upper_threshold = 0.95f;
+	controller->cooldown_frames = 30;
+
+	alice_reset_resolution_controller(controller);
+}
+
+void alice_reset_resolution_controller(alice_resolution_controller_t* controller) {
+	assert(controller);
+
+	controller->average_frame_time = 0.0;
+	controller->scale = controller->max_scale;
+	controller->frames_since_change = 0;
+	controller->has_average = false;
+}
+
+static float alice_quantise_resolution_scale(const alice_resolution_controller_t* controller, float scale) {
+	scale = roundf(scale / controller->step) * controller->step;
+
+	return alice_min(alice_max(scale, controller->min_scale), controller->max_scale);
+}
+
+float alice_update_resolution_controller(alice_resolution_controller_t* controller,
+		double frame_time) {
+	assert(controller);
+
+	if (controller->has_average) {
+		controller->average_frame_time +=
+			(double)controller->smoothing * (frame_time - controller->average_frame_time);
+	} else {
+		controller->average_frame_time = frame_time;
+		controller->has_average = true;
+	}
+
+	controller->frames_since_change++;
+
+	if (controller->frames_since_change < controller->cooldown_frames) {
+		return controller->scale;
+	}
+
+	const double average = controller->average_frame_time;
+	const double budget = controller->target_frame_time;
+
+	float scale = controller->scale;
+
+	if (average > budget * controller->upper_threshold) {
+		/* Frame time goes roughly with the number of pixels, which goes
+		 * with the square of the scale. */
+		const float fit = controller->scale * (float)sqrt(budget * controller->upper_threshold / average);
+
+		scale = alice_min(alice_quantise_resolution_scale(controller, fit),
+			controller->scale - controller->step);
+	} else if (average < budget * controller->lower_threshold) {
+		scale = controller->scale + controller->step;
+	}
+
+	scale = alice_quantise_resolution_scale(controller, scale);
+
+	if (scale != controller->scale) {
+		controller->scale = scale;
+		controller->frames_since_change = 0;
+	}
+
+	return controller->scale;
+}
+
+u32 alice_scale_resolution(u32 size, float scale) {
+	const u32 scaled = (u32)((float)size * scale + 0.5f);
+
+	return alice_max(scaled, 1);
+}
@@ -7,6 +7,7 @@
 #include "alice/graphics.h"
 #include "alice/scripting.h"
 #include "alice/physics.h"
+#include "alice/bvh.h"
 
 alice_m4f_t alice_get_entity_transform(alice_scene_t* scene, alice_entity_t* entity) {
 	assert(entity);
@@ -332,7 +333,9 @@ alice_scene_t* alice_new_scene(const char* script_assembly) {
 		.script_context = alice_new_script_context(new, script_assembly),
 
 		.renderer = alice_null,
-		.physics_engine = alice_null
+		.physics_engine = alice_null,
+
+		.bvh = alice_new_bvh()
 	};
 
 	alice_register_entity_type(new, alice_entity_t);
@@ -411,6 +414,8 @@ void alice_free_scene(alice_scene_t* scene) {
 		free(scene->pools);
 	}
 
+	alice_free_bvh(scene->bvh);
+
 	free(scene);
 }
 
@@ -493,6 +498,10 @@ void alice_destroy_entity(alice_scene_t* scene, alice_entity_handle_t handle) {
 		alice_entity_remove_child(scene, ptr->parent, handle);
 	}
 
+	if (pool->destroy) {
+		pool->destroy(scene, handle, ptr);
+	}
+
 	alice_free_entity(scene, ptr);
 
 	alice_entity_pool_remove(pool, alice_get_entity_handle_id(handle));
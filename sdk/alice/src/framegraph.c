@@ -0,0 +1,333 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alice/framegraph.h"
+#include "alice/profiler.h"
+
+alice_frame_graph_t* alice_new_frame_graph() {
+	alice_frame_graph_t* new = calloc(1, sizeof(alice_frame_graph_t));
+
+	return new;
+}
+
+void alice_free_frame_graph(alice_frame_graph_t* graph) {
+	assert(graph);
+
+	for (u32 i = 0; i < graph->pool_count; i++) {
+		alice_free_render_target(graph->pool[i].target);
+	}
+
+	if (graph->pass_capacity > 0) { free(graph->passes); }
+	if (graph->resource_capacity > 0) { free(graph->resources); }
+	if (graph->order_capacity > 0) { free(graph->order); }
+	if (graph->physical_capacity > 0) { free(graph->physicals); }
+	if (graph->pool_capacity > 0) { free(graph->pool); }
+
+	free(graph);
+}
+
+void alice_begin_frame_graph(alice_frame_graph_t* graph) {
+	assert(graph);
+
+	graph->pass_count = 0;
+	graph->resource_count = 0;
+	graph->order_count = 0;
+	graph->physical_count = 0;
+
+	graph->culled_pass_count = 0;
+	graph->transient_count = 0;
+}
+
+static u32 alice_frame_graph_add_resource(alice_frame_graph_t* graph, alice_frame_graph_resource_t resource) {
+	if (graph->resource_count >= graph->resource_capacity) {
+		graph->resource_capacity = alice_grow_capacity(graph->resource_capacity);
+		graph->resources = realloc(graph->resources,
+				graph->resource_capacity * sizeof(alice_frame_graph_resource_t));
+	}
+
+	graph->resources[graph->resource_count] = resource;
+
+	return graph->resource_count++;
+}
+
+u32 alice_frame_graph_create_target(alice_frame_graph_t* graph, const char* name,
+		alice_frame_graph_target_desc_t desc) {
+	assert(graph);
+	assert(desc.width > 0 && desc.height > 0 && desc.attachment_count > 0);
+
+	return alice_frame_graph_add_resource(graph, (alice_frame_graph_resource_t) {
+		.name = name,
+		.desc = desc
+	});
+}
+
+u32 alice_frame_graph_import_target(alice_frame_graph_t* graph, const char* name,
+		alice_render_target_t* target) {
+	assert(graph);
+
+	alice_frame_graph_resource_t resource = {
+		.name = name,
+		.imported = true,
+		.target = target
+	};
+
+	if (target) {
+		resource.desc = (alice_frame_graph_target_desc_t) {
+			.width = target->width,
+			.height = target->height,
+			.attachment_count = target->color_attachment_count
+		};
+	}
+
+	return alice_frame_graph_add_resource(graph, resource);
+}
+
+void alice_frame_graph_mark_output(alice_frame_graph_t* graph, u32 resource) {
+	assert(graph);
+	assert(resource < graph->resource_count);
+
+	graph->resources[resource].is_output = true;
+}
+
+u32 alice_frame_graph_add_pass(alice_frame_graph_t* graph, const char* name,
+		alice_frame_graph_execute_f execute, void* data) {
+	assert(graph);
+	assert(execute);
+
+	if (graph->pass_count >= graph->pass_capacity) {
+		graph->pass_capacity = alice_grow_capacity(graph->pass_capacity);
+		graph->passes = realloc(graph->passes, graph->pass_capacity * sizeof(alice_frame_graph_pass_t));
+	}
+
+	graph->passes[graph->pass_count] = (alice_frame_graph_pass_t) {
+		.name = name,
+		.execute = execute,
+		.data = data
+	};
+
+	return graph->pass_count++;
+}
+
+void alice_frame_graph_read(alice_frame_graph_t* graph, u32 pass, u32 resource) {
+	assert(graph);
+	assert(pass < graph->pass_count);
+	assert(resource < graph->resource_count);
+
+	alice_frame_graph_pass_t* p = &graph->passes[pass];
+	assert(p->read_count < ALICE_FRAME_GRAPH_MAX_PASS_RESOURCES);
+
+	p->reads[p->read_count++] = resource;
+}
+
+void alice_frame_graph_write(alice_frame_graph_t* graph, u32 pass, u32 resource) {
+	assert(graph);
+	assert(pass < graph->pass_count);
+	assert(resource < graph->resource_count);
+
+	alice_frame_graph_pass_t* p = &graph->passes[pass];
+	assert(p->write_count < ALICE_FRAME_GRAPH_MAX_PASS_RESOURCES);
+
+	p->writes[p->write_count++] = resource;
+}
+
+static bool alice_frame_graph_desc_equal(alice_frame_graph_target_desc_t a, alice_frame_graph_target_desc_t b) {
+	return a.width == b.width && a.height == b.height && a.attachment_count == b.attachment_count;
+}
+
+static void alice_frame_graph_use(alice_frame_graph_resource_t* resource, u32 index) {
+	if (!resource->used) {
+		resource->used = true;
+		resource->first_use = index;
+	}
+
+	resource->last_use = index;
+}
+
+void alice_compile_frame_graph(alice_frame_graph_t* graph) {
+	assert(graph);
+
+	/* Passes are declared in order, so walking them backwards from the
+	 * outputs finds every pass something downstream depends on. */
+	bool* needed = calloc(alice_max(graph->resource_count, 1), sizeof(bool));
+
+	for (u32 i = 0; i < graph->resource_count; i++) {
+		needed[i] = graph->resources[i].is_output;
+
+		graph->resources[i].used = false;
+		graph->resources[i].physical = 0;
+	}
+
+	graph->culled_pass_count = 0;
+
+	for (u32 i = graph->pass_count; i-- > 0;) {
+		alice_frame_graph_pass_t* pass = &graph->passes[i];
+
+		pass->culled = true;
+		for (u32 j = 0; j < pass->write_count; j++) {
+			if (needed[pass->writes[j]]) {
+				pass->culled = false;
+				break;
+			}
+		}
+
+		if (pass->culled) {
+			graph->culled_pass_count++;
+			continue;
+		}
+
+		for (u32 j = 0; j < pass->read_count; j++) {
+			needed[pass->reads[j]] = true;
+		}
+	}
+
+	free(needed);
+
+	graph->order_count = 0;
+
+	for (u32 i = 0; i < graph->pass_count; i++) {
+		alice_frame_graph_pass_t* pass = &graph->passes[i];
+
+		if (pass->culled) { continue; }
+
+		if (graph->order_count >= graph->order_capacity) {
+			graph->order_capacity = alice_grow_capacity(graph->order_capacity);
+			graph->order = realloc(graph->order, graph->order_capacity * sizeof(u32));
+		}
+
+		const u32 index = graph->order_count++;
+		graph->order[index] = i;
+
+		for (u32 j = 0; j < pass->read_count; j++) {
+			alice_frame_graph_use(&graph->resources[pass->reads[j]], index);
+		}
+
+		for (u32 j = 0; j < pass->write_count; j++) {
+			alice_frame_graph_use(&graph->resources[pass->writes[j]], index);
+		}
+	}
+
+	/* Place the transient targets in order of first use, each into the
+	 * first physical target of the same description that the previous
+	 * occupant is finished with. */
+	graph->physical_count = 0;
+	graph->transient_count = 0;
+
+	for (u32 index = 0; index < graph->order_count; index++) {
+		for (u32 i = 0; i < graph->resource_count; i++) {
+			alice_frame_graph_resource_t* resource = &graph->resources[i];
+
+			if (resource->imported || !resource->used || resource->first_use != index) {
+				continue;
+			}
+
+			graph->transient_count++;
+
+			u32 physical = graph->physical_count;
+			for (u32 j = 0; j < graph->physical_count; j++) {
+				if (graph->physicals[j].last_use < index &&
+						alice_frame_graph_desc_equal(graph->physicals[j].desc, resource->desc)) {
+					physical = j;
+					break;
+				}
+			}
+
+			if (physical == graph->physical_count) {
+				if (graph->physical_count >= graph->physical_capacity) {
+					graph->physical_capacity = alice_grow_capacity(graph->physical_capacity);
+					graph->physicals = realloc(graph->physicals,
+							graph->physical_capacity * sizeof(alice_frame_graph_physical_t));
+				}
+
+				graph->physicals[graph->physical_count++] = (alice_frame_graph_physical_t) {
+					.desc = resource->desc
+				};
+			}
+
+			graph->physicals[physical].last_use = resource->last_use;
+			resource->physical = physical;
+		}
+	}
+}
+
+static u32 alice_frame_graph_take_from_pool(alice_frame_graph_t* graph, alice_frame_graph_target_desc_t desc) {
+	for (u32 i = 0; i < graph->pool_count; i++) {
+		alice_frame_graph_pool_entry_t* entry = &graph->pool[i];
+
+		if (!entry->taken && alice_frame_graph_desc_equal(entry->desc, desc)) {
+			entry->taken = true;
+			return i;
+		}
+	}
+
+	if (graph->pool_count >= graph->pool_capacity) {
+		graph->pool_capacity = alice_grow_capacity(graph->pool_capacity);
+		graph->pool = realloc(graph->pool, graph->pool_capacity * sizeof(alice_frame_graph_pool_entry_t));
+	}
+
+	graph->pool[graph->pool_count] = (alice_frame_graph_pool_entry_t) {
+		.desc = desc,
+		.target = alice_new_render_target(desc.width, desc.height, desc.attachment_count),
+		.taken = true
+	};
+
+	return graph->pool_count++;
+}
+
+void alice_execute_frame_graph(alice_frame_graph_t* graph) {
+	assert(graph);
+
+	for (u32 i = 0; i < graph->pool_count; i++) {
+		graph->pool[i].taken = false;
+	}
+
+	for (u32 i = 0; i < graph->physical_count; i++) {
+		graph->physicals[i].pool_index = alice_frame_graph_take_from_pool(graph, graph->physicals[i].desc);
+	}
+
+	/* Free what the last few frames didn't need. */
+	for (u32 i = 0; i < graph->pool_count;) {
+		alice_frame_graph_pool_entry_t* entry = &graph->pool[i];
+
+		entry->unused_frames = entry->taken ? 0 : entry->unused_frames + 1;
+
+		if (entry->unused_frames > ALICE_FRAME_GRAPH_POOL_FRAMES) {
+			alice_free_render_target(entry->target);
+
+			/* The last entry moves into the gap, and may be one this
+			 * frame has taken. */
+			graph->pool[i] = graph->pool[--graph->pool_count];
+			for (u32 j = 0; j < graph->physical_count; j++) {
+				if (graph->physicals[j].pool_index == graph->pool_count) {
+					graph->physicals[j].pool_index = i;
+				}
+			}
+			continue;
+		}
+
+		i++;
+	}
+
+	for (u32 i = 0; i < graph->order_count; i++) {
+		alice_frame_graph_pass_t* pass = &graph->passes[graph->order[i]];
+
+		alice_begin_gpu_profile_scope(pass->name);
+		pass->execute(graph, pass->data);
+		alice_end_profile_scope();
+	}
+}
+
+alice_render_target_t* alice_frame_graph_get_target(alice_frame_graph_t* graph, u32 resource) {
+	assert(graph);
+	assert(resource < graph->resource_count);
+
+	alice_frame_graph_resource_t* r = &graph->resources[resource];
+
+	if (r->imported) {
+		return r->target;
+	}
+
+	assert(r->used);
+
+	return graph->pool[graph->physicals[r->physical].pool_index].target;
+}
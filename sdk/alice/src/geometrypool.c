@@ -0,0 +1,431 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+
+#include "alice/geometrypool.h"
+#include "alice/glstate.h"
+
+#define ALICE_GEOMETRY_POOL_INITIAL_VERTICES (1 << 16)
+#define ALICE_GEOMETRY_POOL_INITIAL_INDICES (1 << 18)
+#define ALICE_GEOMETRY_POOL_INITIAL_DRAW_INDICES 1024
+
+extern u32 total_draw_calls;
+
+void alice_init_range_allocator(alice_range_allocator_t* allocator, u32 capacity) {
+	assert(allocator);
+
+	allocator->free_ranges = alice_null;
+	allocator->free_count = 0;
+	allocator->free_capacity = 0;
+
+	allocator->capacity = 0;
+	allocator->used = 0;
+
+	alice_range_allocator_grow(allocator, capacity);
+}
+
+void alice_deinit_range_allocator(alice_range_allocator_t* allocator) {
+	assert(allocator);
+
+	if (allocator->free_capacity > 0) {
+		free(allocator->free_ranges);
+	}
+}
+
+static void alice_range_allocator_remove_at(alice_range_allocator_t* allocator, u32 index) {
+	memmove(allocator->free_ranges + index, allocator->free_ranges + index + 1,
+			(allocator->free_count - index - 1) * sizeof(alice_range_t));
+	allocator->free_count--;
+}
+
+/* Inserts a free range in offset order, merging it with its neighbours
+ * where they touch. */
+static void alice_range_allocator_insert(alice_range_allocator_t* allocator, u32 offset, u32 count) {
+	u32 index = 0;
+	while (index < allocator->free_count && allocator->free_ranges[index].offset < offset) {
+		index++;
+	}
+
+	assert(index == 0 || allocator->free_ranges[index - 1].offset +
+			allocator->free_ranges[index - 1].count <= offset);
+	assert(index == allocator->free_count || offset + count <= allocator->free_ranges[index].offset);
+
+	if (index > 0) {
+		alice_range_t* previous = &allocator->free_ranges[index - 1];
+
+		if (previous->offset + previous->count == offset) {
+			previous->count += count;
+
+			if (index < allocator->free_count &&
+					previous->offset + previous->count == allocator->free_ranges[index].offset) {
+				previous->count += allocator->free_ranges[index].count;
+				alice_range_allocator_remove_at(allocator, index);
+			}
+
+			return;
+		}
+	}
+
+	if (index < allocator->free_count && offset + count == allocator->free_ranges[index].offset) {
+		allocator->free_ranges[index].offset = offset;
+		allocator->free_ranges[index].count += count;
+		return;
+	}
+
+	if (allocator->free_count >= allocator->free_capacity) {
+		allocator->free_capacity = alice_grow_capacity(allocator->free_capacity);
+		allocator->free_ranges = realloc(allocator->free_ranges,
+				allocator->free_capacity * sizeof(alice_range_t));
+	}
+
+	memmove(allocator->free_ranges + index + 1, allocator->free_ranges + index,
+			(allocator->free_count - index) * sizeof(alice_range_t));
+	allocator->free_ranges[index] = (alice_range_t) { offset, count };
+	allocator->free_count++;
+}
+
+bool alice_range_allocate(alice_range_allocator_t* allocator, u32 count, u32* offset) {
+	assert(allocator);
+	assert(offset);
+
+	if (count == 0) {
+		*offset = 0;
+		return true;
+	}
+
+	for (u32 i = 0; i < allocator->free_count; i++) {
+		alice_range_t* range = &allocator->free_ranges[i];
+
+		if (range->count >= count) {
+			*offset = range->offset;
+
+			range->offset += count;
+			range->count -= count;
+
+			if (range->count == 0) {
+				alice_range_allocator_remove_at(allocator, i);
+			}
+
+			allocator->used += count;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void alice_range_free(alice_range_allocator_t* allocator, u32 offset, u32 count) {
+	assert(allocator);
+	assert(offset + count <= allocator->capacity);
+
+	if (count == 0) { return; }
+
+	assert(count <= allocator->used);
+
+	alice_range_allocator_insert(allocator, offset, count);
+	allocator->used -= count;
+}
+
+void alice_range_allocator_grow(alice_range_allocator_t* allocator, u32 capacity) {
+	assert(allocator);
+
+	if (capacity <= allocator->capacity) { return; }
+
+	const u32 old_capacity = allocator->capacity;
+	allocator->capacity = capacity;
+
+	alice_range_allocator_insert(allocator, old_capacity, capacity - old_capacity);
+}
+
+static alice_geometry_pool_t* geometry_pool = alice_null;
+
+static void alice_geometry_pool_configure(alice_geometry_pool_t* pool) {
+	alice_gl_bind_vertex_array(pool->va_id);
+
+	glBindBuffer(GL_ARRAY_BUFFER, pool->vb_id);
+
+	const u32 stride = ALICE_GEOMETRY_VERTEX_STRIDE * sizeof(float);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)(0 * sizeof(float))); /* vec3 position */
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float))); /* vec3 normal */
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float))); /* vec2 uv */
+	glEnableVertexAttribArray(2);
+
+	glBindBuffer(GL_ARRAY_BUFFER, pool->draw_index_id);
+	glVertexAttribIPointer(ALICE_GEOMETRY_DRAW_INDEX_ATTRIBUTE, 1, GL_UNSIGNED_INT, sizeof(u32), (void*)0);
+	glVertexAttribDivisor(ALICE_GEOMETRY_DRAW_INDEX_ATTRIBUTE, 1);
+	glEnableVertexAttribArray(ALICE_GEOMETRY_DRAW_INDEX_ATTRIBUTE);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool->ib_id);
+
+	alice_gl_bind_vertex_array(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/* Moves the contents of `buffer' into a new, larger buffer. The vertex
+ * array has to be reconfigured afterwards. */
+static void alice_geometry_pool_resize_buffer(u32* buffer, u32 old_size, u32 new_size) {
+	u32 new_buffer;
+	glGenBuffers(1, &new_buffer);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, new_size, alice_null, GL_STATIC_DRAW);
+
+	if (old_size > 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, *buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_size);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, buffer);
+	*buffer = new_buffer;
+}
+
+alice_geometry_pool_t* alice_get_geometry_pool() {
+	if (geometry_pool) {
+		return geometry_pool;
+	}
+
+	alice_geometry_pool_t* new = malloc(sizeof(alice_geometry_pool_t));
+
+	alice_init_range_allocator(&new->vertices, ALICE_GEOMETRY_POOL_INITIAL_VERTICES);
+	alice_init_range_allocator(&new->indices, ALICE_GEOMETRY_POOL_INITIAL_INDICES);
+
+	glGenVertexArrays(1, &new->va_id);
+	glGenBuffers(1, &new->vb_id);
+	glGenBuffers(1, &new->ib_id);
+	glGenBuffers(1, &new->draw_index_id);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, new->vb_id);
+	glBufferData(GL_COPY_WRITE_BUFFER,
+			new->vertices.capacity * ALICE_GEOMETRY_VERTEX_STRIDE * sizeof(float),
+			alice_null, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, new->ib_id);
+	glBufferData(GL_COPY_WRITE_BUFFER, new->indices.capacity * sizeof(u32), alice_null, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	new->draw_index_capacity = 0;
+
+	geometry_pool = new;
+
+	alice_geometry_pool_reserve_draw_indices(new, ALICE_GEOMETRY_POOL_INITIAL_DRAW_INDICES);
+
+	return new;
+}
+
+void alice_free_geometry_pool() {
+	if (!geometry_pool) { return; }
+
+	alice_geometry_pool_t* pool = geometry_pool;
+
+	glDeleteVertexArrays(1, &pool->va_id);
+	alice_gl_forget_vertex_array(pool->va_id);
+	glDeleteBuffers(1, &pool->vb_id);
+	glDeleteBuffers(1, &pool->ib_id);
+	glDeleteBuffers(1, &pool->draw_index_id);
+
+	alice_deinit_range_allocator(&pool->vertices);
+	alice_deinit_range_allocator(&pool->indices);
+
+	free(pool);
+
+	geometry_pool = alice_null;
+}
+
+/* Returns true if the index buffer had to grow, in which case the vertex
+ * array needs configuring again. */
+static bool alice_geometry_pool_allocate_indices(alice_geometry_pool_t* pool, u32 count, u32* first_index) {
+	if (alice_range_allocate(&pool->indices, count, first_index)) {
+		return false;
+	}
+
+	const u32 old_capacity = pool->indices.capacity;
+
+	u32 new_capacity = old_capacity;
+	while (new_capacity - old_capacity < count) {
+		new_capacity = alice_grow_capacity(new_capacity);
+	}
+
+	alice_geometry_pool_resize_buffer(&pool->ib_id,
+			old_capacity * sizeof(u32), new_capacity * sizeof(u32));
+	alice_range_allocator_grow(&pool->indices, new_capacity);
+
+	alice_range_allocate(&pool->indices, count, first_index);
+
+	return true;
+}
+
+alice_geometry_t alice_geometry_pool_add(alice_geometry_pool_t* pool,
+		float* vertices, u32 vertex_count, u32* indices, u32 index_count) {
+	assert(pool);
+	assert(vertex_count % ALICE_GEOMETRY_VERTEX_STRIDE == 0);
+
+	const u32 vertex_size = ALICE_GEOMETRY_VERTEX_STRIDE * sizeof(float);
+
+	alice_geometry_t geometry = {
+		.vertex_count = vertex_count / ALICE_GEOMETRY_VERTEX_STRIDE,
+		.index_count = index_count
+	};
+
+	bool reconfigure = false;
+
+	if (!alice_range_allocate(&pool->vertices, geometry.vertex_count, &geometry.base_vertex)) {
+		const u32 old_capacity = pool->vertices.capacity;
+
+		u32 new_capacity = old_capacity;
+		while (new_capacity - old_capacity < geometry.vertex_count) {
+			new_capacity = alice_grow_capacity(new_capacity);
+		}
+
+		alice_geometry_pool_resize_buffer(&pool->vb_id,
+				old_capacity * vertex_size, new_capacity * vertex_size);
+		alice_range_allocator_grow(&pool->vertices, new_capacity);
+
+		alice_range_allocate(&pool->vertices, geometry.vertex_count, &geometry.base_vertex);
+
+		reconfigure = true;
+	}
+
+	if (alice_geometry_pool_allocate_indices(pool, index_count, &geometry.first_index)) {
+		reconfigure = true;
+	}
+
+	if (reconfigure) {
+		alice_geometry_pool_configure(pool);
+	}
+
+	/* Uploads go through the copy target so that the element buffer
+	 * binding of whatever vertex array is bound doesn't change. */
+	glBindBuffer(GL_COPY_WRITE_BUFFER, pool->vb_id);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, geometry.base_vertex * vertex_size,
+			geometry.vertex_count * vertex_size, vertices);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, pool->ib_id);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, geometry.first_index * sizeof(u32),
+			index_count * sizeof(u32), indices);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	return geometry;
+}
+
+alice_geometry_t alice_geometry_pool_add_indices(alice_geometry_pool_t* pool,
+		const alice_geometry_t* geometry, u32* indices, u32 index_count) {
+	assert(pool);
+	assert(geometry);
+
+	alice_geometry_t result = {
+		.base_vertex = geometry->base_vertex,
+		.vertex_count = geometry->vertex_count,
+		.index_count = index_count
+	};
+
+	if (alice_geometry_pool_allocate_indices(pool, index_count, &result.first_index)) {
+		alice_geometry_pool_configure(pool);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, pool->ib_id);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, result.first_index * sizeof(u32),
+			index_count * sizeof(u32), indices);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	return result;
+}
+
+void alice_geometry_pool_remove(alice_geometry_pool_t* pool, alice_geometry_t* geometry) {
+	assert(pool);
+	assert(geometry);
+
+	alice_range_free(&pool->vertices, geometry->base_vertex, geometry->vertex_count);
+	alice_range_free(&pool->indices, geometry->first_index, geometry->index_count);
+
+	geometry->vertex_count = 0;
+	geometry->index_count = 0;
+}
+
+void alice_geometry_pool_remove_indices(alice_geometry_pool_t* pool, alice_geometry_t* geometry) {
+	assert(pool);
+	assert(geometry);
+
+	alice_range_free(&pool->indices, geometry->first_index, geometry->index_count);
+
+	geometry->vertex_count = 0;
+	geometry->index_count = 0;
+}
+
+void alice_geometry_pool_read(alice_geometry_pool_t* pool, alice_geometry_t* geometry,
+		float* vertices, u32* indices) {
+	assert(pool);
+	assert(geometry);
+
+	const u32 vertex_size = ALICE_GEOMETRY_VERTEX_STRIDE * sizeof(float);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, pool->vb_id);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, geometry->base_vertex * vertex_size,
+			geometry->vertex_count * vertex_size, vertices);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, pool->ib_id);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, geometry->first_index * sizeof(u32),
+			geometry->index_count * sizeof(u32), indices);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void alice_bind_geometry_pool(alice_geometry_pool_t* pool) {
+	alice_gl_bind_vertex_array(pool ? pool->va_id : 0);
+}
+
+void alice_geometry_pool_reserve_draw_indices(alice_geometry_pool_t* pool, u32 count) {
+	assert(pool);
+
+	if (count <= pool->draw_index_capacity) { return; }
+
+	u32 new_capacity = alice_max(pool->draw_index_capacity, 1);
+	while (new_capacity < count) {
+		new_capacity = alice_grow_capacity(new_capacity);
+	}
+
+	u32* draw_indices = malloc(new_capacity * sizeof(u32));
+	for (u32 i = 0; i < new_capacity; i++) {
+		draw_indices[i] = i;
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, pool->draw_index_id);
+	glBufferData(GL_COPY_WRITE_BUFFER, new_capacity * sizeof(u32), draw_indices, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	free(draw_indices);
+
+	if (pool->draw_index_capacity == 0) {
+		alice_geometry_pool_configure(pool);
+	}
+
+	pool->draw_index_capacity = new_capacity;
+}
+
+void alice_draw_geometry(alice_geometry_t* geometry) {
+	assert(geometry);
+
+	glDrawElementsBaseVertex(GL_TRIANGLES, geometry->index_count, GL_UNSIGNED_INT,
+			(void*)(u64)(geometry->first_index * sizeof(u32)), geometry->base_vertex);
+
+	total_draw_calls++;
+}
+
+void alice_draw_geometry_indirect(u32 first_command, u32 command_count) {
+	if (command_count == 0) { return; }
+
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			(void*)(u64)(first_command * sizeof(alice_draw_command_t)), command_count, 0);
+
+	total_draw_calls++;
+}
@@ -0,0 +1,339 @@
+#include <assert.h>
+#include <string.h>
+
+#include <glad/glad.h>
+
+#include "alice/glstate.h"
+
+#define ALICE_GL_UNKNOWN 0xffffffff
+
+typedef enum alice_gl_capability_t {
+	ALICE_GL_CAPABILITY_DEPTH_TEST = 0,
+	ALICE_GL_CAPABILITY_BLEND,
+	ALICE_GL_CAPABILITY_CULL_FACE,
+	ALICE_GL_CAPABILITY_SCISSOR_TEST,
+	ALICE_GL_CAPABILITY_COUNT
+} alice_gl_capability_t;
+
+typedef enum alice_gl_tristate_t {
+	ALICE_GL_OFF = 0,
+	ALICE_GL_ON = 1,
+	ALICE_GL_UNSET = 2
+} alice_gl_tristate_t;
+
+static void alice_gl_default_use_program(u32 program) { glUseProgram(program); }
+static void alice_gl_default_bind_vertex_array(u32 array) { glBindVertexArray(array); }
+static void alice_gl_default_active_texture(u32 unit) { glActiveTexture(unit); }
+static void alice_gl_default_bind_texture(u32 target, u32 texture) { glBindTexture(target, texture); }
+static void alice_gl_default_bind_framebuffer(u32 target, u32 framebuffer) { glBindFramebuffer(target, framebuffer); }
+static void alice_gl_default_enable(u32 capability) { glEnable(capability); }
+static void alice_gl_default_disable(u32 capability) { glDisable(capability); }
+static bool alice_gl_default_is_enabled(u32 capability) { return glIsEnabled(capability); }
+static void alice_gl_default_depth_mask(bool write) { glDepthMask(write ? GL_TRUE : GL_FALSE); }
+static void alice_gl_default_blend_func(u32 source, u32 destination) { glBlendFunc(source, destination); }
+static void alice_gl_default_cull_face(u32 mode) { glCullFace(mode); }
+static void alice_gl_default_viewport(i32 x, i32 y, i32 width, i32 height) { glViewport(x, y, width, height); }
+
+static const alice_gl_functions_t default_functions = {
+	.use_program = alice_gl_default_use_program,
+	.bind_vertex_array = alice_gl_default_bind_vertex_array,
+	.active_texture = alice_gl_default_active_texture,
+	.bind_texture = alice_gl_default_bind_texture,
+	.bind_framebuffer = alice_gl_default_bind_framebuffer,
+	.enable = alice_gl_default_enable,
+	.disable = alice_gl_default_disable,
+	.is_enabled = alice_gl_default_is_enabled,
+	.depth_mask = alice_gl_default_depth_mask,
+	.blend_func = alice_gl_default_blend_func,
+	.cull_face = alice_gl_default_cull_face,
+	.viewport = alice_gl_default_viewport
+};
+
+typedef struct alice_gl_state_t {
+	alice_gl_functions_t functions;
+
+	u32 program;
+	u32 vertex_array;
+
+	/* GL_FRAMEBUFFER binds both. */
+	u32 read_framebuffer;
+	u32 draw_framebuffer;
+
+	u32 active_unit;
+	u32 textures_2d[ALICE_GL_MAX_TEXTURE_UNITS];
+	u32 textures_cube[ALICE_GL_MAX_TEXTURE_UNITS];
+
+	alice_gl_tristate_t capabilities[ALICE_GL_CAPABILITY_COUNT];
+	alice_gl_tristate_t depth_mask;
+
+	u32 blend_source, blend_destination;
+	u32 cull_face;
+
+	bool viewport_known;
+	i32 viewport[4];
+
+	alice_gl_state_stats_t stats;
+} alice_gl_state_t;
+
+/* Filled in by alice_set_gl_functions, which alice_init_application calls
+ * once the context exists. */
+static alice_gl_state_t gl_state;
+
+static i32 alice_gl_capability_index(u32 capability) {
+	switch (capability) {
+		case GL_DEPTH_TEST: return ALICE_GL_CAPABILITY_DEPTH_TEST;
+		case GL_BLEND: return ALICE_GL_CAPABILITY_BLEND;
+		case GL_CULL_FACE: return ALICE_GL_CAPABILITY_CULL_FACE;
+		case GL_SCISSOR_TEST: return ALICE_GL_CAPABILITY_SCISSOR_TEST;
+		default: return -1;
+	}
+}
+
+/* Returns the cached texture binding for `target' on `unit', or null for
+ * bindings that aren't tracked. */
+static u32* alice_gl_texture_slot(u32 unit, u32 target) {
+	if (unit >= ALICE_GL_MAX_TEXTURE_UNITS) { return alice_null; }
+
+	switch (target) {
+		case GL_TEXTURE_2D: return &gl_state.textures_2d[unit];
+		case GL_TEXTURE_CUBE_MAP: return &gl_state.textures_cube[unit];
+		default: return alice_null;
+	}
+}
+
+void alice_set_gl_functions(const alice_gl_functions_t* functions) {
+	gl_state.functions = functions ? *functions : default_functions;
+
+	alice_invalidate_gl_state();
+}
+
+void alice_invalidate_gl_state() {
+	gl_state.program = ALICE_GL_UNKNOWN;
+	gl_state.vertex_array = ALICE_GL_UNKNOWN;
+	gl_state.read_framebuffer = ALICE_GL_UNKNOWN;
+	gl_state.draw_framebuffer = ALICE_GL_UNKNOWN;
+
+	gl_state.active_unit = ALICE_GL_UNKNOWN;
+	for (u32 i = 0; i < ALICE_GL_MAX_TEXTURE_UNITS; i++) {
+		gl_state.textures_2d[i] = ALICE_GL_UNKNOWN;
+		gl_state.textures_cube[i] = ALICE_GL_UNKNOWN;
+	}
+
+	for (u32 i = 0; i < ALICE_GL_CAPABILITY_COUNT; i++) {
+		gl_state.capabilities[i] = ALICE_GL_UNSET;
+	}
+	gl_state.depth_mask = ALICE_GL_UNSET;
+
+	gl_state.blend_source = ALICE_GL_UNKNOWN;
+	gl_state.blend_destination = ALICE_GL_UNKNOWN;
+	gl_state.cull_face = ALICE_GL_UNKNOWN;
+
+	gl_state.viewport_known = false;
+}
+
+alice_gl_state_stats_t alice_get_gl_state_stats() {
+	return gl_state.stats;
+}
+
+void alice_reset_gl_state_stats() {
+	gl_state.stats = (alice_gl_state_stats_t) { 0 };
+}
+
+void alice_gl_use_program(u32 program) {
+	if (gl_state.program == program) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	gl_state.functions.use_program(program);
+	gl_state.program = program;
+	gl_state.stats.issued++;
+}
+
+void alice_gl_bind_vertex_array(u32 array) {
+	if (gl_state.vertex_array == array) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	gl_state.functions.bind_vertex_array(array);
+	gl_state.vertex_array = array;
+	gl_state.stats.issued++;
+}
+
+void alice_gl_bind_texture(u32 unit, u32 target, u32 texture) {
+	u32* slot = alice_gl_texture_slot(unit, target);
+
+	if (slot && *slot == texture) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	if (gl_state.active_unit != unit) {
+		gl_state.functions.active_texture(GL_TEXTURE0 + unit);
+		gl_state.active_unit = unit;
+		gl_state.stats.issued++;
+	}
+
+	gl_state.functions.bind_texture(target, texture);
+	gl_state.stats.issued++;
+
+	if (slot) {
+		*slot = texture;
+	}
+}
+
+void alice_gl_bind_framebuffer(u32 framebuffer) {
+	if (gl_state.read_framebuffer == framebuffer && gl_state.draw_framebuffer == framebuffer) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	gl_state.functions.bind_framebuffer(GL_FRAMEBUFFER, framebuffer);
+	gl_state.read_framebuffer = framebuffer;
+	gl_state.draw_framebuffer = framebuffer;
+	gl_state.stats.issued++;
+}
+
+void alice_gl_bind_read_framebuffer(u32 framebuffer) {
+	if (gl_state.read_framebuffer == framebuffer) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	gl_state.functions.bind_framebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	gl_state.read_framebuffer = framebuffer;
+	gl_state.stats.issued++;
+}
+
+void alice_gl_bind_draw_framebuffer(u32 framebuffer) {
+	if (gl_state.draw_framebuffer == framebuffer) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	gl_state.functions.bind_framebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	gl_state.draw_framebuffer = framebuffer;
+	gl_state.stats.issued++;
+}
+
+void alice_gl_set_capability(u32 capability, bool enabled) {
+	const i32 index = alice_gl_capability_index(capability);
+	const alice_gl_tristate_t wanted = enabled ? ALICE_GL_ON : ALICE_GL_OFF;
+
+	if (index >= 0 && gl_state.capabilities[index] == wanted) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	if (enabled) {
+		gl_state.functions.enable(capability);
+	} else {
+		gl_state.functions.disable(capability);
+	}
+	gl_state.stats.issued++;
+
+	if (index >= 0) {
+		gl_state.capabilities[index] = wanted;
+	}
+}
+
+bool alice_gl_is_enabled(u32 capability) {
+	const i32 index = alice_gl_capability_index(capability);
+
+	if (index >= 0 && gl_state.capabilities[index] != ALICE_GL_UNSET) {
+		return gl_state.capabilities[index] == ALICE_GL_ON;
+	}
+
+	const bool enabled = gl_state.functions.is_enabled(capability);
+
+	if (index >= 0) {
+		gl_state.capabilities[index] = enabled ? ALICE_GL_ON : ALICE_GL_OFF;
+	}
+
+	return enabled;
+}
+
+void alice_gl_depth_mask(bool write) {
+	const alice_gl_tristate_t wanted = write ? ALICE_GL_ON : ALICE_GL_OFF;
+
+	if (gl_state.depth_mask == wanted) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	gl_state.functions.depth_mask(write);
+	gl_state.depth_mask = wanted;
+	gl_state.stats.issued++;
+}
+
+void alice_gl_blend_func(u32 source, u32 destination) {
+	if (gl_state.blend_source == source && gl_state.blend_destination == destination) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	gl_state.functions.blend_func(source, destination);
+	gl_state.blend_source = source;
+	gl_state.blend_destination = destination;
+	gl_state.stats.issued++;
+}
+
+void alice_gl_cull_face(u32 mode) {
+	if (gl_state.cull_face == mode) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	gl_state.functions.cull_face(mode);
+	gl_state.cull_face = mode;
+	gl_state.stats.issued++;
+}
+
+void alice_gl_viewport(i32 x, i32 y, i32 width, i32 height) {
+	const i32 viewport[] = { x, y, width, height };
+
+	if (gl_state.viewport_known && memcmp(gl_state.viewport, viewport, sizeof(viewport)) == 0) {
+		gl_state.stats.skipped++;
+		return;
+	}
+
+	gl_state.functions.viewport(x, y, width, height);
+	memcpy(gl_state.viewport, viewport, sizeof(viewport));
+	gl_state.viewport_known = true;
+	gl_state.stats.issued++;
+}
+
+void alice_gl_forget_program(u32 program) {
+	if (gl_state.program == program) {
+		gl_state.program = ALICE_GL_UNKNOWN;
+	}
+}
+
+void alice_gl_forget_vertex_array(u32 array) {
+	if (gl_state.vertex_array == array) {
+		gl_state.vertex_array = 0;
+	}
+}
+
+void alice_gl_forget_texture(u32 texture) {
+	for (u32 i = 0; i < ALICE_GL_MAX_TEXTURE_UNITS; i++) {
+		if (gl_state.textures_2d[i] == texture) {
+			gl_state.textures_2d[i] = 0;
+		}
+
+		if (gl_state.textures_cube[i] == texture) {
+			gl_state.textures_cube[i] = 0;
+		}
+	}
+}
+
+void alice_gl_forget_framebuffer(u32 framebuffer) {
+	if (gl_state.read_framebuffer == framebuffer) {
+		gl_state.read_framebuffer = 0;
+	}
+
+	if (gl_state.draw_framebuffer == framebuffer) {
+		gl_state.draw_framebuffer = 0;
+	}
+}
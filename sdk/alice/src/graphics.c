@@ -9,7 +9,19 @@
 
 #include "alice/graphics.h"
 #include "alice/debugrenderer.h"
+#include "alice/renderqueue.h"
+#include "alice/staticbatch.h"
 #include "alice/input.h"
+#include "alice/glstate.h"
+#include "alice/jobs.h"
+#include "alice/bvh.h"
+#include "alice/occlusion.h"
+#include "alice/lightclusters.h"
+#include "alice/framegraph.h"
+#include "alice/application.h"
+#include "alice/profiler.h"
+#include "alice/shadercache.h"
+#include "alice/meshsimplify.h"
 
 u32 total_draw_calls;
 
@@ -49,11 +61,11 @@ alice_render_target_t* alice_new_render_target(u32 width, u32 height, u32 color_
 	target->color_attachments = malloc(color_attachment_count * sizeof(u32));
 
 	glGenFramebuffers(1, &target->frame_buffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, target->frame_buffer);
+	alice_gl_bind_framebuffer(target->frame_buffer);
 
 	glGenTextures(color_attachment_count, target->color_attachments);
 	for (u32 i = 0; i < color_attachment_count; i++) {
-		glBindTexture(GL_TEXTURE_2D, target->color_attachments[i]);
+		alice_gl_bind_texture(0, GL_TEXTURE_2D, target->color_attachments[i]);
 
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA,
 			GL_FLOAT, NULL);
@@ -75,6 +87,18 @@ alice_render_target_t* alice_new_render_target(u32 width, u32 height, u32 color_
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
 		GL_RENDERBUFFER, target->render_buffer);
 
+	/* Only the first attachment is drawn to unless asked otherwise. */
+	if (color_attachment_count > 1) {
+		u32* draw_buffers = malloc(color_attachment_count * sizeof(u32));
+		for (u32 i = 0; i < color_attachment_count; i++) {
+			draw_buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		}
+
+		glDrawBuffers(color_attachment_count, draw_buffers);
+
+		free(draw_buffers);
+	}
+
 	alice_unbind_render_target(target);
 
 	return target;
@@ -85,8 +109,12 @@ void alice_free_render_target(alice_render_target_t* target) {
 
 	glDeleteRenderbuffers(1, &target->render_buffer);
 	glDeleteFramebuffers(1, &target->frame_buffer);
+	alice_gl_forget_framebuffer(target->frame_buffer);
 
 	glDeleteTextures(target->color_attachment_count, target->color_attachments);
+	for (u32 i = 0; i < target->color_attachment_count; i++) {
+		alice_gl_forget_texture(target->color_attachments[i]);
+	}
 
 	if (target->color_attachment_count > 0) {
 		free(target->color_attachments);
@@ -101,9 +129,9 @@ void alice_bind_render_target(alice_render_target_t* target, u32 old_width, u32
 	target->old_width = old_width;
 	target->old_height = old_height;
 
-	glBindFramebuffer(GL_FRAMEBUFFER, target->frame_buffer);
+	alice_gl_bind_framebuffer(target->frame_buffer);
 	glBindRenderbuffer(GL_RENDERBUFFER, target->render_buffer);
-	glViewport(0, 0, target->width, target->height);
+	alice_gl_viewport(0, 0, target->width, target->height);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
@@ -111,9 +139,9 @@ void alice_unbind_render_target(alice_render_target_t* target) {
 	assert(target);
 
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	alice_gl_bind_framebuffer(0);
 
-	glViewport(0, 0, target->old_width, target->old_height);
+	alice_gl_viewport(0, 0, target->old_width, target->old_height);
 }
 
 void alice_resize_render_target(alice_render_target_t* target, u32 width, u32 height) {
@@ -126,9 +154,9 @@ void alice_resize_render_target(alice_render_target_t* target, u32 width, u32 he
 	target->width = width;
 	target->height = height;
 
-	glBindFramebuffer(GL_FRAMEBUFFER, target->frame_buffer);
+	alice_gl_bind_framebuffer(target->frame_buffer);
 	for (u32 i = 0; i < target->color_attachment_count; i++) {
-		glBindTexture(GL_TEXTURE_2D, target->color_attachments[i]);
+		alice_gl_bind_texture(0, GL_TEXTURE_2D, target->color_attachments[i]);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA,
 			GL_FLOAT, NULL);
 	}
@@ -147,8 +175,7 @@ void alice_render_target_bind_output(alice_render_target_t* target, u32 attachme
 	assert(target);
 	assert(attachment_index < target->color_attachment_count);
 
-	glActiveTexture(GL_TEXTURE0 + unit);
-	glBindTexture(GL_TEXTURE_2D, target->color_attachments[attachment_index]);
+	alice_gl_bind_texture(unit, GL_TEXTURE_2D, target->color_attachments[attachment_index]);
 }
 
 alice_vertex_buffer_t* alice_new_vertex_buffer(alice_vertex_buffer_flags_t flags) {
@@ -167,6 +194,7 @@ void alice_free_vertex_buffer(alice_vertex_buffer_t* buffer) {
 	assert(buffer);
 
 	glDeleteVertexArrays(1, &buffer->va_id);
+	alice_gl_forget_vertex_array(buffer->va_id);
 	glDeleteBuffers(1, &buffer->vb_id);
 	glDeleteBuffers(1, &buffer->ib_id);
 
@@ -174,17 +202,17 @@ void alice_free_vertex_buffer(alice_vertex_buffer_t* buffer) {
 }
 
 void alice_bind_vertex_buffer_for_draw(alice_vertex_buffer_t* buffer) {
-	glBindVertexArray(buffer ? buffer->va_id : 0);
+	alice_gl_bind_vertex_array(buffer ? buffer->va_id : 0);
 }
 
 void alice_bind_vertex_buffer_for_edit(alice_vertex_buffer_t* buffer) {
 	if (!buffer) {
-		glBindVertexArray(0);
+		alice_gl_bind_vertex_array(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 	else {
-		glBindVertexArray(buffer->va_id);
+		alice_gl_bind_vertex_array(buffer->va_id);
 		glBindBuffer(GL_ARRAY_BUFFER, buffer->vb_id);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->ib_id);
 	}
@@ -271,146 +299,570 @@ void alice_draw_vertex_buffer_custom_count(alice_vertex_buffer_t* buffer, u32 co
 	total_draw_calls++;
 }
 
-alice_shader_t* alice_init_shader(alice_shader_t* shader, char* source) {
-	assert(shader);
+void alice_draw_vertex_buffer_instanced(alice_vertex_buffer_t* buffer, u32 instance_count) {
+	assert(buffer);
 
-	shader->panic_mode = false;
+	u32 draw_type = GL_TRIANGLES;
+	if (buffer->flags & ALICE_VERTEXBUFFER_DRAW_LINES) {
+		draw_type = GL_LINES;
+	}
+	else if (buffer->flags & ALICE_VERTEXBUFFER_DRAW_LINE_STRIP) {
+		draw_type = GL_LINE_STRIP;
+	}
 
-	const u32 source_len = (u32)strlen(source);
+	glDrawElementsInstanced(draw_type, buffer->index_count, GL_UNSIGNED_INT, 0, instance_count);
 
-	char* vertex_source = malloc(source_len);
-	char* fragment_source = malloc(source_len);
-	char* geometry_source = malloc(source_len);
-	memset(vertex_source, 0, source_len);
-	memset(fragment_source, 0, source_len);
-	memset(geometry_source, 0, source_len);
+	total_draw_calls++;
+}
 
-	bool has_geometry = false;
+static u32 alice_gpu_buffer_target(alice_gpu_buffer_type_t type) {
+	switch (type) {
+		case ALICE_GPU_BUFFER_UNIFORM: return GL_UNIFORM_BUFFER;
+		case ALICE_GPU_BUFFER_STORAGE: return GL_SHADER_STORAGE_BUFFER;
+		case ALICE_GPU_BUFFER_INDIRECT: return GL_DRAW_INDIRECT_BUFFER;
+		default: return GL_UNIFORM_BUFFER;
+	}
+}
 
-	u32 count = 0;
-	i32 adding_to = -1;
-	for (char* current = source; *current != '\0'; current++) {
-		if (*current == '\n' && *(current + 1) != '\0') {
-			i32 minus = 1;
+alice_gpu_buffer_t* alice_new_gpu_buffer(alice_gpu_buffer_type_t type, u32 capacity) {
+	alice_gpu_buffer_t* new = malloc(sizeof(alice_gpu_buffer_t));
 
-			current++;
+	new->type = type;
+	new->size = 0;
+	new->capacity = alice_max(capacity, 16);
 
-			char* line = current - count - minus;
-			line[count] = '\0';
+	const u32 target = alice_gpu_buffer_target(type);
 
-			if (strstr(line, "#begin VERTEX")) {
-				adding_to = 0;
-			}
-			else if (strstr(line, "#begin FRAGMENT")) {
-				adding_to = 1;
-			}
-			else if (strstr(line, "#begin GEOMETRY")) {
-				adding_to = 2;
-				has_geometry = true;
-			}
-			else if (strstr(line, "#end VERTEX") ||
-				strstr(line, "#end FRAGMENT") ||
-				strstr(line, "#end GEOMETRY")) {
-				adding_to = -1;
-			}
-			else if (adding_to == 0) {
-				strcat(vertex_source, line);
-				strcat(vertex_source, "\n");
-			}
-			else if (adding_to == 1) {
-				strcat(fragment_source, line);
-				strcat(fragment_source, "\n");
-			}
-			else if (adding_to == 2) {
-				strcat(geometry_source, line);
-				strcat(geometry_source, "\n");
+	glGenBuffers(1, &new->id);
+	glBindBuffer(target, new->id);
+	glBufferData(target, new->capacity, alice_null, GL_DYNAMIC_DRAW);
+	glBindBuffer(target, 0);
+
+	return new;
+}
+
+void alice_free_gpu_buffer(alice_gpu_buffer_t* buffer) {
+	assert(buffer);
+
+	glDeleteBuffers(1, &buffer->id);
+
+	free(buffer);
+}
+
+void alice_update_gpu_buffer(alice_gpu_buffer_t* buffer, const void* data, u32 size) {
+	assert(buffer);
+
+	const u32 target = alice_gpu_buffer_target(buffer->type);
+
+	glBindBuffer(target, buffer->id);
+
+	/* Orphan the old storage so the driver doesn't have to wait for draws
+	 * still reading from it. */
+	while (size > buffer->capacity) {
+		buffer->capacity = alice_grow_capacity(buffer->capacity);
+	}
+	glBufferData(target, buffer->capacity, alice_null, GL_DYNAMIC_DRAW);
+
+	if (size > 0) {
+		glBufferSubData(target, 0, size, data);
+	}
+
+	glBindBuffer(target, 0);
+
+	buffer->size = size;
+}
+
+void alice_bind_gpu_buffer(alice_gpu_buffer_t* buffer, u32 binding) {
+	assert(buffer);
+
+	if (buffer->type == ALICE_GPU_BUFFER_INDIRECT) {
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer->id);
+		return;
+	}
+
+	glBindBufferBase(alice_gpu_buffer_target(buffer->type), binding, buffer->id);
+}
+
+static void alice_shader_insert_uniform(alice_shader_t* shader, const char* name, alice_uniform_t location) {
+	const u32 hash = alice_hash_string(name);
+
+	u32 index = hash % shader->uniform_capacity;
+
+	for (;;) {
+		alice_shader_uniform_t* entry = &shader->uniforms[index];
+
+		if (!entry->occupied) {
+			*entry = (alice_shader_uniform_t) {
+				.name = alice_copy_string(name),
+				.hash = hash,
+				.location = location,
+				.occupied = true
+			};
+
+			shader->uniform_count++;
+			return;
+		}
+
+		if (entry->hash == hash) {
+			if (strcmp(entry->name, name) == 0) {
+				entry->location = location;
+				return;
 			}
 
-			count = 0;
+			/* Different names with the same hash. Keep probing, so that both
+			 * are stored. */
+			entry->ambiguous = true;
+		}
+
+		index = (index + 1) % shader->uniform_capacity;
+	}
+}
+
+static alice_shader_uniform_t* alice_shader_find_uniform(alice_shader_t* shader, u32 hash, const char* name) {
+	if (shader->uniform_count == 0) { return alice_null; }
+
+	u32 index = hash % shader->uniform_capacity;
+
+	for (;;) {
+		alice_shader_uniform_t* entry = &shader->uniforms[index];
+
+		if (!entry->occupied) {
+			return alice_null;
+		}
+
+		if (entry->hash == hash && (!name || strcmp(entry->name, name) == 0)) {
+			return entry;
 		}
 
-		count++;
+		index = (index + 1) % shader->uniform_capacity;
 	}
+}
 
-	const char* vsp = vertex_source;
-	const char* fsp = fragment_source;
-	const char* gsp = geometry_source;
+static void alice_shader_cache_uniforms(alice_shader_t* shader) {
+	i32 active_count = 0;
+	i32 max_name_length = 0;
+	glGetProgramiv(shader->id, GL_ACTIVE_UNIFORMS, &active_count);
+	glGetProgramiv(shader->id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+	if (active_count <= 0) {
+		return;
+	}
 
-	i32 success;
-	u32 v, f, g;
-	v = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(v, 1, &vsp, NULL);
-	glCompileShader(v);
+	/* Arrays of basic types are reported once, so count every element
+	 * before sizing the table. */
+	u32 entry_count = 0;
+	for (i32 i = 0; i < active_count; i++) {
+		i32 size;
+		u32 type;
+		glGetActiveUniform(shader->id, (u32)i, 0, alice_null, &size, &type, alice_null);
 
-	glGetShaderiv(v, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		char info_log[1024];
-		glGetShaderInfoLog(v, 1024, alice_null, info_log);
-		alice_log_error("%s", info_log);
-		shader->panic_mode = true;
+		entry_count += (u32)size + 1;
 	}
 
-	f = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(f, 1, &fsp, NULL);
-	glCompileShader(f);
+	shader->uniform_capacity = 8;
+	while (shader->uniform_capacity < entry_count * 2) {
+		shader->uniform_capacity = alice_grow_capacity(shader->uniform_capacity);
+	}
 
-	glGetShaderiv(f, GL_COMPILE_STATUS, &success);
-	if (!success) {
+	shader->uniforms = calloc(shader->uniform_capacity, sizeof(alice_shader_uniform_t));
+	shader->uniform_count = 0;
+
+	const u32 name_capacity = (u32)max_name_length + 16;
+	char* name = malloc(name_capacity);
+
+	for (i32 i = 0; i < active_count; i++) {
+		i32 size;
+		i32 length;
+		u32 type;
+		glGetActiveUniform(shader->id, (u32)i, max_name_length, &length, &size, &type, name);
+
+		alice_uniform_t location = glGetUniformLocation(shader->id, name);
+		if (location < 0) {
+			/* Members of uniform blocks have no location. */
+			continue;
+		}
+
+		alice_shader_insert_uniform(shader, name, location);
+
+		char* subscript = strstr(name, "[0]");
+		if (!subscript || subscript[3] != '\0') {
+			continue;
+		}
+
+		/* "name[0]" may also be referred to as "name". */
+		*subscript = '\0';
+		alice_shader_insert_uniform(shader, name, location);
+
+		for (i32 element = 1; element < size; element++) {
+			sprintf(subscript, "[%d]", element);
+
+			alice_uniform_t element_location = glGetUniformLocation(shader->id, name);
+			if (element_location >= 0) {
+				alice_shader_insert_uniform(shader, name, element_location);
+			}
+		}
+	}
+
+	free(name);
+}
+
+alice_uniform_t alice_shader_get_uniform_hashed(alice_shader_t* shader, u32 name_hash) {
+	assert(shader);
+
+	alice_shader_uniform_t* entry = alice_shader_find_uniform(shader, name_hash, alice_null);
+	if (!entry) {
+		return -1;
+	}
+
+	if (entry->ambiguous) {
+		alice_log_warning("Uniform hash %u belongs to more than one uniform, including `%s'; "
+				"look it up by name instead", name_hash, entry->name);
+		return -1;
+	}
+
+	return entry->location;
+}
+
+alice_uniform_t alice_shader_get_uniform(alice_shader_t* shader, const char* name) {
+	assert(shader);
+
+	alice_shader_uniform_t* entry = alice_shader_find_uniform(shader, alice_hash_string(name), name);
+
+	return entry ? entry->location : -1;
+}
+
+void alice_uniform_set_int(alice_uniform_t uniform, i32 v) {
+	glUniform1i(uniform, v);
+}
+
+void alice_uniform_set_uint(alice_uniform_t uniform, u32 v) {
+	glUniform1ui(uniform, v);
+}
+
+void alice_uniform_set_float(alice_uniform_t uniform, float v) {
+	glUniform1f(uniform, v);
+}
+
+void alice_uniform_set_color(alice_uniform_t uniform, alice_color_t color) {
+	alice_rgb_color_t rgb = alice_rgb_color_from_color(color);
+
+	glUniform3f(uniform, rgb.r, rgb.g, rgb.b);
+}
+
+void alice_uniform_set_v2f(alice_uniform_t uniform, alice_v2f_t v) {
+	glUniform2f(uniform, v.x, v.y);
+}
+
+void alice_uniform_set_v3f(alice_uniform_t uniform, alice_v3f_t v) {
+	glUniform3f(uniform, v.x, v.y, v.z);
+}
+
+void alice_uniform_set_v4f(alice_uniform_t uniform, alice_v4f_t v) {
+	glUniform4f(uniform, v.x, v.y, v.z, v.w);
+}
+
+void alice_uniform_set_m4f(alice_uniform_t uniform, alice_m4f_t v) {
+	glUniformMatrix4fv(uniform, 1, GL_FALSE, (float*)v.elements);
+}
+
+static alice_shader_stats_t shader_stats;
+
+alice_shader_stats_t alice_get_shader_stats() {
+	return shader_stats;
+}
+
+static u32 alice_compile_shader_stage(const alice_preprocessed_shader_t* preprocessed, alice_shader_stage_t stage,
+		const char* path, bool* success) {
+	static const GLenum types[ALICE_SHADER_STAGE_COUNT] = {
+		GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER
+	};
+
+	const char* source = preprocessed->stages[stage];
+
+	u32 id = glCreateShader(types[stage]);
+	glShaderSource(id, 1, &source, NULL);
+	glCompileShader(id);
+
+	i32 compiled;
+	glGetShaderiv(id, GL_COMPILE_STATUS, &compiled);
+	if (!compiled) {
 		char info_log[1024];
-		glGetShaderInfoLog(f, 1024, alice_null, info_log);
-		alice_log_error("%s", info_log);
-		shader->panic_mode = true;
+		glGetShaderInfoLog(id, 1024, alice_null, info_log);
+		alice_log_error("%s stage of %s: %s", alice_shader_stage_name(stage), path ? path : "shader", info_log);
+		alice_log_shader_sources(preprocessed);
+		*success = false;
+	}
+
+	return id;
+}
+
+static u32 alice_compile_shader_program(const alice_preprocessed_shader_t* preprocessed, const char* path) {
+	bool success = true;
+
+	u32 stages[ALICE_SHADER_STAGE_COUNT] = { 0 };
+	for (u32 i = 0; i < ALICE_SHADER_STAGE_COUNT; i++) {
+		if (preprocessed->stages[i]) {
+			stages[i] = alice_compile_shader_stage(preprocessed, i, path, &success);
+		}
+	}
+
+	u32 id = glCreateProgram();
+
+	for (u32 i = 0; i < ALICE_SHADER_STAGE_COUNT; i++) {
+		if (stages[i]) {
+			glAttachShader(id, stages[i]);
+		}
+	}
+
+	if (alice_is_shader_cache_enabled()) {
+		glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	}
 
-	if (has_geometry) {
-		g = glCreateShader(GL_GEOMETRY_SHADER);
-		glShaderSource(g, 1, &gsp, NULL);
-		glCompileShader(g);
+	if (success) {
+		glLinkProgram(id);
 
-		glGetShaderiv(g, GL_COMPILE_STATUS, &success);
-		if (!success) {
+		i32 linked;
+		glGetProgramiv(id, GL_LINK_STATUS, &linked);
+		if (!linked) {
 			char info_log[1024];
-			glGetShaderInfoLog(g, 1024, alice_null, info_log);
-			alice_log_error("%s", info_log);
-			shader->panic_mode = true;
+			glGetProgramInfoLog(id, 1024, alice_null, info_log);
+			alice_log_error("Failed to link %s: %s", path ? path : "shader", info_log);
+			success = false;
 		}
 	}
 
-	u32 id;
-	id = glCreateProgram();
-	glAttachShader(id, v);
-	glAttachShader(id, f);
-	if (has_geometry) {
-		glAttachShader(id, g);
+	for (u32 i = 0; i < ALICE_SHADER_STAGE_COUNT; i++) {
+		if (stages[i]) {
+			glDeleteShader(stages[i]);
+		}
 	}
-	glLinkProgram(id);
 
-	glGetProgramiv(id, GL_LINK_STATUS, &success);
 	if (!success) {
+		glDeleteProgram(id);
+		return 0;
+	}
+
+	return id;
+}
+
+alice_shader_t* alice_init_shader(alice_shader_t* shader, char* source) {
+	return alice_init_shader_ex(shader, source, alice_null, alice_null, 0);
+}
+
+static const char* alice_shader_feature_defines[ALICE_SHADER_FEATURE_COUNT] = {
+	"ALICE_FEATURE_ALBEDO_MAP",
+	"ALICE_FEATURE_NORMAL_MAP",
+	"ALICE_FEATURE_METALLIC_MAP",
+	"ALICE_FEATURE_ROUGHNESS_MAP",
+	"ALICE_FEATURE_AMBIENT_OCCLUSION_MAP",
+	"ALICE_FEATURE_EMISSIVE_MAP",
+	"ALICE_FEATURE_DIFFUSE_MAP",
+	"ALICE_FEATURE_SHADOWS",
+	"ALICE_FEATURE_POINT_SHADOWS",
+	"ALICE_FEATURE_INSTANCING"
+};
+
+static u32 alice_find_shader_features(const alice_preprocessed_shader_t* preprocessed) {
+	u32 features = 0;
+
+	for (u32 i = 0; i < ALICE_SHADER_STAGE_COUNT; i++) {
+		if (!preprocessed->stages[i]) { continue; }
+
+		for (u32 j = 0; j < ALICE_SHADER_FEATURE_COUNT; j++) {
+			if (strstr(preprocessed->stages[i], alice_shader_feature_defines[j])) {
+				features |= 1 << j;
+			}
+		}
+	}
+
+	return features;
+}
+
+/* Compiles the program and fills everything but the variant fields. */
+static void alice_build_shader(alice_shader_t* shader, const char* source, const char* path,
+		const alice_shader_define_t* defines, u32 define_count) {
+	const double start_time = alice_get_time();
+
+	shader->id = 0;
+	shader->panic_mode = false;
+
+	shader->uniforms = alice_null;
+	shader->uniform_count = 0;
+	shader->uniform_capacity = 0;
+
+	shader->features = 0;
+
+	alice_preprocessed_shader_t preprocessed;
+	if (!alice_preprocess_shader(&preprocessed, source, path, defines, define_count)) {
 		shader->panic_mode = true;
+	} else if (!preprocessed.stages[ALICE_SHADER_STAGE_VERTEX] || !preprocessed.stages[ALICE_SHADER_STAGE_FRAGMENT]) {
+		alice_log_error("%s needs both a vertex and a fragment stage", path ? path : "Shader");
+		shader->panic_mode = true;
+	}
+
+	if (!shader->panic_mode) {
+		shader->features = alice_find_shader_features(&preprocessed);
+
+		const u64 key = alice_get_shader_cache_key(&preprocessed);
+
+		shader->id = alice_load_cached_program(key);
+
+		if (shader->id) {
+			shader_stats.cached_count++;
+		} else {
+			shader->id = alice_compile_shader_program(&preprocessed, path);
+			shader->panic_mode = shader->id == 0;
+
+			if (!shader->panic_mode) {
+				alice_save_cached_program(key, shader->id);
+				shader_stats.compiled_count++;
+			}
+		}
+	}
+
+	if (shader->panic_mode) {
+		shader_stats.failed_count++;
 	}
 
-	glDeleteShader(v);
-	glDeleteShader(f);
+	/* The shader keeps the file list, to check for changes. */
+	shader->dependencies = preprocessed.files;
+	shader->dependency_count = preprocessed.file_count;
+	preprocessed.files = alice_null;
+	preprocessed.file_count = 0;
+	preprocessed.file_capacity = 0;
+
+	alice_deinit_preprocessed_shader(&preprocessed);
 
-	if (has_geometry) {
-		glDeleteShader(g);
+	if (!shader->panic_mode) {
+		alice_shader_cache_uniforms(shader);
 	}
 
-	free(vertex_source);
-	free(fragment_source);
-	free(geometry_source);
+	shader_stats.time += alice_get_time() - start_time;
+}
+
+static char* alice_copy_shader_string(const char* string) {
+	if (!string) { return alice_null; }
+
+	char* copy = malloc(strlen(string) + 1);
+	strcpy(copy, string);
+
+	return copy;
+}
+
+alice_shader_t* alice_init_shader_ex(alice_shader_t* shader, const char* source, const char* path,
+		const alice_shader_define_t* defines, u32 define_count) {
+	static u32 generation = 0;
+
+	assert(shader);
+	assert(source);
+
+	alice_build_shader(shader, source, path, defines, define_count);
+
+	shader->source = alice_copy_shader_string(source);
+	shader->path = alice_copy_shader_string(path);
+
+	shader->variants = alice_null;
+	shader->variant_count = 0;
+	shader->variant_capacity = 0;
+
+	shader->generation = ++generation;
 
-	shader->id = id;
 	return shader;
 }
 
 void alice_deinit_shader(alice_shader_t* shader) {
 	assert(shader);
 
+	if (shader->uniform_capacity > 0) {
+		for (u32 i = 0; i < shader->uniform_capacity; i++) {
+			free(shader->uniforms[i].name);
+		}
+
+		free(shader->uniforms);
+	}
+
+	shader->uniforms = alice_null;
+	shader->uniform_count = 0;
+	shader->uniform_capacity = 0;
+
+	for (u32 i = 0; i < shader->dependency_count; i++) {
+		free(shader->dependencies[i].path);
+	}
+
+	free(shader->dependencies);
+	shader->dependencies = alice_null;
+	shader->dependency_count = 0;
+
+	for (u32 i = 0; i < shader->variant_count; i++) {
+		alice_free_shader(shader->variants[i].shader);
+	}
+
+	if (shader->variant_capacity > 0) {
+		free(shader->variants);
+	}
+
+	shader->variants = alice_null;
+	shader->variant_count = 0;
+	shader->variant_capacity = 0;
+
+	free(shader->source);
+	free(shader->path);
+	shader->source = alice_null;
+	shader->path = alice_null;
+
 	if (shader->panic_mode) { return; };
 
 	glDeleteProgram(shader->id);
+	alice_gl_forget_program(shader->id);
+}
+
+alice_shader_t* alice_get_shader_variant(alice_shader_t* shader, u32 features) {
+	assert(shader);
+
+	features &= shader->features;
+
+	if (features == 0 || !shader->source || shader->panic_mode) {
+		return shader;
+	}
+
+	for (u32 i = 0; i < shader->variant_count; i++) {
+		if (shader->variants[i].features == features) {
+			return shader->variants[i].shader;
+		}
+	}
+
+	alice_shader_define_t defines[ALICE_SHADER_FEATURE_COUNT];
+	u32 define_count = 0;
+
+	for (u32 i = 0; i < ALICE_SHADER_FEATURE_COUNT; i++) {
+		if (features & (1 << i)) {
+			defines[define_count++] = (alice_shader_define_t) { alice_shader_feature_defines[i], alice_null };
+		}
+	}
+
+	alice_shader_t* variant = malloc(sizeof(alice_shader_t));
+	alice_build_shader(variant, shader->source, shader->path, defines, define_count);
+
+	/* Variants don't have variants of their own. */
+	variant->features = 0;
+	variant->source = alice_null;
+	variant->path = alice_null;
+	variant->variants = alice_null;
+	variant->variant_count = 0;
+	variant->variant_capacity = 0;
+	variant->generation = shader->generation;
+
+	if (shader->variant_count >= shader->variant_capacity) {
+		shader->variant_capacity = alice_grow_capacity(shader->variant_capacity);
+		shader->variants = realloc(shader->variants, shader->variant_capacity * sizeof(alice_shader_variant_t));
+	}
+
+	shader->variants[shader->variant_count++] = (alice_shader_variant_t) {
+		.features = features,
+		.shader = variant
+	};
+
+	return variant;
 }
 
 alice_shader_t* alice_new_shader(alice_resource_t* resource) {
@@ -422,7 +874,7 @@ alice_shader_t* alice_new_shader(alice_resource_t* resource) {
 	}
 
 	alice_shader_t* s = malloc(sizeof(alice_shader_t));
-	alice_init_shader(s, resource->payload);
+	alice_init_shader_ex(s, resource->payload, resource->file_name, alice_null, 0);
 
 	return s;
 }
@@ -437,7 +889,7 @@ void alice_free_shader(alice_shader_t* shader) {
 void alice_bind_shader(alice_shader_t* shader) {
 	if (!shader || shader->panic_mode) { return; };
 
-	glUseProgram(shader ? shader->id : 0);
+	alice_gl_use_program(shader ? shader->id : 0);
 }
 
 void alice_shader_set_int(alice_shader_t* shader, const char* name, i32 v) {
@@ -445,7 +897,7 @@ void alice_shader_set_int(alice_shader_t* shader, const char* name, i32 v) {
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform1i(location, v);
 }
 
@@ -454,7 +906,7 @@ void alice_shader_set_uint(alice_shader_t* shader, const char* name, u32 v) {
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform1ui(location, v);
 }
 
@@ -463,7 +915,7 @@ void alice_shader_set_float(alice_shader_t* shader, const char* name, float v) {
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform1f(location, v);
 }
 
@@ -486,7 +938,7 @@ void alice_shader_set_v2i(alice_shader_t* shader, const char* name, alice_v2i_t
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform2i(location, v.x, v.y);
 }
 
@@ -495,7 +947,7 @@ void alice_shader_set_v2u(alice_shader_t* shader, const char* name, alice_v2u_t
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform2ui(location, v.x, v.y);
 }
 
@@ -504,7 +956,7 @@ void alice_shader_set_v2f(alice_shader_t* shader, const char* name, alice_v2f_t
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform2f(location, v.x, v.y);
 }
 
@@ -513,7 +965,7 @@ void alice_shader_set_v3i(alice_shader_t* shader, const char* name, alice_v3i_t
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform3i(location, v.x, v.y, v.z);
 }
 
@@ -522,7 +974,7 @@ void alice_shader_set_v3u(alice_shader_t* shader, const char* name, alice_v3u_t
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform3ui(location, v.x, v.y, v.z);
 }
 
@@ -531,7 +983,7 @@ void alice_shader_set_v3f(alice_shader_t* shader, const char* name, alice_v3f_t
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform3f(location, v.x, v.y, v.z);
 }
 
@@ -540,7 +992,7 @@ void alice_shader_set_v4i(alice_shader_t* shader, const char* name, alice_v4i v)
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform4i(location, v.x, v.y, v.z, v.w);
 }
 
@@ -549,7 +1001,7 @@ void alice_shader_set_v4u(alice_shader_t* shader, const char* name, alice_v4u v)
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform4ui(location, v.x, v.y, v.z, v.w);
 }
 
@@ -558,7 +1010,7 @@ void alice_shader_set_v4f(alice_shader_t* shader, const char* name, alice_v4f_t
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniform4f(location, v.x, v.y, v.z, v.w);
 }
 
@@ -567,7 +1019,7 @@ void alice_shader_set_m4f(alice_shader_t* shader, const char* name, alice_m4f_t
 
 	if (shader->panic_mode) { return; };
 
-	u32 location = glGetUniformLocation(shader->id, name);
+	alice_uniform_t location = alice_shader_get_uniform(shader, name);
 	glUniformMatrix4fv(location, 1, GL_FALSE, (float*)v.elements);
 }
 
@@ -641,7 +1093,7 @@ void alice_init_texture_from_memory_uncompressed(alice_texture_t* texture, unsig
 	texture->flags = flags;
 
 	glGenTextures(1, &texture->id);
-	glBindTexture(GL_TEXTURE_2D, texture->id);
+	alice_gl_bind_texture(0, GL_TEXTURE_2D, texture->id);
 
 	u32 alias_mode = GL_LINEAR;
 	if (flags & ALICE_TEXTURE_ALIASED) {
@@ -668,12 +1120,13 @@ void alice_init_texture_from_memory_uncompressed(alice_texture_t* texture, unsig
 		width, height, 0, internal_format,
 		GL_UNSIGNED_BYTE, pixels);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	alice_gl_bind_texture(0, GL_TEXTURE_2D, 0);
 }
 
 void alice_deinit_texture(alice_texture_t* texture) {
 	assert(texture);
 	glDeleteTextures(1, &texture->id);
+	alice_gl_forget_texture(texture->id);
 }
 
 void alice_free_texture(alice_texture_t* texture) {
@@ -685,46 +1138,144 @@ void alice_free_texture(alice_texture_t* texture) {
 }
 
 void alice_bind_texture(alice_texture_t* texture, u32 slot) {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, texture ? texture->id : 0);
+	alice_gl_bind_texture(slot, GL_TEXTURE_2D, texture ? texture->id : 0);
 }
 
-void alice_init_mesh(alice_mesh_t* mesh, alice_vertex_buffer_t* vb) {
+void alice_init_mesh(alice_mesh_t* mesh, float* vertices, u32 vertex_count,
+		u32* indices, u32 index_count) {
 	assert(mesh);
 
 	*mesh = (alice_mesh_t){
 		.transform = alice_m4f_identity(),
 
-		.vb = vb
+		.geometry = alice_geometry_pool_add(alice_get_geometry_pool(),
+				vertices, vertex_count, indices, index_count)
 	};
+
+	alice_calculate_aabb_from_mesh(&mesh->aabb, vertices, vertex_count, ALICE_GEOMETRY_VERTEX_STRIDE);
+
+	mesh->position_count = vertex_count / ALICE_GEOMETRY_VERTEX_STRIDE;
+	mesh->positions = malloc(mesh->position_count * sizeof(alice_v3f_t));
+	mesh->normals = malloc(mesh->position_count * sizeof(alice_v3f_t));
+	for (u32 i = 0; i < mesh->position_count; i++) {
+		const float* vertex = vertices + i * ALICE_GEOMETRY_VERTEX_STRIDE;
+		mesh->positions[i] = (alice_v3f_t) { vertex[0], vertex[1], vertex[2] };
+		mesh->normals[i] = (alice_v3f_t) { vertex[3], vertex[4], vertex[5] };
+	}
+
+	mesh->index_count = index_count;
+	mesh->indices = malloc(index_count * sizeof(u32));
+	memcpy(mesh->indices, indices, index_count * sizeof(u32));
 }
 
 void alice_deinit_mesh(alice_mesh_t* mesh) {
 	assert(mesh);
 
-	alice_free_vertex_buffer(mesh->vb);
+	for (u32 i = 0; i < mesh->lod_count; i++) {
+		alice_mesh_lod_t* lod = &mesh->lods[i];
+
+		if (lod->geometry.index_count > 0) {
+			alice_geometry_pool_remove_indices(alice_get_geometry_pool(), &lod->geometry);
+		}
+
+		free(lod->indices);
+	}
+
+	alice_geometry_pool_remove(alice_get_geometry_pool(), &mesh->geometry);
+
+	free(mesh->positions);
+	free(mesh->normals);
+	free(mesh->indices);
 }
 
-alice_mesh_t alice_new_cube_mesh() {
-	float verts[] = {
-		 0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.625, 0.500,
-		-0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.875, 0.500,
-		-0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 0.0f, 0.875, 0.750,
-		 0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.625, 0.500,
-		-0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 0.0f, 0.875, 0.750,
-		 0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 0.0f, 0.625, 0.750,
-		 0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.375, 0.750,
-		 0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.625, 0.750,
-		-0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.625, 1.0f,
-		 0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.375, 0.750,
-		-0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.625, 1.0f,
-		-0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.375, 1.0f,
-		-0.5f, -0.5f,  0.5f, -1.0f, 0.0f, 0.0f, 0.375, 0.0f,
-		-0.5f,  0.5f,  0.5f, -1.0f, 0.0f, 0.0f, 0.625, 0.0f,
-		-0.5f,  0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.625, 0.250,
-		-0.5f, -0.5f,  0.5f, -1.0f, 0.0f, 0.0f, 0.375, 0.0f,
-		-0.5f,  0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.625, 0.250,
-		-0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.375, 0.250,
+void alice_simplify_mesh_lods(alice_mesh_t* mesh) {
+	assert(mesh);
+
+	const float max_error = alice_v3f_dist(mesh->aabb.min, mesh->aabb.max) * ALICE_MESH_LOD_MAX_ERROR;
+
+	const u32* source = mesh->indices;
+	u32 source_count = mesh->index_count;
+	float error = 0.0f;
+
+	while (mesh->lod_count < ALICE_MAX_MESH_LODS) {
+		const u32 target_count = (source_count / 6) * 3;
+		if (target_count < ALICE_MESH_LOD_MIN_INDICES) {
+			break;
+		}
+
+		if (error >= max_error) {
+			break;
+		}
+
+		u32* indices = malloc(source_count * sizeof(u32));
+
+		float level_error = 0.0f;
+		const u32 index_count = alice_simplify_mesh(indices, mesh->positions, mesh->normals,
+				mesh->position_count, source, source_count, target_count,
+				max_error - error, &level_error);
+
+		if (index_count < ALICE_MESH_LOD_MIN_INDICES ||
+				(float)index_count > (float)source_count * ALICE_MESH_LOD_MAX_KEPT) {
+			free(indices);
+			break;
+		}
+
+		/* Each level is simplified from the one before it, so their
+		 * errors add up. */
+		error += level_error;
+
+		alice_mesh_lod_t* lod = &mesh->lods[mesh->lod_count++];
+		*lod = (alice_mesh_lod_t) {
+			.indices = realloc(indices, index_count * sizeof(u32)),
+			.index_count = index_count,
+			.error = error
+		};
+
+		source = lod->indices;
+		source_count = lod->index_count;
+	}
+}
+
+void alice_upload_mesh_lods(alice_mesh_t* mesh) {
+	assert(mesh);
+
+	for (u32 i = 0; i < mesh->lod_count; i++) {
+		alice_mesh_lod_t* lod = &mesh->lods[i];
+
+		if (lod->geometry.index_count == 0) {
+			lod->geometry = alice_geometry_pool_add_indices(alice_get_geometry_pool(),
+					&mesh->geometry, lod->indices, lod->index_count);
+		}
+	}
+}
+
+alice_geometry_t* alice_get_mesh_lod_geometry(alice_mesh_t* mesh, u32 lod) {
+	assert(mesh);
+	assert(lod <= mesh->lod_count);
+
+	return lod == 0 ? &mesh->geometry : &mesh->lods[lod - 1].geometry;
+}
+
+alice_mesh_t alice_new_cube_mesh() {
+	float verts[] = {
+		 0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.625, 0.500,
+		-0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.875, 0.500,
+		-0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 0.0f, 0.875, 0.750,
+		 0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.625, 0.500,
+		-0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 0.0f, 0.875, 0.750,
+		 0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 0.0f, 0.625, 0.750,
+		 0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.375, 0.750,
+		 0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.625, 0.750,
+		-0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.625, 1.0f,
+		 0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.375, 0.750,
+		-0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.625, 1.0f,
+		-0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.375, 1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f, 0.0f, 0.0f, 0.375, 0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f, 0.0f, 0.0f, 0.625, 0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.625, 0.250,
+		-0.5f, -0.5f,  0.5f, -1.0f, 0.0f, 0.0f, 0.375, 0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.625, 0.250,
+		-0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.375, 0.250,
 		-0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.125, 0.500,
 		 0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.375, 0.500,
 		 0.5f, -0.5f,  0.5f, 0.0f, -1.0f, 0.0f, 0.375, 0.750,
@@ -754,22 +1305,10 @@ alice_mesh_t alice_new_cube_mesh() {
 		35,
 	};
 
-	alice_vertex_buffer_t* cube = alice_new_vertex_buffer(
-		ALICE_VERTEXBUFFER_DRAW_TRIANGLES | ALICE_VERTEXBUFFER_STATIC_DRAW);
-
-	alice_bind_vertex_buffer_for_edit(cube);
-	alice_push_vertices(cube, verts, sizeof(verts) / sizeof(float));
-	alice_push_indices(cube, indices, sizeof(indices) / sizeof(u32));
-	alice_configure_vertex_buffer(cube, 0, 3, 8, 0); /* vec3 position */
-	alice_configure_vertex_buffer(cube, 1, 3, 8, 3); /* vec3 normal */
-	alice_configure_vertex_buffer(cube, 2, 2, 8, 6); /* vec2 uv */
-	alice_bind_vertex_buffer_for_edit(NULL);
-
 	alice_mesh_t mesh;
 
-	alice_init_mesh(&mesh, cube);
-
-	alice_calculate_aabb_from_mesh(&mesh.aabb, verts, sizeof(verts) / sizeof(float), 8);
+	alice_init_mesh(&mesh, verts, sizeof(verts) / sizeof(float),
+			indices, sizeof(indices) / sizeof(u32));
 
 	return mesh;
 }
@@ -826,6 +1365,12 @@ alice_mesh_t alice_new_sphere_mesh() {
 			vertices[vertex_count++] = s;
 			vertices[vertex_count++] = t;
 
+			/* The last stack and sector only close the seams; there is no
+			 * stack or sector after them to make triangles with. */
+			if (i == (u32)stack_count || j == (u32)sector_count) {
+				continue;
+			}
+
 			if (i != 0) {
 				indices = realloc(indices, (index_count + 3) * sizeof(u32));
 				indices[index_count++] = k1;
@@ -833,7 +1378,6 @@ alice_mesh_t alice_new_sphere_mesh() {
 				indices[index_count++] = k1 + 1;
 			}
 
-
 			if (i != (stack_count - 1)) {
 				indices = realloc(indices, (index_count + 3) * sizeof(u32));
 				indices[index_count++] = k1 + 1;
@@ -843,22 +1387,9 @@ alice_mesh_t alice_new_sphere_mesh() {
 		}
 	}
 
-	alice_vertex_buffer_t* sphere = alice_new_vertex_buffer(
-		ALICE_VERTEXBUFFER_DRAW_TRIANGLES | ALICE_VERTEXBUFFER_STATIC_DRAW);
-
-	alice_bind_vertex_buffer_for_edit(sphere);
-	alice_push_vertices(sphere, vertices, vertex_count);
-	alice_push_indices(sphere, indices, index_count);
-	alice_configure_vertex_buffer(sphere, 0, 3, 8, 0); /* vec3 position */
-	alice_configure_vertex_buffer(sphere, 1, 3, 8, 3); /* vec3 normal */
-	alice_configure_vertex_buffer(sphere, 2, 2, 8, 6); /* vec2 uv */
-	alice_bind_vertex_buffer_for_edit(NULL);
-
 	alice_mesh_t mesh;
 
-	alice_init_mesh(&mesh, sphere);
-
-	alice_calculate_aabb_from_mesh(&mesh.aabb, vertices, vertex_count, 8);
+	alice_init_mesh(&mesh, vertices, vertex_count, indices, index_count);
 
 	free(vertices);
 	free(indices);
@@ -913,6 +1444,22 @@ void alice_model_add_mesh(alice_model_t* model, alice_mesh_t mesh) {
 	model->meshes[model->mesh_count++] = mesh;
 }
 
+static void alice_simplify_mesh_lods_job(void* data, u32 index) {
+	alice_model_t* model = data;
+
+	alice_simplify_mesh_lods(&model->meshes[index]);
+}
+
+void alice_generate_model_lods(alice_model_t* model) {
+	assert(model);
+
+	alice_run_jobs(alice_simplify_mesh_lods_job, model, model->mesh_count);
+
+	for (u32 i = 0; i < model->mesh_count; i++) {
+		alice_upload_mesh_lods(&model->meshes[i]);
+	}
+}
+
 void alice_calculate_aabb_from_mesh(alice_aabb_t* aabb,
 		float* vertices, u32 position_count, u32 position_stride) {
 	assert(aabb);
@@ -965,11 +1512,11 @@ void alice_depth_clear() {
 }
 
 void alice_enable_depth() {
-	glEnable(GL_DEPTH_TEST);
+	alice_gl_set_capability(GL_DEPTH_TEST, true);
 }
 
 void alice_disable_depth() {
-	glDisable(GL_DEPTH_TEST);
+	alice_gl_set_capability(GL_DEPTH_TEST, false);
 }
 
 alice_camera_3d_t* alice_get_scene_camera_3d(alice_scene_t* scene) {
@@ -1062,82 +1609,205 @@ ALICE_API alice_m4f_t alice_get_camera_2d_matrix(alice_scene_t* scene, alice_cam
 	return alice_m4f_multiply(translation, projection);
 }
 
-static void alice_apply_pbr_material(alice_shader_t* shader, alice_pbr_material_t* material) {
-	assert(shader);
-	assert(material);
+/* std140 layouts of the blocks declared by the lit shaders. */
+typedef struct alice_pbr_material_data_t {
+	alice_v3f_t albedo;
+	float roughness;
 
-	alice_shader_set_color(shader, "material.albedo", material->albedo);
-	alice_shader_set_float(shader, "material.metallic", material->metallic);
-	alice_shader_set_float(shader, "material.roughness", material->roughness);
-	alice_shader_set_float(shader, "material.emissive", material->emissive);
+	float metallic;
+	float emissive;
+} alice_pbr_material_data_t;
 
-	if (material->albedo_map) {
-		alice_shader_set_int(shader, "material.use_albedo_map", 1);
-		alice_shader_set_int(shader, "material.albedo_map", 0);
-		alice_bind_texture(material->albedo_map, 0);
-	} else {
-		alice_shader_set_int(shader, "material.use_albedo_map", 0);
-	}
+typedef struct alice_phong_material_data_t {
+	alice_v3f_t diffuse;
+	float shininess;
 
-	if (material->normal_map) {
-		alice_shader_set_int(shader, "material.use_normal_map", 1);
-		alice_shader_set_int(shader, "material.normal_map", 1);
-		alice_bind_texture(material->normal_map, 1);
-	} else {
-		alice_shader_set_int(shader, "material.use_normal_map", 0);
-	}	
+	alice_v3f_t specular;
+	float emissive;
 
-	if (material->metallic_map) {
-		alice_shader_set_int(shader, "material.use_metallic_map", 1);
-		alice_shader_set_int(shader, "material.metallic_map", 2);
-		alice_bind_texture(material->metallic_map, 2);
-	} else {
-		alice_shader_set_int(shader, "material.use_metallic_map", 0);
+	alice_v3f_t ambient;
+} alice_phong_material_data_t;
+
+typedef struct alice_directional_light_data_t {
+	alice_v3f_t direction;
+	float intensity;
+
+	alice_v3f_t color;
+	i32 cast_shadows;
+} alice_directional_light_data_t;
+
+typedef struct alice_frame_data_t {
+	alice_m4f_t camera;
+
+	alice_v3f_t camera_position;
+	float gamma;
+
+	alice_v3f_t ambient_color;
+	float ambient_intensity;
+
+	u32 directional_light_count;
+	u32 point_light_count;
+	u32 padding0;
+	float bloom_threshold;
+
+	/* For finding the light cluster of a fragment. */
+	alice_m4f_t view;
+	alice_v2f_t screen_size;
+	float cluster_near;
+	float cluster_far;
+
+	/* Cascades of the shadow casting directional light. */
+	alice_m4f_t shadow_cascades[ALICE_MAX_SHADOW_CASCADES];
+	float shadow_splits[ALICE_MAX_SHADOW_CASCADES];
+	u32 shadow_cascade_count;
+	u32 padding1[3];
+
+	alice_directional_light_data_t directional_lights[ALICE_MAX_DIRECTIONAL_LIGHTS];
+} alice_frame_data_t;
+
+/* std430 layout of the point light storage buffer. */
+typedef struct alice_point_light_data_t {
+	alice_v3f_t position;
+	float range;
+
+	alice_v3f_t color;
+	float intensity;
+
+	/* Slot in the point shadow cube map array, or -1. */
+	i32 shadow_index;
+	i32 padding[3];
+} alice_point_light_data_t;
+
+static alice_v3f_t alice_v3f_from_color(alice_color_t color) {
+	alice_rgb_color_t rgb = alice_rgb_color_from_color(color);
+
+	return (alice_v3f_t) { rgb.r, rgb.g, rgb.b };
+}
+
+static u32 alice_build_pbr_material_data(alice_pbr_material_t* material, void* out) {
+	alice_pbr_material_data_t data = {
+		.albedo = alice_v3f_from_color(material->albedo),
+		.roughness = material->roughness,
+		.metallic = material->metallic,
+		.emissive = material->emissive
+	};
+
+	memcpy(out, &data, sizeof(data));
+	return sizeof(data);
+}
+
+static u32 alice_build_phong_material_data(alice_phong_material_t* material, void* out) {
+	alice_phong_material_data_t data = {
+		.diffuse = alice_v3f_from_color(material->diffuse),
+		.shininess = material->shininess,
+		.specular = alice_v3f_from_color(material->specular),
+		.emissive = material->emissive,
+		.ambient = alice_v3f_from_color(material->ambient)
+	};
+
+	memcpy(out, &data, sizeof(data));
+	return sizeof(data);
+}
+
+static void alice_bind_material_textures(alice_material_t* material) {
+	switch (material->type) {
+		case ALICE_MATERIAL_PBR: {
+			alice_pbr_material_t* pbr = &material->as.pbr;
+
+			if (pbr->albedo_map) { alice_bind_texture(pbr->albedo_map, 0); }
+			if (pbr->normal_map) { alice_bind_texture(pbr->normal_map, 1); }
+			if (pbr->metallic_map) { alice_bind_texture(pbr->metallic_map, 2); }
+			if (pbr->roughness_map) { alice_bind_texture(pbr->roughness_map, 3); }
+			if (pbr->ambient_occlusion_map) { alice_bind_texture(pbr->ambient_occlusion_map, 4); }
+			if (pbr->emissive_map) { alice_bind_texture(pbr->emissive_map, 5); }
+			break;
+		}
+		case ALICE_MATERIAL_PHONG:
+			if (material->as.phong.diffuse_map) {
+				alice_bind_texture(material->as.phong.diffuse_map, 0);
+			}
+			break;
+		default: break;
 	}
+}
 
-	if (material->roughness_map) {
-		alice_shader_set_int(shader, "material.use_roughness_map", 1);
-		alice_shader_set_int(shader, "material.roughness_map", 3);
-		alice_bind_texture(material->roughness_map, 3);
-	} else {
-		alice_shader_set_int(shader, "material.use_roughness_map", 0);
+/* Uploads the material's uniform block if its parameters have changed
+ * since the last upload, then binds it along with the material's
+ * textures. */
+static void alice_apply_material_properties(alice_material_t* material) {
+	u8 data[sizeof(material->uniform_data)];
+	memset(data, 0, sizeof(data));
+
+	u32 size = 0;
+	switch (material->type) {
+		case ALICE_MATERIAL_PBR:
+			size = alice_build_pbr_material_data(&material->as.pbr, data);
+			break;
+		case ALICE_MATERIAL_PHONG:
+			size = alice_build_phong_material_data(&material->as.phong, data);
+			break;
+		default: break;
 	}
 
-	if (material->ambient_occlusion_map) {
-		alice_shader_set_int(shader, "material.use_ambient_occlusion_map", 1);
-		alice_shader_set_int(shader, "material.ambient_occlusion_map", 4);
-		alice_bind_texture(material->ambient_occlusion_map, 4);
-	} else {
-		alice_shader_set_int(shader, "material.use_ambient_occlusion_map", 0);
+	if (!material->uniform_buffer) {
+		material->uniform_buffer = alice_new_gpu_buffer(ALICE_GPU_BUFFER_UNIFORM, sizeof(data));
+		alice_update_gpu_buffer(material->uniform_buffer, data, size);
+		memcpy(material->uniform_data, data, sizeof(data));
+	} else if (memcmp(material->uniform_data, data, sizeof(data)) != 0) {
+		alice_update_gpu_buffer(material->uniform_buffer, data, size);
+		memcpy(material->uniform_data, data, sizeof(data));
 	}
 
-	if (material->emissive_map) {
-		alice_shader_set_int(shader, "material.use_emissive_map", 1);
-		alice_shader_set_int(shader, "material.ambient_occlusion_map", 5);
-		alice_bind_texture(material->emissive_map, 5);
-	} else {
-		alice_shader_set_int(shader, "material.use_emissive_map", 0);
+	alice_bind_gpu_buffer(material->uniform_buffer, ALICE_MATERIAL_BLOCK_BINDING);
+	alice_bind_material_textures(material);
+}
+
+u32 alice_get_material_features(alice_material_t* material) {
+	assert(material);
+
+	u32 features = 0;
+
+	switch (material->type) {
+		case ALICE_MATERIAL_PBR: {
+			alice_pbr_material_t* pbr = &material->as.pbr;
+
+			if (pbr->albedo_map) { features |= ALICE_SHADER_FEATURE_ALBEDO_MAP; }
+			if (pbr->normal_map) { features |= ALICE_SHADER_FEATURE_NORMAL_MAP; }
+			if (pbr->metallic_map) { features |= ALICE_SHADER_FEATURE_METALLIC_MAP; }
+			if (pbr->roughness_map) { features |= ALICE_SHADER_FEATURE_ROUGHNESS_MAP; }
+			if (pbr->ambient_occlusion_map) { features |= ALICE_SHADER_FEATURE_AMBIENT_OCCLUSION_MAP; }
+			if (pbr->emissive_map) { features |= ALICE_SHADER_FEATURE_EMISSIVE_MAP; }
+			break;
+		}
+		case ALICE_MATERIAL_PHONG:
+			if (material->as.phong.diffuse_map) { features |= ALICE_SHADER_FEATURE_DIFFUSE_MAP; }
+			break;
+		default: break;
 	}
+
+	return features;
 }
 
-static void alice_apply_phong_material(alice_shader_t* shader, alice_phong_material_t* material) {
-	assert(shader);
+alice_shader_t* alice_get_material_shader(alice_material_t* material, u32 frame_features) {
 	assert(material);
 
-	alice_shader_set_color(shader, "material.diffuse", material->diffuse);
-	alice_shader_set_color(shader, "material.ambient", material->ambient);
-	alice_shader_set_color(shader, "material.specular", material->specular);
+	alice_shader_t* shader = material->shader;
+	if (!shader) {
+		return alice_null;
+	}
 
-	alice_shader_set_float(shader, "material.shininess", material->shininess);
-	alice_shader_set_float(shader, "material.emissive", material->emissive);
+	const u32 features = alice_get_material_features(material) | frame_features;
 
-	if (material->diffuse_map) {
-		alice_shader_set_int(shader, "material.use_diffuse_map", 1);
-		alice_shader_set_int(shader, "material.diffuse_map", 2);
-		alice_bind_texture(material->diffuse_map, 2);
-	} else {
-		alice_shader_set_int(shader, "material.use_diffuse_map", 0);
+	if (material->variant && material->variant_features == features &&
+			material->variant_generation == shader->generation) {
+		return material->variant;
 	}
+
+	material->variant = alice_get_shader_variant(shader, features);
+	material->variant_features = features;
+	material->variant_generation = shader->generation;
+
+	return material->variant;
 }
 
 void alice_apply_material(alice_scene_t* scene, alice_material_t* material) {
@@ -1148,78 +1818,118 @@ void alice_apply_material(alice_scene_t* scene, alice_material_t* material) {
 		return;
 	}
 
-	alice_bind_shader(material->shader);
+	alice_bind_shader(alice_get_material_shader(material, 0));
 
-	switch (material->type) {
-		case ALICE_MATERIAL_PBR:
-			alice_apply_pbr_material(material->shader, &material->as.pbr);
-			break;
-		case ALICE_MATERIAL_PHONG:
-			alice_apply_phong_material(material->shader, &material->as.phong);
-			break;
-		default: break;
+	alice_apply_material_properties(material);
+}
+
+void alice_deinit_material(alice_material_t* material) {
+	assert(material);
+
+	if (material->uniform_buffer) {
+		alice_free_gpu_buffer(material->uniform_buffer);
+		material->uniform_buffer = alice_null;
 	}
+}
 
-	/* Apply directional lights */
-	u32 light_count = 0;
-	for (alice_entity_iter(scene, iter, alice_directional_light_t)) {
-		alice_directional_light_t* light = iter.current_ptr;
+/* Fills the per-frame block, the point light storage buffer and the light
+ * clusters and binds them for the lit shaders. */
+static void alice_upload_frame_data(alice_scene_renderer_3d_t* renderer, alice_scene_t* scene,
+		alice_camera_3d_t* camera, alice_m4f_t camera_matrix, alice_v3f_t camera_position,
+		alice_v2f_t screen_size) {
+	static alice_frame_data_t frame;
 
-		char name[256];
+	const alice_m4f_t view = alice_get_camera_3d_view(scene, camera);
 
-		sprintf(name, "directional_lights[%d].color", light_count);
-		alice_shader_set_color(material->shader, name, light->color);
+	frame.camera = camera_matrix;
+	frame.camera_position = camera_position;
+	frame.gamma = camera->gamma;
+	frame.ambient_color = alice_v3f_from_color(renderer->ambient_color);
+	frame.ambient_intensity = renderer->ambient_intensity;
+	frame.bloom_threshold = renderer->bloom_threshold;
 
-		sprintf(name, "directional_lights[%d].direction", light_count);
-		alice_shader_set_v3f(material->shader, name, light->base.position);
+	u32 directional_light_count = 0;
+	for (alice_entity_iter(scene, iter, alice_directional_light_t)) {
+		alice_directional_light_t* light = iter.current_ptr;
+
+		if (directional_light_count >= ALICE_MAX_DIRECTIONAL_LIGHTS) {
+			break;
+		}
 
-		sprintf(name, "directional_lights[%d].intensity", light_count);
-		alice_shader_set_float(material->shader, name, light->intensity);
+		frame.directional_lights[directional_light_count++] = (alice_directional_light_data_t) {
+			.direction = light->base.position,
+			.intensity = light->intensity,
+			.color = alice_v3f_from_color(light->color),
+			.cast_shadows = light == renderer->shadowmap->light
+		};
+	}
 
-		sprintf(name, "directional_lights[%d].transform", light_count);
-		alice_shader_set_m4f(material->shader, name, light->transform);
+	u32 point_light_count = 0;
+	for (alice_entity_iter(scene, iter, alice_point_light_t)) {
+		point_light_count++;
+	}
 
-		light_count++;
+	if (point_light_count > renderer->point_light_capacity) {
+		renderer->point_light_capacity = point_light_count;
+		renderer->point_light_data = realloc(renderer->point_light_data,
+				renderer->point_light_capacity * sizeof(alice_point_light_data_t));
 	}
 
-	alice_shader_set_uint(material->shader, "directional_light_count", light_count);
-}
+	alice_point_light_data_t* point_lights = renderer->point_light_data;
 
-void alice_apply_point_lights(alice_scene_t* scene, alice_aabb_t mesh_aabb, alice_material_t* material) {
-	assert(scene);
-	assert(material);
+	alice_light_clusters_t* clusters = renderer->light_clusters;
+	alice_begin_light_clusters(clusters, view, alice_get_camera_3d_projection(camera),
+			camera->near, camera->far);
 
-	u32 light_count = 0;
+	u32 i = 0;
 	for (alice_entity_iter(scene, iter, alice_point_light_t)) {
 		alice_point_light_t* light = iter.current_ptr;
 
-		alice_v3f_t world_position = alice_get_entity_world_position(scene, (alice_entity_t*)light);
-
-		if (!alice_sphere_vs_aabb(mesh_aabb, world_position, powf(light->range * 5.0f, 2))) {
-			continue;
-		}
-
-		char name[256];
+		const alice_v3f_t position = alice_get_entity_world_position(scene, (alice_entity_t*)light);
 
-		sprintf(name, "point_lights[%d].color", light_count);
-		alice_shader_set_color(material->shader, name, light->color);
+		point_lights[i++] = (alice_point_light_data_t) {
+			.position = position,
+			.range = light->range,
+			.color = alice_v3f_from_color(light->color),
+			.intensity = light->intensity,
+			.shadow_index = alice_get_point_shadow_index(renderer->point_shadowmap, iter.current)
+		};
 
-		sprintf(name, "point_lights[%d].position", light_count);
-		alice_shader_set_v3f(material->shader, name, world_position);
+		alice_add_cluster_light(clusters, position, light->range);
+	}
 
-		sprintf(name, "point_lights[%d].intensity", light_count);
-		alice_shader_set_float(material->shader, name, light->intensity);
+	alice_end_light_clusters(clusters);
 
-		sprintf(name, "point_lights[%d].range", light_count);
-		alice_shader_set_float(material->shader, name, light->range);
+	frame.directional_light_count = directional_light_count;
+	frame.point_light_count = point_light_count;
 
-		sprintf(name, "point_lights[%d].cast_shadows", light_count);
-		alice_shader_set_int(material->shader, name, light->cast_shadows);
+	frame.view = view;
+	frame.screen_size = screen_size;
+	frame.cluster_near = camera->near;
+	frame.cluster_far = camera->far;
 
-		light_count++;
+	const alice_shadow_cascades_t* cascades = &renderer->shadowmap->cascades;
+	for (u32 i = 0; i < cascades->count; i++) {
+		frame.shadow_cascades[i] = cascades->cascades[i].matrix;
+		frame.shadow_splits[i] = cascades->cascades[i].far;
 	}
-
-	alice_shader_set_uint(material->shader, "point_light_count", light_count);
+	frame.shadow_cascade_count = cascades->count;
+
+	const u32 frame_size = (u32)offsetof(alice_frame_data_t, directional_lights) +
+		directional_light_count * sizeof(alice_directional_light_data_t);
+
+	alice_update_gpu_buffer(renderer->frame_uniforms, &frame, frame_size);
+	alice_update_gpu_buffer(renderer->point_light_storage, point_lights,
+			point_light_count * sizeof(alice_point_light_data_t));
+	alice_update_gpu_buffer(renderer->light_cluster_storage, clusters->clusters,
+			sizeof(clusters->clusters));
+	alice_update_gpu_buffer(renderer->light_index_storage, clusters->indices,
+			clusters->index_count * sizeof(u32));
+
+	alice_bind_gpu_buffer(renderer->frame_uniforms, ALICE_FRAME_BLOCK_BINDING);
+	alice_bind_gpu_buffer(renderer->point_light_storage, ALICE_POINT_LIGHT_BLOCK_BINDING);
+	alice_bind_gpu_buffer(renderer->light_cluster_storage, ALICE_LIGHT_CLUSTER_BLOCK_BINDING);
+	alice_bind_gpu_buffer(renderer->light_index_storage, ALICE_LIGHT_INDEX_BLOCK_BINDING);
 }
 
 void alice_on_renderable_3d_create(alice_scene_t* scene, alice_entity_handle_t handle, void* ptr) {
@@ -1232,14 +1942,50 @@ void alice_on_renderable_3d_create(alice_scene_t* scene, alice_entity_handle_t h
 	renderable->model = alice_null;
 
 	renderable->cast_shadows = true;
+
+	renderable->is_static = false;
+	renderable->batched = false;
+
+	renderable->is_occluder = false;
+
+	renderable->bvh_leaf = ALICE_BVH_NULL_NODE;
+
+	renderable->aabb = (alice_aabb_t) { 0 };
+	renderable->mesh_aabbs = alice_null;
+	renderable->mesh_aabb_capacity = 0;
+
+	renderable->mesh_lods = alice_null;
 }
 
 void alice_on_renderable_3d_destroy(alice_scene_t* scene, alice_entity_handle_t handle, void* ptr) {
 	alice_renderable_3d_t* renderable = ptr;
 
+	if (renderable->bvh_leaf != ALICE_BVH_NULL_NODE) {
+		alice_bvh_remove(scene->bvh, renderable->bvh_leaf);
+		renderable->bvh_leaf = ALICE_BVH_NULL_NODE;
+	}
+
+	/* The pool moves its last renderable into the slot being freed, so
+	 * that renderable's leaf has to point at its new index. */
+	alice_entity_pool_t* pool = alice_get_entity_pool(scene, alice_get_entity_handle_type(handle));
+	const u32 index = alice_get_entity_handle_id(handle);
+
+	if (pool->count > 0 && index != pool->count - 1) {
+		alice_renderable_3d_t* last = alice_entity_pool_get(pool, pool->count - 1);
+
+		if (last->bvh_leaf != ALICE_BVH_NULL_NODE) {
+			alice_bvh_set_user_data(scene->bvh, last->bvh_leaf, index);
+		}
+	}
+
 	if (renderable->material_capacity > 0) {
 		free(renderable->materials);
 	}
+
+	if (renderable->mesh_aabb_capacity > 0) {
+		free(renderable->mesh_aabbs);
+		free(renderable->mesh_lods);
+	}
 }
 
 void alice_renderable_3d_add_material(alice_renderable_3d_t* renderable, const char* material_path) {
@@ -1253,281 +1999,1138 @@ void alice_renderable_3d_add_material(alice_renderable_3d_t* renderable, const c
 	renderable->materials[renderable->material_count++] = alice_load_material(material_path);
 }
 
-alice_shadowmap_t* alice_new_shadowmap(u32 res, alice_shader_t* shader) {
-	alice_shadowmap_t* new = malloc(sizeof(alice_shadowmap_t));
+static float alice_aabb_center_distance_squared(alice_aabb_t aabb, alice_v3f_t point) {
+	const float x = (aabb.min.x + aabb.max.x) * 0.5f - point.x;
+	const float y = (aabb.min.y + aabb.max.y) * 0.5f - point.y;
+	const float z = (aabb.min.z + aabb.max.z) * 0.5f - point.z;
 
-	new->shader = shader;
-	new->res = res;
+	return x * x + y * y + z * z;
+}
 
-	glGenFramebuffers(1, &new->framebuffer);
+/* Renderables are handed to the job threads in ranges. There are a few
+ * ranges per thread so that a thread that finishes early can pick up
+ * another, but never so many that a range is tiny. */
+#define ALICE_RENDERABLE_RANGES_PER_THREAD 4
+#define ALICE_MIN_RENDERABLE_RANGE_SIZE 256
 
-	glGenTextures(1, &new->output);
-	glBindTexture(GL_TEXTURE_2D, new->output);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
-			res, res, 0, GL_DEPTH_COMPONENT,
-			GL_FLOAT, alice_null);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+typedef struct alice_renderable_ranges_t {
+	alice_entity_pool_t* pool;
 
-	float border_color[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_color);
+	/* Pool indices to split up, or null to split the whole pool. */
+	const u32* indices;
+	u32 count;
 
-	glBindFramebuffer(GL_FRAMEBUFFER, new->framebuffer);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, new->output, 0);
-	glDrawBuffer(GL_NONE);
-	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	u32 range_size;
+	u32 range_count;
+} alice_renderable_ranges_t;
 
-	return new;
+static alice_entity_pool_t* alice_get_renderable_pool(alice_scene_t* scene) {
+	return alice_get_entity_pool(scene, alice_get_type_info(alice_renderable_3d_t).id);
 }
 
-void alice_free_shadowmap(alice_shadowmap_t* shadowmap) {
-	assert(shadowmap);
+static alice_renderable_ranges_t alice_split_renderables(alice_entity_pool_t* pool,
+		const u32* indices, u32 count) {
+	const u32 wanted = alice_get_job_thread_count() * ALICE_RENDERABLE_RANGES_PER_THREAD;
 
-	glDeleteTextures(1, &shadowmap->output);
-	glDeleteFramebuffers(1, &shadowmap->framebuffer);
+	u32 range_size = (count + wanted - 1) / wanted;
+	range_size = alice_max(range_size, ALICE_MIN_RENDERABLE_RANGE_SIZE);
 
-	free(shadowmap);
+	return (alice_renderable_ranges_t) {
+		.pool = pool,
+		.indices = indices,
+		.count = count,
+		.range_size = range_size,
+		.range_count = (count + range_size - 1) / range_size
+	};
 }
 
-void alice_draw_shadowmap(alice_shadowmap_t* shadowmap, alice_scene_t* scene, alice_camera_3d_t* camera) {
-	assert(shadowmap);
-
-	shadowmap->in_use = false;
+static alice_renderable_3d_t* alice_get_ranged_renderable(const alice_renderable_ranges_t* ranges, u32 i) {
+	return alice_entity_pool_get(ranges->pool, ranges->indices ? ranges->indices[i] : i);
+}
 
-	shadowmap->draw_call_count = 0;
+static void alice_update_renderable_bounds_job(void* data, u32 index) {
+	alice_renderable_ranges_t* ranges = data;
 
-	alice_directional_light_t* light = alice_null;
+	const u32 start = index * ranges->range_size;
+	const u32 end = alice_min(start + ranges->range_size, ranges->count);
 
-	for (alice_entity_iter(scene, iter, alice_directional_light_t)) {
-		alice_directional_light_t* entity = iter.current_ptr;
+	for (u32 r = start; r < end; r++) {
+		alice_renderable_3d_t* renderable = alice_get_ranged_renderable(ranges, r);
 
-		if (entity->cast_shadows) {
-			light = entity;
-			break;
+		alice_model_t* model = renderable->model;
+		if (!model || model->mesh_count == 0 || renderable->batched) {
+			continue;
 		}
-	}
 
-	if (!light) { return; }
+		if (model->mesh_count > renderable->mesh_aabb_capacity) {
+			const u32 old_capacity = renderable->mesh_aabb_capacity;
 
-	shadowmap->in_use = true;
+			renderable->mesh_aabb_capacity = model->mesh_count;
+			renderable->mesh_aabbs = realloc(renderable->mesh_aabbs,
+					renderable->mesh_aabb_capacity * sizeof(alice_aabb_t));
+			renderable->mesh_lods = realloc(renderable->mesh_lods,
+					renderable->mesh_aabb_capacity * sizeof(u8));
+
+			memset(renderable->mesh_lods + old_capacity, 0, renderable->mesh_aabb_capacity - old_capacity);
+		}
 
-	glViewport(0, 0, shadowmap->res, shadowmap->res);
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowmap->framebuffer);
-	glClear(GL_DEPTH_BUFFER_BIT);
+		for (u32 i = 0; i < model->mesh_count; i++) {
+			alice_mesh_t* mesh = &model->meshes[i];
 
-	alice_m4f_t light_view = alice_m4f_lookat(
-			(alice_v3f_t) {
-				-light->base.position.x,
-				-light->base.position.y,
-				-light->base.position.z },
-			(alice_v3f_t) { 0.0f, 0.0f, 0.0f },
-			(alice_v3f_t) { 0.0f, 1.0f, 0.0f });
+			alice_m4f_t mesh_transform = alice_m4f_multiply(renderable->base.transform, mesh->transform);
+			renderable->mesh_aabbs[i] = alice_aabb_to_world(mesh->aabb, mesh_transform);
 
-	alice_aabb_t scene_aabb = alice_compute_scene_aabb(scene);
-	scene_aabb = alice_transform_aabb(scene_aabb, alice_m4f_inverse(light_view));
+			if (i == 0) {
+				renderable->aabb = renderable->mesh_aabbs[i];
+			} else {
+				renderable->aabb = alice_aabb_union(renderable->aabb, renderable->mesh_aabbs[i]);
+			}
+		}
+	}
+}
 
-	alice_m4f_t light_projection = alice_m4f_ortho(
-			scene_aabb.min.x, scene_aabb.max.x,
-			scene_aabb.min.y, scene_aabb.max.y,
-			scene_aabb.min.z, scene_aabb.max.z);
-	alice_m4f_t light_matrix = alice_m4f_multiply(light_projection, light_view);
+/* Reinserting a leaf is cheap when only a few renderables move, but when
+ * much of the scene moves at once it's quicker to update the leaves in
+ * place and refit the whole tree. */
+#define ALICE_BVH_REINSERT_FRACTION 4
 
-	light->transform = light_matrix;
+static void alice_update_renderable_bvh(alice_scene_t* scene, alice_entity_pool_t* pool) {
+	alice_bvh_t* bvh = scene->bvh;
 
-	alice_bind_shader(shadowmap->shader);
-	alice_shader_set_m4f(shadowmap->shader, "light", light_matrix);
+	const u32 reinsert_limit = pool->count / ALICE_BVH_REINSERT_FRACTION + 1;
 
-	for (alice_entity_iter(scene, iter, alice_renderable_3d_t)) {
-		alice_renderable_3d_t* renderable = iter.current_ptr;
+	u32 moved_count = 0;
+	bool refit = false;
+
+	for (u32 i = 0; i < pool->count; i++) {
+		alice_renderable_3d_t* renderable = alice_entity_pool_get(pool, i);
 
 		alice_model_t* model = renderable->model;
-		if (!model || !renderable->cast_shadows) {
+		if (!model || model->mesh_count == 0) {
+			if (renderable->bvh_leaf != ALICE_BVH_NULL_NODE) {
+				alice_bvh_remove(bvh, renderable->bvh_leaf);
+				renderable->bvh_leaf = ALICE_BVH_NULL_NODE;
+			}
+
 			continue;
 		}
 
-		alice_m4f_t transform_matrix = renderable->base.transform;
+		/* Leaves are weighted by the meshes they would draw, so culling
+		 * can count what it rejects. Batched meshes are drawn by their
+		 * chunks instead. */
+		const u32 weight = renderable->batched ? 0 : model->mesh_count;
 
-		for (u32 i = 0; i < model->mesh_count; i++) {
-			alice_mesh_t* mesh = &model->meshes[i];
-			alice_vertex_buffer_t* vb = mesh->vb;
+		if (renderable->bvh_leaf == ALICE_BVH_NULL_NODE) {
+			renderable->bvh_leaf = alice_bvh_insert(bvh, renderable->aabb, i, weight);
+			continue;
+		}
 
-			alice_m4f_t model = alice_m4f_multiply(transform_matrix, mesh->transform);
-			alice_shader_set_m4f(shadowmap->shader, "transform", model);
+		alice_bvh_set_weight(bvh, renderable->bvh_leaf, weight);
 
-			alice_bind_vertex_buffer_for_draw(vb);
-			alice_draw_vertex_buffer(vb);
-			shadowmap->draw_call_count++;
+		const bool defer_refit = moved_count >= reinsert_limit;
+		if (alice_bvh_move(bvh, renderable->bvh_leaf, renderable->aabb, defer_refit)) {
+			moved_count++;
+			refit |= defer_refit;
 		}
 	}
-}
-
-void alice_bind_shadowmap_output(alice_shadowmap_t* shadowmap, u32 unit) {
-	assert(shadowmap);
 
-	glActiveTexture(GL_TEXTURE0 + unit);
-	glBindTexture(GL_TEXTURE_2D, shadowmap->output);
+	if (refit) {
+		alice_bvh_refit(bvh);
+	}
 }
 
-ALICE_API alice_point_shadowmap_t* alice_new_point_shadowmap(u32 res, alice_shader_t* shader) {
-	alice_point_shadowmap_t* new = malloc(sizeof(alice_point_light_t));
+void alice_update_renderable_3d_bounds(alice_scene_t* scene) {
+	assert(scene);
 
-	new->shader = shader;
-	new->res = res;
+	alice_entity_pool_t* pool = alice_get_renderable_pool(scene);
 
-	glGenFramebuffers(1, &new->framebuffer);
+	alice_renderable_ranges_t ranges = alice_split_renderables(pool, alice_null, pool->count);
 
-	glGenTextures(1, &new->cubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, new->cubemap);
-	for (u32 i = 0; i < 6; i++) {
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT,
-				res, res, 0, GL_DEPTH_COMPONENT,
-				GL_FLOAT, alice_null);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, new->framebuffer);
-	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, new->cubemap, 0);
-	glDrawBuffer(GL_NONE);
-	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	alice_run_jobs(alice_update_renderable_bounds_job, &ranges, ranges.range_count);
 
-	return new;
+	alice_update_renderable_bvh(scene, pool);
 }
 
-ALICE_API void alice_free_point_shadowmap(alice_point_shadowmap_t* shadowmap) {
+/* The length of the longest of the matrix's axes. */
+static float alice_get_max_scale(const alice_m4f_t* m) {
+	float result = 0.0f;
+
+	for (u32 i = 0; i < 3; i++) {
+		const float length_squared =
+			m->elements[i][0] * m->elements[i][0] +
+			m->elements[i][1] * m->elements[i][1] +
+			m->elements[i][2] * m->elements[i][2];
+
+		result = alice_max(result, length_squared);
+	}
+
+	return sqrtf(result);
+}
+
+static u32 alice_select_mesh_lod(const alice_mesh_t* mesh, u32 current, const alice_m4f_t* transform,
+		alice_aabb_t aabb, float depth, const alice_lod_selection_t* lods) {
+	if (mesh->lod_count == 0) {
+		return 0;
+	}
+
+	const float radius = 0.5f * alice_v3f_dist(aabb.min, aabb.max);
+	const float distance = sqrtf(depth) - radius;
+	if (distance <= 0.0f) {
+		return 0;
+	}
+
+	const float pixels_per_error = lods->pixels_per_unit * alice_get_max_scale(transform) / distance;
+
+	for (u32 lod = mesh->lod_count; lod > 0; lod--) {
+		const float limit = lod > current ? lods->threshold * ALICE_LOD_HYSTERESIS : lods->threshold;
+
+		if (mesh->lods[lod - 1].error * pixels_per_error <= limit) {
+			return lod;
+		}
+	}
+
+	return 0;
+}
+
+typedef struct alice_lod_context_t {
+	alice_renderable_ranges_t ranges;
+
+	alice_v3f_t eye;
+	const alice_lod_selection_t* lods;
+} alice_lod_context_t;
+
+static void alice_select_renderable_lods_job(void* data, u32 index) {
+	alice_lod_context_t* context = data;
+
+	const u32 start = index * context->ranges.range_size;
+	const u32 end = alice_min(start + context->ranges.range_size, context->ranges.count);
+
+	for (u32 r = start; r < end; r++) {
+		alice_renderable_3d_t* renderable = alice_get_ranged_renderable(&context->ranges, r);
+
+		alice_model_t* model = renderable->model;
+		if (!model || renderable->batched) {
+			continue;
+		}
+
+		for (u32 i = 0; i < model->mesh_count; i++) {
+			alice_mesh_t* mesh = &model->meshes[i];
+
+			if (!context->lods) {
+				renderable->mesh_lods[i] = 0;
+				continue;
+			}
+
+			/* The model may have changed since the level was picked. */
+			const u32 current = alice_min(renderable->mesh_lods[i], mesh->lod_count);
+
+			const alice_aabb_t mesh_aabb = renderable->mesh_aabbs[i];
+			const alice_m4f_t transform = alice_m4f_multiply(renderable->base.transform, mesh->transform);
+
+			renderable->mesh_lods[i] = (u8)alice_select_mesh_lod(mesh, current, &transform, mesh_aabb,
+					alice_aabb_center_distance_squared(mesh_aabb, context->eye), context->lods);
+		}
+	}
+}
+
+void alice_select_renderable_3d_lods(alice_scene_t* scene, alice_v3f_t eye, const alice_lod_selection_t* lods) {
+	assert(scene);
+
+	alice_entity_pool_t* pool = alice_get_renderable_pool(scene);
+
+	alice_lod_context_t context = {
+		.ranges = alice_split_renderables(pool, alice_null, pool->count),
+		.eye = eye,
+		.lods = lods
+	};
+
+	alice_run_jobs(alice_select_renderable_lods_job, &context, context.ranges.range_count);
+}
+
+typedef struct alice_record_context_t {
+	alice_renderable_ranges_t ranges;
+
+	alice_frustum_t frustum;
+	alice_v3f_t eye;
+	bool shadow_pass;
+
+	const alice_occlusion_buffer_t* occlusion;
+
+	alice_command_lists_t* lists;
+} alice_record_context_t;
+
+static void alice_record_renderables_job(void* data, u32 index) {
+	alice_record_context_t* context = data;
+
+	alice_render_queue_t* list = context->lists->lists[index];
+	alice_command_list_stats_t* stats = &context->lists->stats[index];
+
+	const alice_frustum_t* frustum = &context->frustum;
+	const alice_occlusion_buffer_t* occlusion = context->occlusion;
+
+	const u32 start = index * context->ranges.range_size;
+	const u32 end = alice_min(start + context->ranges.range_size, context->ranges.count);
+
+	for (u32 r = start; r < end; r++) {
+		alice_renderable_3d_t* renderable = alice_get_ranged_renderable(&context->ranges, r);
+
+		alice_model_t* model = renderable->model;
+		if (!model || renderable->batched) {
+			continue;
+		}
+
+		if (context->shadow_pass && !renderable->cast_shadows) {
+			continue;
+		}
+
+		/* The tree tested the leaf's fattened bounds. */
+		if (!alice_frustum_vs_aabb(frustum, renderable->aabb)) {
+			stats->culled += model->mesh_count;
+			continue;
+		}
+
+		/* Occluders are already in the buffer, so they would only ever
+		 * hide themselves. */
+		if (occlusion && !renderable->is_occluder) {
+			stats->occlusion_tested++;
+
+			if (alice_occlusion_test_aabb(occlusion, renderable->aabb)) {
+				stats->culled += model->mesh_count;
+				stats->occluded += model->mesh_count;
+				continue;
+			}
+		}
+
+		alice_m4f_t transform_matrix = renderable->base.transform;
+
+		for (u32 i = 0; i < model->mesh_count; i++) {
+			alice_mesh_t* mesh = &model->meshes[i];
+			alice_aabb_t mesh_aabb = renderable->mesh_aabbs[i];
+
+			if (!alice_frustum_vs_aabb(frustum, mesh_aabb)) {
+				stats->culled++;
+				continue;
+			}
+
+			const float depth = alice_aabb_center_distance_squared(mesh_aabb, context->eye);
+
+			alice_m4f_t model = alice_m4f_multiply(transform_matrix, mesh->transform);
+
+			/* The model may have changed since the level was picked. */
+			const u32 lod = alice_min(renderable->mesh_lods[i], mesh->lod_count);
+
+			if (context->shadow_pass) {
+				alice_render_queue_push(list, ALICE_RENDER_PASS_SHADOW, alice_null, mesh,
+						lod, model, mesh_aabb, depth);
+				continue;
+			}
+
+			alice_material_t* material = alice_null;
+			if (i < renderable->material_count) {
+				material = renderable->materials[i];
+			} else if (renderable->material_count == 1) {
+				material = renderable->materials[0];
+			}
+
+			if (!material) {
+				stats->missing_materials += renderable->model->mesh_count - i;
+				break;
+			}
+
+			if (!material->shader) {
+				stats->missing_shaders++;
+				continue;
+			}
+
+			alice_render_queue_push(list,
+					material->transparent ? ALICE_RENDER_PASS_TRANSPARENT : ALICE_RENDER_PASS_OPAQUE,
+					material, mesh, lod, model, mesh_aabb, depth);
+		}
+	}
+}
+
+static void alice_collect_candidate(void* data, u32 user_data) {
+	alice_command_lists_t* lists = data;
+
+	if (lists->candidate_count >= lists->candidate_capacity) {
+		lists->candidate_capacity = alice_grow_capacity(lists->candidate_capacity);
+		lists->candidates = realloc(lists->candidates, lists->candidate_capacity * sizeof(u32));
+	}
+
+	lists->candidates[lists->candidate_count++] = user_data;
+}
+
+static void alice_rasterise_occluders(alice_occlusion_buffer_t* occlusion, alice_entity_pool_t* pool,
+		const u32* candidates, u32 candidate_count, alice_m4f_t view_projection) {
+	alice_begin_occlusion_buffer(occlusion, view_projection);
+
+	for (u32 i = 0; i < candidate_count; i++) {
+		alice_renderable_3d_t* renderable = alice_entity_pool_get(pool, candidates[i]);
+
+		alice_model_t* model = renderable->model;
+		if (!renderable->is_occluder || !model) {
+			continue;
+		}
+
+		for (u32 j = 0; j < model->mesh_count; j++) {
+			alice_mesh_t* mesh = &model->meshes[j];
+
+			alice_occlusion_add_mesh(occlusion,
+					alice_m4f_multiply(renderable->base.transform, mesh->transform),
+					mesh->positions, mesh->indices, mesh->index_count);
+		}
+	}
+
+	alice_end_occlusion_buffer(occlusion);
+}
+
+u32 alice_record_renderables_3d(alice_scene_t* scene, alice_command_lists_t* lists,
+		alice_render_queue_t* queue, alice_m4f_t view_projection, alice_v3f_t eye, bool shadow_pass,
+		alice_occlusion_buffer_t* occlusion) {
+	assert(scene);
+	assert(lists);
+	assert(queue);
+
+	const alice_frustum_t frustum = alice_frustum_from_m4f(view_projection);
+
+	alice_entity_pool_t* pool = alice_get_renderable_pool(scene);
+
+	lists->candidate_count = 0;
+
+	const u32 rejected_count = alice_bvh_query_frustum(scene->bvh, &frustum,
+			alice_collect_candidate, lists);
+
+	if (occlusion) {
+		alice_rasterise_occluders(occlusion, pool, lists->candidates, lists->candidate_count,
+				view_projection);
+	}
+
+	alice_record_context_t context = {
+		.ranges = alice_split_renderables(pool, lists->candidates, lists->candidate_count),
+		.frustum = frustum,
+		.eye = eye,
+		.shadow_pass = shadow_pass,
+		.occlusion = occlusion,
+		.lists = lists
+	};
+
+	alice_reset_command_lists(lists, context.ranges.range_count);
+
+	alice_run_jobs(alice_record_renderables_job, &context, context.ranges.range_count);
+
+	if (occlusion) {
+		for (u32 i = 0; i < lists->count; i++) {
+			occlusion->tested_count += lists->stats[i].occlusion_tested;
+			occlusion->rejected_count += lists->stats[i].occluded;
+		}
+	}
+
+	u32 missing_materials = 0;
+	u32 missing_shaders = 0;
+	for (u32 i = 0; i < lists->count; i++) {
+		missing_materials += lists->stats[i].missing_materials;
+		missing_shaders += lists->stats[i].missing_shaders;
+	}
+
+	if (missing_materials > lists->reported_missing_materials) {
+		alice_log_warning("%u meshes weren't drawn because they don't have a material", missing_materials);
+	}
+
+	if (missing_shaders > lists->reported_missing_shaders) {
+		alice_log_warning("%u meshes weren't drawn because their material doesn't have a shader",
+				missing_shaders);
+	}
+
+	lists->reported_missing_materials = missing_materials;
+	lists->reported_missing_shaders = missing_shaders;
+
+	return rejected_count + alice_merge_command_lists(lists, queue);
+}
+
+alice_shadowmap_t* alice_new_shadowmap(u32 res, alice_shader_t* shader) {
+	alice_shadowmap_t* new = malloc(sizeof(alice_shadowmap_t));
+
+	new->shader = shader;
+	new->res = res;
+
+	new->cascade_count = ALICE_MAX_SHADOW_CASCADES;
+	new->split_lambda = 0.75f;
+
+	new->in_use = false;
+	new->light = alice_null;
+	new->cascades.count = 0;
+
+	new->draw_call_count = 0;
+	new->drawn_object_count = 0;
+	new->culled_object_count = 0;
+
+	new->command_lists = alice_new_command_lists();
+
+	for (u32 i = 0; i < ALICE_MAX_SHADOW_CASCADES; i++) {
+		new->queues[i] = alice_new_render_queue();
+		new->instance_storage[i] = alice_new_gpu_buffer(ALICE_GPU_BUFFER_STORAGE, sizeof(alice_m4f_t));
+		new->draw_commands[i] = alice_new_gpu_buffer(ALICE_GPU_BUFFER_INDIRECT, sizeof(alice_draw_command_t));
+	}
+
+	glGenFramebuffers(1, &new->framebuffer);
+
+	glGenTextures(1, &new->output);
+	alice_gl_bind_texture(0, GL_TEXTURE_2D_ARRAY, new->output);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT,
+			res, res, ALICE_MAX_SHADOW_CASCADES, 0, GL_DEPTH_COMPONENT,
+			GL_FLOAT, alice_null);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+	float border_color[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border_color);
+
+	alice_gl_bind_framebuffer(new->framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, new->output, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	alice_gl_bind_framebuffer(0);
+
+	return new;
+}
+
+void alice_free_shadowmap(alice_shadowmap_t* shadowmap) {
 	assert(shadowmap);
-	
-	glDeleteTextures(1, &shadowmap->cubemap);
+
+	glDeleteTextures(1, &shadowmap->output);
 	glDeleteFramebuffers(1, &shadowmap->framebuffer);
+	alice_gl_forget_texture(shadowmap->output);
+	alice_gl_forget_framebuffer(shadowmap->framebuffer);
+
+	alice_free_command_lists(shadowmap->command_lists);
+
+	for (u32 i = 0; i < ALICE_MAX_SHADOW_CASCADES; i++) {
+		alice_free_render_queue(shadowmap->queues[i]);
+		alice_free_gpu_buffer(shadowmap->instance_storage[i]);
+		alice_free_gpu_buffer(shadowmap->draw_commands[i]);
+	}
 
 	free(shadowmap);
 }
 
-ALICE_API void alice_draw_point_shadowmap(alice_point_shadowmap_t* shadowmap,
-		alice_scene_t* scene) {
+void alice_record_shadow_cascade(alice_shadowmap_t* shadowmap, alice_scene_t* scene, u32 index) {
+	assert(shadowmap);
+	assert(scene);
+	assert(index < shadowmap->cascades.count);
+
+	const alice_shadow_cascade_t* cascade = &shadowmap->cascades.cascades[index];
+	alice_render_queue_t* queue = shadowmap->queues[index];
+
+	const alice_frustum_t frustum = alice_frustum_from_m4f(cascade->matrix);
+
+	/* Casters are sorted front to back from the light's side of the cascade. */
+	const alice_v3f_t forward = alice_v3f_normalise(shadowmap->light->base.position);
+	const alice_v3f_t light_eye = (alice_v3f_t) {
+		cascade->center.x - forward.x * cascade->radius,
+		cascade->center.y - forward.y * cascade->radius,
+		cascade->center.z - forward.z * cascade->radius
+	};
+
+	alice_clear_render_queue(queue);
 
+	shadowmap->culled_object_count += alice_record_renderables_3d(scene, shadowmap->command_lists,
+			queue, cascade->matrix, light_eye, true, alice_null);
+
+	if (scene->renderer) {
+		for (u32 i = 0; i < scene->renderer->static_chunk_count; i++) {
+			alice_static_chunk_t* chunk = &scene->renderer->static_chunks[i];
+
+			if (!chunk->cast_shadows) {
+				continue;
+			}
+
+			if (!alice_frustum_vs_aabb(&frustum, chunk->mesh.aabb)) {
+				shadowmap->culled_object_count++;
+				continue;
+			}
+
+			alice_render_queue_push(queue, ALICE_RENDER_PASS_SHADOW, alice_null, &chunk->mesh,
+					0, alice_m4f_identity(), chunk->mesh.aabb,
+					alice_aabb_center_distance_squared(chunk->mesh.aabb, light_eye));
+		}
+	}
+
+	alice_sort_render_queue(queue);
+	alice_render_queue_build_commands(queue);
+}
+
+void alice_fit_shadowmap(alice_shadowmap_t* shadowmap, alice_scene_t* scene, alice_camera_3d_t* camera) {
 	assert(shadowmap);
 	assert(scene);
+	assert(camera);
 
 	shadowmap->in_use = false;
+	shadowmap->light = alice_null;
+	shadowmap->cascades.count = 0;
 
-	alice_point_light_t* light = alice_null;
-
-	for (alice_entity_iter(scene, iter, alice_point_light_t)) {
-		alice_point_light_t* entity = iter.current_ptr;
+	for (alice_entity_iter(scene, iter, alice_directional_light_t)) {
+		alice_directional_light_t* entity = iter.current_ptr;
 
 		if (entity->cast_shadows) {
-			light = entity;
+			shadowmap->light = entity;
 			break;
 		}
 	}
 
-	if (!light) { return; }
-
-	alice_v3f_t light_pos = alice_get_entity_world_position(scene, (alice_entity_t*)light);
+	if (!shadowmap->light) { return; }
 
 	shadowmap->in_use = true;
 
-	glViewport(0, 0, shadowmap->res, shadowmap->res);
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowmap->framebuffer);
-	glClear(GL_DEPTH_BUFFER_BIT);
+	u32 cascade_count = shadowmap->cascade_count;
+	if (cascade_count < 1) { cascade_count = 1; }
+	if (cascade_count > ALICE_MAX_SHADOW_CASCADES) { cascade_count = ALICE_MAX_SHADOW_CASCADES; }
+
+	alice_fit_shadow_cascades(&shadowmap->cascades, cascade_count, shadowmap->split_lambda,
+			alice_get_camera_3d_view(scene, camera), camera->fov,
+			camera->dimentions.x / camera->dimentions.y, camera->near, camera->far,
+			shadowmap->light->base.position, alice_compute_scene_aabb(scene), shadowmap->res);
+}
+
+void alice_draw_shadowmap(alice_shadowmap_t* shadowmap, alice_scene_t* scene, alice_camera_3d_t* camera) {
+	assert(shadowmap);
+
+	shadowmap->draw_call_count = 0;
+	shadowmap->drawn_object_count = 0;
+	shadowmap->culled_object_count = 0;
+
+	alice_fit_shadowmap(shadowmap, scene, camera);
+
+	if (!shadowmap->in_use) { return; }
+
+	alice_gl_viewport(0, 0, shadowmap->res, shadowmap->res);
+	alice_gl_bind_framebuffer(shadowmap->framebuffer);
+
+	alice_geometry_pool_t* pool = alice_get_geometry_pool();
+	alice_bind_geometry_pool(pool);
+
+	alice_shader_t* shader = alice_get_shader_variant(shadowmap->shader, ALICE_SHADER_FEATURE_INSTANCING);
+	alice_bind_shader(shader);
+
+	for (u32 i = 0; i < shadowmap->cascades.count; i++) {
+		alice_record_shadow_cascade(shadowmap, scene, i);
+
+		alice_render_queue_t* queue = shadowmap->queues[i];
+
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowmap->output, 0, i);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		alice_update_gpu_buffer(shadowmap->instance_storage[i], alice_render_queue_gather_transforms(queue),
+				queue->packet_count * sizeof(alice_m4f_t));
+		alice_bind_gpu_buffer(shadowmap->instance_storage[i], ALICE_INSTANCE_BLOCK_BINDING);
+
+		alice_update_gpu_buffer(shadowmap->draw_commands[i], queue->commands,
+				queue->command_count * sizeof(alice_draw_command_t));
+		alice_bind_gpu_buffer(shadowmap->draw_commands[i], 0);
+
+		alice_geometry_pool_reserve_draw_indices(pool, queue->packet_count);
 
-	const float near = 0.0f;
-	const float far = 25.0f;
+		alice_shader_set_m4f(shader, "light", shadowmap->cascades.cascades[i].matrix);
 
-	alice_m4f_t shadow_proj = alice_m4f_persp(45.0f, 1.0f, near, far);
+		/* Shadow packets have no material, so everything lands in one bucket. */
+		for (u32 j = 0; j < queue->bucket_count; j++) {
+			alice_draw_bucket_t* bucket = &queue->buckets[j];
 
-	alice_m4f_t shadow_matrices[] = {
-		alice_m4f_multiply(shadow_proj, alice_m4f_lookat(light_pos, (alice_v3f_t){light_pos.x + 1.0f, light_pos.y + 0.0f, light_pos.z + 0.0f}, (alice_v3f_t){0.0f, -1.0f,  0.0f})),
-		alice_m4f_multiply(shadow_proj, alice_m4f_lookat(light_pos, (alice_v3f_t){light_pos.x - 1.0f, light_pos.y + 0.0f, light_pos.z + 0.0f}, (alice_v3f_t){0.0f, -1.0f,  0.0f})),
-		alice_m4f_multiply(shadow_proj, alice_m4f_lookat(light_pos, (alice_v3f_t){light_pos.x + 0.0f, light_pos.y + 1.0f, light_pos.z + 0.0f}, (alice_v3f_t){0.0f,  0.0f,  1.0f})),
-		alice_m4f_multiply(shadow_proj, alice_m4f_lookat(light_pos, (alice_v3f_t){light_pos.x + 0.0f, light_pos.y - 1.0f, light_pos.z + 0.0f}, (alice_v3f_t){0.0f,  0.0f, -1.0f})),
-		alice_m4f_multiply(shadow_proj, alice_m4f_lookat(light_pos, (alice_v3f_t){light_pos.x + 0.0f, light_pos.y + 0.0f, light_pos.z + 1.0f}, (alice_v3f_t){0.0f, -1.0f,  0.0f})),
-		alice_m4f_multiply(shadow_proj, alice_m4f_lookat(light_pos, (alice_v3f_t){light_pos.x + 0.0f, light_pos.y + 0.0f, light_pos.z - 1.0f}, (alice_v3f_t){0.0f, -1.0f,  0.0f}))
+			alice_draw_geometry_indirect(bucket->first_command, bucket->command_count);
+
+			shadowmap->draw_call_count++;
+			shadowmap->drawn_object_count += bucket->object_count;
+		}
+	}
+
+	alice_bind_geometry_pool(alice_null);
+}
+
+void alice_bind_shadowmap_output(alice_shadowmap_t* shadowmap, u32 unit) {
+	assert(shadowmap);
+
+	alice_gl_bind_texture(unit, GL_TEXTURE_2D_ARRAY, shadowmap->output);
+}
+
+ALICE_API alice_point_shadowmap_t* alice_new_point_shadowmap(u32 res, alice_shader_t* shader) {
+	alice_point_shadowmap_t* new = calloc(1, sizeof(alice_point_shadowmap_t));
+
+	new->shader = shader;
+	new->res = res;
+
+	for (u32 i = 0; i < ALICE_MAX_POINT_SHADOWS; i++) {
+		new->shadows[i].light = alice_null_entity_handle;
+	}
+
+	glGenFramebuffers(1, &new->framebuffer);
+
+	/* 16 bits is plenty for distance over range, and keeps all eight
+	 * lights' worth of faces small. */
+	glGenTextures(1, &new->cubemap_array);
+	alice_gl_bind_texture(0, GL_TEXTURE_CUBE_MAP_ARRAY, new->cubemap_array);
+	glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, GL_DEPTH_COMPONENT16,
+			res, res, 6 * ALICE_MAX_POINT_SHADOWS, 0, GL_DEPTH_COMPONENT,
+			GL_FLOAT, alice_null);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	alice_gl_bind_framebuffer(new->framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, new->cubemap_array, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	alice_gl_bind_framebuffer(0);
+
+	return new;
+}
+
+ALICE_API void alice_free_point_shadowmap(alice_point_shadowmap_t* shadowmap) {
+	assert(shadowmap);
+	
+	glDeleteTextures(1, &shadowmap->cubemap_array);
+	glDeleteFramebuffers(1, &shadowmap->framebuffer);
+	alice_gl_forget_texture(shadowmap->cubemap_array);
+	alice_gl_forget_framebuffer(shadowmap->framebuffer);
+
+	for (u32 i = 0; i < ALICE_MAX_POINT_SHADOWS; i++) {
+		if (shadowmap->shadows[i].caster_capacity > 0) {
+			free(shadowmap->shadows[i].casters);
+		}
+	}
+
+	free(shadowmap);
+}
+
+/* Near plane of the cube faces. Depth is written as distance over range,
+ * so this only decides what gets clipped. */
+#define ALICE_POINT_SHADOW_NEAR 0.05f
+
+/* Face order is that of the cube map layers: +x, -x, +y, -y, +z, -z. */
+static alice_m4f_t alice_get_point_shadow_face_matrix(alice_v3f_t position, float range, u32 face) {
+	static const alice_v3f_t directions[6] = {
+		{  1.0f,  0.0f,  0.0f }, { -1.0f,  0.0f,  0.0f },
+		{  0.0f,  1.0f,  0.0f }, {  0.0f, -1.0f,  0.0f },
+		{  0.0f,  0.0f,  1.0f }, {  0.0f,  0.0f, -1.0f }
 	};
 
-	alice_bind_shader(shadowmap->shader);
+	static const alice_v3f_t ups[6] = {
+		{ 0.0f, -1.0f,  0.0f }, { 0.0f, -1.0f,  0.0f },
+		{ 0.0f,  0.0f,  1.0f }, { 0.0f,  0.0f, -1.0f },
+		{ 0.0f, -1.0f,  0.0f }, { 0.0f, -1.0f,  0.0f }
+	};
+
+	const alice_v3f_t target = {
+		position.x + directions[face].x,
+		position.y + directions[face].y,
+		position.z + directions[face].z
+	};
+
+	const float near = alice_min(ALICE_POINT_SHADOW_NEAR, range * 0.5f);
+
+	return alice_m4f_multiply(alice_m4f_persp(90.0f, 1.0f, near, range),
+			alice_m4f_lookat(position, target, ups[face]));
+}
+
+static u64 alice_hash_point_shadow_caster(u32 index, u32 mesh, bool is_static_chunk, const alice_m4f_t* transform) {
+	/* FNV-1a */
+	u64 hash = 14695981039346656037ull;
+
+	const u32 header[3] = { index, mesh, is_static_chunk };
+
+	const u8* bytes = (const u8*)header;
+	for (u32 i = 0; i < sizeof(header); i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+
+	bytes = (const u8*)transform;
+	for (u32 i = 0; i < sizeof(alice_m4f_t); i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+
+	return hash;
+}
+
+typedef struct alice_point_shadow_context_t {
+	alice_scene_t* scene;
+	alice_entity_pool_t* pool;
+	alice_point_shadow_t* shadow;
 
+	alice_frustum_t faces[6];
+
+	/* Summed rather than chained, so that the order the BVH hands the
+	 * casters over in doesn't matter. */
+	u64 signatures[6];
+	u32 caster_counts[6];
+} alice_point_shadow_context_t;
+
+static void alice_add_point_shadow_caster(alice_point_shadow_context_t* context,
+		u32 index, u32 mesh, bool is_static_chunk, alice_aabb_t aabb, const alice_m4f_t* transform) {
+	alice_point_shadow_t* shadow = context->shadow;
+
+	if (!alice_sphere_vs_aabb(aabb, shadow->position, shadow->range)) {
+		return;
+	}
+
+	u8 faces = 0;
 	for (u32 i = 0; i < 6; i++) {
-		char name[32];
-		sprintf(name, "shadow_matrices[%d]", i);
-		alice_shader_set_m4f(shadowmap->shader, name, shadow_matrices[i]);
+		if (alice_frustum_vs_aabb(&context->faces[i], aabb)) {
+			faces |= 1 << i;
+		}
 	}
 
-	alice_shader_set_float(shadowmap->shader, "far", far);
-	alice_shader_set_v3f(shadowmap->shader, "light_position", light_pos);
+	if (!faces) { return; }
 
-	for (alice_entity_iter(scene, iter, alice_renderable_3d_t)) {
-		alice_renderable_3d_t* renderable = iter.current_ptr;
+	if (shadow->caster_count >= shadow->caster_capacity) {
+		shadow->caster_capacity = alice_grow_capacity(shadow->caster_capacity);
+		shadow->casters = realloc(shadow->casters,
+				shadow->caster_capacity * sizeof(alice_point_shadow_caster_t));
+	}
 
-		alice_model_t* model = renderable->model;
-		if (!model || !renderable->cast_shadows) {
+	shadow->casters[shadow->caster_count++] = (alice_point_shadow_caster_t) {
+		.index = index,
+		.mesh = mesh,
+		.is_static_chunk = is_static_chunk,
+		.faces = faces
+	};
+
+	const u64 hash = alice_hash_point_shadow_caster(index, mesh, is_static_chunk, transform);
+
+	for (u32 i = 0; i < 6; i++) {
+		if (faces & (1 << i)) {
+			context->signatures[i] += hash;
+			context->caster_counts[i]++;
+		}
+	}
+}
+
+static void alice_gather_point_shadow_caster(void* data, u32 user_data) {
+	alice_point_shadow_context_t* context = data;
+
+	alice_renderable_3d_t* renderable = alice_entity_pool_get(context->pool, user_data);
+
+	alice_model_t* model = renderable->model;
+	if (!model || !renderable->cast_shadows || renderable->batched) {
+		return;
+	}
+
+	for (u32 i = 0; i < model->mesh_count; i++) {
+		alice_add_point_shadow_caster(context, user_data, i, false,
+				renderable->mesh_aabbs[i], &renderable->base.transform);
+	}
+}
+
+static void alice_gather_point_shadow_casters(alice_point_shadow_t* shadow, alice_scene_t* scene) {
+	alice_point_shadow_context_t context = {
+		.scene = scene,
+		.pool = alice_get_renderable_pool(scene),
+		.shadow = shadow
+	};
+
+	for (u32 i = 0; i < 6; i++) {
+		context.faces[i] = alice_frustum_from_m4f(
+				alice_get_point_shadow_face_matrix(shadow->position, shadow->range, i));
+	}
+
+	shadow->caster_count = 0;
+
+	/* Only renderables within the light's range can cast into its cube. */
+	alice_bvh_query_sphere(scene->bvh, shadow->position, shadow->range,
+			alice_gather_point_shadow_caster, &context);
+
+	if (scene->renderer) {
+		const alice_m4f_t identity = alice_m4f_identity();
+
+		for (u32 i = 0; i < scene->renderer->static_chunk_count; i++) {
+			alice_static_chunk_t* chunk = &scene->renderer->static_chunks[i];
+
+			if (chunk->cast_shadows) {
+				alice_add_point_shadow_caster(&context, i, chunk->mesh.geometry.first_index, true,
+						chunk->mesh.aabb, &identity);
+			}
+		}
+	}
+
+	shadow->dirty_faces = 0;
+
+	for (u32 i = 0; i < 6; i++) {
+		/* Mixed with the face's own caster count so that an empty face and
+		 * a face whose hashes happen to sum to zero aren't confused. Casters
+		 * coming or going elsewhere leave it alone. */
+		const u64 signature = context.signatures[i] ^ (u64)context.caster_counts[i] * 0x9e3779b97f4a7c15ull;
+
+		if (!(shadow->valid_faces & (1 << i)) || shadow->signatures[i] != signature) {
+			shadow->dirty_faces |= 1 << i;
+		}
+
+		shadow->signatures[i] = signature;
+	}
+
+	/* Everything dirty is about to be rendered. */
+	shadow->valid_faces = 0x3f;
+}
+
+i32 alice_get_point_shadow_index(alice_point_shadowmap_t* shadowmap, alice_entity_handle_t light) {
+	assert(shadowmap);
+
+	for (u32 i = 0; i < ALICE_MAX_POINT_SHADOWS; i++) {
+		if (shadowmap->shadows[i].light == light) {
+			return (i32)i;
+		}
+	}
+
+	return -1;
+}
+
+void alice_update_point_shadows(alice_point_shadowmap_t* shadowmap, alice_scene_t* scene) {
+	assert(shadowmap);
+	assert(scene);
+
+	alice_entity_handle_t lights[ALICE_MAX_POINT_SHADOWS];
+	u32 light_count = 0;
+
+	for (alice_entity_iter(scene, iter, alice_point_light_t)) {
+		alice_point_light_t* light = iter.current_ptr;
+
+		if (light->cast_shadows && light->range > 0.0f) {
+			lights[light_count++] = iter.current;
+
+			if (light_count >= ALICE_MAX_POINT_SHADOWS) {
+				break;
+			}
+		}
+	}
+
+	/* Free the slots of lights that no longer cast shadows, so that the
+	 * rest keep theirs and their cached faces. */
+	for (u32 i = 0; i < ALICE_MAX_POINT_SHADOWS; i++) {
+		alice_point_shadow_t* shadow = &shadowmap->shadows[i];
+
+		bool found = false;
+		for (u32 j = 0; j < light_count; j++) {
+			if (lights[j] == shadow->light) {
+				found = true;
+				break;
+			}
+		}
+
+		if (!found) {
+			shadow->light = alice_null_entity_handle;
+			shadow->valid_faces = 0;
+			shadow->dirty_faces = 0;
+			shadow->caster_count = 0;
+		}
+	}
+
+	for (u32 i = 0; i < light_count; i++) {
+		if (alice_get_point_shadow_index(shadowmap, lights[i]) >= 0) {
 			continue;
 		}
 
-		alice_m4f_t transform_matrix = renderable->base.transform;
+		for (u32 j = 0; j < ALICE_MAX_POINT_SHADOWS; j++) {
+			if (shadowmap->shadows[j].light == alice_null_entity_handle) {
+				shadowmap->shadows[j].light = lights[i];
+				break;
+			}
+		}
+	}
+
+	shadowmap->shadow_count = light_count;
+
+	shadowmap->faces_rendered = 0;
+	shadowmap->faces_reused = 0;
+
+	for (u32 i = 0; i < ALICE_MAX_POINT_SHADOWS; i++) {
+		alice_point_shadow_t* shadow = &shadowmap->shadows[i];
+
+		if (shadow->light == alice_null_entity_handle) {
+			continue;
+		}
+
+		alice_point_light_t* light = alice_get_entity_ptr(scene, shadow->light);
+		const alice_v3f_t position = alice_get_entity_world_position(scene, (alice_entity_t*)light);
+
+		if (position.x != shadow->position.x || position.y != shadow->position.y ||
+				position.z != shadow->position.z || light->range != shadow->range) {
+			shadow->valid_faces = 0;
+		}
+
+		shadow->position = position;
+		shadow->range = light->range;
+
+		alice_gather_point_shadow_casters(shadow, scene);
+
+		for (u32 j = 0; j < 6; j++) {
+			if (shadow->dirty_faces & (1 << j)) {
+				shadowmap->faces_rendered++;
+			} else {
+				shadowmap->faces_reused++;
+			}
+		}
+	}
+}
+
+void alice_draw_point_shadowmap(alice_point_shadowmap_t* shadowmap,
+		alice_scene_t* scene) {
+
+	assert(shadowmap);
+	assert(scene);
+
+	shadowmap->faces_rendered = 0;
+	shadowmap->faces_reused = 0;
+	shadowmap->draw_call_count = 0;
+
+	if (!shadowmap->shader) {
+		shadowmap->in_use = false;
+		return;
+	}
+
+	alice_update_point_shadows(shadowmap, scene);
+
+	shadowmap->in_use = shadowmap->shadow_count > 0;
+
+	if (!shadowmap->in_use) { return; }
+
+	alice_gl_viewport(0, 0, shadowmap->res, shadowmap->res);
+	alice_gl_bind_framebuffer(shadowmap->framebuffer);
+
+	alice_bind_shader(shadowmap->shader);
+	alice_bind_geometry_pool(alice_get_geometry_pool());
+
+	alice_entity_pool_t* pool = alice_get_renderable_pool(scene);
+
+	for (u32 i = 0; i < ALICE_MAX_POINT_SHADOWS; i++) {
+		alice_point_shadow_t* shadow = &shadowmap->shadows[i];
+
+		if (shadow->light == alice_null_entity_handle) {
+			continue;
+		}
+
+		alice_shader_set_float(shadowmap->shader, "far", shadow->range);
+		alice_shader_set_v3f(shadowmap->shader, "light_position", shadow->position);
+
+		for (u32 face = 0; face < 6; face++) {
+			if (!(shadow->dirty_faces & (1 << face))) {
+				continue;
+			}
+
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+					shadowmap->cubemap_array, 0, i * 6 + face);
+			glClear(GL_DEPTH_BUFFER_BIT);
+
+			alice_shader_set_m4f(shadowmap->shader, "shadow_matrix",
+					alice_get_point_shadow_face_matrix(shadow->position, shadow->range, face));
+
+			for (u32 j = 0; j < shadow->caster_count; j++) {
+				alice_point_shadow_caster_t* caster = &shadow->casters[j];
+
+				if (!(caster->faces & (1 << face))) {
+					continue;
+				}
+
+				if (caster->is_static_chunk) {
+					alice_static_chunk_t* chunk = &scene->renderer->static_chunks[caster->index];
 
-		for (u32 i = 0; i < model->mesh_count; i++) {
-			alice_mesh_t* mesh = &model->meshes[i];
-			alice_vertex_buffer_t* vb = mesh->vb;
+					alice_shader_set_m4f(shadowmap->shader, "transform", alice_m4f_identity());
+					alice_draw_geometry(&chunk->mesh.geometry);
+				} else {
+					alice_renderable_3d_t* renderable = alice_entity_pool_get(pool, caster->index);
+					alice_mesh_t* mesh = &renderable->model->meshes[caster->mesh];
 
-			alice_m4f_t model = alice_m4f_multiply(transform_matrix, mesh->transform);
-			alice_shader_set_m4f(shadowmap->shader, "transform", model);
+					alice_shader_set_m4f(shadowmap->shader, "transform",
+							alice_m4f_multiply(renderable->base.transform, mesh->transform));
+					alice_draw_geometry(&mesh->geometry);
+				}
 
-			alice_bind_vertex_buffer_for_draw(vb);
-			alice_draw_vertex_buffer(vb);
+				shadowmap->draw_call_count++;
+			}
 		}
 	}
+
+	alice_bind_geometry_pool(alice_null);
 }
 
 ALICE_API void alice_bind_point_shadowmap_output(alice_point_shadowmap_t* shadowmap, u32 unit) {
 	assert(shadowmap);
 
-	glActiveTexture(GL_TEXTURE0 + unit);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, shadowmap->cubemap);
+	alice_gl_bind_texture(unit, GL_TEXTURE_CUBE_MAP_ARRAY, shadowmap->cubemap_array);
 }
 
 alice_scene_renderer_3d_t* alice_new_scene_renderer_3d(alice_shader_t* postprocess_shader,
-	alice_shader_t* extract_shader, alice_shader_t* blur_shader, alice_shader_t* depth_shader,
+	alice_shader_t* bloom_downsample_shader, alice_shader_t* bloom_upsample_shader, alice_shader_t* depth_shader,
 	alice_shader_t* point_depth_shader, bool debug, alice_shader_t* debug_shader,
-	u32 shadowmap_resolution) {
+	u32 shadowmap_resolution, u32 point_shadowmap_resolution) {
 
 	assert(postprocess_shader);
-	assert(extract_shader);
-	assert(blur_shader);
+	assert(bloom_downsample_shader);
+	assert(bloom_upsample_shader);
 	assert(depth_shader);
 	assert(point_depth_shader);
 
 	alice_scene_renderer_3d_t* new = malloc(sizeof(alice_scene_renderer_3d_t));
 
 	new->draw_call_count = 0;
+	new->drawn_object_count = 0;
+	new->culled_object_count = 0;
 
-	new->output = alice_new_render_target(128, 128, 1);
-	new->bright_pixels = alice_new_render_target(128, 128, 1);
-	new->bloom_ping_pong[0] = alice_new_render_target(128, 128, 1);
-	new->bloom_ping_pong[1] = alice_new_render_target(128, 128, 1);
+	new->frame_graph = alice_new_frame_graph();
 
 	new->postprocess = postprocess_shader;
-	new->extract = extract_shader;
-	new->blur = blur_shader;
+	new->bloom_downsample = bloom_downsample_shader;
+	new->bloom_upsample = bloom_upsample_shader;
 	new->shadowmap = alice_new_shadowmap(shadowmap_resolution, depth_shader);
-	new->point_shadowmap = alice_new_point_shadowmap(1024, point_depth_shader);
+	new->point_shadowmap = alice_new_point_shadowmap(point_shadowmap_resolution, point_depth_shader);
+
+	new->queue = alice_new_render_queue();
+	new->command_lists = alice_new_command_lists();
+
+	new->static_chunks = alice_null;
+	new->static_chunk_count = 0;
+	new->static_chunk_capacity = 0;
+
+	new->frame_uniforms = alice_new_gpu_buffer(ALICE_GPU_BUFFER_UNIFORM, sizeof(alice_frame_data_t));
+	new->point_light_storage = alice_new_gpu_buffer(ALICE_GPU_BUFFER_STORAGE,
+			sizeof(alice_point_light_data_t));
+
+	new->point_light_data = alice_null;
+	new->point_light_capacity = 0;
+
+	new->light_clusters = alice_new_light_clusters();
+	new->light_cluster_storage = alice_new_gpu_buffer(ALICE_GPU_BUFFER_STORAGE,
+			ALICE_LIGHT_CLUSTER_COUNT * sizeof(alice_light_cluster_t));
+	new->light_index_storage = alice_new_gpu_buffer(ALICE_GPU_BUFFER_STORAGE, sizeof(u32));
+
+	new->instance_storage = alice_new_gpu_buffer(ALICE_GPU_BUFFER_STORAGE, sizeof(alice_m4f_t));
+	new->draw_commands = alice_new_gpu_buffer(ALICE_GPU_BUFFER_INDIRECT, sizeof(alice_draw_command_t));
 
 	new->use_bloom = false;
 	new->bloom_threshold = 100.0f;
-	new->bloom_blur_iterations = 10;
+	new->bloom_mip_count = 6;
+	new->bloom_pass_count = 0;
+
+	new->use_deferred = false;
+
+	new->use_dynamic_resolution = false;
+	alice_init_resolution_controller(&new->resolution, 1.0 / 60.0);
+	new->resolution_scale = 1.0f;
+	new->gbuffer_shader = alice_null;
+	new->deferred_shader = alice_null;
+
+	new->use_occlusion_culling = false;
+	new->occlusion = alice_new_occlusion_buffer(ALICE_OCCLUSION_DEFAULT_WIDTH,
+			ALICE_OCCLUSION_DEFAULT_HEIGHT);
+	new->occluded_object_count = 0;
 
 	new->use_antialiasing = false;
 
+	new->use_lods = true;
+	new->lod_threshold = 1.0f;
+	memset(new->lod_object_counts, 0, sizeof(new->lod_object_counts));
+
 	new->debug = debug;
 	if (debug && debug_shader) {
 		new->debug_renderer = alice_new_debug_renderer(debug_shader);
@@ -1535,6 +3138,9 @@ alice_scene_renderer_3d_t* alice_new_scene_renderer_3d(alice_shader_t* postproce
 
 	new->color_mod = ALICE_COLOR_WHITE;
 
+	new->ambient_color = ALICE_COLOR_WHITE;
+	new->ambient_intensity = 0.0f;
+
 	float verts[] = {
 		 1.0,  1.0, 	1.0f, 1.0f,
 		 1.0, -1.0, 	1.0f, 0.0f,
@@ -1563,15 +3169,31 @@ alice_scene_renderer_3d_t* alice_new_scene_renderer_3d(alice_shader_t* postproce
 void alice_free_scene_renderer_3d(alice_scene_renderer_3d_t* renderer) {
 	assert(renderer);
 
-	alice_free_render_target(renderer->output);
-	alice_free_render_target(renderer->bright_pixels);
-	alice_free_render_target(renderer->bloom_ping_pong[0]);
-	alice_free_render_target(renderer->bloom_ping_pong[1]);
+	alice_free_frame_graph(renderer->frame_graph);
 	alice_free_vertex_buffer(renderer->quad);
 
 	alice_free_shadowmap(renderer->shadowmap);
 	alice_free_point_shadowmap(renderer->point_shadowmap);
 
+	alice_free_render_queue(renderer->queue);
+	alice_free_command_lists(renderer->command_lists);
+
+	alice_free_occlusion_buffer(renderer->occlusion);
+
+	alice_free_static_batches(renderer);
+
+	alice_free_gpu_buffer(renderer->frame_uniforms);
+	alice_free_gpu_buffer(renderer->point_light_storage);
+	alice_free_gpu_buffer(renderer->light_cluster_storage);
+	alice_free_gpu_buffer(renderer->light_index_storage);
+	alice_free_light_clusters(renderer->light_clusters);
+	alice_free_gpu_buffer(renderer->instance_storage);
+	alice_free_gpu_buffer(renderer->draw_commands);
+
+	if (renderer->point_light_capacity > 0) {
+		free(renderer->point_light_data);
+	}
+
 	if (renderer->debug) {
 		alice_free_debug_renderer(renderer->debug_renderer);
 	}
@@ -1639,260 +3261,331 @@ alice_aabb_t alice_compute_scene_aabb(alice_scene_t* scene) {
 		.max = {-INFINITY, -INFINITY, -INFINITY}
 	};
 
-	for (alice_entity_iter(scene, iter, alice_renderable_3d_t)) {
-		alice_renderable_3d_t* renderable = iter.current_ptr;
+	/* The root's bounds are made of fattened leaves, so they can be a
+	 * little larger than the renderables themselves. */
+	alice_bvh_get_bounds(scene->bvh, &result);
 
-		alice_m4f_t transform_matrix = renderable->base.transform;
+	return result;
+}
 
-		alice_model_t* model = renderable->model;
-		if (!model) {
-			continue;
-		}
+static bool alice_is_deferred_bucket(const alice_draw_bucket_t* bucket) {
+	return bucket->pass == ALICE_RENDER_PASS_OPAQUE &&
+		bucket->material && bucket->material->type == ALICE_MATERIAL_PBR;
+}
 
-		for (u32 i = 0; i < model->mesh_count; i++) {
-			alice_mesh_t* mesh = &model->meshes[i];
+/* What the passes of a 3D frame need, handed to each of them through the
+ * frame graph. The bloom passes each get one of `bloom_passes' so they
+ * know which mip they're on. */
+typedef struct alice_scene_frame_t alice_scene_frame_t;
 
-			alice_m4f_t mesh_transform = alice_m4f_multiply(transform_matrix, mesh->transform);
+typedef struct alice_bloom_pass_t {
+	alice_scene_frame_t* frame;
+	u32 mip;
+} alice_bloom_pass_t;
 
-			alice_aabb_t mesh_aabb = alice_transform_aabb(mesh->aabb, mesh_transform);
-			mesh_aabb.min.x += mesh_transform.elements[3][0];
-			mesh_aabb.min.y += mesh_transform.elements[3][1];
-			mesh_aabb.min.z += mesh_transform.elements[3][2];
-			mesh_aabb.max.x += mesh_transform.elements[3][0];
-			mesh_aabb.max.y += mesh_transform.elements[3][1];
-			mesh_aabb.max.z += mesh_transform.elements[3][2];
+struct alice_scene_frame_t {
+	alice_scene_renderer_3d_t* renderer;
+	alice_scene_t* scene;
+	alice_camera_3d_t* camera;
 
-			result.min.x = alice_min(result.min.x, mesh_aabb.min.x);
-			result.min.y = alice_min(result.min.y, mesh_aabb.min.y);
-			result.min.z = alice_min(result.min.z, mesh_aabb.min.z);
-			result.max.x = alice_max(result.max.x, mesh_aabb.max.x);
-			result.max.y = alice_max(result.max.y, mesh_aabb.max.y);
-			result.max.z = alice_max(result.max.z, mesh_aabb.max.z);
+	/* The scene is drawn at `scene_width' by `scene_height' and scaled
+	 * up to `width' by `height' by the postprocess pass. */
+	u32 width, height;
+	u32 scene_width, scene_height;
+	bool deferred;
+
+	/* Shader features shared by everything drawn in the frame. */
+	u32 features;
+
+	u32 gbuffer;
+	u32 output;
+	u32 final;
+
+	u32 bloom_mips[ALICE_MAX_BLOOM_MIPS];
+	u32 bloom_mip_count;
+	alice_bloom_pass_t bloom_passes[ALICE_MAX_BLOOM_MIPS];
+};
+
+/* Draws the deferred buckets into the G-buffer. Expects the frame data and
+ * the queue's buffers to be bound already. */
+static void alice_gbuffer_pass(alice_frame_graph_t* graph, void* data) {
+	alice_scene_frame_t* frame = data;
+	alice_scene_renderer_3d_t* renderer = frame->renderer;
+	alice_render_queue_t* queue = renderer->queue;
+
+	alice_render_target_t* gbuffer = alice_frame_graph_get_target(graph, frame->gbuffer);
+
+	alice_bind_render_target(gbuffer, frame->width, frame->height);
+
+	/* The lighting pass skips texels with no depth, whatever the clear
+	 * colour is. */
+	const float zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	glClearBufferfv(GL_COLOR, ALICE_GBUFFER_ATTACHMENT_COUNT - 1, zero);
+
+	alice_bind_geometry_pool(alice_get_geometry_pool());
+
+	alice_shader_t* bound_shader = alice_null;
+
+	for (u32 i = 0; i < queue->bucket_count; i++) {
+		alice_draw_bucket_t* bucket = &queue->buckets[i];
+
+		if (!alice_is_deferred_bucket(bucket)) {
+			continue;
 		}
-	}
 
-	return result;
-}
+		alice_shader_t* shader = alice_get_shader_variant(renderer->gbuffer_shader,
+				alice_get_material_features(bucket->material) | frame->features);
 
-void alice_render_scene_3d(alice_scene_renderer_3d_t* renderer, u32 width, u32 height,
-		alice_scene_t* scene, alice_render_target_t* render_target) {
-	assert(renderer);
-	assert(scene);
+		if (shader != bound_shader) {
+			alice_bind_shader(shader);
+			bound_shader = shader;
+		}
 
-	renderer->draw_call_count = 0;
+		alice_apply_material_properties(bucket->material);
 
-	alice_camera_3d_t* camera = alice_get_scene_camera_3d(scene);
-	if (!camera) {
-		alice_log_warning("Attempting 3D scene render with no active 3D camera");
-		return;
+		alice_draw_geometry_indirect(bucket->first_command, bucket->command_count);
+
+		renderer->draw_call_count++;
+		renderer->drawn_object_count += bucket->object_count;
 	}
 
-	camera->dimentions = (alice_v2f_t){(float)width, (float)height};
+	alice_bind_geometry_pool(alice_null);
 
-	alice_enable_depth();
+	alice_unbind_render_target(gbuffer);
+}
 
-	alice_draw_shadowmap(renderer->shadowmap, scene, camera);
+/* Lights the G-buffer into the bound output target and copies its depth
+ * across, so that the forward buckets can be drawn over the top. */
+static void alice_draw_deferred_lighting(alice_scene_frame_t* frame,
+		alice_render_target_t* gbuffer, alice_render_target_t* output) {
+	alice_scene_renderer_3d_t* renderer = frame->renderer;
 
-	renderer->draw_call_count += renderer->shadowmap->draw_call_count;
+	alice_gl_bind_read_framebuffer(gbuffer->frame_buffer);
+	alice_gl_bind_draw_framebuffer(output->frame_buffer);
+	glBlitFramebuffer(0, 0, frame->scene_width, frame->scene_height,
+		0, 0, frame->scene_width, frame->scene_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	alice_gl_bind_framebuffer(output->frame_buffer);
 
-	alice_resize_render_target(renderer->output, width, height);
-	alice_bind_render_target(renderer->output, width, height);
+	const alice_m4f_t projection = alice_get_camera_3d_projection(frame->camera);
 
-	if (renderer->debug) {
-		renderer->debug_renderer->scene = scene;
-		renderer->debug_renderer->camera = camera;
+	alice_shader_t* shader = alice_get_shader_variant(renderer->deferred_shader, frame->features);
+	alice_bind_shader(shader);
+
+	for (u32 i = 0; i < ALICE_GBUFFER_ATTACHMENT_COUNT; i++) {
+		alice_render_target_bind_output(gbuffer, i, i);
 	}
 
-	alice_m4f_t camera_matrix = alice_get_camera_3d_matrix(scene, camera);
+	alice_shader_set_m4f(shader, "inverse_view",
+		alice_m4f_inverse(alice_get_camera_3d_view(frame->scene, frame->camera)));
+	alice_shader_set_v2f(shader, "projection_scale", (alice_v2f_t) {
+		1.0f / projection.elements[0][0],
+		1.0f / projection.elements[1][1]
+	});
 
-	for (alice_entity_iter(scene, iter, alice_renderable_3d_t)) {
-		alice_renderable_3d_t* renderable = iter.current_ptr;
+	alice_disable_depth();
 
-		alice_m4f_t transform_matrix = renderable->base.transform;
+	alice_bind_vertex_buffer_for_draw(renderer->quad);
+	alice_draw_vertex_buffer(renderer->quad);
+	alice_bind_vertex_buffer_for_draw(alice_null);
 
-		alice_model_t* model = renderable->model;
-		if (!model) {
-			continue;
-		}
+	renderer->draw_call_count++;
 
-		for (u32 i = 0; i < model->mesh_count; i++) {
-			alice_mesh_t* mesh = &model->meshes[i];
-			alice_vertex_buffer_t* vb = mesh->vb;
+	alice_enable_depth();
+}
 
-			alice_material_t* material = alice_null;
-			if (i < renderable->material_count) {
-				material = renderable->materials[i];
-			} else if (renderable->material_count == 1) {
-				material = renderable->materials[0];
-			}
+/* Draws the scene into the output target: the deferred lighting if there
+ * is any, then every bucket it didn't cover, then the debug lines. */
+static void alice_scene_pass(alice_frame_graph_t* graph, void* data) {
+	alice_scene_frame_t* frame = data;
+	alice_scene_renderer_3d_t* renderer = frame->renderer;
+	alice_render_queue_t* queue = renderer->queue;
+	alice_scene_t* scene = frame->scene;
 
-			if (!material) {
-				alice_log_warning("Attempting to render object that doesn't have any materials.");
-				goto renderable_iter_continue;
-			}
+	alice_render_target_t* output = alice_frame_graph_get_target(graph, frame->output);
 
-			alice_m4f_t mesh_transform = alice_m4f_multiply(transform_matrix, mesh->transform);
+	alice_bind_render_target(output, frame->width, frame->height);
 
-			alice_aabb_t mesh_aabb = alice_transform_aabb(mesh->aabb, mesh_transform);
-			mesh_aabb.min.x += mesh_transform.elements[3][0];
-			mesh_aabb.min.y += mesh_transform.elements[3][1];
-			mesh_aabb.min.z += mesh_transform.elements[3][2];
-			mesh_aabb.max.x += mesh_transform.elements[3][0];
-			mesh_aabb.max.y += mesh_transform.elements[3][1];
-			mesh_aabb.max.z += mesh_transform.elements[3][2];
+	/* The clear colour isn't bright, whatever it is. */
+	const float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	glClearBufferfv(GL_COLOR, 1, black);
 
-			alice_apply_material(scene, material);
-			alice_apply_point_lights(scene, mesh_aabb, material);
+	if (frame->deferred) {
+		alice_draw_deferred_lighting(frame, alice_frame_graph_get_target(graph, frame->gbuffer), output);
+	}
 
-			alice_shader_t* shader = material->shader;
+	alice_bind_geometry_pool(alice_get_geometry_pool());
 
-			alice_shader_set_color(shader, "ambient_color", renderer->ambient_color);
-			alice_shader_set_int(shader, "use_shadows", renderer->shadowmap->in_use);
-			alice_shader_set_float(shader, "ambient_intensity", renderer->ambient_intensity);
+	alice_shader_t* bound_shader = alice_null;
+	bool depth_write = true;
 
-			alice_shader_set_int(shader, "shadowmap", 8);
-			alice_bind_shadowmap_output(renderer->shadowmap, 8);
+	for (u32 i = 0; i < queue->bucket_count; i++) {
+		alice_draw_bucket_t* bucket = &queue->buckets[i];
 
-			alice_m4f_t model = alice_m4f_multiply(transform_matrix, mesh->transform);
+		if (frame->deferred && alice_is_deferred_bucket(bucket)) {
+			continue;
+		}
 
-			alice_shader_set_m4f(shader, "transform", model);
-			alice_shader_set_v3f(shader, "camera_position",
-					alice_get_entity_world_position(scene, (alice_entity_t*)camera));
-			alice_shader_set_float(shader, "gamma", camera->gamma);
-			alice_shader_set_m4f(shader, "camera", camera_matrix);
+		if (depth_write && bucket->pass == ALICE_RENDER_PASS_TRANSPARENT) {
+			alice_gl_depth_mask(false);
+			depth_write = false;
+		}
 
-			alice_bind_vertex_buffer_for_draw(vb);
-			alice_draw_vertex_buffer(vb);
+		alice_shader_t* shader = alice_get_material_shader(bucket->material, frame->features);
 
-			renderer->draw_call_count++;
+		if (shader != bound_shader) {
+			alice_bind_shader(shader);
+			bound_shader = shader;
 		}
 
-renderable_iter_continue:
-		continue;
+		/* Buckets are split on material changes, so every bucket needs
+		 * its material applied. */
+		alice_apply_material_properties(bucket->material);
+
+		alice_draw_geometry_indirect(bucket->first_command, bucket->command_count);
+
+		renderer->draw_call_count++;
+		renderer->drawn_object_count += bucket->object_count;
+	}
+
+	if (!depth_write) {
+		alice_gl_depth_mask(true);
 	}
 
+	alice_bind_geometry_pool(alice_null);
+
 	alice_disable_depth();
 
 	if (renderer->debug) {
+		/* The line shader has no bright output to write. */
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
 		alice_aabb_t scene_aabb = alice_compute_scene_aabb(scene);
 		alice_debug_renderer_draw_aabb(renderer->debug_renderer, scene_aabb);
 
 		for (alice_entity_iter(scene, iter, alice_renderable_3d_t)) {
 			alice_renderable_3d_t* renderable = iter.current_ptr;
 
-			alice_m4f_t transform_matrix = renderable->base.transform;
-
 			alice_model_t* model = renderable->model;
 			if (!model) {
 				continue;
 			}
 
 			for (u32 i = 0; i < model->mesh_count; i++) {
-				alice_mesh_t* mesh = &model->meshes[i];
-
-				alice_m4f_t mesh_transform = alice_m4f_multiply(transform_matrix, mesh->transform);
-
-				alice_aabb_t mesh_aabb = alice_transform_aabb(mesh->aabb, mesh_transform);
-				mesh_aabb.min.x += mesh_transform.elements[3][0];
-				mesh_aabb.min.y += mesh_transform.elements[3][1];
-				mesh_aabb.min.z += mesh_transform.elements[3][2];
-				mesh_aabb.max.x += mesh_transform.elements[3][0];
-				mesh_aabb.max.y += mesh_transform.elements[3][1];
-				mesh_aabb.max.z += mesh_transform.elements[3][2];
-
-				alice_debug_renderer_draw_aabb(renderer->debug_renderer, mesh_aabb);
+				alice_debug_renderer_draw_aabb(renderer->debug_renderer, renderable->mesh_aabbs[i]);
 			}
 		}
+
+		const u32 draw_buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+		glDrawBuffers(2, draw_buffers);
 	}
 
-	alice_unbind_render_target(renderer->output);
+	alice_unbind_render_target(output);
+}
 
-	alice_render_target_t* bloom_output;
-	if (renderer->use_bloom) {
-		/* Draw bright areas to bloom target */
-		alice_resize_render_target(renderer->bright_pixels, width, height);
-		alice_bind_render_target(renderer->bright_pixels, width, height);
+/* Binds a bloom mip without clearing it, so that upsampling can add onto
+ * what the downsample left there. */
+static void alice_bind_bloom_mip(alice_render_target_t* target, u32 width, u32 height) {
+	target->old_width = width;
+	target->old_height = height;
 
-		alice_bind_shader(renderer->extract);
+	alice_gl_bind_framebuffer(target->frame_buffer);
+	alice_gl_viewport(0, 0, target->width, target->height);
+}
 
-		alice_render_target_bind_output(renderer->output, 0, 0);
-		alice_shader_set_int(renderer->extract, "input_color", 0);
+/* Downsamples into a bloom mip from the one above it, or from the bright
+ * pixels of the output for the first. */
+static void alice_bloom_downsample_pass(alice_frame_graph_t* graph, void* data) {
+	alice_bloom_pass_t* pass = data;
+	alice_scene_frame_t* frame = pass->frame;
+	alice_scene_renderer_3d_t* renderer = frame->renderer;
 
-		alice_shader_set_float(renderer->extract, "input_width", (float)renderer->output->width);
-		alice_shader_set_float(renderer->extract, "input_height", (float)renderer->output->height);
+	alice_render_target_t* mip = alice_frame_graph_get_target(graph, frame->bloom_mips[pass->mip]);
 
-		alice_shader_set_float(renderer->extract, "threshold", renderer->bloom_threshold);
+	alice_bind_bloom_mip(mip, frame->width, frame->height);
 
-		alice_bind_vertex_buffer_for_draw(renderer->quad);
-		alice_draw_vertex_buffer(renderer->quad);
-		alice_bind_vertex_buffer_for_draw(alice_null);
+	if (pass->mip == 0) {
+		alice_render_target_bind_output(alice_frame_graph_get_target(graph, frame->output), 1, 0);
+	} else {
+		alice_render_target_bind_output(
+			alice_frame_graph_get_target(graph, frame->bloom_mips[pass->mip - 1]), 0, 0);
+	}
 
-		renderer->draw_call_count++;
+	alice_bind_shader(renderer->bloom_downsample);
+	alice_shader_set_int(renderer->bloom_downsample, "input_color", 0);
+	alice_shader_set_int(renderer->bloom_downsample, "first_mip", pass->mip == 0);
 
-		alice_unbind_render_target(renderer->bright_pixels);
+	alice_bind_vertex_buffer_for_draw(renderer->quad);
+	alice_draw_vertex_buffer(renderer->quad);
+	alice_bind_vertex_buffer_for_draw(alice_null);
 
-		/* Blur the bloom target */
-		bool horizontal = true;
-		bool first_iteration = true;
-		for (u32 i = 0; i < renderer->bloom_blur_iterations; i++) {
-			bloom_output = renderer->bloom_ping_pong[horizontal];
+	renderer->draw_call_count++;
+	renderer->bloom_pass_count++;
 
-			alice_resize_render_target(bloom_output, width, height);
-			alice_bind_render_target(bloom_output, width, height);
+	alice_unbind_render_target(mip);
+}
 
-			alice_bind_shader(renderer->blur);
+/* Adds a bloom mip onto the one above it. */
+static void alice_bloom_upsample_pass(alice_frame_graph_t* graph, void* data) {
+	alice_bloom_pass_t* pass = data;
+	alice_scene_frame_t* frame = pass->frame;
+	alice_scene_renderer_3d_t* renderer = frame->renderer;
 
-			if (first_iteration) {
-				alice_render_target_bind_output(renderer->bright_pixels, 0, 0);
-				first_iteration = false;
-			} else {
-				alice_render_target_bind_output(renderer->bloom_ping_pong[!horizontal], 0, 0);
-			}
+	alice_render_target_t* mip = alice_frame_graph_get_target(graph, frame->bloom_mips[pass->mip - 1]);
 
-			alice_shader_set_int(renderer->blur, "input_color", 0);
+	alice_bind_bloom_mip(mip, frame->width, frame->height);
+	alice_render_target_bind_output(alice_frame_graph_get_target(graph, frame->bloom_mips[pass->mip]), 0, 0);
 
-			alice_shader_set_int(renderer->blur, "horizontal", horizontal);
+	alice_bind_shader(renderer->bloom_upsample);
+	alice_shader_set_int(renderer->bloom_upsample, "input_color", 0);
 
-			alice_shader_set_float(renderer->blur, "input_width",
-					(float)renderer->bright_pixels->width);
-			alice_shader_set_float(renderer->blur, "input_height",
-					(float)renderer->bright_pixels->height);
+	alice_gl_blend_func(GL_ONE, GL_ONE);
 
-			alice_bind_vertex_buffer_for_draw(renderer->quad);
-			alice_draw_vertex_buffer(renderer->quad);
-			alice_bind_vertex_buffer_for_draw(alice_null);
+	alice_bind_vertex_buffer_for_draw(renderer->quad);
+	alice_draw_vertex_buffer(renderer->quad);
+	alice_bind_vertex_buffer_for_draw(alice_null);
 
-			renderer->draw_call_count++;
+	alice_gl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-			alice_unbind_render_target(bloom_output);
+	renderer->draw_call_count++;
+	renderer->bloom_pass_count++;
 
-			horizontal = !horizontal;
-		}
-	}
+	alice_unbind_render_target(mip);
+}
+
+/* Tonemaps the output, with the bloom added on if it was drawn, into the
+ * render target or the backbuffer. */
+static void alice_postprocess_pass(alice_frame_graph_t* graph, void* data) {
+	alice_scene_frame_t* frame = data;
+	alice_scene_renderer_3d_t* renderer = frame->renderer;
+
+	alice_render_target_t* output = alice_frame_graph_get_target(graph, frame->output);
+	alice_render_target_t* render_target = alice_frame_graph_get_target(graph, frame->final);
 
-	/* Draw to render target/backbuffer */
 	if (render_target) {
-		alice_resize_render_target(render_target, width, height);
-		alice_bind_render_target(render_target, width, height);
+		alice_bind_render_target(render_target, frame->width, frame->height);
 	}
 
 	alice_bind_shader(renderer->postprocess);
-	alice_render_target_bind_output(renderer->output, 0, 0);
+	alice_render_target_bind_output(output, 0, 0);
+
+	const bool use_bloom = renderer->use_bloom && frame->bloom_mip_count > 0;
 
-	if (renderer->use_bloom) {
-		alice_render_target_bind_output(bloom_output, 0, 1);
+	if (use_bloom) {
+		alice_render_target_bind_output(alice_frame_graph_get_target(graph, frame->bloom_mips[0]), 0, 1);
 		alice_shader_set_int(renderer->postprocess, "bloom_texture", 1);
+		alice_shader_set_float(renderer->postprocess, "bloom_scale", 1.0f / (float)frame->bloom_mip_count);
 	}
 
-	alice_shader_set_int(renderer->postprocess, "use_bloom", renderer->use_bloom);
+	alice_shader_set_int(renderer->postprocess, "use_bloom", use_bloom);
 	alice_shader_set_int(renderer->postprocess, "use_antialiasing", renderer->use_antialiasing);
 
 	alice_shader_set_int(renderer->postprocess, "input_color", 0);
 
-	alice_shader_set_float(renderer->postprocess, "input_width", (float)renderer->output->width);
-	alice_shader_set_float(renderer->postprocess, "input_height", (float)renderer->output->height);
-	alice_shader_set_float(renderer->postprocess, "exposure", camera->exposure);
-	alice_shader_set_float(renderer->postprocess, "gamma", camera->gamma);
+	alice_shader_set_float(renderer->postprocess, "input_width", (float)output->width);
+	alice_shader_set_float(renderer->postprocess, "input_height", (float)output->height);
+	alice_shader_set_float(renderer->postprocess, "render_scale", (float)output->width / (float)frame->width);
+	alice_shader_set_float(renderer->postprocess, "exposure", frame->camera->exposure);
+	alice_shader_set_float(renderer->postprocess, "gamma", frame->camera->gamma);
 
 	alice_shader_set_color(renderer->postprocess, "color_mod", renderer->color_mod);
 
@@ -1909,105 +3602,377 @@ renderable_iter_continue:
 	}
 }
 
-alice_3d_pick_context_t* alice_new_3d_pick_context(alice_shader_t* shader) {
-	assert(shader);
+/* Declares the passes of a frame. The G-buffer and bloom passes are always
+ * declared and left for the graph to cull when nothing reads them. */
+static void alice_build_scene_frame_graph(alice_frame_graph_t* graph, alice_scene_frame_t* frame,
+		alice_render_target_t* render_target) {
+	alice_scene_renderer_3d_t* renderer = frame->renderer;
 
-	alice_3d_pick_context_t* new = malloc(sizeof(alice_3d_pick_context_t));
+	const u32 width = frame->scene_width;
+	const u32 height = frame->scene_height;
 
-	new->shader = shader;
-	new->target = alice_new_render_target(128, 128, 1);
+	alice_begin_frame_graph(graph);
 
-	return new;
-}
+	frame->gbuffer = alice_frame_graph_create_target(graph, "gbuffer", (alice_frame_graph_target_desc_t) {
+		width, height, ALICE_GBUFFER_ATTACHMENT_COUNT });
+	frame->output = alice_frame_graph_create_target(graph, "output", (alice_frame_graph_target_desc_t) {
+		width, height, 2 });
+	frame->final = alice_frame_graph_import_target(graph, "final", render_target);
+	alice_frame_graph_mark_output(graph, frame->final);
+
+	frame->bloom_mip_count = 0;
+
+	u32 mip_width = width / 2;
+	u32 mip_height = height / 2;
+
+	const u32 max_mips = alice_min(renderer->bloom_mip_count, ALICE_MAX_BLOOM_MIPS);
+	while (frame->bloom_mip_count < max_mips && mip_width >= 2 && mip_height >= 2) {
+		frame->bloom_mips[frame->bloom_mip_count++] = alice_frame_graph_create_target(graph, "bloom_mip",
+			(alice_frame_graph_target_desc_t) { mip_width, mip_height, 1 });
+
+		mip_width /= 2;
+		mip_height /= 2;
+	}
+
+	u32 pass = alice_frame_graph_add_pass(graph, "gbuffer", alice_gbuffer_pass, frame);
+	alice_frame_graph_write(graph, pass, frame->gbuffer);
 
-void alice_free_3d_pick_context(alice_3d_pick_context_t* context) {
-	assert(context);
+	pass = alice_frame_graph_add_pass(graph, "scene", alice_scene_pass, frame);
+	if (frame->deferred) {
+		alice_frame_graph_read(graph, pass, frame->gbuffer);
+	}
+	alice_frame_graph_write(graph, pass, frame->output);
+
+	for (u32 i = 0; i < frame->bloom_mip_count; i++) {
+		frame->bloom_passes[i] = (alice_bloom_pass_t) { frame, i };
+
+		pass = alice_frame_graph_add_pass(graph, "bloom_downsample", alice_bloom_downsample_pass,
+				&frame->bloom_passes[i]);
+		alice_frame_graph_read(graph, pass, i == 0 ? frame->output : frame->bloom_mips[i - 1]);
+		alice_frame_graph_write(graph, pass, frame->bloom_mips[i]);
+	}
 
-	alice_free_render_target(context->target);
+	for (u32 i = frame->bloom_mip_count; i-- > 1;) {
+		pass = alice_frame_graph_add_pass(graph, "bloom_upsample", alice_bloom_upsample_pass,
+				&frame->bloom_passes[i]);
+		alice_frame_graph_read(graph, pass, frame->bloom_mips[i]);
+		alice_frame_graph_read(graph, pass, frame->bloom_mips[i - 1]);
+		alice_frame_graph_write(graph, pass, frame->bloom_mips[i - 1]);
+	}
+
+	pass = alice_frame_graph_add_pass(graph, "postprocess", alice_postprocess_pass, frame);
+	alice_frame_graph_read(graph, pass, frame->output);
+	if (renderer->use_bloom && frame->bloom_mip_count > 0) {
+		alice_frame_graph_read(graph, pass, frame->bloom_mips[0]);
+	}
+	alice_frame_graph_write(graph, pass, frame->final);
 
-	free(context);
+	alice_compile_frame_graph(graph);
 }
 
-alice_entity_handle_t alice_3d_pick(alice_3d_pick_context_t* context, alice_scene_t* scene) {
-	assert(context);
+void alice_render_scene_3d(alice_scene_renderer_3d_t* renderer, u32 width, u32 height,
+		alice_scene_t* scene, alice_render_target_t* render_target) {
+	assert(renderer);
 	assert(scene);
 
+	renderer->draw_call_count = 0;
+	renderer->drawn_object_count = 0;
+	renderer->culled_object_count = 0;
+	renderer->occluded_object_count = 0;
+	renderer->bloom_pass_count = 0;
+
 	alice_camera_3d_t* camera = alice_get_scene_camera_3d(scene);
 	if (!camera) {
 		alice_log_warning("Attempting 3D scene render with no active 3D camera");
-		return alice_null_entity_handle;
+		return;
 	}
 
+	camera->dimentions = (alice_v2f_t){(float)width, (float)height};
+
+	alice_begin_profile_scope("Scene 3D");
+
 	alice_enable_depth();
 
-	alice_resize_render_target(context->target, camera->dimentions.x, camera->dimentions.y);
-	alice_bind_render_target(context->target, camera->dimentions.x, camera->dimentions.y);
+	alice_update_renderable_3d_bounds(scene);
+
+	const alice_v3f_t camera_position = alice_get_entity_world_position(scene, (alice_entity_t*)camera);
+
+	/* LODs are picked before any pass records, so that the shadow
+	 * cascades draw the levels the camera draws this frame. Errors are
+	 * measured against the output, not the scene's dynamic resolution,
+	 * since that's what they end up covering. */
+	const alice_lod_selection_t lods = {
+		.pixels_per_unit = (float)height / (2.0f * tanf(alice_torad(0.5f * camera->fov))),
+		.threshold = renderer->lod_threshold
+	};
+
+	alice_select_renderable_3d_lods(scene, camera_position, renderer->use_lods ? &lods : alice_null);
+
+	alice_begin_gpu_profile_scope("Shadows");
+	alice_draw_shadowmap(renderer->shadowmap, scene, camera);
+	alice_end_profile_scope();
+
+	renderer->draw_call_count += renderer->shadowmap->draw_call_count;
+
+	alice_begin_gpu_profile_scope("Point Shadows");
+	alice_draw_point_shadowmap(renderer->point_shadowmap, scene);
+	alice_end_profile_scope();
+
+	renderer->draw_call_count += renderer->point_shadowmap->draw_call_count;
+
+	if (renderer->debug) {
+		renderer->debug_renderer->scene = scene;
+		renderer->debug_renderer->camera = camera;
+	}
 
 	alice_m4f_t camera_matrix = alice_get_camera_3d_matrix(scene, camera);
+	const alice_frustum_t frustum = alice_frustum_from_m4f(camera_matrix);
 
-	alice_shader_t* shader = context->shader;
-	alice_bind_shader(shader);
-	alice_shader_set_m4f(shader, "camera", camera_matrix);
+	alice_begin_profile_scope("Culling");
 
-	for (alice_entity_iter(scene, iter, alice_renderable_3d_t)) {
-		alice_renderable_3d_t* renderable = iter.current_ptr;
+	alice_clear_render_queue(renderer->queue);
 
-		alice_m4f_t transform_matrix = renderable->base.transform;
+	alice_occlusion_buffer_t* occlusion = renderer->use_occlusion_culling ? renderer->occlusion : alice_null;
 
-		alice_model_t* model = renderable->model;
-		if (!model) {
+	renderer->culled_object_count += alice_record_renderables_3d(scene, renderer->command_lists,
+			renderer->queue, camera_matrix, camera_position, false, occlusion);
+
+	for (u32 i = 0; i < renderer->static_chunk_count; i++) {
+		alice_static_chunk_t* chunk = &renderer->static_chunks[i];
+
+		if (!alice_frustum_vs_aabb(&frustum, chunk->mesh.aabb)) {
+			renderer->culled_object_count++;
 			continue;
 		}
 
-		alice_entity_handle_t entity_id = alice_get_entity_handle_id(iter.current) + 1;
+		if (occlusion) {
+			occlusion->tested_count++;
 
-		for (u32 i = 0; i < model->mesh_count; i++) {
-			alice_mesh_t* mesh = &model->meshes[i];
-			alice_vertex_buffer_t* vb = mesh->vb;
+			if (alice_occlusion_test_aabb(occlusion, chunk->mesh.aabb)) {
+				occlusion->rejected_count++;
+				renderer->culled_object_count++;
+				continue;
+			}
+		}
 
-			alice_m4f_t mesh_transform = alice_m4f_multiply(transform_matrix, mesh->transform);
+		alice_render_queue_push(renderer->queue, ALICE_RENDER_PASS_OPAQUE,
+				chunk->material, &chunk->mesh, 0, alice_m4f_identity(), chunk->mesh.aabb,
+				alice_aabb_center_distance_squared(chunk->mesh.aabb, camera_position));
+	}
 
-			alice_m4f_t model = alice_m4f_multiply(transform_matrix, mesh->transform);
+	if (occlusion) {
+		renderer->occluded_object_count = occlusion->rejected_count;
+	}
+
+	alice_sort_render_queue(renderer->queue);
+
+	memset(renderer->lod_object_counts, 0, sizeof(renderer->lod_object_counts));
+	for (u32 i = 0; i < renderer->queue->packet_count; i++) {
+		renderer->lod_object_counts[renderer->queue->packets[i].lod]++;
+	}
+
+	alice_end_profile_scope();
 
-			i32 r = (entity_id & 0x000000FF) >> 0;
-			i32 g = (entity_id & 0x0000FF00) >> 8;
-			i32 b = (entity_id & 0x00FF0000) >> 16;
+	u32 scene_width = width;
+	u32 scene_height = height;
 
-			alice_shader_set_m4f(shader, "transform", model);
-			alice_shader_set_v3f(shader, "object", (alice_v3f_t){
-					(float)r / 255.0f, (float)g / 255.0f, (float)b / 255.0f});
+	if (renderer->use_dynamic_resolution) {
+		renderer->resolution_scale = alice_update_resolution_controller(&renderer->resolution,
+				alice_get_timestep());
 
-			alice_bind_vertex_buffer_for_draw(vb);
-			alice_draw_vertex_buffer(vb);
+		scene_width = alice_scale_resolution(width, renderer->resolution_scale);
+		scene_height = alice_scale_resolution(height, renderer->resolution_scale);
+	} else {
+		renderer->resolution_scale = 1.0f;
+	}
+
+	alice_upload_frame_data(renderer, scene, camera, camera_matrix, camera_position,
+			(alice_v2f_t) { (float)scene_width, (float)scene_height });
+	alice_bind_shadowmap_output(renderer->shadowmap, 8);
+	alice_bind_point_shadowmap_output(renderer->point_shadowmap, 9);
+
+	alice_render_queue_t* queue = renderer->queue;
+
+	alice_render_queue_build_commands(queue);
+
+	alice_update_gpu_buffer(renderer->instance_storage, alice_render_queue_gather_transforms(queue),
+			queue->packet_count * sizeof(alice_m4f_t));
+	alice_bind_gpu_buffer(renderer->instance_storage, ALICE_INSTANCE_BLOCK_BINDING);
+
+	alice_update_gpu_buffer(renderer->draw_commands, queue->commands,
+			queue->command_count * sizeof(alice_draw_command_t));
+	alice_bind_gpu_buffer(renderer->draw_commands, 0);
+
+	alice_geometry_pool_reserve_draw_indices(alice_get_geometry_pool(), queue->packet_count);
+
+	if (render_target) {
+		alice_resize_render_target(render_target, width, height);
+	}
+
+	u32 features = ALICE_SHADER_FEATURE_INSTANCING;
+
+	if (renderer->shadowmap->in_use) {
+		features |= ALICE_SHADER_FEATURE_SHADOWS;
+	}
+
+	if (renderer->point_shadowmap->in_use) {
+		features |= ALICE_SHADER_FEATURE_POINT_SHADOWS;
+	}
+
+	alice_scene_frame_t frame = {
+		.renderer = renderer,
+		.scene = scene,
+		.camera = camera,
+		.width = width,
+		.height = height,
+		.scene_width = scene_width,
+		.scene_height = scene_height,
+		.features = features,
+
+		/* Without its shaders there is nothing to draw the deferred path
+		 * with, so everything goes forward. */
+		.deferred = renderer->use_deferred && renderer->gbuffer_shader && renderer->deferred_shader
+	};
+
+	alice_build_scene_frame_graph(renderer->frame_graph, &frame, render_target);
+	alice_execute_frame_graph(renderer->frame_graph);
+
+	alice_end_profile_scope();
+}
+
+/* Maps a point in normalised device coordinates back into world space. */
+static alice_v3f_t alice_unproject(alice_m4f_t inverse_camera, float x, float y, float z) {
+	const alice_m4f_t m = inverse_camera;
+
+	const float w = m.elements[0][3] * x + m.elements[1][3] * y + m.elements[2][3] * z + m.elements[3][3];
+
+	return (alice_v3f_t) {
+		(m.elements[0][0] * x + m.elements[1][0] * y + m.elements[2][0] * z + m.elements[3][0]) / w,
+		(m.elements[0][1] * x + m.elements[1][1] * y + m.elements[2][1] * z + m.elements[3][1]) / w,
+		(m.elements[0][2] * x + m.elements[1][2] * y + m.elements[2][2] * z + m.elements[3][2]) / w
+	};
+}
+
+typedef struct alice_raycast_context_t {
+	alice_entity_pool_t* pool;
+
+	alice_v3f_t origin;
+	alice_v3f_t direction;
+
+	bool hit;
+	alice_3d_raycast_result_t* result;
+} alice_raycast_context_t;
+
+static float alice_raycast_candidate(void* data, u32 user_data, float max_distance) {
+	alice_raycast_context_t* context = data;
+
+	alice_renderable_3d_t* renderable = alice_entity_pool_get(context->pool, user_data);
+
+	alice_model_t* model = renderable->model;
+	if (!model) {
+		return max_distance;
+	}
+
+	const alice_v3f_t o = context->origin;
+	const alice_v3f_t d = context->direction;
+
+	for (u32 i = 0; i < model->mesh_count; i++) {
+		alice_mesh_t* mesh = &model->meshes[i];
+
+		float t;
+		if (!alice_ray_vs_aabb(renderable->mesh_aabbs[i], o, d, &t) || t > max_distance) {
+			continue;
+		}
+
+		/* The ray is taken into the mesh's space rather than every vertex
+		 * into world space. The direction isn't renormalised, so distances
+		 * along it are still world-space distances. */
+		const alice_m4f_t m = alice_m4f_inverse(alice_m4f_multiply(renderable->base.transform, mesh->transform));
+
+		const alice_v3f_t local_origin = {
+			m.elements[0][0] * o.x + m.elements[1][0] * o.y + m.elements[2][0] * o.z + m.elements[3][0],
+			m.elements[0][1] * o.x + m.elements[1][1] * o.y + m.elements[2][1] * o.z + m.elements[3][1],
+			m.elements[0][2] * o.x + m.elements[1][2] * o.y + m.elements[2][2] * o.z + m.elements[3][2]
+		};
+
+		const alice_v3f_t local_direction = {
+			m.elements[0][0] * d.x + m.elements[1][0] * d.y + m.elements[2][0] * d.z,
+			m.elements[0][1] * d.x + m.elements[1][1] * d.y + m.elements[2][1] * d.z,
+			m.elements[0][2] * d.x + m.elements[1][2] * d.y + m.elements[2][2] * d.z
+		};
+
+		for (u32 j = 0; j + 2 < mesh->index_count; j += 3) {
+			const alice_v3f_t a = mesh->positions[mesh->indices[j + 0]];
+			const alice_v3f_t b = mesh->positions[mesh->indices[j + 1]];
+			const alice_v3f_t c = mesh->positions[mesh->indices[j + 2]];
+
+			if (!alice_ray_vs_triangle(local_origin, local_direction, a, b, c, &t) || t >= max_distance) {
+				continue;
+			}
+
+			max_distance = t;
+
+			context->hit = true;
+			*context->result = (alice_3d_raycast_result_t) {
+				.entity = alice_new_entity_handle(user_data, context->pool->type_id),
+				.point = (alice_v3f_t) { o.x + d.x * t, o.y + d.y * t, o.z + d.z * t },
+				.distance = t,
+				.mesh_index = i,
+				.triangle_index = j / 3
+			};
 		}
 	}
 
-	alice_disable_depth();
+	return max_distance;
+}
 
-	alice_v2i_t mouse_pos = alice_get_mouse_position();
+bool alice_3d_raycast(alice_scene_t* scene, alice_v3f_t origin, alice_v3f_t direction,
+		float max_distance, alice_3d_raycast_result_t* result) {
+	assert(scene);
+	assert(result);
+
+	alice_raycast_context_t context = {
+		.pool = alice_get_renderable_pool(scene),
+		.origin = origin,
+		.direction = alice_v3f_normalise(direction),
+		.hit = false,
+		.result = result
+	};
 
-	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	alice_bvh_query_ray(scene->bvh, context.origin, context.direction, max_distance,
+			alice_raycast_candidate, &context);
 
-	u8 data[3];
-	glReadPixels(mouse_pos.x, camera->dimentions.y - mouse_pos.y, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, &data);
+	if (!context.hit) {
+		*result = (alice_3d_raycast_result_t) { .entity = alice_null_entity_handle };
+	}
 
-	u32 picked_id = 
-		data[0] + 
-		data[1] * 256 +
-		data[2] * 256 * 256;
+	return context.hit;
+}
 
-	alice_entity_handle_t picked_entity = alice_null_entity_handle;
+bool alice_3d_pick(alice_scene_t* scene, alice_v2f_t screen_position, alice_3d_raycast_result_t* result) {
+	assert(scene);
+	assert(result);
 
-	if (picked_id != 0) {
-		picked_entity = alice_new_entity_handle(picked_id - 1,
-				alice_get_type_info(alice_renderable_3d_t).id);
+	alice_camera_3d_t* camera = alice_get_scene_camera_3d(scene);
+	if (!camera) {
+		alice_log_warning("Attempting 3D pick with no active 3D camera");
+		*result = (alice_3d_raycast_result_t) { .entity = alice_null_entity_handle };
+		return false;
 	}
 
-	glReadBuffer(GL_NONE);
+	const alice_m4f_t inverse_camera = alice_m4f_inverse(alice_get_camera_3d_matrix(scene, camera));
+
+	const float ndc_x = 2.0f * screen_position.x / camera->dimentions.x - 1.0f;
+	const float ndc_y = 1.0f - 2.0f * screen_position.y / camera->dimentions.y;
 
-	alice_unbind_render_target(context->target);
+	const alice_v3f_t near_point = alice_unproject(inverse_camera, ndc_x, ndc_y, -1.0f);
+	const alice_v3f_t far_point = alice_unproject(inverse_camera, ndc_x, ndc_y, 1.0f);
 
-	return picked_entity;
+	return alice_3d_raycast(scene, near_point, (alice_v3f_t) {
+		far_point.x - near_point.x,
+		far_point.y - near_point.y,
+		far_point.z - near_point.z
+	}, alice_v3f_dist(near_point, far_point), result);
 }
 
 alice_v3f_t alice_get_sprite_2d_world_position(alice_scene_t* scene, alice_entity_t* entity) {
@@ -2123,7 +4088,9 @@ void alice_render_scene_2d(alice_scene_renderer_2d_t* renderer, u32 width, u32 h
 	assert(renderer);
 	assert(scene);
 
-	glViewport(0.0f, 0.0f, width, height);
+	alice_begin_gpu_profile_scope("Scene 2D");
+
+	alice_gl_viewport(0.0f, 0.0f, width, height);
 
 	alice_camera_2d_t* camera = alice_get_scene_camera_3d_2d(scene);
 
@@ -2213,6 +4180,8 @@ void alice_render_scene_2d(alice_scene_renderer_2d_t* renderer, u32 width, u32 h
 	if (render_target) {
 		alice_unbind_render_target(render_target);
 	}
+
+	alice_end_profile_scope();
 }
 
 void alice_on_tilemap_create(alice_scene_t* scene, alice_entity_handle_t handle, void* ptr) {
@@ -0,0 +1,251 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "alice/jobs.h"
+
+#ifdef ALICE_PLATFORM_WINDOWS
+	#include <windows.h>
+
+	typedef HANDLE alice_thread_t;
+	typedef CRITICAL_SECTION alice_mutex_t;
+	typedef CONDITION_VARIABLE alice_condition_t;
+#else
+	#include <pthread.h>
+	#include <unistd.h>
+
+	typedef pthread_t alice_thread_t;
+	typedef pthread_mutex_t alice_mutex_t;
+	typedef pthread_cond_t alice_condition_t;
+#endif
+
+typedef struct alice_job_system_t {
+	alice_thread_t* threads;
+	u32 thread_count;
+
+	alice_mutex_t mutex;
+	alice_condition_t work_ready;
+	alice_condition_t work_done;
+
+	/* Bumped for every batch, so that sleeping workers can tell a new
+	 * batch from a spurious wake-up. */
+	u64 generation;
+	bool quit;
+
+	alice_job_f function;
+	void* data;
+	u32 count;
+	u32 next;
+	u32 finished;
+} alice_job_system_t;
+
+static alice_job_system_t* job_system = alice_null;
+
+#ifdef ALICE_PLATFORM_WINDOWS
+
+static void alice_init_mutex(alice_mutex_t* mutex) { InitializeCriticalSection(mutex); }
+static void alice_deinit_mutex(alice_mutex_t* mutex) { DeleteCriticalSection(mutex); }
+static void alice_lock_mutex(alice_mutex_t* mutex) { EnterCriticalSection(mutex); }
+static void alice_unlock_mutex(alice_mutex_t* mutex) { LeaveCriticalSection(mutex); }
+
+static void alice_init_condition(alice_condition_t* condition) { InitializeConditionVariable(condition); }
+static void alice_deinit_condition(alice_condition_t* condition) { (void)condition; }
+static void alice_wait_condition(alice_condition_t* condition, alice_mutex_t* mutex) {
+	SleepConditionVariableCS(condition, mutex, INFINITE);
+}
+static void alice_signal_condition(alice_condition_t* condition) { WakeConditionVariable(condition); }
+static void alice_broadcast_condition(alice_condition_t* condition) { WakeAllConditionVariable(condition); }
+
+static u32 alice_get_hardware_thread_count() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (u32)info.dwNumberOfProcessors;
+}
+
+#else
+
+static void alice_init_mutex(alice_mutex_t* mutex) { pthread_mutex_init(mutex, alice_null); }
+static void alice_deinit_mutex(alice_mutex_t* mutex) { pthread_mutex_destroy(mutex); }
+static void alice_lock_mutex(alice_mutex_t* mutex) { pthread_mutex_lock(mutex); }
+static void alice_unlock_mutex(alice_mutex_t* mutex) { pthread_mutex_unlock(mutex); }
+
+static void alice_init_condition(alice_condition_t* condition) { pthread_cond_init(condition, alice_null); }
+static void alice_deinit_condition(alice_condition_t* condition) { pthread_cond_destroy(condition); }
+static void alice_wait_condition(alice_condition_t* condition, alice_mutex_t* mutex) {
+	pthread_cond_wait(condition, mutex);
+}
+static void alice_signal_condition(alice_condition_t* condition) { pthread_cond_signal(condition); }
+static void alice_broadcast_condition(alice_condition_t* condition) { pthread_cond_broadcast(condition); }
+
+static u32 alice_get_hardware_thread_count() {
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32)count : 1;
+}
+
+#endif
+
+/* Takes jobs from the current batch until there are none left. Expects
+ * the mutex to be locked, and leaves it locked. */
+static void alice_work_on_batch(alice_job_system_t* system) {
+	while (system->next < system->count) {
+		const alice_job_f function = system->function;
+		void* data = system->data;
+		const u32 index = system->next++;
+
+		alice_unlock_mutex(&system->mutex);
+		function(data, index);
+		alice_lock_mutex(&system->mutex);
+
+		if (++system->finished == system->count) {
+			alice_signal_condition(&system->work_done);
+		}
+	}
+}
+
+static void alice_worker_loop(alice_job_system_t* system) {
+	u64 seen_generation = 0;
+
+	alice_lock_mutex(&system->mutex);
+
+	while (true) {
+		while (!system->quit && system->generation == seen_generation) {
+			alice_wait_condition(&system->work_ready, &system->mutex);
+		}
+
+		if (system->quit) {
+			break;
+		}
+
+		seen_generation = system->generation;
+
+		alice_work_on_batch(system);
+	}
+
+	alice_unlock_mutex(&system->mutex);
+}
+
+#ifdef ALICE_PLATFORM_WINDOWS
+static DWORD WINAPI alice_worker_main(LPVOID data) {
+	alice_worker_loop(data);
+	return 0;
+}
+#else
+static void* alice_worker_main(void* data) {
+	alice_worker_loop(data);
+	return alice_null;
+}
+#endif
+
+void alice_init_jobs(u32 thread_count) {
+	if (job_system) {
+		alice_log_warning("Job system already initialised");
+		return;
+	}
+
+	if (thread_count == 0) {
+		const u32 hardware_threads = alice_get_hardware_thread_count();
+		thread_count = hardware_threads > 1 ? hardware_threads - 1 : 0;
+	}
+
+	alice_job_system_t* system = malloc(sizeof(alice_job_system_t));
+
+	system->threads = thread_count > 0 ? malloc(thread_count * sizeof(alice_thread_t)) : alice_null;
+	system->thread_count = 0;
+
+	alice_init_mutex(&system->mutex);
+	alice_init_condition(&system->work_ready);
+	alice_init_condition(&system->work_done);
+
+	system->generation = 0;
+	system->quit = false;
+
+	system->function = alice_null;
+	system->data = alice_null;
+	system->count = 0;
+	system->next = 0;
+	system->finished = 0;
+
+	for (u32 i = 0; i < thread_count; i++) {
+		alice_thread_t* thread = &system->threads[system->thread_count];
+
+#ifdef ALICE_PLATFORM_WINDOWS
+		*thread = CreateThread(alice_null, 0, alice_worker_main, system, 0, alice_null);
+		const bool ok = *thread != alice_null;
+#else
+		const bool ok = pthread_create(thread, alice_null, alice_worker_main, system) == 0;
+#endif
+
+		if (!ok) {
+			alice_log_warning("Failed to start job thread; continuing with %u", system->thread_count);
+			break;
+		}
+
+		system->thread_count++;
+	}
+
+	job_system = system;
+}
+
+void alice_deinit_jobs() {
+	alice_job_system_t* system = job_system;
+	if (!system) { return; }
+
+	alice_lock_mutex(&system->mutex);
+	system->quit = true;
+	alice_broadcast_condition(&system->work_ready);
+	alice_unlock_mutex(&system->mutex);
+
+	for (u32 i = 0; i < system->thread_count; i++) {
+#ifdef ALICE_PLATFORM_WINDOWS
+		WaitForSingleObject(system->threads[i], INFINITE);
+		CloseHandle(system->threads[i]);
+#else
+		pthread_join(system->threads[i], alice_null);
+#endif
+	}
+
+	alice_deinit_condition(&system->work_done);
+	alice_deinit_condition(&system->work_ready);
+	alice_deinit_mutex(&system->mutex);
+
+	free(system->threads);
+	free(system);
+
+	job_system = alice_null;
+}
+
+u32 alice_get_job_thread_count() {
+	return job_system ? job_system->thread_count + 1 : 1;
+}
+
+void alice_run_jobs(alice_job_f function, void* data, u32 count) {
+	assert(function);
+
+	alice_job_system_t* system = job_system;
+
+	if (!system || system->thread_count == 0 || count <= 1) {
+		for (u32 i = 0; i < count; i++) {
+			function(data, i);
+		}
+
+		return;
+	}
+
+	alice_lock_mutex(&system->mutex);
+
+	system->function = function;
+	system->data = data;
+	system->count = count;
+	system->next = 0;
+	system->finished = 0;
+	system->generation++;
+
+	alice_broadcast_condition(&system->work_ready);
+
+	alice_work_on_batch(system);
+
+	while (system->finished < system->count) {
+		alice_wait_condition(&system->work_done, &system->mutex);
+	}
+
+	alice_unlock_mutex(&system->mutex);
+}
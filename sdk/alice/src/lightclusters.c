@@ -0,0 +1,300 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alice/lightclusters.h"
+#include "alice/jobs.h"
+
+#ifdef ALICE_SIMD_SSE
+#include <xmmintrin.h>
+#endif
+
+alice_light_clusters_t* alice_new_light_clusters() {
+	alice_light_clusters_t* new = calloc(1, sizeof(alice_light_clusters_t));
+
+	new->view = alice_m4f_identity();
+	new->near = 0.1f;
+	new->far = 100.0f;
+
+	return new;
+}
+
+void alice_free_light_clusters(alice_light_clusters_t* clusters) {
+	assert(clusters);
+
+	if (clusters->light_capacity > 0) {
+		free(clusters->light_x);
+		free(clusters->light_y);
+		free(clusters->light_z);
+		free(clusters->light_radius);
+	}
+
+	for (u32 i = 0; i < ALICE_LIGHT_CLUSTER_Z; i++) {
+		alice_light_cluster_slice_t* slice = &clusters->slices[i];
+
+		if (slice->candidate_capacity > 0) {
+			free(slice->x);
+			free(slice->y);
+			free(slice->z);
+			free(slice->radius);
+			free(slice->lights);
+		}
+
+		if (slice->index_capacity > 0) {
+			free(slice->indices);
+		}
+	}
+
+	if (clusters->index_capacity > 0) {
+		free(clusters->indices);
+	}
+
+	free(clusters);
+}
+
+void alice_begin_light_clusters(alice_light_clusters_t* clusters, alice_m4f_t view,
+		alice_m4f_t projection, float near, float far) {
+	assert(clusters);
+	assert(near > 0.0f && far > near);
+
+	clusters->view = view;
+	clusters->near = near;
+	clusters->far = far;
+
+	clusters->light_count = 0;
+
+	const alice_m4f_t m = alice_m4f_inverse(projection);
+
+	for (u32 y = 0; y <= ALICE_LIGHT_CLUSTER_Y; y++) {
+		for (u32 x = 0; x <= ALICE_LIGHT_CLUSTER_X; x++) {
+			const float ndc_x = -1.0f + 2.0f * (float)x / (float)ALICE_LIGHT_CLUSTER_X;
+			const float ndc_y = -1.0f + 2.0f * (float)y / (float)ALICE_LIGHT_CLUSTER_Y;
+
+			/* Unproject onto the near plane, then scale out to z = -1. */
+			const float px = m.elements[0][0] * ndc_x + m.elements[1][0] * ndc_y - m.elements[2][0] + m.elements[3][0];
+			const float py = m.elements[0][1] * ndc_x + m.elements[1][1] * ndc_y - m.elements[2][1] + m.elements[3][1];
+			const float pz = m.elements[0][2] * ndc_x + m.elements[1][2] * ndc_y - m.elements[2][2] + m.elements[3][2];
+
+			clusters->corners[y * (ALICE_LIGHT_CLUSTER_X + 1) + x] = (alice_v3f_t) {
+				px / -pz, py / -pz, -1.0f
+			};
+		}
+	}
+}
+
+void alice_add_cluster_light(alice_light_clusters_t* clusters, alice_v3f_t position, float range) {
+	assert(clusters);
+
+	if (clusters->light_count >= clusters->light_capacity) {
+		clusters->light_capacity = alice_grow_capacity(clusters->light_capacity);
+		clusters->light_x = realloc(clusters->light_x, clusters->light_capacity * sizeof(float));
+		clusters->light_y = realloc(clusters->light_y, clusters->light_capacity * sizeof(float));
+		clusters->light_z = realloc(clusters->light_z, clusters->light_capacity * sizeof(float));
+		clusters->light_radius = realloc(clusters->light_radius, clusters->light_capacity * sizeof(float));
+	}
+
+	const alice_m4f_t m = clusters->view;
+	const alice_v3f_t p = position;
+
+	const u32 i = clusters->light_count++;
+
+	clusters->light_x[i] = m.elements[0][0] * p.x + m.elements[1][0] * p.y + m.elements[2][0] * p.z + m.elements[3][0];
+	clusters->light_y[i] = m.elements[0][1] * p.x + m.elements[1][1] * p.y + m.elements[2][1] * p.z + m.elements[3][1];
+	clusters->light_z[i] = m.elements[0][2] * p.x + m.elements[1][2] * p.y + m.elements[2][2] * p.z + m.elements[3][2];
+	clusters->light_radius[i] = range;
+}
+
+static float alice_get_light_cluster_depth(const alice_light_clusters_t* clusters, u32 slice) {
+	return clusters->near * powf(clusters->far / clusters->near, (float)slice / (float)ALICE_LIGHT_CLUSTER_Z);
+}
+
+static void alice_push_slice_candidate(alice_light_cluster_slice_t* slice,
+		float x, float y, float z, float radius, u32 light) {
+	if (slice->candidate_count >= slice->candidate_capacity) {
+		slice->candidate_capacity = alice_grow_capacity(slice->candidate_capacity);
+		slice->x = realloc(slice->x, slice->candidate_capacity * sizeof(float));
+		slice->y = realloc(slice->y, slice->candidate_capacity * sizeof(float));
+		slice->z = realloc(slice->z, slice->candidate_capacity * sizeof(float));
+		slice->radius = realloc(slice->radius, slice->candidate_capacity * sizeof(float));
+		slice->lights = realloc(slice->lights, slice->candidate_capacity * sizeof(u32));
+	}
+
+	const u32 i = slice->candidate_count++;
+
+	slice->x[i] = x;
+	slice->y[i] = y;
+	slice->z[i] = z;
+	slice->radius[i] = radius;
+	slice->lights[i] = light;
+}
+
+static void alice_push_slice_index(alice_light_cluster_slice_t* slice, u32 light) {
+	if (slice->index_count >= slice->index_capacity) {
+		slice->index_capacity = alice_grow_capacity(slice->index_capacity);
+		slice->indices = realloc(slice->indices, slice->index_capacity * sizeof(u32));
+	}
+
+	slice->indices[slice->index_count++] = light;
+}
+
+static void alice_cluster_slice_job(void* data, u32 z) {
+	alice_light_clusters_t* clusters = data;
+	alice_light_cluster_slice_t* slice = &clusters->slices[z];
+
+	const float near = alice_get_light_cluster_depth(clusters, z);
+	const float far = alice_get_light_cluster_depth(clusters, z + 1);
+
+	slice->candidate_count = 0;
+	slice->index_count = 0;
+
+	for (u32 i = 0; i < clusters->light_count; i++) {
+		const float depth = -clusters->light_z[i];
+		const float radius = clusters->light_radius[i];
+
+		if (depth + radius < near || depth - radius > far) {
+			continue;
+		}
+
+		alice_push_slice_candidate(slice, clusters->light_x[i], clusters->light_y[i],
+				clusters->light_z[i], radius, i);
+	}
+
+	const u32 candidate_count = slice->candidate_count;
+
+	/* Pad to a whole number of groups of four with spheres that can't
+	 * touch anything. */
+	while (slice->candidate_count % 4 != 0) {
+		alice_push_slice_candidate(slice, INFINITY, INFINITY, INFINITY, 0.0f, 0);
+	}
+
+	for (u32 y = 0; y < ALICE_LIGHT_CLUSTER_Y; y++) {
+		for (u32 x = 0; x < ALICE_LIGHT_CLUSTER_X; x++) {
+			alice_light_cluster_t* cluster = &clusters->clusters[
+				(z * ALICE_LIGHT_CLUSTER_Y + y) * ALICE_LIGHT_CLUSTER_X + x];
+
+			cluster->offset = slice->index_count;
+			cluster->count = 0;
+
+			if (candidate_count == 0) {
+				continue;
+			}
+
+			/* Bounds of the cluster, from the four corner rays of its tile
+			 * at either end of the slice. */
+			float min_x = INFINITY, min_y = INFINITY;
+			float max_x = -INFINITY, max_y = -INFINITY;
+
+			for (u32 c = 0; c < 4; c++) {
+				const alice_v3f_t corner = clusters->corners[
+					(y + (c >> 1)) * (ALICE_LIGHT_CLUSTER_X + 1) + x + (c & 1)];
+
+				min_x = alice_min(min_x, alice_min(corner.x * near, corner.x * far));
+				max_x = alice_max(max_x, alice_max(corner.x * near, corner.x * far));
+				min_y = alice_min(min_y, alice_min(corner.y * near, corner.y * far));
+				max_y = alice_max(max_y, alice_max(corner.y * near, corner.y * far));
+			}
+
+			const float min_z = -far;
+			const float max_z = -near;
+
+#ifdef ALICE_SIMD_SSE
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 box_min_x = _mm_set1_ps(min_x), box_max_x = _mm_set1_ps(max_x);
+			const __m128 box_min_y = _mm_set1_ps(min_y), box_max_y = _mm_set1_ps(max_y);
+			const __m128 box_min_z = _mm_set1_ps(min_z), box_max_z = _mm_set1_ps(max_z);
+
+			for (u32 i = 0; i < slice->candidate_count; i += 4) {
+				const __m128 cx = _mm_loadu_ps(slice->x + i);
+				const __m128 cy = _mm_loadu_ps(slice->y + i);
+				const __m128 cz = _mm_loadu_ps(slice->z + i);
+				const __m128 r = _mm_loadu_ps(slice->radius + i);
+
+				/* Distance from each centre to the box. */
+				const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(box_min_x, cx), _mm_sub_ps(cx, box_max_x)), zero);
+				const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(box_min_y, cy), _mm_sub_ps(cy, box_max_y)), zero);
+				const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(box_min_z, cz), _mm_sub_ps(cz, box_max_z)), zero);
+
+				const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+				i32 mask = _mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(r, r)));
+
+				for (u32 j = 0; mask; j++, mask >>= 1) {
+					if (mask & 1) {
+						alice_push_slice_index(slice, slice->lights[i + j]);
+					}
+				}
+			}
+#else
+			for (u32 i = 0; i < candidate_count; i++) {
+				const float dx = alice_max(alice_max(min_x - slice->x[i], slice->x[i] - max_x), 0.0f);
+				const float dy = alice_max(alice_max(min_y - slice->y[i], slice->y[i] - max_y), 0.0f);
+				const float dz = alice_max(alice_max(min_z - slice->z[i], slice->z[i] - max_z), 0.0f);
+
+				if (dx * dx + dy * dy + dz * dz <= slice->radius[i] * slice->radius[i]) {
+					alice_push_slice_index(slice, slice->lights[i]);
+				}
+			}
+#endif
+
+			cluster->count = slice->index_count - cluster->offset;
+		}
+	}
+}
+
+void alice_end_light_clusters(alice_light_clusters_t* clusters) {
+	assert(clusters);
+
+	alice_run_jobs(alice_cluster_slice_job, clusters, ALICE_LIGHT_CLUSTER_Z);
+
+	u32 total = 0;
+	for (u32 i = 0; i < ALICE_LIGHT_CLUSTER_Z; i++) {
+		total += clusters->slices[i].index_count;
+	}
+
+	if (total > clusters->index_capacity) {
+		while (clusters->index_capacity < total) {
+			clusters->index_capacity = alice_grow_capacity(clusters->index_capacity);
+		}
+
+		clusters->indices = realloc(clusters->indices, clusters->index_capacity * sizeof(u32));
+	}
+
+	/* Each slice's offsets are relative to its own list until the lists
+	 * are joined. */
+	clusters->index_count = 0;
+	for (u32 z = 0; z < ALICE_LIGHT_CLUSTER_Z; z++) {
+		alice_light_cluster_slice_t* slice = &clusters->slices[z];
+
+		if (slice->index_count > 0) {
+			memcpy(clusters->indices + clusters->index_count, slice->indices, slice->index_count * sizeof(u32));
+		}
+
+		alice_light_cluster_t* slice_clusters = &clusters->clusters[z * ALICE_LIGHT_CLUSTER_X * ALICE_LIGHT_CLUSTER_Y];
+		for (u32 i = 0; i < ALICE_LIGHT_CLUSTER_X * ALICE_LIGHT_CLUSTER_Y; i++) {
+			slice_clusters[i].offset += clusters->index_count;
+		}
+
+		clusters->index_count += slice->index_count;
+	}
+}
+
+u32 alice_get_light_cluster_index(const alice_light_clusters_t* clusters,
+		float x, float y, float width, float height, float view_depth) {
+	assert(clusters);
+
+	const i32 tile_x = (i32)(x / width * (float)ALICE_LIGHT_CLUSTER_X);
+	const i32 tile_y = (i32)(y / height * (float)ALICE_LIGHT_CLUSTER_Y);
+
+	i32 slice = 0;
+	if (view_depth > clusters->near) {
+		slice = (i32)(logf(view_depth / clusters->near) / logf(clusters->far / clusters->near) *
+				(float)ALICE_LIGHT_CLUSTER_Z);
+	}
+
+	const u32 cx = (u32)alice_min(alice_max(tile_x, 0), ALICE_LIGHT_CLUSTER_X - 1);
+	const u32 cy = (u32)alice_min(alice_max(tile_y, 0), ALICE_LIGHT_CLUSTER_Y - 1);
+	const u32 cz = (u32)alice_min(alice_max(slice, 0), ALICE_LIGHT_CLUSTER_Z - 1);
+
+	return (cz * ALICE_LIGHT_CLUSTER_Y + cy) * ALICE_LIGHT_CLUSTER_X + cx;
+}
@@ -426,6 +426,7 @@ alice_m4f_t alice_m4f_persp(float fov, float aspect, float near, float far) {
 	result.elements[2][2] = b;
 	result.elements[2][3] = -1.0;
 	result.elements[3][2] = c;
+	result.elements[3][3] = 0.0f;
 
 	return result;
 }
@@ -0,0 +1,530 @@
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alice/meshsimplify.h"
+
+#define ALICE_SIMPLIFY_EMPTY ((u32)-1)
+
+/* The plane equations of the triangles around a vertex, summed as the
+ * symmetric 4x4 matrix they make, and the area they were weighted by. */
+typedef struct alice_quadric_t {
+	double a2, ab, ac, ad;
+	double b2, bc, bd;
+	double c2, cd;
+	double d2;
+
+	double weight;
+} alice_quadric_t;
+
+/* Moving class `from' onto class `to'. */
+typedef struct alice_collapse_t {
+	u32 from;
+	u32 to;
+	float cost;
+} alice_collapse_t;
+
+static void alice_quadric_add_plane(alice_quadric_t* q, alice_v3f_t n, float d, double weight) {
+	const double a = n.x, b = n.y, c = n.z;
+
+	q->a2 += weight * a * a;
+	q->ab += weight * a * b;
+	q->ac += weight * a * c;
+	q->ad += weight * a * d;
+	q->b2 += weight * b * b;
+	q->bc += weight * b * c;
+	q->bd += weight * b * d;
+	q->c2 += weight * c * c;
+	q->cd += weight * c * d;
+	q->d2 += weight * d * d;
+
+	q->weight += weight;
+}
+
+static void alice_quadric_add(alice_quadric_t* q, const alice_quadric_t* other) {
+	q->a2 += other->a2;
+	q->ab += other->ab;
+	q->ac += other->ac;
+	q->ad += other->ad;
+	q->b2 += other->b2;
+	q->bc += other->bc;
+	q->bd += other->bd;
+	q->c2 += other->c2;
+	q->cd += other->cd;
+	q->d2 += other->d2;
+
+	q->weight += other->weight;
+}
+
+/* The mean squared distance from `p' to the quadric's planes. */
+static double alice_quadric_error(const alice_quadric_t* q, alice_v3f_t p) {
+	if (q->weight <= 0.0) { return 0.0; }
+
+	const double x = p.x, y = p.y, z = p.z;
+
+	const double error =
+		q->a2 * x * x + 2.0 * q->ab * x * y + 2.0 * q->ac * x * z + 2.0 * q->ad * x +
+		q->b2 * y * y + 2.0 * q->bc * y * z + 2.0 * q->bd * y +
+		q->c2 * z * z + 2.0 * q->cd * z +
+		q->d2;
+
+	return error > 0.0 ? error / q->weight : 0.0;
+}
+
+static u32 alice_table_size(u32 count) {
+	u32 size = 16;
+	while (size < count * 2) {
+		size *= 2;
+	}
+
+	return size;
+}
+
+static u32 alice_hash_position(alice_v3f_t p) {
+	/* Adding zero turns -0 into 0, so that the two weld. */
+	const float xyz[3] = { p.x + 0.0f, p.y + 0.0f, p.z + 0.0f };
+
+	u32 bits[3];
+	memcpy(bits, xyz, sizeof(bits));
+
+	return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+}
+
+static bool alice_positions_equal(alice_v3f_t a, alice_v3f_t b) {
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+/* Gives every vertex the index of the first vertex at its position, and
+ * returns how many distinct positions there are. */
+static u32 alice_weld_positions(const alice_v3f_t* positions, u32 count, u32* classes, u32* class_vertices) {
+	const u32 size = alice_table_size(count);
+	u32* table = malloc(size * sizeof(u32));
+	memset(table, 0xff, size * sizeof(u32));
+
+	u32 class_count = 0;
+
+	for (u32 i = 0; i < count; i++) {
+		u32 slot = alice_hash_position(positions[i]) & (size - 1);
+
+		while (true) {
+			const u32 other = table[slot];
+
+			if (other == ALICE_SIMPLIFY_EMPTY) {
+				table[slot] = i;
+				classes[i] = class_count;
+				class_vertices[class_count++] = i;
+				break;
+			}
+
+			if (alice_positions_equal(positions[other], positions[i])) {
+				classes[i] = classes[other];
+				break;
+			}
+
+			slot = (slot + 1) & (size - 1);
+		}
+	}
+
+	free(table);
+
+	return class_count;
+}
+
+/* Marks both ends of every edge that isn't shared by exactly two
+ * triangles, which are the open borders and the non-manifold edges. */
+static void alice_find_borders(const u32* triangles, u32 triangle_count, bool* border) {
+	const u32 size = alice_table_size(triangle_count * 3);
+
+	u64* keys = malloc(size * sizeof(u64));
+	u32* counts = malloc(size * sizeof(u32));
+	memset(keys, 0xff, size * sizeof(u64));
+
+	for (u32 i = 0; i < triangle_count * 3; i++) {
+		const u32 a = triangles[i];
+		const u32 b = triangles[i % 3 == 2 ? i - 2 : i + 1];
+
+		const u64 key = a < b ? ((u64)a << 32) | b : ((u64)b << 32) | a;
+
+		u32 slot = (u32)((key * 0x9e3779b97f4a7c15ull) >> 32) & (size - 1);
+		while (keys[slot] != key && keys[slot] != (u64)-1) {
+			slot = (slot + 1) & (size - 1);
+		}
+
+		if (keys[slot] == key) {
+			counts[slot]++;
+		} else {
+			keys[slot] = key;
+			counts[slot] = 1;
+		}
+	}
+
+	for (u32 i = 0; i < size; i++) {
+		if (keys[i] != (u64)-1 && counts[i] != 2) {
+			border[keys[i] >> 32] = true;
+			border[keys[i] & 0xffffffff] = true;
+		}
+	}
+
+	free(keys);
+	free(counts);
+}
+
+static alice_v3f_t alice_triangle_normal(alice_v3f_t a, alice_v3f_t b, alice_v3f_t c) {
+	return alice_v3f_cross(
+		(alice_v3f_t) { b.x - a.x, b.y - a.y, b.z - a.z },
+		(alice_v3f_t) { c.x - a.x, c.y - a.y, c.z - a.z });
+}
+
+static int alice_compare_collapses(const void* a, const void* b) {
+	const float x = ((const alice_collapse_t*)a)->cost;
+	const float y = ((const alice_collapse_t*)b)->cost;
+
+	return (x > y) - (x < y);
+}
+
+typedef struct alice_simplifier_t {
+	const alice_v3f_t* class_positions;
+
+	u32* triangles;
+	u32 triangle_count;
+
+	u32* remap;
+
+	u32* adjacency_offsets;
+	u32* adjacency;
+} alice_simplifier_t;
+
+/* Checks that none of the triangles around `from' would flip or collapse
+ * to nothing, and counts the ones that would go away because they have
+ * `to' as well. */
+static bool alice_collapse_is_valid(const alice_simplifier_t* s, u32 from, u32 to, u32* removed) {
+	const alice_v3f_t* positions = s->class_positions;
+
+	*removed = 0;
+
+	for (u32 i = s->adjacency_offsets[from]; i < s->adjacency_offsets[from + 1]; i++) {
+		const u32* triangle = &s->triangles[s->adjacency[i] * 3];
+
+		const u32 a = s->remap[triangle[0]];
+		const u32 b = s->remap[triangle[1]];
+		const u32 c = s->remap[triangle[2]];
+
+		/* Already collapsed by an earlier edge of this pass. */
+		if (a == b || b == c || c == a) {
+			continue;
+		}
+
+		if (a == to || b == to || c == to) {
+			(*removed)++;
+			continue;
+		}
+
+		const alice_v3f_t pa = positions[a];
+		const alice_v3f_t pb = positions[b];
+		const alice_v3f_t pc = positions[c];
+
+		const alice_v3f_t before = alice_triangle_normal(pa, pb, pc);
+		const alice_v3f_t after = alice_triangle_normal(
+			a == from ? positions[to] : pa,
+			b == from ? positions[to] : pb,
+			c == from ? positions[to] : pc);
+
+		const float facing = alice_v3f_dot(before, after);
+		const float lengths = sqrtf(alice_v3f_dot(before, before) * alice_v3f_dot(after, after));
+
+		if (facing <= ALICE_SIMPLIFY_MIN_FACING * lengths) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Groups the indices below `count' by their keys, so that those with key k
+ * end up in values[offsets[k]] up to values[offsets[k + 1]]. Each index is
+ * divided by `divisor' on the way in. */
+static void alice_group_by_key(const u32* keys, u32 count, u32 key_count, u32 divisor,
+		u32* offsets, u32* values) {
+	memset(offsets, 0, (key_count + 1) * sizeof(u32));
+
+	for (u32 i = 0; i < count; i++) {
+		offsets[keys[i] + 1]++;
+	}
+
+	for (u32 i = 0; i < key_count; i++) {
+		offsets[i + 1] += offsets[i];
+	}
+
+	for (u32 i = 0; i < count; i++) {
+		values[offsets[keys[i]]++] = i / divisor;
+	}
+
+	/* Each offset has been moved on to the end of its run, which is the
+	 * start of the next one. */
+	for (u32 i = key_count; i > 0; i--) {
+		offsets[i] = offsets[i - 1];
+	}
+
+	offsets[0] = 0;
+}
+
+/* The vertex at class `c' whose normal is closest to vertex `v's. */
+static u32 alice_pick_wedge(const alice_v3f_t* normals, const u32* class_offsets, const u32* class_members,
+		u32 c, u32 v) {
+	u32 best = class_members[class_offsets[c]];
+	if (!normals) {
+		return best;
+	}
+
+	float best_facing = -FLT_MAX;
+
+	for (u32 i = class_offsets[c]; i < class_offsets[c + 1]; i++) {
+		const float facing = alice_v3f_dot(normals[class_members[i]], normals[v]);
+
+		if (facing > best_facing) {
+			best_facing = facing;
+			best = class_members[i];
+		}
+	}
+
+	return best;
+}
+
+u32 alice_simplify_mesh(u32* out, const alice_v3f_t* positions, const alice_v3f_t* normals,
+		u32 position_count, const u32* indices, u32 index_count, u32 target_index_count,
+		float max_error, float* result_error) {
+	assert(out);
+	assert(positions);
+	assert(indices);
+	assert(index_count % 3 == 0);
+
+	if (result_error) {
+		*result_error = 0.0f;
+	}
+
+	if (index_count <= target_index_count || position_count == 0) {
+		memmove(out, indices, index_count * sizeof(u32));
+		return index_count;
+	}
+
+	u32* vertex_classes = malloc(position_count * sizeof(u32));
+	u32* class_vertices = malloc(position_count * sizeof(u32));
+
+	const u32 class_count = alice_weld_positions(positions, position_count, vertex_classes, class_vertices);
+
+	alice_v3f_t* class_positions = malloc(class_count * sizeof(alice_v3f_t));
+	for (u32 i = 0; i < class_count; i++) {
+		class_positions[i] = positions[class_vertices[i]];
+	}
+
+	/* The vertices at each position, for picking which one a moved
+	 * corner should use. */
+	u32* class_offsets = malloc((class_count + 1) * sizeof(u32));
+	u32* class_members = malloc(position_count * sizeof(u32));
+	alice_group_by_key(vertex_classes, position_count, class_count, 1, class_offsets, class_members);
+
+	/* Triangles by position, dropping any that are degenerate to begin
+	 * with, alongside the vertices their corners started out as. */
+	u32* triangles = malloc(index_count * sizeof(u32));
+	u32* corners = malloc(index_count * sizeof(u32));
+	u32 triangle_count = 0;
+
+	for (u32 i = 0; i < index_count; i += 3) {
+		const u32 a = vertex_classes[indices[i + 0]];
+		const u32 b = vertex_classes[indices[i + 1]];
+		const u32 c = vertex_classes[indices[i + 2]];
+
+		if (a == b || b == c || c == a) {
+			continue;
+		}
+
+		triangles[triangle_count * 3 + 0] = a;
+		triangles[triangle_count * 3 + 1] = b;
+		triangles[triangle_count * 3 + 2] = c;
+		memcpy(&corners[triangle_count * 3], &indices[i], 3 * sizeof(u32));
+		triangle_count++;
+	}
+
+	alice_quadric_t* quadrics = calloc(class_count, sizeof(alice_quadric_t));
+
+	for (u32 i = 0; i < triangle_count; i++) {
+		const u32* triangle = &triangles[i * 3];
+
+		const alice_v3f_t p = class_positions[triangle[0]];
+
+		alice_v3f_t n = alice_triangle_normal(p, class_positions[triangle[1]], class_positions[triangle[2]]);
+
+		const float length = sqrtf(alice_v3f_dot(n, n));
+		if (length <= 0.0f) {
+			continue;
+		}
+
+		n = (alice_v3f_t) { n.x / length, n.y / length, n.z / length };
+
+		const float d = -alice_v3f_dot(n, p);
+
+		for (u32 j = 0; j < 3; j++) {
+			alice_quadric_add_plane(&quadrics[triangle[j]], n, d, length * 0.5);
+		}
+	}
+
+	bool* border = calloc(class_count, sizeof(bool));
+	alice_find_borders(triangles, triangle_count, border);
+
+	alice_simplifier_t s = {
+		.class_positions = class_positions,
+		.triangles = triangles,
+		.triangle_count = triangle_count,
+		.remap = malloc(class_count * sizeof(u32)),
+		.adjacency_offsets = malloc((class_count + 1) * sizeof(u32)),
+		.adjacency = malloc(index_count * sizeof(u32))
+	};
+
+	for (u32 i = 0; i < class_count; i++) {
+		s.remap[i] = i;
+	}
+
+	bool* locked = malloc(class_count * sizeof(bool));
+	alice_collapse_t* collapses = malloc(index_count * sizeof(alice_collapse_t));
+
+	const double max_cost = (double)max_error * (double)max_error;
+	double worst_cost = 0.0;
+
+	/* Each pass collapses the cheapest edges that don't touch each other,
+	 * then rebuilds the triangles and starts again with fresh costs. */
+	while (s.triangle_count * 3 > target_index_count) {
+		alice_group_by_key(s.triangles, s.triangle_count * 3, class_count, 3,
+				s.adjacency_offsets, s.adjacency);
+
+		u32 collapse_count = 0;
+
+		for (u32 i = 0; i < s.triangle_count * 3; i++) {
+			const u32 a = s.triangles[i];
+			const u32 b = s.triangles[i % 3 == 2 ? i - 2 : i + 1];
+
+			/* Interior edges come up once each way, and border edges
+			 * can't be collapsed at all. */
+			if (a > b || (border[a] && border[b])) {
+				continue;
+			}
+
+			alice_quadric_t q = quadrics[a];
+			alice_quadric_add(&q, &quadrics[b]);
+
+			const double a_to_b = border[a] ? DBL_MAX : alice_quadric_error(&q, class_positions[b]);
+			const double b_to_a = border[b] ? DBL_MAX : alice_quadric_error(&q, class_positions[a]);
+
+			const bool forward = a_to_b <= b_to_a;
+			const double cost = forward ? a_to_b : b_to_a;
+
+			if (cost > max_cost) {
+				continue;
+			}
+
+			collapses[collapse_count++] = (alice_collapse_t) {
+				.from = forward ? a : b,
+				.to = forward ? b : a,
+				.cost = (float)cost
+			};
+		}
+
+		qsort(collapses, collapse_count, sizeof(alice_collapse_t), alice_compare_collapses);
+
+		memset(locked, 0, class_count * sizeof(bool));
+
+		u32 remaining = s.triangle_count;
+		u32 collapsed = 0;
+
+		for (u32 i = 0; i < collapse_count && remaining * 3 > target_index_count; i++) {
+			const alice_collapse_t* collapse = &collapses[i];
+
+			if (locked[collapse->from] || locked[collapse->to]) {
+				continue;
+			}
+
+			u32 removed;
+			if (!alice_collapse_is_valid(&s, collapse->from, collapse->to, &removed)) {
+				continue;
+			}
+
+			s.remap[collapse->from] = collapse->to;
+			alice_quadric_add(&quadrics[collapse->to], &quadrics[collapse->from]);
+
+			/* The triangles around both ends have changed, so neither
+			 * can be collapsed again until the costs are redone. */
+			locked[collapse->from] = true;
+			locked[collapse->to] = true;
+
+			remaining -= removed;
+			worst_cost = alice_max(worst_cost, (double)collapse->cost);
+			collapsed++;
+		}
+
+		if (collapsed == 0) {
+			break;
+		}
+
+		/* Classes only ever move onto ones that were locked in place, so
+		 * following the map once is enough within a pass, but earlier
+		 * passes leave chains behind. */
+		for (u32 i = 0; i < class_count; i++) {
+			u32 c = s.remap[i];
+			while (s.remap[c] != c) {
+				c = s.remap[c];
+			}
+
+			s.remap[i] = c;
+		}
+
+		u32 kept = 0;
+		for (u32 i = 0; i < s.triangle_count; i++) {
+			const u32 a = s.remap[s.triangles[i * 3 + 0]];
+			const u32 b = s.remap[s.triangles[i * 3 + 1]];
+			const u32 c = s.remap[s.triangles[i * 3 + 2]];
+
+			if (a == b || b == c || c == a) {
+				continue;
+			}
+
+			s.triangles[kept * 3 + 0] = a;
+			s.triangles[kept * 3 + 1] = b;
+			s.triangles[kept * 3 + 2] = c;
+			memmove(&corners[kept * 3], &corners[i * 3], 3 * sizeof(u32));
+			kept++;
+		}
+
+		s.triangle_count = kept;
+	}
+
+	for (u32 i = 0; i < s.triangle_count * 3; i++) {
+		const u32 c = s.triangles[i];
+		const u32 v = corners[i];
+
+		out[i] = vertex_classes[v] == c ? v : alice_pick_wedge(normals, class_offsets, class_members, c, v);
+	}
+
+	if (result_error) {
+		*result_error = (float)sqrt(worst_cost);
+	}
+
+	const u32 result_count = s.triangle_count * 3;
+
+	free(collapses);
+	free(locked);
+	free(s.adjacency);
+	free(s.adjacency_offsets);
+	free(s.remap);
+	free(border);
+	free(quadrics);
+	free(corners);
+	free(triangles);
+	free(class_members);
+	free(class_offsets);
+	free(class_positions);
+	free(class_vertices);
+	free(vertex_classes);
+
+	return result_count;
+}
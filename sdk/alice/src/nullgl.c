@@ -0,0 +1,714 @@
+#include <glad/glad.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alice/nullgl.h"
+
+typedef struct alice_null_gl_buffer_t {
+	u8* data;
+	u64 size;
+} alice_null_gl_buffer_t;
+
+enum {
+	ALICE_NULL_GL_ARRAY_BUFFER,
+	ALICE_NULL_GL_ELEMENT_ARRAY_BUFFER,
+	ALICE_NULL_GL_COPY_READ_BUFFER,
+	ALICE_NULL_GL_COPY_WRITE_BUFFER,
+	ALICE_NULL_GL_UNIFORM_BUFFER,
+	ALICE_NULL_GL_SHADER_STORAGE_BUFFER,
+	ALICE_NULL_GL_DRAW_INDIRECT_BUFFER,
+	ALICE_NULL_GL_OTHER_BUFFER,
+	ALICE_NULL_GL_BUFFER_TARGET_COUNT
+};
+
+typedef struct alice_null_gl_t {
+	alice_null_gl_stats_t stats;
+
+	u32 next_name;
+
+	/* Indexed by buffer name. */
+	alice_null_gl_buffer_t* buffers;
+	u32 buffer_capacity;
+
+	u32 bound_buffers[ALICE_NULL_GL_BUFFER_TARGET_COUNT];
+} alice_null_gl_t;
+
+static alice_null_gl_t null_gl;
+
+static u32 alice_null_gl_buffer_target(GLenum target) {
+	switch (target) {
+		case GL_ARRAY_BUFFER:          return ALICE_NULL_GL_ARRAY_BUFFER;
+		case GL_ELEMENT_ARRAY_BUFFER:  return ALICE_NULL_GL_ELEMENT_ARRAY_BUFFER;
+		case GL_COPY_READ_BUFFER:      return ALICE_NULL_GL_COPY_READ_BUFFER;
+		case GL_COPY_WRITE_BUFFER:     return ALICE_NULL_GL_COPY_WRITE_BUFFER;
+		case GL_UNIFORM_BUFFER:        return ALICE_NULL_GL_UNIFORM_BUFFER;
+		case GL_SHADER_STORAGE_BUFFER: return ALICE_NULL_GL_SHADER_STORAGE_BUFFER;
+		case GL_DRAW_INDIRECT_BUFFER:  return ALICE_NULL_GL_DRAW_INDIRECT_BUFFER;
+		default:                       return ALICE_NULL_GL_OTHER_BUFFER;
+	}
+}
+
+static alice_null_gl_buffer_t* alice_null_gl_bound_buffer(GLenum target) {
+	const u32 name = null_gl.bound_buffers[alice_null_gl_buffer_target(target)];
+
+	if (name == 0 || name >= null_gl.buffer_capacity) {
+		return alice_null;
+	}
+
+	return &null_gl.buffers[name];
+}
+
+static void alice_null_gl_gen_names(GLsizei n, GLuint* names) {
+	for (GLsizei i = 0; i < n; i++) {
+		names[i] = null_gl.next_name++;
+	}
+}
+
+/* ==== Buffers ==== */
+
+static void APIENTRY alice_null_gl_gen_buffers(GLsizei n, GLuint* buffers) {
+	null_gl.stats.buffer_calls++;
+
+	alice_null_gl_gen_names(n, buffers);
+
+	for (GLsizei i = 0; i < n; i++) {
+		if (buffers[i] >= null_gl.buffer_capacity) {
+			const u32 old_capacity = null_gl.buffer_capacity;
+
+			while (buffers[i] >= null_gl.buffer_capacity) {
+				null_gl.buffer_capacity = alice_grow_capacity(null_gl.buffer_capacity);
+			}
+
+			null_gl.buffers = realloc(null_gl.buffers,
+					null_gl.buffer_capacity * sizeof(alice_null_gl_buffer_t));
+			memset(null_gl.buffers + old_capacity, 0,
+					(null_gl.buffer_capacity - old_capacity) * sizeof(alice_null_gl_buffer_t));
+		}
+	}
+}
+
+static void APIENTRY alice_null_gl_delete_buffers(GLsizei n, const GLuint* buffers) {
+	null_gl.stats.buffer_calls++;
+
+	for (GLsizei i = 0; i < n; i++) {
+		if (buffers[i] == 0 || buffers[i] >= null_gl.buffer_capacity) { continue; }
+
+		free(null_gl.buffers[buffers[i]].data);
+		null_gl.buffers[buffers[i]] = (alice_null_gl_buffer_t) { 0 };
+
+		for (u32 j = 0; j < ALICE_NULL_GL_BUFFER_TARGET_COUNT; j++) {
+			if (null_gl.bound_buffers[j] == buffers[i]) {
+				null_gl.bound_buffers[j] = 0;
+			}
+		}
+	}
+}
+
+static void APIENTRY alice_null_gl_bind_buffer(GLenum target, GLuint buffer) {
+	null_gl.stats.buffer_calls++;
+
+	null_gl.bound_buffers[alice_null_gl_buffer_target(target)] = buffer;
+}
+
+static void APIENTRY alice_null_gl_bind_buffer_base(GLenum target, GLuint index, GLuint buffer) {
+	null_gl.stats.buffer_calls++;
+
+	null_gl.bound_buffers[alice_null_gl_buffer_target(target)] = buffer;
+}
+
+static void APIENTRY alice_null_gl_buffer_data(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+	null_gl.stats.buffer_calls++;
+
+	alice_null_gl_buffer_t* buffer = alice_null_gl_bound_buffer(target);
+	if (!buffer) { return; }
+
+	buffer->data = realloc(buffer->data, size > 0 ? (u64)size : 1);
+	buffer->size = (u64)size;
+
+	if (data) {
+		memcpy(buffer->data, data, size);
+		null_gl.stats.uploaded_bytes += (u64)size;
+	} else {
+		memset(buffer->data, 0, size);
+	}
+}
+
+static void APIENTRY alice_null_gl_buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size,
+		const void* data) {
+	null_gl.stats.buffer_calls++;
+	null_gl.stats.uploaded_bytes += (u64)size;
+
+	alice_null_gl_buffer_t* buffer = alice_null_gl_bound_buffer(target);
+	if (!buffer || (u64)(offset + size) > buffer->size) { return; }
+
+	memcpy(buffer->data + offset, data, size);
+}
+
+static void APIENTRY alice_null_gl_get_buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size,
+		void* data) {
+	null_gl.stats.buffer_calls++;
+
+	alice_null_gl_buffer_t* buffer = alice_null_gl_bound_buffer(target);
+	if (!buffer || (u64)(offset + size) > buffer->size) {
+		memset(data, 0, size);
+		return;
+	}
+
+	memcpy(data, buffer->data + offset, size);
+}
+
+static void APIENTRY alice_null_gl_copy_buffer_sub_data(GLenum read_target, GLenum write_target,
+		GLintptr read_offset, GLintptr write_offset, GLsizeiptr size) {
+	null_gl.stats.buffer_calls++;
+
+	alice_null_gl_buffer_t* read = alice_null_gl_bound_buffer(read_target);
+	alice_null_gl_buffer_t* write = alice_null_gl_bound_buffer(write_target);
+
+	if (!read || !write ||
+			(u64)(read_offset + size) > read->size ||
+			(u64)(write_offset + size) > write->size) {
+		return;
+	}
+
+	memmove(write->data + write_offset, read->data + read_offset, size);
+}
+
+/* ==== Vertex arrays ==== */
+
+static void APIENTRY alice_null_gl_gen_vertex_arrays(GLsizei n, GLuint* arrays) {
+	null_gl.stats.buffer_calls++;
+	alice_null_gl_gen_names(n, arrays);
+}
+
+static void APIENTRY alice_null_gl_delete_vertex_arrays(GLsizei n, const GLuint* arrays) {
+	null_gl.stats.buffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_bind_vertex_array(GLuint array) {
+	null_gl.stats.buffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_enable_vertex_attrib_array(GLuint index) {
+	null_gl.stats.buffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_vertex_attrib_pointer(GLuint index, GLint size, GLenum type,
+		GLboolean normalized, GLsizei stride, const void* pointer) {
+	null_gl.stats.buffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_vertex_attrib_i_pointer(GLuint index, GLint size, GLenum type,
+		GLsizei stride, const void* pointer) {
+	null_gl.stats.buffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_vertex_attrib_divisor(GLuint index, GLuint divisor) {
+	null_gl.stats.buffer_calls++;
+}
+
+/* ==== Textures ==== */
+
+static u64 alice_null_gl_pixel_size(GLenum format, GLenum type) {
+	u64 channels = 4;
+	switch (format) {
+		case GL_RED:
+		case GL_DEPTH_COMPONENT:
+		case GL_DEPTH_STENCIL:
+			channels = 1; break;
+		case GL_RG:  channels = 2; break;
+		case GL_RGB: channels = 3; break;
+	}
+
+	switch (type) {
+		case GL_UNSIGNED_BYTE: return channels;
+		case GL_HALF_FLOAT:    return channels * 2;
+		default:               return channels * 4;
+	}
+}
+
+static void APIENTRY alice_null_gl_gen_textures(GLsizei n, GLuint* textures) {
+	null_gl.stats.texture_calls++;
+	alice_null_gl_gen_names(n, textures);
+}
+
+static void APIENTRY alice_null_gl_delete_textures(GLsizei n, const GLuint* textures) {
+	null_gl.stats.texture_calls++;
+}
+
+static void APIENTRY alice_null_gl_active_texture(GLenum texture) {
+	null_gl.stats.texture_calls++;
+}
+
+static void APIENTRY alice_null_gl_bind_texture(GLenum target, GLuint texture) {
+	null_gl.stats.texture_calls++;
+}
+
+static void APIENTRY alice_null_gl_tex_image_2d(GLenum target, GLint level, GLint internal_format,
+		GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels) {
+	null_gl.stats.texture_calls++;
+
+	if (pixels) {
+		null_gl.stats.uploaded_bytes += (u64)width * (u64)height * alice_null_gl_pixel_size(format, type);
+	}
+}
+
+static void APIENTRY alice_null_gl_tex_image_3d(GLenum target, GLint level, GLint internal_format,
+		GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type,
+		const void* pixels) {
+	null_gl.stats.texture_calls++;
+
+	if (pixels) {
+		null_gl.stats.uploaded_bytes += (u64)width * (u64)height * (u64)depth *
+			alice_null_gl_pixel_size(format, type);
+	}
+}
+
+static void APIENTRY alice_null_gl_tex_parameter_i(GLenum target, GLenum name, GLint param) {
+	null_gl.stats.texture_calls++;
+}
+
+static void APIENTRY alice_null_gl_tex_parameter_fv(GLenum target, GLenum name, const GLfloat* params) {
+	null_gl.stats.texture_calls++;
+}
+
+/* ==== Framebuffers ==== */
+
+static void APIENTRY alice_null_gl_gen_framebuffers(GLsizei n, GLuint* framebuffers) {
+	null_gl.stats.framebuffer_calls++;
+	alice_null_gl_gen_names(n, framebuffers);
+}
+
+static void APIENTRY alice_null_gl_delete_framebuffers(GLsizei n, const GLuint* framebuffers) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_bind_framebuffer(GLenum target, GLuint framebuffer) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_gen_renderbuffers(GLsizei n, GLuint* renderbuffers) {
+	null_gl.stats.framebuffer_calls++;
+	alice_null_gl_gen_names(n, renderbuffers);
+}
+
+static void APIENTRY alice_null_gl_delete_renderbuffers(GLsizei n, const GLuint* renderbuffers) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_bind_renderbuffer(GLenum target, GLuint renderbuffer) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_renderbuffer_storage(GLenum target, GLenum internal_format,
+		GLsizei width, GLsizei height) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_framebuffer_renderbuffer(GLenum target, GLenum attachment,
+		GLenum renderbuffer_target, GLuint renderbuffer) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_framebuffer_texture_2d(GLenum target, GLenum attachment,
+		GLenum texture_target, GLuint texture, GLint level) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_framebuffer_texture_layer(GLenum target, GLenum attachment,
+		GLuint texture, GLint level, GLint layer) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_draw_buffer(GLenum buffer) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_draw_buffers(GLsizei n, const GLenum* buffers) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_read_buffer(GLenum buffer) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_blit_framebuffer(GLint src_x0, GLint src_y0, GLint src_x1, GLint src_y1,
+		GLint dst_x0, GLint dst_y0, GLint dst_x1, GLint dst_y1, GLbitfield mask, GLenum filter) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_clear(GLbitfield mask) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+static void APIENTRY alice_null_gl_clear_buffer_fv(GLenum buffer, GLint draw_buffer, const GLfloat* value) {
+	null_gl.stats.framebuffer_calls++;
+}
+
+/* ==== Shaders ==== */
+
+static GLuint APIENTRY alice_null_gl_create_shader(GLenum type) {
+	null_gl.stats.shader_calls++;
+	return null_gl.next_name++;
+}
+
+static GLuint APIENTRY alice_null_gl_create_program() {
+	null_gl.stats.shader_calls++;
+	return null_gl.next_name++;
+}
+
+static void APIENTRY alice_null_gl_delete_shader(GLuint shader) {
+	null_gl.stats.shader_calls++;
+}
+
+static void APIENTRY alice_null_gl_delete_program(GLuint program) {
+	null_gl.stats.shader_calls++;
+}
+
+static void APIENTRY alice_null_gl_shader_source(GLuint shader, GLsizei count, const GLchar* const* string,
+		const GLint* length) {
+	null_gl.stats.shader_calls++;
+}
+
+static void APIENTRY alice_null_gl_compile_shader(GLuint shader) {
+	null_gl.stats.shader_calls++;
+}
+
+static void APIENTRY alice_null_gl_attach_shader(GLuint program, GLuint shader) {
+	null_gl.stats.shader_calls++;
+}
+
+static void APIENTRY alice_null_gl_link_program(GLuint program) {
+	null_gl.stats.shader_calls++;
+}
+
+static void APIENTRY alice_null_gl_use_program(GLuint program) {
+	null_gl.stats.shader_calls++;
+}
+
+static void APIENTRY alice_null_gl_get_shader_iv(GLuint shader, GLenum name, GLint* params) {
+	null_gl.stats.shader_calls++;
+
+	*params = name == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static void APIENTRY alice_null_gl_get_program_iv(GLuint program, GLenum name, GLint* params) {
+	null_gl.stats.shader_calls++;
+
+	*params = name == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+static void APIENTRY alice_null_gl_get_program_info_log(GLuint program, GLsizei size, GLsizei* length,
+		GLchar* log) {
+	null_gl.stats.shader_calls++;
+
+	if (length) { *length = 0; }
+	if (log && size > 0) { log[0] = '\0'; }
+}
+
+static void APIENTRY alice_null_gl_program_parameter_i(GLuint program, GLenum name, GLint value) {
+	null_gl.stats.shader_calls++;
+}
+
+static void APIENTRY alice_null_gl_get_shader_info_log(GLuint shader, GLsizei size, GLsizei* length,
+		GLchar* log) {
+	null_gl.stats.shader_calls++;
+
+	if (length) { *length = 0; }
+	if (log && size > 0) { log[0] = '\0'; }
+}
+
+static void APIENTRY alice_null_gl_get_active_uniform(GLuint program, GLuint index, GLsizei size,
+		GLsizei* length, GLint* count, GLenum* type, GLchar* name) {
+	null_gl.stats.shader_calls++;
+
+	if (length) { *length = 0; }
+	if (count) { *count = 0; }
+	if (type) { *type = 0; }
+	if (name && size > 0) { name[0] = '\0'; }
+}
+
+static GLint APIENTRY alice_null_gl_get_uniform_location(GLuint program, const GLchar* name) {
+	null_gl.stats.shader_calls++;
+	return -1;
+}
+
+/* ==== Uniforms ==== */
+
+static void APIENTRY alice_null_gl_uniform_1f(GLint location, GLfloat v0) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_2f(GLint location, GLfloat v0, GLfloat v1) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_1i(GLint location, GLint v0) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_2i(GLint location, GLint v0, GLint v1) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_3i(GLint location, GLint v0, GLint v1, GLint v2) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_4i(GLint location, GLint v0, GLint v1, GLint v2, GLint v3) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_1ui(GLint location, GLuint v0) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_2ui(GLint location, GLuint v0, GLuint v1) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_3ui(GLint location, GLuint v0, GLuint v1, GLuint v2) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_4ui(GLint location, GLuint v0, GLuint v1, GLuint v2, GLuint v3) {
+	null_gl.stats.uniform_calls++;
+}
+
+static void APIENTRY alice_null_gl_uniform_matrix_4fv(GLint location, GLsizei count, GLboolean transpose,
+		const GLfloat* value) {
+	null_gl.stats.uniform_calls++;
+}
+
+/* ==== State ==== */
+
+static void APIENTRY alice_null_gl_enable(GLenum capability) {
+	null_gl.stats.state_calls++;
+}
+
+static void APIENTRY alice_null_gl_disable(GLenum capability) {
+	null_gl.stats.state_calls++;
+}
+
+static GLboolean APIENTRY alice_null_gl_is_enabled(GLenum capability) {
+	null_gl.stats.state_calls++;
+	return GL_FALSE;
+}
+
+static void APIENTRY alice_null_gl_depth_mask(GLboolean flag) {
+	null_gl.stats.state_calls++;
+}
+
+static void APIENTRY alice_null_gl_blend_func(GLenum source, GLenum destination) {
+	null_gl.stats.state_calls++;
+}
+
+static void APIENTRY alice_null_gl_cull_face(GLenum mode) {
+	null_gl.stats.state_calls++;
+}
+
+static void APIENTRY alice_null_gl_viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+	null_gl.stats.state_calls++;
+}
+
+static void APIENTRY alice_null_gl_scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+	null_gl.stats.state_calls++;
+}
+
+static void APIENTRY alice_null_gl_clear_color(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+	null_gl.stats.state_calls++;
+}
+
+static void APIENTRY alice_null_gl_debug_message_callback(GLDEBUGPROC callback, const void* user) {
+	null_gl.stats.state_calls++;
+}
+
+static void APIENTRY alice_null_gl_debug_message_control(GLenum source, GLenum type, GLenum severity,
+		GLsizei count, const GLuint* ids, GLboolean enabled) {
+	null_gl.stats.state_calls++;
+}
+
+/* ==== Queries ==== */
+
+static void APIENTRY alice_null_gl_gen_queries(GLsizei n, GLuint* queries) {
+	null_gl.stats.state_calls++;
+	alice_null_gl_gen_names(n, queries);
+}
+
+static void APIENTRY alice_null_gl_delete_queries(GLsizei n, const GLuint* queries) {
+	null_gl.stats.state_calls++;
+}
+
+static void APIENTRY alice_null_gl_begin_query(GLenum target, GLuint query) {
+	null_gl.stats.state_calls++;
+}
+
+static void APIENTRY alice_null_gl_end_query(GLenum target) {
+	null_gl.stats.state_calls++;
+}
+
+/* Results are always ready, and nothing takes any time. */
+static void APIENTRY alice_null_gl_get_query_object_iv(GLuint query, GLenum name, GLint* params) {
+	null_gl.stats.state_calls++;
+
+	*params = name == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+static void APIENTRY alice_null_gl_get_query_object_ui64v(GLuint query, GLenum name, GLuint64* params) {
+	null_gl.stats.state_calls++;
+
+	*params = 0;
+}
+
+/* ==== Draws ==== */
+
+static void APIENTRY alice_null_gl_draw_elements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+	null_gl.stats.draw_calls++;
+}
+
+static void APIENTRY alice_null_gl_draw_elements_base_vertex(GLenum mode, GLsizei count, GLenum type,
+		const void* indices, GLint base_vertex) {
+	null_gl.stats.draw_calls++;
+}
+
+static void APIENTRY alice_null_gl_draw_elements_instanced(GLenum mode, GLsizei count, GLenum type,
+		const void* indices, GLsizei instance_count) {
+	null_gl.stats.draw_calls++;
+}
+
+static void APIENTRY alice_null_gl_multi_draw_elements_indirect(GLenum mode, GLenum type,
+		const void* indirect, GLsizei draw_count, GLsizei stride) {
+	null_gl.stats.draw_calls++;
+}
+
+void alice_load_null_gl() {
+	alice_unload_null_gl();
+
+	/* Zero is never a valid object. */
+	null_gl.next_name = 1;
+
+	glad_glGenBuffers = alice_null_gl_gen_buffers;
+	glad_glDeleteBuffers = alice_null_gl_delete_buffers;
+	glad_glBindBuffer = alice_null_gl_bind_buffer;
+	glad_glBindBufferBase = alice_null_gl_bind_buffer_base;
+	glad_glBufferData = alice_null_gl_buffer_data;
+	glad_glBufferSubData = alice_null_gl_buffer_sub_data;
+	glad_glGetBufferSubData = alice_null_gl_get_buffer_sub_data;
+	glad_glCopyBufferSubData = alice_null_gl_copy_buffer_sub_data;
+
+	glad_glGenVertexArrays = alice_null_gl_gen_vertex_arrays;
+	glad_glDeleteVertexArrays = alice_null_gl_delete_vertex_arrays;
+	glad_glBindVertexArray = alice_null_gl_bind_vertex_array;
+	glad_glEnableVertexAttribArray = alice_null_gl_enable_vertex_attrib_array;
+	glad_glVertexAttribPointer = alice_null_gl_vertex_attrib_pointer;
+	glad_glVertexAttribIPointer = alice_null_gl_vertex_attrib_i_pointer;
+	glad_glVertexAttribDivisor = alice_null_gl_vertex_attrib_divisor;
+
+	glad_glGenTextures = alice_null_gl_gen_textures;
+	glad_glDeleteTextures = alice_null_gl_delete_textures;
+	glad_glActiveTexture = alice_null_gl_active_texture;
+	glad_glBindTexture = alice_null_gl_bind_texture;
+	glad_glTexImage2D = alice_null_gl_tex_image_2d;
+	glad_glTexImage3D = alice_null_gl_tex_image_3d;
+	glad_glTexParameteri = alice_null_gl_tex_parameter_i;
+	glad_glTexParameterfv = alice_null_gl_tex_parameter_fv;
+
+	glad_glGenFramebuffers = alice_null_gl_gen_framebuffers;
+	glad_glDeleteFramebuffers = alice_null_gl_delete_framebuffers;
+	glad_glBindFramebuffer = alice_null_gl_bind_framebuffer;
+	glad_glGenRenderbuffers = alice_null_gl_gen_renderbuffers;
+	glad_glDeleteRenderbuffers = alice_null_gl_delete_renderbuffers;
+	glad_glBindRenderbuffer = alice_null_gl_bind_renderbuffer;
+	glad_glRenderbufferStorage = alice_null_gl_renderbuffer_storage;
+	glad_glFramebufferRenderbuffer = alice_null_gl_framebuffer_renderbuffer;
+	glad_glFramebufferTexture2D = alice_null_gl_framebuffer_texture_2d;
+	glad_glFramebufferTextureLayer = alice_null_gl_framebuffer_texture_layer;
+	glad_glDrawBuffer = alice_null_gl_draw_buffer;
+	glad_glDrawBuffers = alice_null_gl_draw_buffers;
+	glad_glReadBuffer = alice_null_gl_read_buffer;
+	glad_glBlitFramebuffer = alice_null_gl_blit_framebuffer;
+	glad_glClear = alice_null_gl_clear;
+	glad_glClearBufferfv = alice_null_gl_clear_buffer_fv;
+
+	glad_glCreateShader = alice_null_gl_create_shader;
+	glad_glCreateProgram = alice_null_gl_create_program;
+	glad_glDeleteShader = alice_null_gl_delete_shader;
+	glad_glDeleteProgram = alice_null_gl_delete_program;
+	glad_glShaderSource = alice_null_gl_shader_source;
+	glad_glCompileShader = alice_null_gl_compile_shader;
+	glad_glAttachShader = alice_null_gl_attach_shader;
+	glad_glLinkProgram = alice_null_gl_link_program;
+	glad_glUseProgram = alice_null_gl_use_program;
+	glad_glGetShaderiv = alice_null_gl_get_shader_iv;
+	glad_glGetProgramiv = alice_null_gl_get_program_iv;
+	glad_glGetShaderInfoLog = alice_null_gl_get_shader_info_log;
+	glad_glGetProgramInfoLog = alice_null_gl_get_program_info_log;
+	glad_glProgramParameteri = alice_null_gl_program_parameter_i;
+	glad_glGetActiveUniform = alice_null_gl_get_active_uniform;
+	glad_glGetUniformLocation = alice_null_gl_get_uniform_location;
+
+	glad_glUniform1f = alice_null_gl_uniform_1f;
+	glad_glUniform2f = alice_null_gl_uniform_2f;
+	glad_glUniform3f = alice_null_gl_uniform_3f;
+	glad_glUniform4f = alice_null_gl_uniform_4f;
+	glad_glUniform1i = alice_null_gl_uniform_1i;
+	glad_glUniform2i = alice_null_gl_uniform_2i;
+	glad_glUniform3i = alice_null_gl_uniform_3i;
+	glad_glUniform4i = alice_null_gl_uniform_4i;
+	glad_glUniform1ui = alice_null_gl_uniform_1ui;
+	glad_glUniform2ui = alice_null_gl_uniform_2ui;
+	glad_glUniform3ui = alice_null_gl_uniform_3ui;
+	glad_glUniform4ui = alice_null_gl_uniform_4ui;
+	glad_glUniformMatrix4fv = alice_null_gl_uniform_matrix_4fv;
+
+	glad_glEnable = alice_null_gl_enable;
+	glad_glDisable = alice_null_gl_disable;
+	glad_glIsEnabled = alice_null_gl_is_enabled;
+	glad_glDepthMask = alice_null_gl_depth_mask;
+	glad_glBlendFunc = alice_null_gl_blend_func;
+	glad_glCullFace = alice_null_gl_cull_face;
+	glad_glViewport = alice_null_gl_viewport;
+	glad_glScissor = alice_null_gl_scissor;
+	glad_glClearColor = alice_null_gl_clear_color;
+	glad_glDebugMessageCallback = alice_null_gl_debug_message_callback;
+	glad_glDebugMessageControl = alice_null_gl_debug_message_control;
+
+	glad_glGenQueries = alice_null_gl_gen_queries;
+	glad_glDeleteQueries = alice_null_gl_delete_queries;
+	glad_glBeginQuery = alice_null_gl_begin_query;
+	glad_glEndQuery = alice_null_gl_end_query;
+	glad_glGetQueryObjectiv = alice_null_gl_get_query_object_iv;
+	glad_glGetQueryObjectui64v = alice_null_gl_get_query_object_ui64v;
+
+	glad_glDrawElements = alice_null_gl_draw_elements;
+	glad_glDrawElementsBaseVertex = alice_null_gl_draw_elements_base_vertex;
+	glad_glDrawElementsInstanced = alice_null_gl_draw_elements_instanced;
+	glad_glMultiDrawElementsIndirect = alice_null_gl_multi_draw_elements_indirect;
+}
+
+void alice_unload_null_gl() {
+	for (u32 i = 0; i < null_gl.buffer_capacity; i++) {
+		free(null_gl.buffers[i].data);
+	}
+
+	free(null_gl.buffers);
+
+	null_gl = (alice_null_gl_t) { 0 };
+}
+
+alice_null_gl_stats_t alice_get_null_gl_stats() {
+	return null_gl.stats;
+}
+
+void alice_reset_null_gl_stats() {
+	null_gl.stats = (alice_null_gl_stats_t) { 0 };
+}
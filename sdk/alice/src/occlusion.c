@@ -0,0 +1,461 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "alice/occlusion.h"
+#include "alice/jobs.h"
+
+#ifdef ALICE_SIMD_SSE
+#include <xmmintrin.h>
+#endif
+
+/* Corners with a smaller w than this are treated as crossing the near
+ * plane. */
+#define ALICE_OCCLUSION_MIN_W 1e-5f
+
+typedef struct alice_clip_vertex_t {
+	float x, y, z, w;
+} alice_clip_vertex_t;
+
+static alice_clip_vertex_t alice_occlusion_transform(alice_m4f_t m, alice_v3f_t p) {
+	return (alice_clip_vertex_t) {
+		m.elements[0][0] * p.x + m.elements[1][0] * p.y + m.elements[2][0] * p.z + m.elements[3][0],
+		m.elements[0][1] * p.x + m.elements[1][1] * p.y + m.elements[2][1] * p.z + m.elements[3][1],
+		m.elements[0][2] * p.x + m.elements[1][2] * p.y + m.elements[2][2] * p.z + m.elements[3][2],
+		m.elements[0][3] * p.x + m.elements[1][3] * p.y + m.elements[2][3] * p.z + m.elements[3][3]
+	};
+}
+
+alice_occlusion_buffer_t* alice_new_occlusion_buffer(u32 width, u32 height) {
+	assert(width > 0 && height > 0);
+	assert(width % 4 == 0);
+
+	alice_occlusion_buffer_t* new = malloc(sizeof(alice_occlusion_buffer_t));
+
+	new->width = width;
+	new->height = height;
+
+	new->view_projection = alice_m4f_identity();
+
+	new->level_count = 0;
+
+	u32 level_width = width;
+	u32 level_height = height;
+
+	while (new->level_count < ALICE_OCCLUSION_MAX_LEVELS) {
+		new->levels[new->level_count] = malloc(level_width * level_height * sizeof(float));
+		new->level_widths[new->level_count] = level_width;
+		new->level_heights[new->level_count] = level_height;
+		new->level_count++;
+
+		if (level_width == 1 && level_height == 1) {
+			break;
+		}
+
+		level_width = alice_max((level_width + 1) / 2, 1);
+		level_height = alice_max((level_height + 1) / 2, 1);
+	}
+
+	new->triangles = alice_null;
+	new->triangle_count = 0;
+	new->triangle_capacity = 0;
+
+	new->tile_count_x = (width + ALICE_OCCLUSION_TILE_WIDTH - 1) / ALICE_OCCLUSION_TILE_WIDTH;
+	new->tile_count_y = (height + ALICE_OCCLUSION_TILE_HEIGHT - 1) / ALICE_OCCLUSION_TILE_HEIGHT;
+
+	new->bins = calloc(new->tile_count_x * new->tile_count_y, sizeof(alice_occlusion_bin_t));
+
+	new->tested_count = 0;
+	new->rejected_count = 0;
+
+	return new;
+}
+
+void alice_free_occlusion_buffer(alice_occlusion_buffer_t* buffer) {
+	assert(buffer);
+
+	for (u32 i = 0; i < buffer->level_count; i++) {
+		free(buffer->levels[i]);
+	}
+
+	if (buffer->triangle_capacity > 0) {
+		free(buffer->triangles);
+	}
+
+	for (u32 i = 0; i < buffer->tile_count_x * buffer->tile_count_y; i++) {
+		if (buffer->bins[i].capacity > 0) {
+			free(buffer->bins[i].triangles);
+		}
+	}
+
+	free(buffer->bins);
+
+	free(buffer);
+}
+
+void alice_begin_occlusion_buffer(alice_occlusion_buffer_t* buffer, alice_m4f_t view_projection) {
+	assert(buffer);
+
+	buffer->view_projection = view_projection;
+
+	float* depth = buffer->levels[0];
+	for (u32 i = 0; i < buffer->width * buffer->height; i++) {
+		depth[i] = 1.0f;
+	}
+
+	buffer->triangle_count = 0;
+
+	for (u32 i = 0; i < buffer->tile_count_x * buffer->tile_count_y; i++) {
+		buffer->bins[i].count = 0;
+	}
+
+	buffer->tested_count = 0;
+	buffer->rejected_count = 0;
+}
+
+static void alice_occlusion_bin_triangle(alice_occlusion_buffer_t* buffer,
+		const alice_clip_vertex_t* a, const alice_clip_vertex_t* b, const alice_clip_vertex_t* c) {
+	const alice_clip_vertex_t* vertices[] = { a, b, c };
+
+	alice_occlusion_triangle_t triangle;
+
+	for (u32 i = 0; i < 3; i++) {
+		const alice_clip_vertex_t* v = vertices[i];
+		const float inv_w = 1.0f / v->w;
+
+		triangle.x[i] = (v->x * inv_w * 0.5f + 0.5f) * (float)buffer->width;
+		triangle.y[i] = (v->y * inv_w * 0.5f + 0.5f) * (float)buffer->height;
+		triangle.z[i] = v->z * inv_w * 0.5f + 0.5f;
+	}
+
+	const float min_x = alice_min(triangle.x[0], alice_min(triangle.x[1], triangle.x[2]));
+	const float max_x = alice_max(triangle.x[0], alice_max(triangle.x[1], triangle.x[2]));
+	const float min_y = alice_min(triangle.y[0], alice_min(triangle.y[1], triangle.y[2]));
+	const float max_y = alice_max(triangle.y[0], alice_max(triangle.y[1], triangle.y[2]));
+
+	if (max_x < 0.0f || max_y < 0.0f ||
+		min_x >= (float)buffer->width || min_y >= (float)buffer->height) {
+		return;
+	}
+
+	const float area =
+		(triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+		(triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+
+	if (area == 0.0f) {
+		return;
+	}
+
+	/* Occluders are drawn from both sides, so clockwise triangles are
+	 * flipped rather than culled. */
+	if (area < 0.0f) {
+		float temp;
+		temp = triangle.x[1]; triangle.x[1] = triangle.x[2]; triangle.x[2] = temp;
+		temp = triangle.y[1]; triangle.y[1] = triangle.y[2]; triangle.y[2] = temp;
+		temp = triangle.z[1]; triangle.z[1] = triangle.z[2]; triangle.z[2] = temp;
+	}
+
+	if (buffer->triangle_count >= buffer->triangle_capacity) {
+		buffer->triangle_capacity = alice_grow_capacity(buffer->triangle_capacity);
+		buffer->triangles = realloc(buffer->triangles,
+				buffer->triangle_capacity * sizeof(alice_occlusion_triangle_t));
+	}
+
+	const u32 index = buffer->triangle_count++;
+	buffer->triangles[index] = triangle;
+
+	const u32 tile_x0 = (u32)alice_max(min_x, 0.0f) / ALICE_OCCLUSION_TILE_WIDTH;
+	const u32 tile_y0 = (u32)alice_max(min_y, 0.0f) / ALICE_OCCLUSION_TILE_HEIGHT;
+	const u32 tile_x1 = alice_min((u32)alice_min(max_x, (float)(buffer->width - 1)) /
+			ALICE_OCCLUSION_TILE_WIDTH, buffer->tile_count_x - 1);
+	const u32 tile_y1 = alice_min((u32)alice_min(max_y, (float)(buffer->height - 1)) /
+			ALICE_OCCLUSION_TILE_HEIGHT, buffer->tile_count_y - 1);
+
+	for (u32 ty = tile_y0; ty <= tile_y1; ty++) {
+		for (u32 tx = tile_x0; tx <= tile_x1; tx++) {
+			alice_occlusion_bin_t* bin = &buffer->bins[ty * buffer->tile_count_x + tx];
+
+			if (bin->count >= bin->capacity) {
+				bin->capacity = alice_grow_capacity(bin->capacity);
+				bin->triangles = realloc(bin->triangles, bin->capacity * sizeof(u32));
+			}
+
+			bin->triangles[bin->count++] = index;
+		}
+	}
+}
+
+void alice_occlusion_add_mesh(alice_occlusion_buffer_t* buffer, alice_m4f_t transform,
+		const alice_v3f_t* positions, const u32* indices, u32 index_count) {
+	assert(buffer);
+	assert(positions);
+	assert(indices);
+
+	const alice_m4f_t m = alice_m4f_multiply(buffer->view_projection, transform);
+
+	for (u32 i = 0; i + 2 < index_count; i += 3) {
+		alice_clip_vertex_t input[3];
+		for (u32 j = 0; j < 3; j++) {
+			input[j] = alice_occlusion_transform(m, positions[indices[i + j]]);
+		}
+
+		/* Clip against the near plane, z = -w, which turns the triangle
+		 * into a polygon of at most four vertices. The other planes are
+		 * handled by clamping to the buffer when binning. */
+		alice_clip_vertex_t output[4];
+		u32 output_count = 0;
+
+		for (u32 j = 0; j < 3; j++) {
+			const alice_clip_vertex_t* current = &input[j];
+			const alice_clip_vertex_t* next = &input[(j + 1) % 3];
+
+			const float current_distance = current->z + current->w;
+			const float next_distance = next->z + next->w;
+
+			if (current_distance >= 0.0f) {
+				output[output_count++] = *current;
+			}
+
+			if ((current_distance >= 0.0f) != (next_distance >= 0.0f)) {
+				const float t = current_distance / (current_distance - next_distance);
+
+				output[output_count++] = (alice_clip_vertex_t) {
+					current->x + (next->x - current->x) * t,
+					current->y + (next->y - current->y) * t,
+					current->z + (next->z - current->z) * t,
+					current->w + (next->w - current->w) * t
+				};
+			}
+		}
+
+		for (u32 j = 0; j + 2 < output_count; j++) {
+			if (output[0].w < ALICE_OCCLUSION_MIN_W ||
+				output[j + 1].w < ALICE_OCCLUSION_MIN_W ||
+				output[j + 2].w < ALICE_OCCLUSION_MIN_W) {
+				continue;
+			}
+
+			alice_occlusion_bin_triangle(buffer, &output[0], &output[j + 1], &output[j + 2]);
+		}
+	}
+}
+
+static void alice_rasterise_occlusion_tile(void* data, u32 tile) {
+	alice_occlusion_buffer_t* buffer = data;
+
+	const u32 tile_x = tile % buffer->tile_count_x;
+	const u32 tile_y = tile / buffer->tile_count_x;
+
+	const i32 tile_x0 = (i32)(tile_x * ALICE_OCCLUSION_TILE_WIDTH);
+	const i32 tile_y0 = (i32)(tile_y * ALICE_OCCLUSION_TILE_HEIGHT);
+	const i32 tile_x1 = alice_min(tile_x0 + ALICE_OCCLUSION_TILE_WIDTH, (i32)buffer->width) - 1;
+	const i32 tile_y1 = alice_min(tile_y0 + ALICE_OCCLUSION_TILE_HEIGHT, (i32)buffer->height) - 1;
+
+	float* depth = buffer->levels[0];
+
+	const alice_occlusion_bin_t* bin = &buffer->bins[tile];
+
+	for (u32 i = 0; i < bin->count; i++) {
+		const alice_occlusion_triangle_t* t = &buffer->triangles[bin->triangles[i]];
+
+		const float min_x = alice_min(t->x[0], alice_min(t->x[1], t->x[2]));
+		const float max_x = alice_max(t->x[0], alice_max(t->x[1], t->x[2]));
+		const float min_y = alice_min(t->y[0], alice_min(t->y[1], t->y[2]));
+		const float max_y = alice_max(t->y[0], alice_max(t->y[1], t->y[2]));
+
+		/* Spans start on a multiple of four so that rows can be processed
+		 * four pixels at a time. Tiles are multiples of four wide, so the
+		 * last group never runs past the tile. */
+		const i32 x0 = alice_max((i32)floorf(alice_max(min_x, (float)tile_x0)), tile_x0) & ~3;
+		const i32 x1 = alice_min((i32)ceilf(alice_min(max_x, (float)tile_x1)), tile_x1);
+		const i32 y0 = alice_max((i32)floorf(alice_max(min_y, (float)tile_y0)), tile_y0);
+		const i32 y1 = alice_min((i32)ceilf(alice_min(max_y, (float)tile_y1)), tile_y1);
+
+		if (x0 > x1 || y0 > y1) {
+			continue;
+		}
+
+		/* Edge functions e(x, y) = a * x + b * y + c, positive inside. Edge i
+		 * is opposite vertex i, so dividing by the area gives the
+		 * barycentric weight of that vertex. */
+		float ea[3], eb[3], ec[3];
+		for (u32 e = 0; e < 3; e++) {
+			const u32 v0 = (e + 1) % 3;
+			const u32 v1 = (e + 2) % 3;
+
+			ea[e] = t->y[v0] - t->y[v1];
+			eb[e] = t->x[v1] - t->x[v0];
+			ec[e] = t->x[v0] * t->y[v1] - t->y[v0] * t->x[v1];
+		}
+
+		const float area = ec[0] + ec[1] + ec[2];
+		const float inv_area = 1.0f / area;
+
+		/* Depth is linear in screen space after the perspective divide. */
+		const float za = (ea[0] * t->z[0] + ea[1] * t->z[1] + ea[2] * t->z[2]) * inv_area;
+		const float zb = (eb[0] * t->z[0] + eb[1] * t->z[1] + eb[2] * t->z[2]) * inv_area;
+		const float zc = (ec[0] * t->z[0] + ec[1] * t->z[1] + ec[2] * t->z[2]) * inv_area;
+
+#ifdef ALICE_SIMD_SSE
+		const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+
+		const __m128 ea0 = _mm_set1_ps(ea[0]), ea1 = _mm_set1_ps(ea[1]), ea2 = _mm_set1_ps(ea[2]);
+		const __m128 za4 = _mm_set1_ps(za);
+
+		for (i32 y = y0; y <= y1; y++) {
+			const float py = (float)y + 0.5f;
+
+			const __m128 row0 = _mm_set1_ps(eb[0] * py + ec[0]);
+			const __m128 row1 = _mm_set1_ps(eb[1] * py + ec[1]);
+			const __m128 row2 = _mm_set1_ps(eb[2] * py + ec[2]);
+			const __m128 rowz = _mm_set1_ps(zb * py + zc);
+
+			float* row = depth + y * buffer->width;
+
+			for (i32 x = x0; x <= x1; x += 4) {
+				const __m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+
+				const __m128 e0 = _mm_add_ps(_mm_mul_ps(ea0, px), row0);
+				const __m128 e1 = _mm_add_ps(_mm_mul_ps(ea1, px), row1);
+				const __m128 e2 = _mm_add_ps(_mm_mul_ps(ea2, px), row2);
+
+				const __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero),
+					_mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+
+				if (_mm_movemask_ps(inside) == 0) {
+					continue;
+				}
+
+				const __m128 z = _mm_add_ps(_mm_mul_ps(za4, px), rowz);
+				const __m128 stored = _mm_loadu_ps(row + x);
+				const __m128 nearest = _mm_min_ps(stored, z);
+
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, stored)));
+			}
+		}
+#else
+		for (i32 y = y0; y <= y1; y++) {
+			const float py = (float)y + 0.5f;
+
+			float* row = depth + y * buffer->width;
+
+			for (i32 x = x0; x < x1 + 4 && x <= tile_x1; x++) {
+				const float px = (float)x + 0.5f;
+
+				const float e0 = ea[0] * px + eb[0] * py + ec[0];
+				const float e1 = ea[1] * px + eb[1] * py + ec[1];
+				const float e2 = ea[2] * px + eb[2] * py + ec[2];
+
+				if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f) {
+					continue;
+				}
+
+				const float z = za * px + zb * py + zc;
+				row[x] = alice_min(row[x], z);
+			}
+		}
+#endif
+	}
+}
+
+static void alice_build_occlusion_hierarchy(alice_occlusion_buffer_t* buffer) {
+	for (u32 level = 1; level < buffer->level_count; level++) {
+		const float* src = buffer->levels[level - 1];
+		const u32 src_width = buffer->level_widths[level - 1];
+		const u32 src_height = buffer->level_heights[level - 1];
+
+		float* dst = buffer->levels[level];
+		const u32 dst_width = buffer->level_widths[level];
+		const u32 dst_height = buffer->level_heights[level];
+
+		for (u32 y = 0; y < dst_height; y++) {
+			const u32 sy0 = alice_min(y * 2, src_height - 1);
+			const u32 sy1 = alice_min(y * 2 + 1, src_height - 1);
+
+			for (u32 x = 0; x < dst_width; x++) {
+				const u32 sx0 = alice_min(x * 2, src_width - 1);
+				const u32 sx1 = alice_min(x * 2 + 1, src_width - 1);
+
+				dst[y * dst_width + x] = alice_max(
+					alice_max(src[sy0 * src_width + sx0], src[sy0 * src_width + sx1]),
+					alice_max(src[sy1 * src_width + sx0], src[sy1 * src_width + sx1]));
+			}
+		}
+	}
+}
+
+void alice_end_occlusion_buffer(alice_occlusion_buffer_t* buffer) {
+	assert(buffer);
+
+	if (buffer->triangle_count > 0) {
+		alice_run_jobs(alice_rasterise_occlusion_tile, buffer, buffer->tile_count_x * buffer->tile_count_y);
+	}
+
+	alice_build_occlusion_hierarchy(buffer);
+}
+
+bool alice_occlusion_test_aabb(const alice_occlusion_buffer_t* buffer, alice_aabb_t aabb) {
+	assert(buffer);
+
+	float min_x = INFINITY, min_y = INFINITY, min_z = INFINITY;
+	float max_x = -INFINITY, max_y = -INFINITY;
+
+	for (u32 i = 0; i < 8; i++) {
+		const alice_v3f_t corner = {
+			(i & 1) ? aabb.max.x : aabb.min.x,
+			(i & 2) ? aabb.max.y : aabb.min.y,
+			(i & 4) ? aabb.max.z : aabb.min.z
+		};
+
+		const alice_clip_vertex_t v = alice_occlusion_transform(buffer->view_projection, corner);
+
+		if (v.w < ALICE_OCCLUSION_MIN_W) {
+			return false;
+		}
+
+		const float inv_w = 1.0f / v.w;
+
+		const float x = (v.x * inv_w * 0.5f + 0.5f) * (float)buffer->width;
+		const float y = (v.y * inv_w * 0.5f + 0.5f) * (float)buffer->height;
+		const float z = v.z * inv_w * 0.5f + 0.5f;
+
+		min_x = alice_min(min_x, x);
+		max_x = alice_max(max_x, x);
+		min_y = alice_min(min_y, y);
+		max_y = alice_max(max_y, y);
+		min_z = alice_min(min_z, z);
+	}
+
+	if (max_x < 0.0f || max_y < 0.0f ||
+		min_x >= (float)buffer->width || min_y >= (float)buffer->height || min_z > 1.0f) {
+		return false;
+	}
+
+	const u32 x0 = (u32)alice_max(min_x, 0.0f);
+	const u32 y0 = (u32)alice_max(min_y, 0.0f);
+	const u32 x1 = (u32)alice_min(max_x, (float)(buffer->width - 1));
+	const u32 y1 = (u32)alice_min(max_y, (float)(buffer->height - 1));
+
+	/* Use the level at which the box covers at most three texels across,
+	 * so that the test is a handful of reads however large the box. */
+	const u32 span = alice_max(x1 - x0, y1 - y0) + 1;
+
+	u32 level = 0;
+	while ((span >> level) > 2 && level + 1 < buffer->level_count) {
+		level++;
+	}
+
+	const float* depth = buffer->levels[level];
+	const u32 level_width = buffer->level_widths[level];
+
+	for (u32 y = y0 >> level; y <= y1 >> level; y++) {
+		for (u32 x = x0 >> level; x <= x1 >> level; x++) {
+			if (min_z <= depth[y * level_width + x]) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
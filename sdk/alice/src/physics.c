@@ -4,6 +4,11 @@
 
 #include "alice/physics.h"
 #include "alice/scripting.h"
+#include "alice/profiler.h"
+
+#ifdef ALICE_SIMD_SSE
+#include <xmmintrin.h>
+#endif
 
 static void alice_calculate_body_aabb(alice_physics_engine_t* engine, alice_rigidbody_3d_t* body, alice_aabb_t* aabb) {
 	assert(engine);
@@ -197,6 +202,200 @@ bool alice_ray_vs_aabb(alice_aabb_t a, alice_v3f_t origin, alice_v3f_t direction
 	return true;
 }
 
+bool alice_ray_vs_triangle(alice_v3f_t origin, alice_v3f_t direction,
+		alice_v3f_t a, alice_v3f_t b, alice_v3f_t c, float* t) {
+	const alice_v3f_t edge1 = { b.x - a.x, b.y - a.y, b.z - a.z };
+	const alice_v3f_t edge2 = { c.x - a.x, c.y - a.y, c.z - a.z };
+
+	const alice_v3f_t p = alice_v3f_cross(direction, edge2);
+	const float determinant = alice_v3f_dot(edge1, p);
+
+	if (fabsf(determinant) < 1e-12f) {
+		return false;
+	}
+
+	const float inv_determinant = 1.0f / determinant;
+
+	const alice_v3f_t s = { origin.x - a.x, origin.y - a.y, origin.z - a.z };
+	const float u = alice_v3f_dot(s, p) * inv_determinant;
+	if (u < 0.0f || u > 1.0f) {
+		return false;
+	}
+
+	const alice_v3f_t q = alice_v3f_cross(s, edge1);
+	const float v = alice_v3f_dot(direction, q) * inv_determinant;
+	if (v < 0.0f || u + v > 1.0f) {
+		return false;
+	}
+
+	const float distance = alice_v3f_dot(edge2, q) * inv_determinant;
+	if (distance < 0.0f) {
+		return false;
+	}
+
+	*t = distance;
+	return true;
+}
+
+alice_aabb_t alice_aabb_to_world(alice_aabb_t aabb, alice_m4f_t m) {
+	const float center[3] = {
+		(aabb.min.x + aabb.max.x) * 0.5f,
+		(aabb.min.y + aabb.max.y) * 0.5f,
+		(aabb.min.z + aabb.max.z) * 0.5f
+	};
+
+	const float extents[3] = {
+		(aabb.max.x - aabb.min.x) * 0.5f,
+		(aabb.max.y - aabb.min.y) * 0.5f,
+		(aabb.max.z - aabb.min.z) * 0.5f
+	};
+
+	float new_center[3];
+	float new_extents[3];
+
+	for (u32 row = 0; row < 3; row++) {
+		new_center[row] = m.elements[3][row];
+		new_extents[row] = 0.0f;
+
+		for (u32 col = 0; col < 3; col++) {
+			new_center[row] += m.elements[col][row] * center[col];
+			new_extents[row] += fabsf(m.elements[col][row]) * extents[col];
+		}
+	}
+
+	return (alice_aabb_t) {
+		.min = { new_center[0] - new_extents[0], new_center[1] - new_extents[1], new_center[2] - new_extents[2] },
+		.max = { new_center[0] + new_extents[0], new_center[1] + new_extents[1], new_center[2] + new_extents[2] }
+	};
+}
+
+alice_aabb_t alice_aabb_union(alice_aabb_t a, alice_aabb_t b) {
+	return (alice_aabb_t) {
+		.min = {
+			alice_min(a.min.x, b.min.x),
+			alice_min(a.min.y, b.min.y),
+			alice_min(a.min.z, b.min.z)
+		},
+		.max = {
+			alice_max(a.max.x, b.max.x),
+			alice_max(a.max.y, b.max.y),
+			alice_max(a.max.z, b.max.z)
+		}
+	};
+}
+
+alice_frustum_t alice_frustum_from_m4f(alice_m4f_t m) {
+	alice_frustum_t frustum;
+
+	/* Gribb-Hartmann: each plane is the fourth row of the matrix plus or
+	 * minus one of the other rows. */
+	for (u32 i = 0; i < 6; i++) {
+		const u32 row = i / 2;
+		const float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+
+		float a = m.elements[0][3] + sign * m.elements[0][row];
+		float b = m.elements[1][3] + sign * m.elements[1][row];
+		float c = m.elements[2][3] + sign * m.elements[2][row];
+		float d = m.elements[3][3] + sign * m.elements[3][row];
+
+		const float length = sqrtf(a * a + b * b + c * c);
+		if (length > 0.0f) {
+			a /= length;
+			b /= length;
+			c /= length;
+			d /= length;
+		}
+
+		frustum.nx[i] = a;
+		frustum.ny[i] = b;
+		frustum.nz[i] = c;
+		frustum.d[i] = d;
+	}
+
+	for (u32 i = 6; i < 8; i++) {
+		frustum.nx[i] = frustum.nx[i - 6];
+		frustum.ny[i] = frustum.ny[i - 6];
+		frustum.nz[i] = frustum.nz[i - 6];
+		frustum.d[i] = frustum.d[i - 6];
+	}
+
+	return frustum;
+}
+
+bool alice_frustum_vs_aabb(const alice_frustum_t* frustum, alice_aabb_t aabb) {
+	assert(frustum);
+
+	const float cx = (aabb.min.x + aabb.max.x) * 0.5f;
+	const float cy = (aabb.min.y + aabb.max.y) * 0.5f;
+	const float cz = (aabb.min.z + aabb.max.z) * 0.5f;
+
+	const float ex = (aabb.max.x - aabb.min.x) * 0.5f;
+	const float ey = (aabb.max.y - aabb.min.y) * 0.5f;
+	const float ez = (aabb.max.z - aabb.min.z) * 0.5f;
+
+#ifdef ALICE_SIMD_SSE
+	const __m128 center_x = _mm_set1_ps(cx);
+	const __m128 center_y = _mm_set1_ps(cy);
+	const __m128 center_z = _mm_set1_ps(cz);
+
+	const __m128 extent_x = _mm_set1_ps(ex);
+	const __m128 extent_y = _mm_set1_ps(ey);
+	const __m128 extent_z = _mm_set1_ps(ez);
+
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (u32 i = 0; i < 8; i += 4) {
+		const __m128 nx = _mm_loadu_ps(frustum->nx + i);
+		const __m128 ny = _mm_loadu_ps(frustum->ny + i);
+		const __m128 nz = _mm_loadu_ps(frustum->nz + i);
+		const __m128 d = _mm_loadu_ps(frustum->d + i);
+
+		const __m128 distance = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(nx, center_x), _mm_mul_ps(ny, center_y)),
+			_mm_add_ps(_mm_mul_ps(nz, center_z), d));
+
+		const __m128 radius = _mm_add_ps(
+			_mm_add_ps(
+				_mm_mul_ps(_mm_andnot_ps(sign_mask, nx), extent_x),
+				_mm_mul_ps(_mm_andnot_ps(sign_mask, ny), extent_y)),
+			_mm_mul_ps(_mm_andnot_ps(sign_mask, nz), extent_z));
+
+		if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero)) != 0) {
+			return false;
+		}
+	}
+#else
+	for (u32 i = 0; i < 6; i++) {
+		const float distance =
+			frustum->nx[i] * cx + frustum->ny[i] * cy + frustum->nz[i] * cz + frustum->d[i];
+		const float radius =
+			fabsf(frustum->nx[i]) * ex + fabsf(frustum->ny[i]) * ey + fabsf(frustum->nz[i]) * ez;
+
+		if (distance + radius < 0.0f) {
+			return false;
+		}
+	}
+#endif
+
+	return true;
+}
+
+u32 alice_frustum_cull_aabbs(const alice_frustum_t* frustum,
+		const alice_aabb_t* aabbs, u32 count, bool* visible) {
+	assert(frustum);
+	assert(count == 0 || (aabbs && visible));
+
+	u32 visible_count = 0;
+
+	for (u32 i = 0; i < count; i++) {
+		visible[i] = alice_frustum_vs_aabb(frustum, aabbs[i]);
+		visible_count += visible[i] ? 1 : 0;
+	}
+
+	return visible_count;
+}
+
 alice_physics_engine_t* alice_new_physics_engine(alice_scene_t* scene) {
 	alice_physics_engine_t* new = malloc(sizeof(alice_physics_engine_t));
 
@@ -417,6 +616,8 @@ static void alice_tick_physics_engine(alice_physics_engine_t* engine, double tim
 void alice_update_physics_engine(alice_physics_engine_t* engine, double timestep) {
 	assert(engine);
 
+	alice_begin_profile_scope("Physics");
+
 	const double fps = 60.0f;
 	const double dt = 1.0f / fps;
 
@@ -448,6 +649,8 @@ void alice_update_physics_engine(alice_physics_engine_t* engine, double timestep
 
 		body->old_position = body->position;
 	}
+
+	alice_end_profile_scope();
 }
 
 void alice_on_rigidbody_3d_create(alice_scene_t* scene, alice_entity_handle_t handle, void* ptr) {
@@ -0,0 +1,231 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+
+#include "alice/application.h"
+#include "alice/profiler.h"
+
+static alice_profiler_t profiler;
+
+void alice_init_profiler(bool gpu_timing) {
+	alice_deinit_profiler();
+
+	profiler.initialised = true;
+	profiler.gpu_timing = gpu_timing;
+}
+
+void alice_deinit_profiler() {
+	for (u32 i = 0; i < 2; i++) {
+		alice_profile_query_set_t* set = &profiler.query_sets[i];
+
+		if (set->capacity > 0) {
+			glDeleteQueries(set->capacity, set->queries);
+
+			free(set->queries);
+			free(set->scopes);
+		}
+	}
+
+	memset(&profiler, 0, sizeof(profiler));
+}
+
+alice_profiler_t* alice_get_profiler() {
+	return &profiler;
+}
+
+static u32 alice_find_profile_scope(const char* name, u32 parent) {
+	for (u32 i = 0; i < profiler.scope_count; i++) {
+		alice_profile_scope_t* scope = &profiler.scopes[i];
+
+		if (scope->parent == parent && (scope->name == name || strcmp(scope->name, name) == 0)) {
+			return i;
+		}
+	}
+
+	if (profiler.scope_count >= ALICE_PROFILER_MAX_SCOPES) {
+		return ALICE_PROFILER_NO_PARENT;
+	}
+
+	alice_profile_scope_t* scope = &profiler.scopes[profiler.scope_count];
+	memset(scope, 0, sizeof(alice_profile_scope_t));
+
+	scope->name = name;
+	scope->parent = parent;
+	scope->depth = parent == ALICE_PROFILER_NO_PARENT ? 0 : profiler.scopes[parent].depth + 1;
+
+	return profiler.scope_count++;
+}
+
+static void alice_begin_query(u32 scope) {
+	alice_profile_query_set_t* set = &profiler.query_sets[profiler.frame_index & 1];
+
+	if (set->count >= set->capacity) {
+		const u32 old_capacity = set->capacity;
+
+		set->capacity = alice_grow_capacity(set->capacity);
+		set->queries = realloc(set->queries, set->capacity * sizeof(u32));
+		set->scopes = realloc(set->scopes, set->capacity * sizeof(u32));
+
+		glGenQueries(set->capacity - old_capacity, set->queries + old_capacity);
+	}
+
+	set->scopes[set->count] = scope;
+	glBeginQuery(GL_TIME_ELAPSED, set->queries[set->count]);
+	set->count++;
+}
+
+static void alice_push_profile_scope(const char* name, bool gpu) {
+	assert(name);
+
+	if (!profiler.initialised) {
+		return;
+	}
+
+	if (profiler.depth >= ALICE_PROFILER_MAX_DEPTH) {
+		alice_log_warning("Profile scope `%s' is nested too deeply", name);
+		profiler.overflow_depth++;
+		return;
+	}
+
+	const u32 parent = profiler.depth > 0 ? profiler.stack[profiler.depth - 1].scope : ALICE_PROFILER_NO_PARENT;
+
+	alice_profile_marker_t* marker = &profiler.stack[profiler.depth++];
+
+	/* Scopes under one that didn't fit aren't recorded either, but keep
+	 * their place on the stack so that the ends still match. */
+	marker->scope = ALICE_PROFILER_NO_PARENT;
+	if (profiler.depth == 1 || parent != ALICE_PROFILER_NO_PARENT) {
+		marker->scope = alice_find_profile_scope(name, parent);
+	}
+
+	marker->gpu = false;
+	if (gpu && profiler.gpu_timing && !profiler.query_active && marker->scope != ALICE_PROFILER_NO_PARENT) {
+		alice_begin_query(marker->scope);
+
+		profiler.scopes[marker->scope].gpu_timed = true;
+		profiler.query_active = true;
+		marker->gpu = true;
+	}
+
+	marker->start = alice_get_time();
+}
+
+void alice_begin_profile_scope(const char* name) {
+	alice_push_profile_scope(name, false);
+}
+
+void alice_begin_gpu_profile_scope(const char* name) {
+	alice_push_profile_scope(name, true);
+}
+
+void alice_end_profile_scope() {
+	if (!profiler.initialised || profiler.depth == 0) {
+		return;
+	}
+
+	if (profiler.overflow_depth > 0) {
+		profiler.overflow_depth--;
+		return;
+	}
+
+	const double now = alice_get_time();
+
+	alice_profile_marker_t* marker = &profiler.stack[--profiler.depth];
+
+	if (marker->gpu) {
+		glEndQuery(GL_TIME_ELAPSED);
+		profiler.query_active = false;
+	}
+
+	if (marker->scope != ALICE_PROFILER_NO_PARENT) {
+		alice_profile_scope_t* scope = &profiler.scopes[marker->scope];
+
+		scope->frame_cpu += (now - marker->start) * 1000.0;
+		scope->frame_calls++;
+	}
+}
+
+/* Never waits: queries still in flight are dropped. */
+static void alice_read_back_queries(alice_profile_query_set_t* set) {
+	for (u32 i = 0; i < set->count; i++) {
+		i32 available = 0;
+		glGetQueryObjectiv(set->queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available) {
+			profiler.dropped_query_count++;
+			continue;
+		}
+
+		u64 elapsed = 0;
+		glGetQueryObjectui64v(set->queries[i], GL_QUERY_RESULT, &elapsed);
+
+		profiler.scopes[set->scopes[i]].frame_gpu += (double)elapsed / 1000000.0;
+	}
+
+	set->count = 0;
+}
+
+void alice_end_profiler_frame() {
+	if (!profiler.initialised) {
+		return;
+	}
+
+	if (profiler.depth > 0) {
+		alice_log_warning("Profile scope `%s' was never ended",
+			profiler.stack[profiler.depth - 1].scope != ALICE_PROFILER_NO_PARENT ?
+			profiler.scopes[profiler.stack[profiler.depth - 1].scope].name : "?");
+
+		profiler.overflow_depth = 0;
+		while (profiler.depth > 0) {
+			alice_end_profile_scope();
+		}
+	}
+
+	/* The other set was filled last frame, and is filled again next frame. */
+	alice_read_back_queries(&profiler.query_sets[(profiler.frame_index + 1) & 1]);
+
+	for (u32 i = 0; i < profiler.scope_count; i++) {
+		alice_profile_scope_t* scope = &profiler.scopes[i];
+
+		scope->cpu_total += scope->frame_cpu;
+		scope->gpu_total += scope->frame_gpu;
+
+		scope->window_cpu += scope->frame_cpu;
+		scope->window_cpu_max = alice_max(scope->window_cpu_max, scope->frame_cpu);
+		scope->window_gpu += scope->frame_gpu;
+		scope->window_gpu_max = alice_max(scope->window_gpu_max, scope->frame_gpu);
+		scope->window_calls += scope->frame_calls;
+
+		scope->frame_cpu = 0.0;
+		scope->frame_gpu = 0.0;
+		scope->frame_calls = 0;
+	}
+
+	profiler.frame_index++;
+
+	if (++profiler.window_frames < ALICE_PROFILER_WINDOW) {
+		return;
+	}
+
+	const double n = (double)profiler.window_frames;
+
+	for (u32 i = 0; i < profiler.scope_count; i++) {
+		alice_profile_scope_t* scope = &profiler.scopes[i];
+
+		scope->cpu_average = scope->window_cpu / n;
+		scope->cpu_max = scope->window_cpu_max;
+		scope->gpu_average = scope->window_gpu / n;
+		scope->gpu_max = scope->window_gpu_max;
+		scope->calls_per_frame = (double)scope->window_calls / n;
+
+		scope->window_cpu = 0.0;
+		scope->window_cpu_max = 0.0;
+		scope->window_gpu = 0.0;
+		scope->window_gpu_max = 0.0;
+		scope->window_calls = 0;
+	}
+
+	profiler.window_frames = 0;
+}
@@ -0,0 +1,429 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alice/renderqueue.h"
+#include "alice/jobs.h"
+
+#define ALICE_SORT_KEY_ID_MASK ((1ull << ALICE_SORT_KEY_ID_BITS) - 1)
+#define ALICE_SORT_KEY_DEPTH_MASK ((1ull << ALICE_SORT_KEY_DEPTH_BITS) - 1)
+
+/* Transforms are gathered on the job threads in ranges of this size. */
+#define ALICE_GATHER_RANGE_SIZE 4096
+
+static u64 alice_hash_id(u64 x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdull;
+	x ^= x >> 33;
+
+	return x & ALICE_SORT_KEY_ID_MASK;
+}
+
+static u64 alice_hash_pointer(const void* ptr) {
+	if (!ptr) { return 0; }
+
+	return alice_hash_id((u64)(uintptr_t)ptr);
+}
+
+/* For things drawn differently depending on a small number, such as a
+ * shader's variants, each of which is its own program, or a mesh's LODs.
+ * User space pointers leave the top bits clear, so the number goes there. */
+static u64 alice_hash_pointer_variant(const void* ptr, u32 variant) {
+	if (!ptr) { return 0; }
+
+	return alice_hash_id((u64)(uintptr_t)ptr ^ ((u64)variant << 48));
+}
+
+/* Non-negative IEEE floats order the same way as their bit patterns, so
+ * the top bits after the sign make a monotonic fixed-width depth. */
+static u64 alice_quantize_depth(float depth) {
+	if (!(depth > 0.0f)) { return 0; }
+
+	u32 bits;
+	memcpy(&bits, &depth, sizeof(bits));
+
+	return (bits >> (31 - ALICE_SORT_KEY_DEPTH_BITS)) & ALICE_SORT_KEY_DEPTH_MASK;
+}
+
+alice_render_queue_t* alice_new_render_queue() {
+	alice_render_queue_t* new = malloc(sizeof(alice_render_queue_t));
+
+	new->packets = alice_null;
+	new->packet_count = 0;
+	new->packet_capacity = 0;
+
+	new->items = alice_null;
+	new->scratch = alice_null;
+	new->item_capacity = 0;
+
+	new->transforms = alice_null;
+	new->transform_capacity = 0;
+
+	new->commands = alice_null;
+	new->command_count = 0;
+	new->command_capacity = 0;
+
+	new->buckets = alice_null;
+	new->bucket_count = 0;
+	new->bucket_capacity = 0;
+
+	return new;
+}
+
+void alice_free_render_queue(alice_render_queue_t* queue) {
+	assert(queue);
+
+	if (queue->packet_capacity > 0) {
+		free(queue->packets);
+	}
+
+	if (queue->item_capacity > 0) {
+		free(queue->items);
+		free(queue->scratch);
+	}
+
+	if (queue->transform_capacity > 0) {
+		free(queue->transforms);
+	}
+
+	if (queue->command_capacity > 0) {
+		free(queue->commands);
+	}
+
+	if (queue->bucket_capacity > 0) {
+		free(queue->buckets);
+	}
+
+	free(queue);
+}
+
+void alice_clear_render_queue(alice_render_queue_t* queue) {
+	assert(queue);
+
+	queue->packet_count = 0;
+	queue->command_count = 0;
+	queue->bucket_count = 0;
+}
+
+u64 alice_make_sort_key(alice_render_pass_t pass, const void* shader, u32 features,
+		const void* material, const void* mesh, u32 lod, float depth) {
+	const u64 state =
+		(alice_hash_pointer_variant(shader, features) << (ALICE_SORT_KEY_ID_BITS * 2)) |
+		(alice_hash_pointer(material) << ALICE_SORT_KEY_ID_BITS) |
+		alice_hash_pointer_variant(mesh, lod);
+
+	const u64 quantized_depth = alice_quantize_depth(depth);
+
+	u64 key = (u64)pass << (64 - ALICE_SORT_KEY_PASS_BITS);
+
+	if (pass == ALICE_RENDER_PASS_TRANSPARENT) {
+		key |= (~quantized_depth & ALICE_SORT_KEY_DEPTH_MASK) << (ALICE_SORT_KEY_ID_BITS * 3);
+		key |= state;
+	} else {
+		key |= state << ALICE_SORT_KEY_DEPTH_BITS;
+		key |= quantized_depth;
+	}
+
+	return key;
+}
+
+alice_draw_packet_t* alice_render_queue_push(alice_render_queue_t* queue,
+		alice_render_pass_t pass, alice_material_t* material, alice_mesh_t* mesh,
+		u32 lod, alice_m4f_t transform, alice_aabb_t aabb, float depth) {
+	assert(queue);
+	assert(mesh);
+	assert(lod <= mesh->lod_count);
+
+	if (queue->packet_count >= queue->packet_capacity) {
+		queue->packet_capacity = alice_grow_capacity(queue->packet_capacity);
+		queue->packets = realloc(queue->packets, queue->packet_capacity * sizeof(alice_draw_packet_t));
+	}
+
+	alice_shader_t* shader = material ? material->shader : alice_null;
+	const u32 features = material ? alice_get_material_features(material) : 0;
+
+	alice_draw_packet_t* packet = &queue->packets[queue->packet_count++];
+	*packet = (alice_draw_packet_t) {
+		.key = alice_make_sort_key(pass, shader, features, material, mesh, lod, depth),
+		.pass = pass,
+		.shader = shader,
+		.material = material,
+		.mesh = mesh,
+		.lod = lod,
+		.transform = transform,
+		.aabb = aabb
+	};
+
+	return packet;
+}
+
+void alice_sort_render_queue(alice_render_queue_t* queue) {
+	assert(queue);
+
+	const u32 count = queue->packet_count;
+
+	if (count > queue->item_capacity) {
+		while (queue->item_capacity < count) {
+			queue->item_capacity = alice_grow_capacity(queue->item_capacity);
+		}
+
+		queue->items = realloc(queue->items, queue->item_capacity * sizeof(alice_sort_item_t));
+		queue->scratch = realloc(queue->scratch, queue->item_capacity * sizeof(alice_sort_item_t));
+	}
+
+	for (u32 i = 0; i < count; i++) {
+		queue->items[i] = (alice_sort_item_t) {
+			.key = queue->packets[i].key,
+			.index = i
+		};
+	}
+
+	/* LSD radix sort, one byte per pass. All eight histograms are built up
+	 * front so that passes over bytes every key shares can be skipped. */
+	u32 histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+
+	for (u32 i = 0; i < count; i++) {
+		const u64 key = queue->items[i].key;
+		for (u32 byte = 0; byte < 8; byte++) {
+			histograms[byte][(key >> (byte * 8)) & 0xff]++;
+		}
+	}
+
+	alice_sort_item_t* src = queue->items;
+	alice_sort_item_t* dst = queue->scratch;
+
+	for (u32 byte = 0; byte < 8; byte++) {
+		u32* histogram = histograms[byte];
+
+		if (count == 0 || histogram[(src[0].key >> (byte * 8)) & 0xff] == count) {
+			continue;
+		}
+
+		u32 offset = 0;
+		for (u32 i = 0; i < 256; i++) {
+			const u32 bucket_count = histogram[i];
+			histogram[i] = offset;
+			offset += bucket_count;
+		}
+
+		for (u32 i = 0; i < count; i++) {
+			const u32 digit = (src[i].key >> (byte * 8)) & 0xff;
+			dst[histogram[digit]++] = src[i];
+		}
+
+		alice_sort_item_t* temp = src;
+		src = dst;
+		dst = temp;
+	}
+
+	if (src != queue->items) {
+		queue->scratch = queue->items;
+		queue->items = src;
+	}
+}
+
+alice_draw_packet_t* alice_render_queue_get(alice_render_queue_t* queue, u32 index) {
+	assert(queue);
+	assert(index < queue->packet_count);
+
+	return &queue->packets[queue->items[index].index];
+}
+
+u32 alice_render_queue_batch_size(alice_render_queue_t* queue, u32 start) {
+	assert(queue);
+	assert(start < queue->packet_count);
+
+	alice_draw_packet_t* first = alice_render_queue_get(queue, start);
+
+	u32 count = 1;
+	while (start + count < queue->packet_count) {
+		alice_draw_packet_t* packet = alice_render_queue_get(queue, start + count);
+
+		if (packet->pass != first->pass ||
+			packet->mesh != first->mesh ||
+			packet->lod != first->lod ||
+			packet->material != first->material) {
+			break;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+static void alice_gather_transforms_job(void* data, u32 index) {
+	alice_render_queue_t* queue = data;
+
+	const u32 start = index * ALICE_GATHER_RANGE_SIZE;
+	const u32 end = alice_min(start + ALICE_GATHER_RANGE_SIZE, queue->packet_count);
+
+	for (u32 i = start; i < end; i++) {
+		queue->transforms[i] = queue->packets[queue->items[i].index].transform;
+	}
+}
+
+alice_m4f_t* alice_render_queue_gather_transforms(alice_render_queue_t* queue) {
+	assert(queue);
+
+	if (queue->packet_count > queue->transform_capacity) {
+		while (queue->transform_capacity < queue->packet_count) {
+			queue->transform_capacity = alice_grow_capacity(queue->transform_capacity);
+		}
+
+		queue->transforms = realloc(queue->transforms, queue->transform_capacity * sizeof(alice_m4f_t));
+	}
+
+	alice_run_jobs(alice_gather_transforms_job, queue,
+			(queue->packet_count + ALICE_GATHER_RANGE_SIZE - 1) / ALICE_GATHER_RANGE_SIZE);
+
+	return queue->transforms;
+}
+
+void alice_render_queue_build_commands(alice_render_queue_t* queue) {
+	assert(queue);
+
+	queue->command_count = 0;
+	queue->bucket_count = 0;
+
+	alice_draw_bucket_t* bucket = alice_null;
+
+	for (u32 i = 0; i < queue->packet_count;) {
+		alice_draw_packet_t* packet = alice_render_queue_get(queue, i);
+		alice_geometry_t* geometry = alice_get_mesh_lod_geometry(packet->mesh, packet->lod);
+
+		const u32 instance_count = alice_render_queue_batch_size(queue, i);
+
+		if (!bucket ||
+			bucket->pass != packet->pass ||
+			bucket->shader != packet->shader ||
+			bucket->material != packet->material) {
+
+			if (queue->bucket_count >= queue->bucket_capacity) {
+				queue->bucket_capacity = alice_grow_capacity(queue->bucket_capacity);
+				queue->buckets = realloc(queue->buckets, queue->bucket_capacity * sizeof(alice_draw_bucket_t));
+			}
+
+			bucket = &queue->buckets[queue->bucket_count++];
+			*bucket = (alice_draw_bucket_t) {
+				.pass = packet->pass,
+				.shader = packet->shader,
+				.material = packet->material,
+				.first_command = queue->command_count,
+				.command_count = 0,
+				.object_count = 0
+			};
+		}
+
+		if (queue->command_count >= queue->command_capacity) {
+			queue->command_capacity = alice_grow_capacity(queue->command_capacity);
+			queue->commands = realloc(queue->commands, queue->command_capacity * sizeof(alice_draw_command_t));
+		}
+
+		queue->commands[queue->command_count++] = (alice_draw_command_t) {
+			.count = geometry->index_count,
+			.instance_count = instance_count,
+			.first_index = geometry->first_index,
+			.base_vertex = (i32)geometry->base_vertex,
+			.base_instance = i
+		};
+
+		bucket->command_count++;
+		bucket->object_count += instance_count;
+
+		i += instance_count;
+	}
+}
+
+alice_command_lists_t* alice_new_command_lists() {
+	alice_command_lists_t* new = malloc(sizeof(alice_command_lists_t));
+
+	new->lists = alice_null;
+	new->stats = alice_null;
+	new->count = 0;
+	new->capacity = 0;
+
+	new->candidates = alice_null;
+	new->candidate_count = 0;
+	new->candidate_capacity = 0;
+
+	new->reported_missing_materials = 0;
+	new->reported_missing_shaders = 0;
+
+	return new;
+}
+
+void alice_free_command_lists(alice_command_lists_t* lists) {
+	assert(lists);
+
+	for (u32 i = 0; i < lists->capacity; i++) {
+		alice_free_render_queue(lists->lists[i]);
+	}
+
+	if (lists->capacity > 0) {
+		free(lists->lists);
+		free(lists->stats);
+	}
+
+	if (lists->candidate_capacity > 0) {
+		free(lists->candidates);
+	}
+
+	free(lists);
+}
+
+void alice_reset_command_lists(alice_command_lists_t* lists, u32 count) {
+	assert(lists);
+
+	if (count > lists->capacity) {
+		const u32 old_capacity = lists->capacity;
+
+		lists->capacity = count;
+		lists->lists = realloc(lists->lists, lists->capacity * sizeof(alice_render_queue_t*));
+		lists->stats = realloc(lists->stats, lists->capacity * sizeof(alice_command_list_stats_t));
+
+		for (u32 i = old_capacity; i < lists->capacity; i++) {
+			lists->lists[i] = alice_new_render_queue();
+		}
+	}
+
+	lists->count = count;
+
+	for (u32 i = 0; i < count; i++) {
+		alice_clear_render_queue(lists->lists[i]);
+		lists->stats[i] = (alice_command_list_stats_t) { 0 };
+	}
+}
+
+u32 alice_merge_command_lists(alice_command_lists_t* lists, alice_render_queue_t* queue) {
+	assert(lists);
+	assert(queue);
+
+	u32 total = queue->packet_count;
+	u32 culled_count = 0;
+
+	for (u32 i = 0; i < lists->count; i++) {
+		total += lists->lists[i]->packet_count;
+		culled_count += lists->stats[i].culled;
+	}
+
+	if (total > queue->packet_capacity) {
+		while (queue->packet_capacity < total) {
+			queue->packet_capacity = alice_grow_capacity(queue->packet_capacity);
+		}
+
+		queue->packets = realloc(queue->packets, queue->packet_capacity * sizeof(alice_draw_packet_t));
+	}
+
+	for (u32 i = 0; i < lists->count; i++) {
+		alice_render_queue_t* list = lists->lists[i];
+
+		memcpy(queue->packets + queue->packet_count, list->packets,
+				list->packet_count * sizeof(alice_draw_packet_t));
+		queue->packet_count += list->packet_count;
+	}
+
+	return culled_count;
+}
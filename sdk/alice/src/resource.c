@@ -10,6 +10,7 @@
 #include "alice/resource.h"
 #include "alice/dtable.h"
 #include "alice/graphics.h"
+#include "alice/profiler.h"
 #include "font.h"
 
 #define ALICE_RESOURCE_TABLE_MAX_LOAD 0.75
@@ -176,8 +177,7 @@ void alice_free_resource_payload(alice_resource_t* resource) {
 		alice_deinit_shader(resource->payload);
 	}
 	else if (resource->type == ALICE_RESOURCE_MATERIAL) {
-		/* Nothing needs to be freed for materials */
-		return;
+		alice_deinit_material(resource->payload);
 	}
 	else if (resource->type == ALICE_RESOURCE_MODEL) {
 		alice_deinit_model(resource->payload);
@@ -275,6 +275,7 @@ void alice_init_default_resources() {
 			.file_name_hash = alice_hash_string("sphere")
 		};
 		alice_model_add_mesh(sphere_resource->payload, alice_new_sphere_mesh());
+		alice_generate_model_lods(sphere_resource->payload);
 
 		strcpy(sphere_resource->file_name, "sphere");
 
@@ -334,6 +335,9 @@ void alice_get_working_dir(char* working_dir) {
 void alice_free_resource_manager() {
 	alice_free_resource_table(rm.table);
 
+	/* Every model has been freed, so nothing references the pool anymore. */
+	alice_free_geometry_pool();
+
 	PHYSFS_unmount(rm.working_dir);
 	PHYSFS_deinit();
 }
@@ -487,7 +491,7 @@ static bool impl_alice_load_shader(alice_resource_t* resource, const char* path,
 		resource->payload = malloc(sizeof(alice_shader_t));
 	}
 
-	alice_init_shader(resource->payload, raw->payload);
+	alice_init_shader_ex(resource->payload, raw->payload, path, alice_null, 0);
 
 	strcpy(resource->file_name, path);
 
@@ -733,6 +737,7 @@ static bool impl_alice_load_material(alice_resource_t* resource, const char* pat
 	*material = (alice_material_t){
 		.shader = alice_null,
 		.type = ALICE_MATERIAL_PBR,
+		.transparent = false,
 		.as.pbr = {
 			.albedo = 0xffffff,
 			.roughness = 0.3f,
@@ -756,6 +761,11 @@ static bool impl_alice_load_material(alice_resource_t* resource, const char* pat
 		alice_log_warning("Material does not have a shader, so objects with this material won't render");
 	}
 
+	alice_dtable_t* transparent_table = alice_dtable_find_child(table, "transparent");
+	if (transparent_table && transparent_table->value.type == ALICE_DTABLE_BOOL) {
+		material->transparent = transparent_table->value.as.boolean;
+	}
+
 	alice_dtable_t* pbr_table = alice_dtable_find_child(table, "pbr_material");
 	if (pbr_table) {
 		material->type = ALICE_MATERIAL_PBR;
@@ -817,21 +827,9 @@ static alice_mesh_t alice_process_model_mesh(aiNode* node, aiMesh* ai_mesh, cons
 		}
 	}
 
-
-	alice_vertex_buffer_t* vb = alice_new_vertex_buffer(
-		ALICE_VERTEXBUFFER_DRAW_TRIANGLES | ALICE_VERTEXBUFFER_STATIC_DRAW);
-
-	alice_bind_vertex_buffer_for_edit(vb);
-	alice_push_vertices(vb, vertices, current_vertex);
-	alice_push_indices(vb, indices, index_count);
-	alice_configure_vertex_buffer(vb, 0, 3, 8, 0); /* vec3 position */
-	alice_configure_vertex_buffer(vb, 1, 3, 8, 3); /* vec3 normal */
-	alice_configure_vertex_buffer(vb, 2, 2, 8, 6); /* vec2 uv */
-	alice_bind_vertex_buffer_for_edit(NULL);
-
 	alice_mesh_t mesh;
 
-	alice_init_mesh(&mesh, vb);
+	alice_init_mesh(&mesh, vertices, current_vertex, indices, index_count);
 
 	aiMatrix4x4 ai_transform = node->mTransformation;
 
@@ -855,8 +853,6 @@ static alice_mesh_t alice_process_model_mesh(aiNode* node, aiMesh* ai_mesh, cons
 	mesh.transform.elements[2][3] = ai_transform.d3;
 	mesh.transform.elements[3][3] = ai_transform.d4;
 
-	alice_calculate_aabb_from_mesh(&mesh.aabb, vertices, current_vertex, 8);
-
 	free(indices);
 	free(vertices);
 
@@ -913,6 +909,7 @@ static bool impl_alice_load_model(alice_resource_t* resource, const char* path,
 	}
 
 	alice_process_model_node(model, scene->mRootNode, scene);
+	alice_generate_model_lods(model);
 
 	aiReleaseImport(scene);
 
@@ -1073,7 +1070,23 @@ void alice_reload_resource(alice_resource_t* resource) {
 	}
 }
 
+/* Shaders also reload when a file they include changes. */
+static bool alice_shader_includes_changed(alice_shader_t* shader) {
+	for (u32 i = 1; i < shader->dependency_count; i++) {
+		alice_shader_dependency_t* dependency = &shader->dependencies[i];
+
+		PHYSFS_Stat stat;
+		if (PHYSFS_stat(dependency->path, &stat) && stat.modtime > dependency->modtime) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void alice_reload_changed_resources() {
+	alice_begin_profile_scope("Resource Reloading");
+
 	for (u32 i = 0; i < rm.table->capacity; i++) {
 		alice_resource_table_entry_t* entry = &rm.table->entries[i];
 
@@ -1082,11 +1095,14 @@ void alice_reload_changed_resources() {
 			PHYSFS_Stat stat;
 			PHYSFS_stat(r->file_name, &stat);
 
-			if (stat.modtime > r->modtime) {
+			if (stat.modtime > r->modtime ||
+				(r->type == ALICE_RESOURCE_SHADER && alice_shader_includes_changed(r->payload))) {
 				alice_reload_resource(r);
 			}
 		}
 	}
+
+	alice_end_profile_scope();
 }
 
 alice_resource_type_t alice_predict_resource_type(const char* file_extension) {
@@ -1254,6 +1270,9 @@ void alice_save_material(alice_material_t* material, const char* path) {
 	alice_dtable_t shader_table = alice_new_string_dtable("shader", shader_path);
 	alice_dtable_add_child(&material_table, shader_table);
 
+	alice_dtable_t transparent_table = alice_new_bool_dtable("transparent", material->transparent);
+	alice_dtable_add_child(&material_table, transparent_table);
+
 	switch (material->type) {
 		case ALICE_MATERIAL_PBR:
 			alice_save_pbr_material(&material_table, &material->as.pbr);
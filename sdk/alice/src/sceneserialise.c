@@ -8,6 +8,7 @@
 #include "alice/scripting.h"
 #include "alice/physics.h"
 #include "alice/debugrenderer.h"
+#include "alice/staticbatch.h"
 
 typedef enum alice_serialisable_type_t {
 	ALICE_ST_ENTITY,
@@ -165,6 +166,12 @@ static void alice_serialise_entity(alice_dtable_t* table, alice_scene_t* scene,
 					renderable->cast_shadows);
 			alice_dtable_add_child(&entity_table, cast_shadows_table);
 
+			alice_dtable_t static_table = alice_new_bool_dtable("static", renderable->is_static);
+			alice_dtable_add_child(&entity_table, static_table);
+
+			alice_dtable_t occluder_table = alice_new_bool_dtable("occluder", renderable->is_occluder);
+			alice_dtable_add_child(&entity_table, occluder_table);
+
 			alice_dtable_t model_table = alice_new_string_dtable("model", model_path);
 			alice_dtable_add_child(&entity_table, model_table);
 
@@ -517,15 +524,15 @@ void alice_serialise_scene(alice_scene_t* scene, const char* file_path) {
 			alice_dtable_add_child(&renderer_table, shader_table);
 		}
 
-		if (scene->renderer->extract) {
-			alice_dtable_t shader_table = alice_new_string_dtable("bright_extract_shader",
-					alice_get_resource_filename(scene->renderer->extract));
+		if (scene->renderer->bloom_downsample) {
+			alice_dtable_t shader_table = alice_new_string_dtable("bloom_downsample_shader",
+					alice_get_resource_filename(scene->renderer->bloom_downsample));
 			alice_dtable_add_child(&renderer_table, shader_table);
 		}
 
-		if (scene->renderer->blur) {
-			alice_dtable_t shader_table = alice_new_string_dtable("blur_shader",
-					alice_get_resource_filename(scene->renderer->blur));
+		if (scene->renderer->bloom_upsample) {
+			alice_dtable_t shader_table = alice_new_string_dtable("bloom_upsample_shader",
+					alice_get_resource_filename(scene->renderer->bloom_upsample));
 			alice_dtable_add_child(&renderer_table, shader_table);
 		}
 
@@ -541,6 +548,18 @@ void alice_serialise_scene(alice_scene_t* scene, const char* file_path) {
 			alice_dtable_add_child(&renderer_table, shader_table);
 		}
 
+		if (scene->renderer->gbuffer_shader) {
+			alice_dtable_t shader_table = alice_new_string_dtable("gbuffer_shader",
+					alice_get_resource_filename(scene->renderer->gbuffer_shader));
+			alice_dtable_add_child(&renderer_table, shader_table);
+		}
+
+		if (scene->renderer->deferred_shader) {
+			alice_dtable_t shader_table = alice_new_string_dtable("deferred_shader",
+					alice_get_resource_filename(scene->renderer->deferred_shader));
+			alice_dtable_add_child(&renderer_table, shader_table);
+		}
+
 		alice_dtable_t debug_table = alice_new_bool_dtable("debug", scene->renderer->debug);
 		alice_dtable_add_child(&renderer_table, debug_table);
 
@@ -558,18 +577,53 @@ void alice_serialise_scene(alice_scene_t* scene, const char* file_path) {
 				scene->renderer->bloom_threshold);
 		alice_dtable_add_child(&renderer_table, bloom_threshold_table);
 
-		alice_dtable_t bloom_blur_iterations_table = alice_new_number_dtable("bloom_blur_iterations",
-				scene->renderer->bloom_blur_iterations);
-		alice_dtable_add_child(&renderer_table, bloom_blur_iterations_table);
+		alice_dtable_t bloom_mip_count_table = alice_new_number_dtable("bloom_mip_count",
+				scene->renderer->bloom_mip_count);
+		alice_dtable_add_child(&renderer_table, bloom_mip_count_table);
+
+		alice_dtable_t use_deferred_table = alice_new_bool_dtable("use_deferred",
+				scene->renderer->use_deferred);
+		alice_dtable_add_child(&renderer_table, use_deferred_table);
+
+		alice_dtable_t use_dynamic_resolution_table = alice_new_bool_dtable("use_dynamic_resolution",
+				scene->renderer->use_dynamic_resolution);
+		alice_dtable_add_child(&renderer_table, use_dynamic_resolution_table);
+
+		alice_dtable_t target_frame_time_table = alice_new_number_dtable("target_frame_time",
+				scene->renderer->resolution.target_frame_time);
+		alice_dtable_add_child(&renderer_table, target_frame_time_table);
+
+		alice_dtable_t use_occlusion_culling_table = alice_new_bool_dtable("use_occlusion_culling",
+				scene->renderer->use_occlusion_culling);
+		alice_dtable_add_child(&renderer_table, use_occlusion_culling_table);
 
 		alice_dtable_t use_antialiasing_table = alice_new_bool_dtable("use_antialiasing",
 				scene->renderer->use_antialiasing);
 		alice_dtable_add_child(&renderer_table, use_antialiasing_table);
 
+		alice_dtable_t use_lods_table = alice_new_bool_dtable("use_lods", scene->renderer->use_lods);
+		alice_dtable_add_child(&renderer_table, use_lods_table);
+
+		alice_dtable_t lod_threshold_table = alice_new_number_dtable("lod_threshold",
+				scene->renderer->lod_threshold);
+		alice_dtable_add_child(&renderer_table, lod_threshold_table);
+
 		alice_dtable_t shadowmap_resolution_table =
 			alice_new_number_dtable("shadowmap_resolution", scene->renderer->shadowmap->res);
 		alice_dtable_add_child(&renderer_table, shadowmap_resolution_table);
 
+		alice_dtable_t point_shadowmap_resolution_table = alice_new_number_dtable(
+				"point_shadowmap_resolution", scene->renderer->point_shadowmap->res);
+		alice_dtable_add_child(&renderer_table, point_shadowmap_resolution_table);
+
+		alice_dtable_t shadow_cascades_table =
+			alice_new_number_dtable("shadow_cascades", scene->renderer->shadowmap->cascade_count);
+		alice_dtable_add_child(&renderer_table, shadow_cascades_table);
+
+		alice_dtable_t shadow_split_lambda_table =
+			alice_new_number_dtable("shadow_split_lambda", scene->renderer->shadowmap->split_lambda);
+		alice_dtable_add_child(&renderer_table, shadow_split_lambda_table);
+
 		alice_dtable_t ambient_intensity_table =
 			alice_new_number_dtable("ambient_intensity", scene->renderer->ambient_intensity);
 		alice_dtable_add_child(&renderer_table, ambient_intensity_table);
@@ -814,6 +868,16 @@ static alice_entity_handle_t alice_deserialise_entity(alice_dtable_t* table, ali
 				renderable->cast_shadows = cast_shadows_table->value.as.boolean;
 			}
 
+			alice_dtable_t* static_table = alice_dtable_find_child(table, "static");
+			if (static_table && static_table->value.type == ALICE_DTABLE_BOOL) {
+				renderable->is_static = static_table->value.as.boolean;
+			}
+
+			alice_dtable_t* occluder_table = alice_dtable_find_child(table, "occluder");
+			if (occluder_table && occluder_table->value.type == ALICE_DTABLE_BOOL) {
+				renderable->is_occluder = occluder_table->value.as.boolean;
+			}
+
 			alice_dtable_t* model_path_table = alice_dtable_find_child(table, "model");
 			if (model_path_table && model_path_table->value.type == ALICE_DTABLE_STRING) {
 				renderable->model = alice_load_model(model_path_table->value.as.string);
@@ -1234,13 +1298,14 @@ void alice_deserialise_scene(alice_scene_t* scene, const char* file_path) {
 		alice_dtable_t* renderer_3d_table = alice_dtable_find_child(settings_table, "renderer_3d");
 		if (renderer_3d_table) {
 			alice_shader_t* postprocess = alice_null;
-			alice_shader_t* blur = alice_null;
-			alice_shader_t* extract = alice_null;
+			alice_shader_t* bloom_downsample = alice_null;
+			alice_shader_t* bloom_upsample = alice_null;
 			alice_shader_t* debug_shader = alice_null;
 			alice_shader_t* depth_shader = alice_null;
 			alice_shader_t* point_depth_shader = alice_null;
 			bool debug = false;
 			u32 shadowmap_resolution = 1024;
+			u32 point_shadowmap_resolution = 1024;
 
 			alice_dtable_t* postprocess_shader_table = alice_dtable_find_child(renderer_3d_table,
 					"postprocess_shader");
@@ -1248,17 +1313,18 @@ void alice_deserialise_scene(alice_scene_t* scene, const char* file_path) {
 				postprocess = alice_load_shader(postprocess_shader_table->value.as.string);
 			}
 
-			alice_dtable_t* bright_extract_shader_table = alice_dtable_find_child(renderer_3d_table,
-					"bright_extract_shader");
-			if (bright_extract_shader_table &&
-					bright_extract_shader_table->value.type == ALICE_DTABLE_STRING) {
-				extract = alice_load_shader(bright_extract_shader_table->value.as.string);
+			alice_dtable_t* bloom_downsample_shader_table = alice_dtable_find_child(renderer_3d_table,
+					"bloom_downsample_shader");
+			if (bloom_downsample_shader_table &&
+					bloom_downsample_shader_table->value.type == ALICE_DTABLE_STRING) {
+				bloom_downsample = alice_load_shader(bloom_downsample_shader_table->value.as.string);
 			}
 
-			alice_dtable_t* blur_shader_table = alice_dtable_find_child(renderer_3d_table,
-					"blur_shader");
-			if (blur_shader_table && blur_shader_table->value.type == ALICE_DTABLE_STRING) {
-				blur = alice_load_shader(blur_shader_table->value.as.string);
+			alice_dtable_t* bloom_upsample_shader_table = alice_dtable_find_child(renderer_3d_table,
+					"bloom_upsample_shader");
+			if (bloom_upsample_shader_table &&
+					bloom_upsample_shader_table->value.type == ALICE_DTABLE_STRING) {
+				bloom_upsample = alice_load_shader(bloom_upsample_shader_table->value.as.string);
 			}
 
 			alice_dtable_t* debug_shader_table = alice_dtable_find_child(renderer_3d_table,
@@ -1290,8 +1356,17 @@ void alice_deserialise_scene(alice_scene_t* scene, const char* file_path) {
 				shadowmap_resolution = (u32)shadowmap_resolution_table->value.as.number;
 			}
 
-			scene->renderer = alice_new_scene_renderer_3d(postprocess, extract, blur, depth_shader,
-					point_depth_shader, debug, debug_shader, shadowmap_resolution);
+			/* Every point shadow slot is allocated up front, so this sets the
+			 * memory of all of them: at 1024, 16 bit depth makes it 96 MB. */
+			alice_dtable_t* point_shadowmap_resolution_table =
+				alice_dtable_find_child(renderer_3d_table, "point_shadowmap_resolution");
+			if (point_shadowmap_resolution_table &&
+					point_shadowmap_resolution_table->value.type == ALICE_DTABLE_NUMBER) {
+				point_shadowmap_resolution = (u32)point_shadowmap_resolution_table->value.as.number;
+			}
+
+			scene->renderer = alice_new_scene_renderer_3d(postprocess, bloom_downsample, bloom_upsample, depth_shader,
+					point_depth_shader, debug, debug_shader, shadowmap_resolution, point_shadowmap_resolution);
 			scene->renderer->use_antialiasing = true;
 			scene->renderer->use_bloom = true;
 
@@ -1301,17 +1376,66 @@ void alice_deserialise_scene(alice_scene_t* scene, const char* file_path) {
 				scene->renderer->use_bloom = use_bloom_table->value.as.boolean;
 			}
 
+			alice_dtable_t* gbuffer_shader_table = alice_dtable_find_child(renderer_3d_table,
+					"gbuffer_shader");
+			if (gbuffer_shader_table && gbuffer_shader_table->value.type == ALICE_DTABLE_STRING) {
+				scene->renderer->gbuffer_shader = alice_load_shader(gbuffer_shader_table->value.as.string);
+			}
+
+			alice_dtable_t* deferred_shader_table = alice_dtable_find_child(renderer_3d_table,
+					"deferred_shader");
+			if (deferred_shader_table && deferred_shader_table->value.type == ALICE_DTABLE_STRING) {
+				scene->renderer->deferred_shader = alice_load_shader(deferred_shader_table->value.as.string);
+			}
+
+			alice_dtable_t* use_deferred_table = alice_dtable_find_child(renderer_3d_table,
+					"use_deferred");
+			if (use_deferred_table && use_deferred_table->value.type == ALICE_DTABLE_BOOL) {
+				scene->renderer->use_deferred = use_deferred_table->value.as.boolean;
+			}
+
+			alice_dtable_t* use_dynamic_resolution_table = alice_dtable_find_child(renderer_3d_table,
+					"use_dynamic_resolution");
+			if (use_dynamic_resolution_table && use_dynamic_resolution_table->value.type == ALICE_DTABLE_BOOL) {
+				scene->renderer->use_dynamic_resolution = use_dynamic_resolution_table->value.as.boolean;
+			}
+
+			alice_dtable_t* target_frame_time_table = alice_dtable_find_child(renderer_3d_table,
+					"target_frame_time");
+			if (target_frame_time_table && target_frame_time_table->value.type == ALICE_DTABLE_NUMBER &&
+					target_frame_time_table->value.as.number > 0.0) {
+				scene->renderer->resolution.target_frame_time = target_frame_time_table->value.as.number;
+			}
+
+			alice_dtable_t* use_occlusion_culling_table = alice_dtable_find_child(renderer_3d_table,
+					"use_occlusion_culling");
+			if (use_occlusion_culling_table && use_occlusion_culling_table->value.type == ALICE_DTABLE_BOOL) {
+				scene->renderer->use_occlusion_culling = use_occlusion_culling_table->value.as.boolean;
+			}
+
+			alice_dtable_t* shadow_cascades_table = alice_dtable_find_child(renderer_3d_table,
+					"shadow_cascades");
+			if (shadow_cascades_table && shadow_cascades_table->value.type == ALICE_DTABLE_NUMBER) {
+				scene->renderer->shadowmap->cascade_count = (u32)shadow_cascades_table->value.as.number;
+			}
+
+			alice_dtable_t* shadow_split_lambda_table = alice_dtable_find_child(renderer_3d_table,
+					"shadow_split_lambda");
+			if (shadow_split_lambda_table && shadow_split_lambda_table->value.type == ALICE_DTABLE_NUMBER) {
+				scene->renderer->shadowmap->split_lambda = (float)shadow_split_lambda_table->value.as.number;
+			}
+
 			alice_dtable_t* bloom_threshold_table = alice_dtable_find_child(renderer_3d_table, "bloom_threshold");
 			if (bloom_threshold_table && bloom_threshold_table->value.type == ALICE_DTABLE_NUMBER) {
 				scene->renderer->bloom_threshold = (float)bloom_threshold_table->value.as.number;
 			}
 
-			alice_dtable_t* bloom_blur_iterations_table = alice_dtable_find_child(renderer_3d_table,
-					"bloom_blur_iterations");
-			if (bloom_blur_iterations_table &&
-					bloom_blur_iterations_table->value.type == ALICE_DTABLE_NUMBER) {
-				scene->renderer->bloom_blur_iterations =
-					(u32)bloom_blur_iterations_table->value.as.number;
+			alice_dtable_t* bloom_mip_count_table = alice_dtable_find_child(renderer_3d_table,
+					"bloom_mip_count");
+			if (bloom_mip_count_table &&
+					bloom_mip_count_table->value.type == ALICE_DTABLE_NUMBER) {
+				scene->renderer->bloom_mip_count =
+					(u32)bloom_mip_count_table->value.as.number;
 			}
 
 			alice_dtable_t* use_antialiasing_table = alice_dtable_find_child(renderer_3d_table,
@@ -1320,6 +1444,17 @@ void alice_deserialise_scene(alice_scene_t* scene, const char* file_path) {
 				scene->renderer->use_antialiasing = use_antialiasing_table->value.as.boolean;
 			}
 
+			alice_dtable_t* use_lods_table = alice_dtable_find_child(renderer_3d_table, "use_lods");
+			if (use_lods_table && use_lods_table->value.type == ALICE_DTABLE_BOOL) {
+				scene->renderer->use_lods = use_lods_table->value.as.boolean;
+			}
+
+			alice_dtable_t* lod_threshold_table = alice_dtable_find_child(renderer_3d_table, "lod_threshold");
+			if (lod_threshold_table && lod_threshold_table->value.type == ALICE_DTABLE_NUMBER &&
+					lod_threshold_table->value.as.number > 0.0) {
+				scene->renderer->lod_threshold = (float)lod_threshold_table->value.as.number;
+			}
+
 			alice_dtable_t* ambient_intensity_table = alice_dtable_find_child(renderer_3d_table,
 					"ambient_intensity");
 			if (ambient_intensity_table &&
@@ -1382,5 +1517,9 @@ void alice_deserialise_scene(alice_scene_t* scene, const char* file_path) {
 		alice_deserialise_entity(child_table, scene);
 	}
 
+	if (scene->renderer) {
+		alice_build_static_batches(scene);
+	}
+
 	alice_free_dtable(table);
 }
@@ -3,6 +3,7 @@
 
 #include "alice/scripting.h"
 #include "alice/entity.h"
+#include "alice/profiler.h"
 
 #ifdef ALICE_PLATFORM_WINDOWS
 #include <windows.h>
@@ -225,12 +226,16 @@ void alice_init_scripts(alice_script_context_t* context) {
 void alice_update_scripts(alice_script_context_t* context, double timestep) {
 	assert(context);
 
+	alice_begin_profile_scope("Scripts");
+
 	for (u32 i = 0; i < context->script_count; i++) {
 		alice_script_t* script = &context->scripts[i];
 		if (script->on_update) {
 			script->on_update(context->scene, script->entity, script->instance, timestep);
 		}
 	}
+
+	alice_end_profile_scope();
 }
 
 void alice_physics_update_scripts(alice_script_context_t* context, double timestep) {
@@ -0,0 +1,199 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+#include <physfs.h>
+
+#include "alice/shadercache.h"
+
+#define ALICE_SHADER_CACHE_MAGIC 0x43535341 /* "ASSC" */
+#define ALICE_SHADER_CACHE_VERSION 1
+
+typedef struct alice_shader_cache_header_t {
+	u32 magic;
+	u32 version;
+	u64 key;
+	u32 format;
+	u32 length;
+} alice_shader_cache_header_t;
+
+typedef struct alice_shader_cache_t {
+	bool enabled;
+	char directory[256];
+
+	/* Hash of the driver strings, which every key starts from. */
+	u64 driver_hash;
+} alice_shader_cache_t;
+
+static alice_shader_cache_t shader_cache;
+
+/* FNV-1a. */
+static u64 alice_hash_shader_data(u64 hash, const void* data, u32 size) {
+	const u8* bytes = data;
+
+	for (u32 i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+static u64 alice_hash_shader_string(u64 hash, const char* string) {
+	return string ? alice_hash_shader_data(hash, string, (u32)strlen(string) + 1) : hash;
+}
+
+void alice_init_shader_cache(const char* directory) {
+	assert(directory);
+
+	shader_cache.enabled = false;
+
+	i32 format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+	if (format_count <= 0) {
+		alice_log_warning("The driver can't save program binaries; shaders will always be compiled");
+		return;
+	}
+
+	if (strlen(directory) + 1 > sizeof(shader_cache.directory)) {
+		alice_log_warning("Shader cache directory `%s' is too long", directory);
+		return;
+	}
+
+	if (!PHYSFS_mkdir(directory)) {
+		alice_log_warning("Failed to create shader cache directory `%s': %s", directory,
+			PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+		return;
+	}
+
+	strcpy(shader_cache.directory, directory);
+
+	u64 hash = 0xcbf29ce484222325ull;
+	hash = alice_hash_shader_string(hash, (const char*)glGetString(GL_VENDOR));
+	hash = alice_hash_shader_string(hash, (const char*)glGetString(GL_RENDERER));
+	hash = alice_hash_shader_string(hash, (const char*)glGetString(GL_VERSION));
+	shader_cache.driver_hash = hash;
+
+	shader_cache.enabled = true;
+}
+
+void alice_deinit_shader_cache() {
+	shader_cache.enabled = false;
+}
+
+bool alice_is_shader_cache_enabled() {
+	return shader_cache.enabled;
+}
+
+u64 alice_get_shader_cache_key(const alice_preprocessed_shader_t* shader) {
+	assert(shader);
+
+	u64 hash = shader_cache.driver_hash;
+
+	for (u32 i = 0; i < ALICE_SHADER_STAGE_COUNT; i++) {
+		/* Keeps the same text in different stages from hashing alike. */
+		hash = alice_hash_shader_data(hash, &i, sizeof(i));
+
+		if (shader->stages[i]) {
+			hash = alice_hash_shader_data(hash, shader->stages[i], shader->stage_lengths[i]);
+		}
+	}
+
+	return hash;
+}
+
+static void alice_get_shader_cache_path(char* path, u32 size, u64 key) {
+	snprintf(path, size, "%s/%016llx.bin", shader_cache.directory, (unsigned long long)key);
+}
+
+u32 alice_load_cached_program(u64 key) {
+	if (!shader_cache.enabled) {
+		return 0;
+	}
+
+	char path[300];
+	alice_get_shader_cache_path(path, sizeof(path), key);
+
+	PHYSFS_File* file = PHYSFS_openRead(path);
+	if (!file) {
+		return 0;
+	}
+
+	alice_shader_cache_header_t header;
+	void* binary = alice_null;
+
+	bool valid = PHYSFS_readBytes(file, &header, sizeof(header)) == sizeof(header) &&
+		header.magic == ALICE_SHADER_CACHE_MAGIC &&
+		header.version == ALICE_SHADER_CACHE_VERSION &&
+		header.key == key &&
+		(i64)header.length == PHYSFS_fileLength(file) - (i64)sizeof(header);
+
+	if (valid) {
+		binary = malloc(header.length);
+		valid = PHYSFS_readBytes(file, binary, header.length) == (i64)header.length;
+	}
+
+	PHYSFS_close(file);
+
+	u32 program = 0;
+
+	if (valid) {
+		program = glCreateProgram();
+		glProgramBinary(program, header.format, binary, (GLsizei)header.length);
+
+		/* Drivers refuse binaries from other versions of themselves. */
+		i32 success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success) {
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	free(binary);
+
+	return program;
+}
+
+void alice_save_cached_program(u64 key, u32 program) {
+	if (!shader_cache.enabled) {
+		return;
+	}
+
+	i32 length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+
+	alice_shader_cache_header_t header = {
+		.magic = ALICE_SHADER_CACHE_MAGIC,
+		.version = ALICE_SHADER_CACHE_VERSION,
+		.key = key,
+		.length = (u32)length
+	};
+
+	void* binary = malloc(length);
+
+	GLenum format = 0;
+	glGetProgramBinary(program, length, alice_null, &format, binary);
+	header.format = format;
+
+	char path[300];
+	alice_get_shader_cache_path(path, sizeof(path), key);
+
+	PHYSFS_File* file = PHYSFS_openWrite(path);
+	if (!file) {
+		alice_log_warning("Failed to write shader cache entry `%s'", path);
+		free(binary);
+		return;
+	}
+
+	PHYSFS_writeBytes(file, &header, sizeof(header));
+	PHYSFS_writeBytes(file, binary, header.length);
+	PHYSFS_close(file);
+
+	free(binary);
+}
@@ -0,0 +1,401 @@
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <physfs.h>
+
+#include "alice/shaderpreprocessor.h"
+
+typedef struct alice_shader_text_t {
+	char* data;
+	u32 length;
+	u32 capacity;
+} alice_shader_text_t;
+
+typedef struct alice_shader_preprocessor_t {
+	alice_preprocessed_shader_t* shader;
+
+	alice_shader_text_t stages[ALICE_SHADER_STAGE_COUNT];
+	bool has_stage[ALICE_SHADER_STAGE_COUNT];
+
+	/* Whether the #version line, the defines and the first #line have
+	 * been written. */
+	bool header_written[ALICE_SHADER_STAGE_COUNT];
+
+	i32 stage;
+
+	/* Parallel to the shader's files: their text, and a bit for every
+	 * stage they have been included in. */
+	char** contents;
+	u32* included_in;
+
+	const alice_shader_define_t* defines;
+	u32 define_count;
+
+	bool failed;
+} alice_shader_preprocessor_t;
+
+static const char* stage_names[ALICE_SHADER_STAGE_COUNT] = {
+	"VERTEX", "FRAGMENT", "GEOMETRY"
+};
+
+const char* alice_shader_stage_name(alice_shader_stage_t stage) {
+	assert(stage < ALICE_SHADER_STAGE_COUNT);
+
+	return stage_names[stage];
+}
+
+static void alice_shader_text_append(alice_shader_text_t* text, const char* data, u32 length) {
+	if (text->length + length + 1 > text->capacity) {
+		while (text->length + length + 1 > text->capacity) {
+			text->capacity = alice_grow_capacity(text->capacity);
+		}
+
+		text->data = realloc(text->data, text->capacity);
+	}
+
+	memcpy(text->data + text->length, data, length);
+	text->length += length;
+	text->data[text->length] = '\0';
+}
+
+static void alice_shader_text_printf(alice_shader_text_t* text, const char* format, ...) {
+	char buffer[512];
+
+	va_list args;
+	va_start(args, format);
+	const i32 length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	alice_shader_text_append(text, buffer, (u32)alice_min(alice_max(length, 0), (i32)sizeof(buffer) - 1));
+}
+
+static bool alice_line_starts_with(const char* line, const char* end, const char* prefix) {
+	const u32 length = (u32)strlen(prefix);
+
+	return (u32)(end - line) >= length && memcmp(line, prefix, length) == 0;
+}
+
+/* Like alice_line_starts_with, but the directive has to be a whole word, so
+ * that #end doesn't match #endif. */
+static bool alice_line_has_directive(const char* line, const char* end, const char* directive) {
+	if (!alice_line_starts_with(line, end, directive)) {
+		return false;
+	}
+
+	const char* after = line + strlen(directive);
+
+	return after == end || *after == ' ' || *after == '\t' || *after == '\r';
+}
+
+static const char* alice_skip_blanks(const char* c, const char* end) {
+	while (c < end && (*c == ' ' || *c == '\t' || *c == '\r')) {
+		c++;
+	}
+
+	return c;
+}
+
+static u32 alice_add_shader_file(alice_shader_preprocessor_t* pp, const char* path, char* contents, i64 modtime) {
+	alice_preprocessed_shader_t* shader = pp->shader;
+
+	if (shader->file_count >= shader->file_capacity) {
+		shader->file_capacity = alice_grow_capacity(shader->file_capacity);
+		shader->files = realloc(shader->files, shader->file_capacity * sizeof(alice_shader_dependency_t));
+		pp->contents = realloc(pp->contents, shader->file_capacity * sizeof(char*));
+		pp->included_in = realloc(pp->included_in, shader->file_capacity * sizeof(u32));
+	}
+
+	alice_shader_dependency_t* file = &shader->files[shader->file_count];
+
+	file->path = alice_null;
+	if (path) {
+		file->path = malloc(strlen(path) + 1);
+		strcpy(file->path, path);
+	}
+	file->modtime = modtime;
+
+	pp->contents[shader->file_count] = contents;
+	pp->included_in[shader->file_count] = 0;
+
+	return shader->file_count++;
+}
+
+static char* alice_read_shader_file(const char* path, i64* modtime) {
+	PHYSFS_File* file = PHYSFS_openRead(path);
+	if (!file) {
+		return alice_null;
+	}
+
+	PHYSFS_Stat stat;
+	*modtime = PHYSFS_stat(path, &stat) ? stat.modtime : 0;
+
+	const u32 size = (u32)PHYSFS_fileLength(file);
+
+	char* buffer = malloc(size + 1);
+	const i64 read = PHYSFS_readBytes(file, buffer, size);
+	buffer[read > 0 ? read : 0] = '\0';
+
+	PHYSFS_close(file);
+
+	return buffer;
+}
+
+/* Writes the defines at the start of a stage. GLSL wants #version before
+ * anything else, so if the stage's first line is one it is written first,
+ * and true is returned to say that it has been dealt with. */
+static bool alice_write_shader_stage_header(alice_shader_preprocessor_t* pp, alice_shader_text_t* text,
+		const char* line, u32 length, u32 line_number, u32 file) {
+	const bool is_version = alice_line_has_directive(alice_skip_blanks(line, line + length), line + length, "#version");
+
+	if (is_version) {
+		alice_shader_text_append(text, line, length);
+		alice_shader_text_append(text, "\n", 1);
+	}
+
+	for (u32 i = 0; i < pp->define_count; i++) {
+		const alice_shader_define_t* define = &pp->defines[i];
+
+		alice_shader_text_printf(text, "#define %s %s\n", define->name, define->value ? define->value : "");
+	}
+
+	alice_shader_text_printf(text, "#line %u %u\n", is_version ? line_number + 1 : line_number, file);
+
+	pp->header_written[pp->stage] = true;
+
+	return is_version;
+}
+
+static void alice_preprocess_shader_file(alice_shader_preprocessor_t* pp, u32 file, u32 depth);
+
+static void alice_include_shader_file(alice_shader_preprocessor_t* pp, const char* line, const char* end,
+		u32 from, u32 line_number, u32 depth) {
+	alice_shader_text_t* text = &pp->stages[pp->stage];
+	const char* from_path = pp->shader->files[from].path;
+
+	const char* c = alice_skip_blanks(line + strlen("#include"), end);
+	const char close = *c == '<' ? '>' : '"';
+	if (c >= end || (*c != '"' && *c != '<')) {
+		alice_log_error("%s:%u: Expected a quoted path after #include", from_path ? from_path : "shader", line_number);
+		pp->failed = true;
+		return;
+	}
+
+	const char* name = ++c;
+	while (c < end && *c != close) {
+		c++;
+	}
+
+	const u32 name_length = (u32)(c - name);
+
+	char path[256];
+	u32 directory_length = 0;
+
+	/* Relative to the including file, unless it starts from the root. */
+	if (name[0] != '/' && from_path) {
+		const char* slash = strrchr(from_path, '/');
+		directory_length = slash ? (u32)(slash - from_path) + 1 : 0;
+	}
+
+	const u32 skip = name[0] == '/' ? 1 : 0;
+	if (directory_length + name_length - skip + 1 > sizeof(path)) {
+		alice_log_error("%s:%u: Include path is too long", from_path ? from_path : "shader", line_number);
+		pp->failed = true;
+		return;
+	}
+
+	if (directory_length > 0) {
+		memcpy(path, from_path, directory_length);
+	}
+	memcpy(path + directory_length, name + skip, name_length - skip);
+	path[directory_length + name_length - skip] = '\0';
+
+	if (depth + 1 >= ALICE_SHADER_MAX_INCLUDE_DEPTH) {
+		alice_log_error("%s:%u: Includes nested too deeply including `%s'",
+			from_path ? from_path : "shader", line_number, path);
+		pp->failed = true;
+		return;
+	}
+
+	u32 index = pp->shader->file_count;
+	for (u32 i = 1; i < pp->shader->file_count; i++) {
+		if (strcmp(pp->shader->files[i].path, path) == 0) {
+			index = i;
+			break;
+		}
+	}
+
+	if (index == pp->shader->file_count) {
+		i64 modtime = 0;
+		char* contents = alice_read_shader_file(path, &modtime);
+		if (!contents) {
+			alice_log_error("%s:%u: Failed to include `%s'", from_path ? from_path : "shader", line_number, path);
+			pp->failed = true;
+			return;
+		}
+
+		index = alice_add_shader_file(pp, path, contents, modtime);
+	}
+
+	/* The include still takes up its line. */
+	if (pp->included_in[index] & (1 << pp->stage)) {
+		alice_shader_text_append(text, "\n", 1);
+		return;
+	}
+
+	pp->included_in[index] |= 1 << pp->stage;
+
+	alice_shader_text_printf(text, "#line 1 %u\n", index);
+	alice_preprocess_shader_file(pp, index, depth + 1);
+	alice_shader_text_printf(&pp->stages[pp->stage], "#line %u %u\n", line_number + 1, from);
+}
+
+static void alice_preprocess_shader_file(alice_shader_preprocessor_t* pp, u32 file, u32 depth) {
+	const char* path = pp->shader->files[file].path;
+
+	u32 line_number = 1;
+	for (const char* line = pp->contents[file]; *line != '\0' && !pp->failed; line_number++) {
+		const char* end = strchr(line, '\n');
+		if (!end) {
+			end = line + strlen(line);
+		}
+
+		const u32 length = (u32)(end - line);
+		const char* directive = alice_skip_blanks(line, end);
+
+		if (alice_line_has_directive(directive, end, "#begin") || alice_line_has_directive(directive, end, "#end")) {
+			if (depth > 0) {
+				alice_log_error("%s:%u: Included files can't begin or end stages", path ? path : "shader", line_number);
+				pp->failed = true;
+				break;
+			}
+
+			const bool begin = directive[1] == 'b';
+
+			pp->stage = -1;
+
+			if (begin) {
+				const char* name = alice_skip_blanks(directive + strlen("#begin"), end);
+
+				for (u32 i = 0; i < ALICE_SHADER_STAGE_COUNT; i++) {
+					if (alice_line_starts_with(name, end, stage_names[i])) {
+						pp->stage = (i32)i;
+						pp->has_stage[i] = true;
+					}
+				}
+
+				if (pp->stage < 0) {
+					alice_log_warning("%s:%u: Unknown shader stage", path ? path : "shader", line_number);
+				}
+			}
+		} else if (pp->stage >= 0) {
+			alice_shader_text_t* text = &pp->stages[pp->stage];
+
+			if (!pp->header_written[pp->stage]) {
+				/* Blank lines before #version are allowed. */
+				if (directive == end) {
+					alice_shader_text_append(text, "\n", 1);
+					line = *end == '\0' ? end : end + 1;
+					continue;
+				}
+
+				if (alice_write_shader_stage_header(pp, text, line, length, line_number, file)) {
+					line = *end == '\0' ? end : end + 1;
+					continue;
+				}
+			}
+
+			if (alice_line_has_directive(directive, end, "#include")) {
+				alice_include_shader_file(pp, directive, end, file, line_number, depth);
+			} else {
+				alice_shader_text_append(text, line, length);
+				alice_shader_text_append(text, "\n", 1);
+			}
+		}
+
+		line = *end == '\0' ? end : end + 1;
+	}
+}
+
+bool alice_preprocess_shader(alice_preprocessed_shader_t* shader, const char* source,
+		const char* path, const alice_shader_define_t* defines, u32 define_count) {
+	assert(shader);
+	assert(source);
+
+	memset(shader, 0, sizeof(alice_preprocessed_shader_t));
+
+	alice_shader_preprocessor_t pp = {
+		.shader = shader,
+		.stage = -1,
+		.defines = defines,
+		.define_count = define_count
+	};
+
+	i64 modtime = 0;
+	if (path) {
+		PHYSFS_Stat stat;
+		modtime = PHYSFS_stat(path, &stat) ? stat.modtime : 0;
+	}
+
+	/* The source belongs to the caller, so it isn't freed with the rest. */
+	alice_add_shader_file(&pp, path, (char*)source, modtime);
+
+	alice_preprocess_shader_file(&pp, 0, 0);
+
+	for (u32 i = 0; i < ALICE_SHADER_STAGE_COUNT; i++) {
+		if (!pp.has_stage[i]) {
+			free(pp.stages[i].data);
+			continue;
+		}
+
+		if (!pp.stages[i].data) {
+			alice_shader_text_append(&pp.stages[i], "", 0);
+		}
+
+		shader->stages[i] = pp.stages[i].data;
+		shader->stage_lengths[i] = pp.stages[i].length;
+	}
+
+	for (u32 i = 1; i < shader->file_count; i++) {
+		free(pp.contents[i]);
+	}
+
+	free(pp.contents);
+	free(pp.included_in);
+
+	return !pp.failed;
+}
+
+void alice_deinit_preprocessed_shader(alice_preprocessed_shader_t* shader) {
+	assert(shader);
+
+	for (u32 i = 0; i < ALICE_SHADER_STAGE_COUNT; i++) {
+		free(shader->stages[i]);
+		shader->stages[i] = alice_null;
+		shader->stage_lengths[i] = 0;
+	}
+
+	for (u32 i = 0; i < shader->file_count; i++) {
+		free(shader->files[i].path);
+	}
+
+	if (shader->file_capacity > 0) {
+		free(shader->files);
+	}
+
+	shader->files = alice_null;
+	shader->file_count = 0;
+	shader->file_capacity = 0;
+}
+
+void alice_log_shader_sources(const alice_preprocessed_shader_t* shader) {
+	assert(shader);
+
+	for (u32 i = 0; i < shader->file_count; i++) {
+		const char* path = shader->files[i].path;
+
+		alice_log("Shader source %u is %s", i, path ? path : "the shader's own source");
+	}
+}
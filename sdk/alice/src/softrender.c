@@ -0,0 +1,750 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alice/softrender.h"
+#include "alice/jobs.h"
+
+#ifdef ALICE_SIMD_SSE
+#include <xmmintrin.h>
+#endif
+
+/* Vertices with a smaller w than this are treated as crossing the near
+ * plane. */
+#define ALICE_SOFTWARE_MIN_W 1e-5f
+
+static alice_v3f_t alice_software_v3f_from_color(alice_color_t color) {
+	alice_rgb_color_t rgb = alice_rgb_color_from_color(color);
+
+	return (alice_v3f_t) { rgb.r, rgb.g, rgb.b };
+}
+
+static alice_v3f_t alice_software_normalise(alice_v3f_t v) {
+	const float length = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+	if (length == 0.0f) {
+		return v;
+	}
+
+	const float inv_length = 1.0f / length;
+
+	return (alice_v3f_t) { v.x * inv_length, v.y * inv_length, v.z * inv_length };
+}
+
+alice_software_renderer_t* alice_new_software_renderer(u32 width, u32 height) {
+	assert(width > 0 && height > 0);
+	assert(width % 4 == 0);
+
+	alice_software_renderer_t* new = calloc(1, sizeof(alice_software_renderer_t));
+
+	new->width = width;
+	new->height = height;
+
+	new->shading = ALICE_SOFTWARE_SHADING_PHONG;
+	new->clear_color = 0x000000;
+
+	/* Forces the tone map to be built on the first frame. */
+	new->tone_map_gamma = -1.0f;
+
+	new->pixels = malloc(width * height * 4);
+	new->depth = malloc(width * height * sizeof(float));
+	new->visibility = malloc(width * height * sizeof(u32));
+
+	new->tile_count_x = (width + ALICE_SOFTWARE_TILE_WIDTH - 1) / ALICE_SOFTWARE_TILE_WIDTH;
+	new->tile_count_y = (height + ALICE_SOFTWARE_TILE_HEIGHT - 1) / ALICE_SOFTWARE_TILE_HEIGHT;
+
+	new->bins = calloc(new->tile_count_x * new->tile_count_y, sizeof(alice_software_bin_t));
+
+	return new;
+}
+
+void alice_free_software_renderer(alice_software_renderer_t* renderer) {
+	assert(renderer);
+
+	free(renderer->pixels);
+	free(renderer->depth);
+	free(renderer->visibility);
+
+	if (renderer->triangle_capacity > 0) { free(renderer->triangles); }
+	if (renderer->material_capacity > 0) { free(renderer->materials); }
+	if (renderer->directional_light_capacity > 0) { free(renderer->directional_lights); }
+	if (renderer->point_light_capacity > 0) { free(renderer->point_lights); }
+	if (renderer->vertex_capacity > 0) { free(renderer->vertices); }
+
+	for (u32 i = 0; i < renderer->tile_count_x * renderer->tile_count_y; i++) {
+		if (renderer->bins[i].capacity > 0) {
+			free(renderer->bins[i].triangles);
+		}
+	}
+
+	free(renderer->bins);
+
+	free(renderer);
+}
+
+static alice_software_material_t alice_software_material_from_material(const alice_material_t* material) {
+	if (material->type == ALICE_MATERIAL_PHONG) {
+		const alice_phong_material_t* phong = &material->as.phong;
+
+		return (alice_software_material_t) {
+			.diffuse = alice_software_v3f_from_color(phong->diffuse),
+			.specular = alice_software_v3f_from_color(phong->specular),
+			.ambient = alice_software_v3f_from_color(phong->ambient),
+			.shininess = phong->shininess,
+			.emissive = phong->emissive
+		};
+	}
+
+	/* PBR materials become a Blinn-Phong material with a similar
+	 * highlight: metals tint their reflections, everything else reflects
+	 * about four percent, and rougher surfaces get a wider lobe. */
+	const alice_pbr_material_t* pbr = &material->as.pbr;
+
+	const alice_v3f_t albedo = alice_software_v3f_from_color(pbr->albedo);
+	const float metallic = pbr->metallic;
+	const float roughness = alice_max(pbr->roughness, 0.05f);
+
+	return (alice_software_material_t) {
+		.diffuse = {
+			albedo.x * (1.0f - metallic),
+			albedo.y * (1.0f - metallic),
+			albedo.z * (1.0f - metallic)
+		},
+		.specular = {
+			0.04f + (albedo.x - 0.04f) * metallic,
+			0.04f + (albedo.y - 0.04f) * metallic,
+			0.04f + (albedo.z - 0.04f) * metallic
+		},
+		.ambient = albedo,
+		.shininess = alice_max(2.0f / (roughness * roughness * roughness * roughness) - 2.0f, 1.0f),
+		.emissive = pbr->emissive
+	};
+}
+
+static u32 alice_software_push_material(alice_software_renderer_t* renderer, alice_software_material_t material) {
+	if (renderer->material_count >= renderer->material_capacity) {
+		renderer->material_capacity = alice_grow_capacity(renderer->material_capacity);
+		renderer->materials = realloc(renderer->materials,
+				renderer->material_capacity * sizeof(alice_software_material_t));
+	}
+
+	renderer->materials[renderer->material_count] = material;
+
+	return renderer->material_count++;
+}
+
+static void alice_software_collect_lights(alice_software_renderer_t* renderer, alice_scene_t* scene) {
+	renderer->directional_light_count = 0;
+	renderer->point_light_count = 0;
+
+	for (alice_entity_iter(scene, iter, alice_directional_light_t)) {
+		alice_directional_light_t* light = iter.current_ptr;
+
+		if (renderer->directional_light_count >= renderer->directional_light_capacity) {
+			renderer->directional_light_capacity = alice_grow_capacity(renderer->directional_light_capacity);
+			renderer->directional_lights = realloc(renderer->directional_lights,
+					renderer->directional_light_capacity * sizeof(alice_software_directional_light_t));
+		}
+
+		const alice_v3f_t color = alice_software_v3f_from_color(light->color);
+
+		/* A directional light's position is its direction. */
+		renderer->directional_lights[renderer->directional_light_count++] = (alice_software_directional_light_t) {
+			.to_light = alice_software_normalise((alice_v3f_t) {
+				-light->base.position.x, -light->base.position.y, -light->base.position.z }),
+			.color = { color.x * light->intensity, color.y * light->intensity, color.z * light->intensity }
+		};
+	}
+
+	for (alice_entity_iter(scene, iter, alice_point_light_t)) {
+		alice_point_light_t* light = iter.current_ptr;
+
+		if (renderer->point_light_count >= renderer->point_light_capacity) {
+			renderer->point_light_capacity = alice_grow_capacity(renderer->point_light_capacity);
+			renderer->point_lights = realloc(renderer->point_lights,
+					renderer->point_light_capacity * sizeof(alice_software_point_light_t));
+		}
+
+		const alice_v3f_t color = alice_software_v3f_from_color(light->color);
+
+		renderer->point_lights[renderer->point_light_count++] = (alice_software_point_light_t) {
+			.position = alice_get_entity_world_position(scene, (alice_entity_t*)light),
+			.range = light->range,
+			.color = { color.x * light->intensity, color.y * light->intensity, color.z * light->intensity }
+		};
+	}
+}
+
+static void alice_software_bin_triangle(alice_software_renderer_t* renderer, u32 material,
+		const alice_software_vertex_t* a, const alice_software_vertex_t* b, const alice_software_vertex_t* c) {
+	const alice_software_vertex_t* vertices[] = { a, b, c };
+
+	float x[3], y[3], z[3], inv_w[3];
+
+	for (u32 i = 0; i < 3; i++) {
+		const alice_software_vertex_t* v = vertices[i];
+
+		inv_w[i] = 1.0f / v->w;
+
+		/* The image is stored top row first, so y is flipped. */
+		x[i] = (v->x * inv_w[i] * 0.5f + 0.5f) * (float)renderer->width;
+		y[i] = (0.5f - v->y * inv_w[i] * 0.5f) * (float)renderer->height;
+		z[i] = v->z * inv_w[i] * 0.5f + 0.5f;
+	}
+
+	const float min_x = alice_min(x[0], alice_min(x[1], x[2]));
+	const float max_x = alice_max(x[0], alice_max(x[1], x[2]));
+	const float min_y = alice_min(y[0], alice_min(y[1], y[2]));
+	const float max_y = alice_max(y[0], alice_max(y[1], y[2]));
+
+	if (max_x < 0.0f || max_y < 0.0f ||
+		min_x >= (float)renderer->width || min_y >= (float)renderer->height) {
+		return;
+	}
+
+	const float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+
+	/* Counter-clockwise triangles face the camera, as with GL's default
+	 * culling. With y flipped they come out with a negative area, and are
+	 * put in the other order so that the edge functions are positive
+	 * inside. */
+	if (area >= 0.0f) {
+		return;
+	}
+
+	static const u32 order[] = { 0, 2, 1 };
+
+	alice_software_triangle_t triangle = {
+		.min_x = alice_max((i32)floorf(min_x), 0),
+		.min_y = alice_max((i32)floorf(min_y), 0),
+		.max_x = alice_min((i32)ceilf(max_x), (i32)renderer->width - 1),
+		.max_y = alice_min((i32)ceilf(max_y), (i32)renderer->height - 1),
+		.material = material
+	};
+
+	const float inv_area = 1.0f / -area;
+
+	/* Edge e is opposite vertex e, so dividing by the area gives the
+	 * barycentric weight of that vertex. The edges are set up around the
+	 * corner of the bounds rather than the corner of the image: far from
+	 * the origin the products in the constant term lose enough precision
+	 * to open cracks between small triangles. */
+	for (u32 i = 0; i < 3; i++) {
+		x[i] -= (float)triangle.min_x;
+		y[i] -= (float)triangle.min_y;
+	}
+
+	for (u32 e = 0; e < 3; e++) {
+		const u32 v0 = order[(e + 1) % 3];
+		const u32 v1 = order[(e + 2) % 3];
+
+		triangle.ea[e] = (y[v0] - y[v1]) * inv_area;
+		triangle.eb[e] = (x[v1] - x[v0]) * inv_area;
+		triangle.ec[e] = (x[v0] * y[v1] - y[v0] * x[v1]) * inv_area;
+
+		const u32 v = order[e];
+
+		triangle.inv_w[e] = inv_w[v];
+		triangle.world_positions[e] = vertices[v]->world_position;
+		triangle.normals[e] = vertices[v]->normal;
+	}
+
+	/* Depth is linear in screen space after the perspective divide. */
+	triangle.za = triangle.ea[0] * z[order[0]] + triangle.ea[1] * z[order[1]] + triangle.ea[2] * z[order[2]];
+	triangle.zb = triangle.eb[0] * z[order[0]] + triangle.eb[1] * z[order[1]] + triangle.eb[2] * z[order[2]];
+	triangle.zc = triangle.ec[0] * z[order[0]] + triangle.ec[1] * z[order[1]] + triangle.ec[2] * z[order[2]];
+
+	if (renderer->triangle_count >= renderer->triangle_capacity) {
+		renderer->triangle_capacity = alice_grow_capacity(renderer->triangle_capacity);
+		renderer->triangles = realloc(renderer->triangles,
+				renderer->triangle_capacity * sizeof(alice_software_triangle_t));
+	}
+
+	const u32 index = renderer->triangle_count++;
+	renderer->triangles[index] = triangle;
+
+	const u32 tile_x0 = (u32)triangle.min_x / ALICE_SOFTWARE_TILE_WIDTH;
+	const u32 tile_y0 = (u32)triangle.min_y / ALICE_SOFTWARE_TILE_HEIGHT;
+	const u32 tile_x1 = (u32)triangle.max_x / ALICE_SOFTWARE_TILE_WIDTH;
+	const u32 tile_y1 = (u32)triangle.max_y / ALICE_SOFTWARE_TILE_HEIGHT;
+
+	for (u32 ty = tile_y0; ty <= tile_y1; ty++) {
+		for (u32 tx = tile_x0; tx <= tile_x1; tx++) {
+			alice_software_bin_t* bin = &renderer->bins[ty * renderer->tile_count_x + tx];
+
+			if (bin->count >= bin->capacity) {
+				bin->capacity = alice_grow_capacity(bin->capacity);
+				bin->triangles = realloc(bin->triangles, bin->capacity * sizeof(u32));
+			}
+
+			bin->triangles[bin->count++] = index;
+		}
+	}
+}
+
+static alice_software_vertex_t alice_software_lerp_vertex(const alice_software_vertex_t* a,
+		const alice_software_vertex_t* b, float t) {
+	return (alice_software_vertex_t) {
+		.x = a->x + (b->x - a->x) * t,
+		.y = a->y + (b->y - a->y) * t,
+		.z = a->z + (b->z - a->z) * t,
+		.w = a->w + (b->w - a->w) * t,
+		.world_position = {
+			a->world_position.x + (b->world_position.x - a->world_position.x) * t,
+			a->world_position.y + (b->world_position.y - a->world_position.y) * t,
+			a->world_position.z + (b->world_position.z - a->world_position.z) * t
+		},
+		.normal = {
+			a->normal.x + (b->normal.x - a->normal.x) * t,
+			a->normal.y + (b->normal.y - a->normal.y) * t,
+			a->normal.z + (b->normal.z - a->normal.z) * t
+		}
+	};
+}
+
+static void alice_software_add_mesh(alice_software_renderer_t* renderer, alice_m4f_t m,
+		const alice_mesh_t* mesh, u32 material) {
+	if (mesh->position_count > renderer->vertex_capacity) {
+		renderer->vertex_capacity = mesh->position_count;
+		renderer->vertices = realloc(renderer->vertices,
+				renderer->vertex_capacity * sizeof(alice_software_vertex_t));
+	}
+
+	const alice_m4f_t vp = renderer->view_projection;
+
+	/* Every vertex is transformed once, however many triangles share it.
+	 * Normals go through the model matrix without its translation, as
+	 * the shaders do it. */
+	for (u32 i = 0; i < mesh->position_count; i++) {
+		const alice_v3f_t p = mesh->positions[i];
+		const alice_v3f_t n = mesh->normals[i];
+
+		const alice_v3f_t world = {
+			m.elements[0][0] * p.x + m.elements[1][0] * p.y + m.elements[2][0] * p.z + m.elements[3][0],
+			m.elements[0][1] * p.x + m.elements[1][1] * p.y + m.elements[2][1] * p.z + m.elements[3][1],
+			m.elements[0][2] * p.x + m.elements[1][2] * p.y + m.elements[2][2] * p.z + m.elements[3][2]
+		};
+
+		renderer->vertices[i] = (alice_software_vertex_t) {
+			.x = vp.elements[0][0] * world.x + vp.elements[1][0] * world.y + vp.elements[2][0] * world.z + vp.elements[3][0],
+			.y = vp.elements[0][1] * world.x + vp.elements[1][1] * world.y + vp.elements[2][1] * world.z + vp.elements[3][1],
+			.z = vp.elements[0][2] * world.x + vp.elements[1][2] * world.y + vp.elements[2][2] * world.z + vp.elements[3][2],
+			.w = vp.elements[0][3] * world.x + vp.elements[1][3] * world.y + vp.elements[2][3] * world.z + vp.elements[3][3],
+			.world_position = world,
+			.normal = {
+				m.elements[0][0] * n.x + m.elements[1][0] * n.y + m.elements[2][0] * n.z,
+				m.elements[0][1] * n.x + m.elements[1][1] * n.y + m.elements[2][1] * n.z,
+				m.elements[0][2] * n.x + m.elements[1][2] * n.y + m.elements[2][2] * n.z
+			}
+		};
+	}
+
+	for (u32 i = 0; i + 2 < mesh->index_count; i += 3) {
+		const alice_software_vertex_t* input[3];
+		for (u32 j = 0; j < 3; j++) {
+			input[j] = &renderer->vertices[mesh->indices[i + j]];
+		}
+
+		/* Clip against the near plane, z = -w, which turns the triangle
+		 * into a polygon of at most four vertices. The other planes are
+		 * handled by clamping to the image when binning, and by the depth
+		 * test. */
+		alice_software_vertex_t output[4];
+		u32 output_count = 0;
+
+		for (u32 j = 0; j < 3; j++) {
+			const alice_software_vertex_t* current = input[j];
+			const alice_software_vertex_t* next = input[(j + 1) % 3];
+
+			const float current_distance = current->z + current->w;
+			const float next_distance = next->z + next->w;
+
+			if (current_distance >= 0.0f) {
+				output[output_count++] = *current;
+			}
+
+			if ((current_distance >= 0.0f) != (next_distance >= 0.0f)) {
+				output[output_count++] = alice_software_lerp_vertex(current, next,
+						current_distance / (current_distance - next_distance));
+			}
+		}
+
+		for (u32 j = 0; j + 2 < output_count; j++) {
+			if (output[0].w < ALICE_SOFTWARE_MIN_W ||
+				output[j + 1].w < ALICE_SOFTWARE_MIN_W ||
+				output[j + 2].w < ALICE_SOFTWARE_MIN_W) {
+				continue;
+			}
+
+			alice_software_bin_triangle(renderer, material, &output[0], &output[j + 1], &output[j + 2]);
+		}
+	}
+}
+
+static alice_v3f_t alice_software_shade(const alice_software_renderer_t* renderer,
+		const alice_software_triangle_t* t, float px, float py) {
+	const alice_software_material_t* material = &renderer->materials[t->material];
+
+	if (renderer->shading == ALICE_SOFTWARE_SHADING_UNLIT) {
+		return material->diffuse;
+	}
+
+	/* Screen-space weights, corrected for perspective. */
+	float weights[3];
+	float total = 0.0f;
+	for (u32 i = 0; i < 3; i++) {
+		weights[i] = alice_max(t->ea[i] * px + t->eb[i] * py + t->ec[i], 0.0f) * t->inv_w[i];
+		total += weights[i];
+	}
+
+	const float inv_total = total > 0.0f ? 1.0f / total : 0.0f;
+
+	alice_v3f_t position = { 0.0f, 0.0f, 0.0f };
+	alice_v3f_t normal = { 0.0f, 0.0f, 0.0f };
+	for (u32 i = 0; i < 3; i++) {
+		const float w = weights[i] * inv_total;
+
+		position.x += t->world_positions[i].x * w;
+		position.y += t->world_positions[i].y * w;
+		position.z += t->world_positions[i].z * w;
+
+		normal.x += t->normals[i].x * w;
+		normal.y += t->normals[i].y * w;
+		normal.z += t->normals[i].z * w;
+	}
+
+	normal = alice_software_normalise(normal);
+
+	const alice_v3f_t view_dir = alice_software_normalise((alice_v3f_t) {
+		renderer->camera_position.x - position.x,
+		renderer->camera_position.y - position.y,
+		renderer->camera_position.z - position.z
+	});
+
+	alice_v3f_t result = {
+		material->ambient.x * renderer->ambient.x + material->emissive,
+		material->ambient.y * renderer->ambient.y + material->emissive,
+		material->ambient.z * renderer->ambient.z + material->emissive
+	};
+
+	for (u32 i = 0; i < renderer->directional_light_count + renderer->point_light_count; i++) {
+		alice_v3f_t light_dir;
+		alice_v3f_t color;
+
+		if (i < renderer->directional_light_count) {
+			const alice_software_directional_light_t* light = &renderer->directional_lights[i];
+
+			light_dir = light->to_light;
+			color = light->color;
+		} else {
+			const alice_software_point_light_t* light =
+				&renderer->point_lights[i - renderer->directional_light_count];
+
+			const alice_v3f_t to_light = {
+				light->position.x - position.x,
+				light->position.y - position.y,
+				light->position.z - position.z
+			};
+
+			const float dist = sqrtf(to_light.x * to_light.x + to_light.y * to_light.y + to_light.z * to_light.z);
+
+			/* The GPU path only lights a fragment from the lights whose
+			 * range reaches its cluster. */
+			if (dist > light->range || dist == 0.0f) {
+				continue;
+			}
+
+			const float falloff = (dist / light->range) * 5.0f;
+			const float attenuation = 1.0f / (falloff * falloff + 1.0f);
+
+			light_dir = (alice_v3f_t) { to_light.x / dist, to_light.y / dist, to_light.z / dist };
+			color = (alice_v3f_t) {
+				light->color.x * attenuation,
+				light->color.y * attenuation,
+				light->color.z * attenuation
+			};
+		}
+
+		const float diff = alice_max(normal.x * light_dir.x + normal.y * light_dir.y + normal.z * light_dir.z, 0.0f);
+
+		const alice_v3f_t halfway = alice_software_normalise((alice_v3f_t) {
+			light_dir.x + view_dir.x, light_dir.y + view_dir.y, light_dir.z + view_dir.z });
+
+		const float n_dot_h = normal.x * halfway.x + normal.y * halfway.y + normal.z * halfway.z;
+		const float spec = n_dot_h > 0.0f ? powf(n_dot_h, material->shininess) : 0.0f;
+
+		result.x += color.x * (diff * material->diffuse.x + spec * material->specular.x);
+		result.y += color.y * (diff * material->diffuse.y + spec * material->specular.y);
+		result.z += color.z * (diff * material->diffuse.z + spec * material->specular.z);
+	}
+
+	return result;
+}
+
+static void alice_software_build_tone_map(alice_software_renderer_t* renderer, float exposure, float gamma) {
+	if (exposure == renderer->tone_map_exposure && gamma == renderer->tone_map_gamma) {
+		return;
+	}
+
+	renderer->tone_map_exposure = exposure;
+	renderer->tone_map_gamma = gamma;
+
+	for (u32 i = 0; i < ALICE_SOFTWARE_TONE_MAP_SIZE; i++) {
+		const float s = (float)i / (float)(ALICE_SOFTWARE_TONE_MAP_SIZE - 1);
+		const float x = s * s * ALICE_SOFTWARE_TONE_MAP_RANGE;
+
+		const float c = powf(1.0f - expf(-x), 1.0f / gamma);
+
+		renderer->tone_map[i] = (u8)(alice_min(alice_max(c, 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+}
+
+static u8 alice_software_tone_map(const alice_software_renderer_t* renderer, float c) {
+	const float x = alice_min(alice_max(c * renderer->tone_map_exposure, 0.0f), ALICE_SOFTWARE_TONE_MAP_RANGE);
+
+	return renderer->tone_map[(u32)(sqrtf(x / ALICE_SOFTWARE_TONE_MAP_RANGE) *
+			(float)(ALICE_SOFTWARE_TONE_MAP_SIZE - 1) + 0.5f)];
+}
+
+static void alice_software_render_tile(void* data, u32 tile) {
+	alice_software_renderer_t* renderer = data;
+
+	const u32 tile_x = tile % renderer->tile_count_x;
+	const u32 tile_y = tile / renderer->tile_count_x;
+
+	const i32 tile_x0 = (i32)(tile_x * ALICE_SOFTWARE_TILE_WIDTH);
+	const i32 tile_y0 = (i32)(tile_y * ALICE_SOFTWARE_TILE_HEIGHT);
+	const i32 tile_x1 = alice_min(tile_x0 + ALICE_SOFTWARE_TILE_WIDTH, (i32)renderer->width) - 1;
+	const i32 tile_y1 = alice_min(tile_y0 + ALICE_SOFTWARE_TILE_HEIGHT, (i32)renderer->height) - 1;
+
+	const u32 width = renderer->width;
+
+	float* depth = renderer->depth;
+	u32* visibility = renderer->visibility;
+	u8* pixels = renderer->pixels;
+
+	for (i32 y = tile_y0; y <= tile_y1; y++) {
+		for (i32 x = tile_x0; x <= tile_x1; x++) {
+			depth[y * width + x] = 1.0f;
+			visibility[y * width + x] = 0;
+		}
+	}
+
+	const alice_software_bin_t* bin = &renderer->bins[tile];
+
+	/* Visibility first: find the nearest triangle at every pixel, so that
+	 * each pixel is only shaded once. */
+	for (u32 i = 0; i < bin->count; i++) {
+		const u32 id = bin->triangles[i] + 1;
+		const alice_software_triangle_t* t = &renderer->triangles[id - 1];
+
+		/* Spans start on a multiple of four so that rows can be processed
+		 * four pixels at a time. Tiles are multiples of four wide, so the
+		 * last group never runs past the tile. */
+		const i32 x0 = alice_max(t->min_x, tile_x0) & ~3;
+		const i32 x1 = alice_min(t->max_x, tile_x1);
+		const i32 y0 = alice_max(t->min_y, tile_y0);
+		const i32 y1 = alice_min(t->max_y, tile_y1);
+
+		if (x0 > x1 || y0 > y1) {
+			continue;
+		}
+
+#ifdef ALICE_SIMD_SSE
+		const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+
+		const __m128 ea0 = _mm_set1_ps(t->ea[0]), ea1 = _mm_set1_ps(t->ea[1]), ea2 = _mm_set1_ps(t->ea[2]);
+		const __m128 za = _mm_set1_ps(t->za);
+
+		for (i32 y = y0; y <= y1; y++) {
+			const float py = (float)(y - t->min_y) + 0.5f;
+
+			const __m128 row0 = _mm_set1_ps(t->eb[0] * py + t->ec[0]);
+			const __m128 row1 = _mm_set1_ps(t->eb[1] * py + t->ec[1]);
+			const __m128 row2 = _mm_set1_ps(t->eb[2] * py + t->ec[2]);
+			const __m128 rowz = _mm_set1_ps(t->zb * py + t->zc);
+
+			float* depth_row = depth + y * width;
+			u32* visibility_row = visibility + y * width;
+
+			for (i32 x = x0; x <= x1; x += 4) {
+				const __m128 px = _mm_add_ps(_mm_set1_ps((float)(x - t->min_x)), offsets);
+
+				const __m128 e0 = _mm_add_ps(_mm_mul_ps(ea0, px), row0);
+				const __m128 e1 = _mm_add_ps(_mm_mul_ps(ea1, px), row1);
+				const __m128 e2 = _mm_add_ps(_mm_mul_ps(ea2, px), row2);
+
+				const __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero),
+					_mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+
+				if (_mm_movemask_ps(inside) == 0) {
+					continue;
+				}
+
+				const __m128 z = _mm_add_ps(_mm_mul_ps(za, px), rowz);
+				const __m128 stored = _mm_loadu_ps(depth_row + x);
+				const __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, stored));
+
+				const int mask = _mm_movemask_ps(pass);
+				if (mask == 0) {
+					continue;
+				}
+
+				_mm_storeu_ps(depth_row + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, stored)));
+
+				for (i32 k = 0; k < 4; k++) {
+					if (mask & (1 << k)) {
+						visibility_row[x + k] = id;
+					}
+				}
+			}
+		}
+#else
+		for (i32 y = y0; y <= y1; y++) {
+			const float py = (float)(y - t->min_y) + 0.5f;
+
+			float* depth_row = depth + y * width;
+			u32* visibility_row = visibility + y * width;
+
+			for (i32 x = x0; x <= x1; x++) {
+				const float px = (float)(x - t->min_x) + 0.5f;
+
+				const float e0 = t->ea[0] * px + t->eb[0] * py + t->ec[0];
+				const float e1 = t->ea[1] * px + t->eb[1] * py + t->ec[1];
+				const float e2 = t->ea[2] * px + t->eb[2] * py + t->ec[2];
+
+				if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f) {
+					continue;
+				}
+
+				const float z = t->za * px + t->zb * py + t->zc;
+				if (z < depth_row[x]) {
+					depth_row[x] = z;
+					visibility_row[x] = id;
+				}
+			}
+		}
+#endif
+	}
+
+	const alice_rgb_color_t clear = alice_rgb_color_from_color(renderer->clear_color);
+	const u8 clear_pixel[4] = {
+		(u8)(clear.r * 255.0f + 0.5f),
+		(u8)(clear.g * 255.0f + 0.5f),
+		(u8)(clear.b * 255.0f + 0.5f),
+		0
+	};
+
+	for (i32 y = tile_y0; y <= tile_y1; y++) {
+		for (i32 x = tile_x0; x <= tile_x1; x++) {
+			const u32 id = visibility[y * width + x];
+			u8* pixel = pixels + (y * width + x) * 4;
+
+			if (id == 0) {
+				memcpy(pixel, clear_pixel, 4);
+				continue;
+			}
+
+			const alice_software_triangle_t* t = &renderer->triangles[id - 1];
+
+			const alice_v3f_t color = alice_software_shade(renderer, t,
+					(float)(x - t->min_x) + 0.5f, (float)(y - t->min_y) + 0.5f);
+
+			pixel[0] = alice_software_tone_map(renderer, color.x);
+			pixel[1] = alice_software_tone_map(renderer, color.y);
+			pixel[2] = alice_software_tone_map(renderer, color.z);
+			pixel[3] = 255;
+		}
+	}
+}
+
+void alice_software_render_scene(alice_software_renderer_t* renderer, alice_scene_t* scene) {
+	assert(renderer);
+	assert(scene);
+
+	renderer->triangle_count = 0;
+	renderer->material_count = 0;
+	renderer->drawn_mesh_count = 0;
+	renderer->culled_mesh_count = 0;
+
+	for (u32 i = 0; i < renderer->tile_count_x * renderer->tile_count_y; i++) {
+		renderer->bins[i].count = 0;
+	}
+
+	alice_camera_3d_t* camera = alice_get_scene_camera_3d(scene);
+	if (!camera) {
+		alice_log_warning("Attempting software scene render with no active 3D camera");
+		return;
+	}
+
+	camera->dimentions = (alice_v2f_t) { (float)renderer->width, (float)renderer->height };
+
+	renderer->view_projection = alice_get_camera_3d_matrix(scene, camera);
+	renderer->camera_position = alice_get_entity_world_position(scene, (alice_entity_t*)camera);
+	alice_software_build_tone_map(renderer, camera->exposure, camera->gamma > 0.0f ? camera->gamma : 2.2f);
+
+	renderer->ambient = (alice_v3f_t) { 0.0f, 0.0f, 0.0f };
+	if (scene->renderer) {
+		const alice_v3f_t ambient = alice_software_v3f_from_color(scene->renderer->ambient_color);
+		const float intensity = scene->renderer->ambient_intensity;
+
+		renderer->ambient = (alice_v3f_t) { ambient.x * intensity, ambient.y * intensity, ambient.z * intensity };
+	}
+
+	alice_software_collect_lights(renderer, scene);
+
+	alice_update_renderable_3d_bounds(scene);
+
+	const alice_frustum_t frustum = alice_frustum_from_m4f(renderer->view_projection);
+
+	for (alice_entity_iter(scene, iter, alice_renderable_3d_t)) {
+		alice_renderable_3d_t* renderable = iter.current_ptr;
+
+		alice_model_t* model = renderable->model;
+		if (!model || renderable->material_count == 0) {
+			continue;
+		}
+
+		if (!alice_frustum_vs_aabb(&frustum, renderable->aabb)) {
+			renderer->culled_mesh_count += model->mesh_count;
+			continue;
+		}
+
+		const alice_material_t* last_material = alice_null;
+		u32 material = 0;
+
+		for (u32 i = 0; i < model->mesh_count; i++) {
+			alice_mesh_t* mesh = &model->meshes[i];
+
+			if (!alice_frustum_vs_aabb(&frustum, renderable->mesh_aabbs[i])) {
+				renderer->culled_mesh_count++;
+				continue;
+			}
+
+			const alice_material_t* mesh_material = alice_null;
+			if (i < renderable->material_count) {
+				mesh_material = renderable->materials[i];
+			} else if (renderable->material_count == 1) {
+				mesh_material = renderable->materials[0];
+			}
+
+			if (!mesh_material) {
+				break;
+			}
+
+			if (mesh_material != last_material) {
+				material = alice_software_push_material(renderer,
+						alice_software_material_from_material(mesh_material));
+				last_material = mesh_material;
+			}
+
+			alice_software_add_mesh(renderer, alice_m4f_multiply(renderable->base.transform, mesh->transform),
+					mesh, material);
+
+			renderer->drawn_mesh_count++;
+		}
+	}
+
+	alice_run_jobs(alice_software_render_tile, renderer, renderer->tile_count_x * renderer->tile_count_y);
+}
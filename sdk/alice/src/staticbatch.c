@@ -0,0 +1,293 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alice/staticbatch.h"
+
+typedef struct alice_static_item_t {
+	alice_material_t* material;
+	bool cast_shadows;
+
+	alice_mesh_t* mesh;
+	alice_m4f_t transform;
+
+	u32 morton;
+} alice_static_item_t;
+
+/* Spreads the low ten bits of `v' out so that there are two zero bits
+ * between each of them. */
+static u32 alice_morton_spread(u32 v) {
+	v &= 0x3ff;
+	v = (v | (v << 16)) & 0x030000ff;
+	v = (v | (v << 8)) & 0x0300f00f;
+	v = (v | (v << 4)) & 0x030c30c3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+static u32 alice_morton_code(alice_v3f_t point, alice_aabb_t bounds) {
+	const float extents[] = {
+		bounds.max.x - bounds.min.x,
+		bounds.max.y - bounds.min.y,
+		bounds.max.z - bounds.min.z
+	};
+
+	const float offsets[] = {
+		point.x - bounds.min.x,
+		point.y - bounds.min.y,
+		point.z - bounds.min.z
+	};
+
+	u32 cells[3];
+	for (u32 i = 0; i < 3; i++) {
+		float t = extents[i] > 0.0f ? offsets[i] / extents[i] : 0.0f;
+		t = alice_min(alice_max(t, 0.0f), 1.0f);
+		cells[i] = (u32)(t * 1023.0f);
+	}
+
+	return alice_morton_spread(cells[0]) |
+		(alice_morton_spread(cells[1]) << 1) |
+		(alice_morton_spread(cells[2]) << 2);
+}
+
+/* Items are grouped by material and shadow casting, then ordered along a
+ * Morton curve so that each chunk covers a compact part of the level. */
+static int alice_compare_static_items(const void* a, const void* b) {
+	const alice_static_item_t* x = a;
+	const alice_static_item_t* y = b;
+
+	if (x->material != y->material) {
+		return (uintptr_t)x->material < (uintptr_t)y->material ? -1 : 1;
+	}
+
+	if (x->cast_shadows != y->cast_shadows) {
+		return x->cast_shadows ? 1 : -1;
+	}
+
+	if (x->morton != y->morton) {
+		return x->morton < y->morton ? -1 : 1;
+	}
+
+	return 0;
+}
+
+static alice_material_t* alice_get_renderable_mesh_material(alice_renderable_3d_t* renderable, u32 index) {
+	if (index < renderable->material_count) {
+		return renderable->materials[index];
+	} else if (renderable->material_count == 1) {
+		return renderable->materials[0];
+	}
+
+	return alice_null;
+}
+
+static void alice_push_static_chunk(alice_scene_renderer_3d_t* renderer,
+		alice_static_item_t* items, u32 item_count) {
+	u32 vertex_count = 0;
+	u32 index_count = 0;
+
+	for (u32 i = 0; i < item_count; i++) {
+		vertex_count += items[i].mesh->geometry.vertex_count;
+		index_count += items[i].mesh->geometry.index_count;
+	}
+
+	float* vertices = malloc(vertex_count * ALICE_GEOMETRY_VERTEX_STRIDE * sizeof(float));
+	u32* indices = malloc(index_count * sizeof(u32));
+
+	alice_geometry_pool_t* pool = alice_get_geometry_pool();
+
+	u32 vertex_offset = 0;
+	u32 index_offset = 0;
+
+	for (u32 i = 0; i < item_count; i++) {
+		alice_geometry_t* geometry = &items[i].mesh->geometry;
+
+		float* mesh_vertices = vertices + vertex_offset * ALICE_GEOMETRY_VERTEX_STRIDE;
+		u32* mesh_indices = indices + index_offset;
+
+		alice_geometry_pool_read(pool, geometry, mesh_vertices, mesh_indices);
+
+		const alice_m4f_t m = items[i].transform;
+		const alice_m4f_t n = alice_m4f_inverse(m);
+
+		for (u32 v = 0; v < geometry->vertex_count; v++) {
+			float* vertex = mesh_vertices + v * ALICE_GEOMETRY_VERTEX_STRIDE;
+
+			const alice_v3f_t p = { vertex[0], vertex[1], vertex[2] };
+			vertex[0] = m.elements[0][0] * p.x + m.elements[1][0] * p.y + m.elements[2][0] * p.z + m.elements[3][0];
+			vertex[1] = m.elements[0][1] * p.x + m.elements[1][1] * p.y + m.elements[2][1] * p.z + m.elements[3][1];
+			vertex[2] = m.elements[0][2] * p.x + m.elements[1][2] * p.y + m.elements[2][2] * p.z + m.elements[3][2];
+
+			/* Normals go through the inverse transpose, so that non-uniform
+			 * scales don't skew them. */
+			const alice_v3f_t normal = alice_v3f_normalise((alice_v3f_t) {
+				n.elements[0][0] * vertex[3] + n.elements[0][1] * vertex[4] + n.elements[0][2] * vertex[5],
+				n.elements[1][0] * vertex[3] + n.elements[1][1] * vertex[4] + n.elements[1][2] * vertex[5],
+				n.elements[2][0] * vertex[3] + n.elements[2][1] * vertex[4] + n.elements[2][2] * vertex[5]
+			});
+
+			vertex[3] = normal.x;
+			vertex[4] = normal.y;
+			vertex[5] = normal.z;
+		}
+
+		for (u32 j = 0; j < geometry->index_count; j++) {
+			mesh_indices[j] += vertex_offset;
+		}
+
+		vertex_offset += geometry->vertex_count;
+		index_offset += geometry->index_count;
+	}
+
+	if (renderer->static_chunk_count >= renderer->static_chunk_capacity) {
+		renderer->static_chunk_capacity = alice_grow_capacity(renderer->static_chunk_capacity);
+		renderer->static_chunks = realloc(renderer->static_chunks,
+				renderer->static_chunk_capacity * sizeof(alice_static_chunk_t));
+	}
+
+	alice_static_chunk_t* chunk = &renderer->static_chunks[renderer->static_chunk_count++];
+
+	chunk->material = items[0].material;
+	chunk->cast_shadows = items[0].cast_shadows;
+
+	alice_init_mesh(&chunk->mesh, vertices, vertex_count * ALICE_GEOMETRY_VERTEX_STRIDE,
+			indices, index_count);
+
+	free(vertices);
+	free(indices);
+}
+
+void alice_build_static_batches(alice_scene_t* scene) {
+	assert(scene);
+
+	alice_scene_renderer_3d_t* renderer = scene->renderer;
+	if (!renderer) {
+		alice_log_warning("Attempting to build static batches for a scene without a 3D renderer");
+		return;
+	}
+
+	alice_free_static_batches(renderer);
+
+	for (alice_entity_iter(scene, iter, alice_renderable_3d_t)) {
+		alice_renderable_3d_t* renderable = iter.current_ptr;
+		renderable->batched = false;
+	}
+
+	/* Batched renderables don't move, so their bounds are computed once
+	 * here instead of every frame. They're still needed for the scene
+	 * bounds, debug drawing and picking. */
+	alice_compute_scene_transforms(scene);
+	alice_update_renderable_3d_bounds(scene);
+
+	alice_static_item_t* items = alice_null;
+	u32 item_count = 0;
+	u32 item_capacity = 0;
+
+	for (alice_entity_iter(scene, iter, alice_renderable_3d_t)) {
+		alice_renderable_3d_t* renderable = iter.current_ptr;
+
+		alice_model_t* model = renderable->model;
+		if (!renderable->is_static || !model || model->mesh_count == 0) {
+			continue;
+		}
+
+		/* Renderables with a mesh that can't be drawn are left to the
+		 * regular path, which reports the problem. Transparent meshes are
+		 * left out as well, since merging them would break their
+		 * back-to-front order. */
+		bool drawable = true;
+		for (u32 i = 0; i < model->mesh_count; i++) {
+			alice_material_t* material = alice_get_renderable_mesh_material(renderable, i);
+			if (!material || !material->shader || material->transparent) {
+				drawable = false;
+				break;
+			}
+		}
+
+		if (!drawable) {
+			continue;
+		}
+
+		for (u32 i = 0; i < model->mesh_count; i++) {
+			alice_mesh_t* mesh = &model->meshes[i];
+
+			if (item_count >= item_capacity) {
+				item_capacity = alice_grow_capacity(item_capacity);
+				items = realloc(items, item_capacity * sizeof(alice_static_item_t));
+			}
+
+			items[item_count++] = (alice_static_item_t) {
+				.material = alice_get_renderable_mesh_material(renderable, i),
+				.cast_shadows = renderable->cast_shadows,
+				.mesh = mesh,
+				.transform = alice_m4f_multiply(renderable->base.transform, mesh->transform)
+			};
+		}
+
+		renderable->batched = true;
+	}
+
+	if (item_count == 0) {
+		return;
+	}
+
+	alice_aabb_t bounds;
+	for (u32 i = 0; i < item_count; i++) {
+		const alice_aabb_t aabb = alice_aabb_to_world(items[i].mesh->aabb, items[i].transform);
+		bounds = i == 0 ? aabb : alice_aabb_union(bounds, aabb);
+	}
+
+	for (u32 i = 0; i < item_count; i++) {
+		const alice_aabb_t aabb = alice_aabb_to_world(items[i].mesh->aabb, items[i].transform);
+		const alice_v3f_t center = {
+			(aabb.min.x + aabb.max.x) * 0.5f,
+			(aabb.min.y + aabb.max.y) * 0.5f,
+			(aabb.min.z + aabb.max.z) * 0.5f
+		};
+
+		items[i].morton = alice_morton_code(center, bounds);
+	}
+
+	qsort(items, item_count, sizeof(alice_static_item_t), alice_compare_static_items);
+
+	u32 chunk_start = 0;
+	u32 chunk_vertex_count = 0;
+
+	for (u32 i = 0; i < item_count; i++) {
+		const u32 vertex_count = items[i].mesh->geometry.vertex_count;
+
+		const bool same_group = i > chunk_start &&
+			items[i].material == items[chunk_start].material &&
+			items[i].cast_shadows == items[chunk_start].cast_shadows;
+
+		if (i > chunk_start &&
+			(!same_group || chunk_vertex_count + vertex_count > ALICE_STATIC_CHUNK_MAX_VERTICES)) {
+			alice_push_static_chunk(renderer, items + chunk_start, i - chunk_start);
+
+			chunk_start = i;
+			chunk_vertex_count = 0;
+		}
+
+		chunk_vertex_count += vertex_count;
+	}
+
+	alice_push_static_chunk(renderer, items + chunk_start, item_count - chunk_start);
+
+	free(items);
+}
+
+void alice_free_static_batches(alice_scene_renderer_3d_t* renderer) {
+	assert(renderer);
+
+	for (u32 i = 0; i < renderer->static_chunk_count; i++) {
+		alice_deinit_mesh(&renderer->static_chunks[i].mesh);
+	}
+
+	if (renderer->static_chunk_capacity > 0) {
+		free(renderer->static_chunks);
+	}
+
+	renderer->static_chunks = alice_null;
+	renderer->static_chunk_count = 0;
+	renderer->static_chunk_capacity = 0;
+}
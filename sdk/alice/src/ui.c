@@ -10,6 +10,8 @@
 #include "alice/ui.h"
 #include "alice/application.h"
 #include "alice/input.h"
+#include "alice/glstate.h"
+#include "alice/profiler.h"
 #include "font.h"
 
 const u32 ui_renderer_max_quads = 800;
@@ -119,16 +121,16 @@ void alice_ui_renderer_push_quad(alice_ui_renderer_t* renderer, alice_rect_t dst
 }
 
 void alice_begin_ui_renderer(alice_ui_renderer_t* renderer, u32 width, u32 height) {
-	renderer->backup.blend = glIsEnabled(GL_BLEND);
-	renderer->backup.cull_face = glIsEnabled(GL_CULL_FACE);
-	renderer->backup.depth_test = glIsEnabled(GL_DEPTH_TEST);
-	renderer->backup.scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+	renderer->backup.blend = alice_gl_is_enabled(GL_BLEND);
+	renderer->backup.cull_face = alice_gl_is_enabled(GL_CULL_FACE);
+	renderer->backup.depth_test = alice_gl_is_enabled(GL_DEPTH_TEST);
+	renderer->backup.scissor_test = alice_gl_is_enabled(GL_SCISSOR_TEST);
 
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_DEPTH_TEST);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable(GL_SCISSOR_TEST);
+	alice_gl_set_capability(GL_CULL_FACE, false);
+	alice_gl_set_capability(GL_DEPTH_TEST, false);
+	alice_gl_set_capability(GL_BLEND, true);
+	alice_gl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	alice_gl_set_capability(GL_SCISSOR_TEST, true);
 
 	renderer->quad_count = 0;
 	renderer->draw_call_count = 0;
@@ -138,16 +140,16 @@ void alice_begin_ui_renderer(alice_ui_renderer_t* renderer, u32 width, u32 heigh
 	renderer->camera = alice_m4f_ortho(0.0f, (float)width, (float)height, 0.0f, -1.0f, 1.0f);
 
 	glScissor(0.0f, 0.0f, (float)width, (float)height);
-	glViewport(0, 0, width, height);
+	alice_gl_viewport(0, 0, width, height);
 }
 
 void alice_end_ui_renderer(alice_ui_renderer_t* renderer) {
 	alice_flush_ui_renderer(renderer);
 
-	if (renderer->backup.blend) {        glEnable(GL_BLEND); }        else { glDisable(GL_BLEND); }
-	if (renderer->backup.cull_face) {    glEnable(GL_CULL_FACE); }    else { glDisable(GL_CULL_FACE); }
-	if (renderer->backup.depth_test) {   glEnable(GL_DEPTH_TEST); }   else { glDisable(GL_DEPTH_TEST); }
-	if (renderer->backup.scissor_test) { glEnable(GL_SCISSOR_TEST); } else { glDisable(GL_SCISSOR_TEST); }
+	alice_gl_set_capability(GL_BLEND, renderer->backup.blend);
+	alice_gl_set_capability(GL_CULL_FACE, renderer->backup.cull_face);
+	alice_gl_set_capability(GL_DEPTH_TEST, renderer->backup.depth_test);
+	alice_gl_set_capability(GL_SCISSOR_TEST, renderer->backup.scissor_test);
 }
 
 void alice_flush_ui_renderer(alice_ui_renderer_t* renderer) {
@@ -410,6 +412,8 @@ void alice_update_microui(mu_Context* context) {
 void alice_render_microui(mu_Context* context, u32 width, u32 height) {
 	assert(context);
 
+	alice_begin_gpu_profile_scope("UI");
+
 	alice_begin_microui_render(width, height);
 	
 	mu_Command* cmd = alice_null;
@@ -427,6 +431,8 @@ void alice_render_microui(mu_Context* context, u32 width, u32 height) {
 	}
 
 	alice_end_microui_render();
+
+	alice_end_profile_scope();
 }
 
 alice_ui_renderer_t* alice_get_microui_renderer() {